@@ -0,0 +1,134 @@
+/**
+ * @file
+ * @brief File message writer.
+ *
+ * File writer collects messages into a batch buffer and writes them to a
+ * file descriptor with a single call, once the buffer fills up, or the
+ * writer is flushed. Each write contains whole messages only, so several
+ * writers can append to the same file. The writer can also make the
+ * written data durable with fdatasync(2) according to a policy, and
+ * preallocate file space ahead of the writes.
+ */
+/*
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TLOG_FILE_JSON_WRITER_H
+#define _TLOG_FILE_JSON_WRITER_H
+
+#include <assert.h>
+#include <tlog/json_writer.h>
+
+/** File data synchronization policy */
+enum tlog_file_json_writer_sync {
+    /** Never synchronize, leave it to the system */
+    TLOG_FILE_JSON_WRITER_SYNC_NEVER,
+    /**
+     * Synchronize after writing, or when flushed, if the interval has
+     * elapsed
+     */
+    TLOG_FILE_JSON_WRITER_SYNC_INTERVAL,
+    /** Synchronize after writing the threshold number of bytes */
+    TLOG_FILE_JSON_WRITER_SYNC_BYTES,
+    /** Synchronize each time the writer is flushed */
+    TLOG_FILE_JSON_WRITER_SYNC_FLUSH,
+    /** Number of policies (not a valid policy itself) */
+    TLOG_FILE_JSON_WRITER_SYNC_NUM
+};
+
+/**
+ * Check if a file data synchronization policy is valid.
+ *
+ * @param sync  The policy to check.
+ *
+ * @return True if the policy is valid, false otherwise.
+ */
+static inline bool
+tlog_file_json_writer_sync_is_valid(enum tlog_file_json_writer_sync sync)
+{
+    return sync < TLOG_FILE_JSON_WRITER_SYNC_NUM;
+}
+
+/** File writer creation parameters */
+struct tlog_file_json_writer_params {
+    /** File descriptor to write messages to */
+    int                                 fd;
+    /**
+     * True if the file descriptor should be closed upon destruction of
+     * the writer, false otherwise
+     */
+    bool                                fd_owned;
+    /**
+     * Size of the batch buffer, bytes, zero to write each message
+     * as soon as it arrives
+     */
+    size_t                              batch;
+    /** Data synchronization policy */
+    enum tlog_file_json_writer_sync     sync;
+    /** Synchronization interval for the "interval" policy, milliseconds */
+    unsigned int                        interval;
+    /** Number of bytes to synchronize after, for the "bytes" policy */
+    size_t                              threshold;
+    /** Number of bytes to preallocate ahead of writes, zero to disable */
+    size_t                              prealloc;
+};
+
+/**
+ * Check if file writer creation parameters structure is valid.
+ *
+ * @param params    The parameters structure to check.
+ *
+ * @return True if the parameters structure is valid, false otherwise.
+ */
+static inline bool
+tlog_file_json_writer_params_is_valid(
+                    const struct tlog_file_json_writer_params *params)
+{
+    return params != NULL &&
+           params->fd >= 0 &&
+           tlog_file_json_writer_sync_is_valid(params->sync) &&
+           (params->sync != TLOG_FILE_JSON_WRITER_SYNC_INTERVAL ||
+            params->interval > 0) &&
+           (params->sync != TLOG_FILE_JSON_WRITER_SYNC_BYTES ||
+            params->threshold > 0);
+}
+
+/** File message writer type */
+extern const struct tlog_json_writer_type tlog_file_json_writer_type;
+
+/**
+ * Create an instance of file writer.
+ *
+ * @param pwriter   Location for the created writer pointer, will be set to
+ *                  NULL in case of error.
+ * @param params    Creation parameters structure.
+ *
+ * @return Global return code.
+ */
+static inline tlog_grc
+tlog_file_json_writer_create(struct tlog_json_writer **pwriter,
+                             const struct tlog_file_json_writer_params
+                                                                *params)
+{
+    assert(tlog_file_json_writer_params_is_valid(params));
+    return tlog_json_writer_create(pwriter, &tlog_file_json_writer_type,
+                                   params);
+}
+
+#endif /* _TLOG_FILE_JSON_WRITER_H */
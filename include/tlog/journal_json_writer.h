@@ -3,7 +3,11 @@
  * @brief Systemd journal JSON message writer
  *
  * An implementation of a JSON log message writer which sends messages to
- * systemd's journal service.
+ * systemd's journal service. The constant fields are built once, and each
+ * message is sent with a single sd_journal_sendv(3) call. Alternatively,
+ * if no extra fields are needed, messages can be written as lines to a
+ * persistent journal stream connection, which carries only the MESSAGE and
+ * PRIORITY fields.
  */
 /*
  * Copyright (C) 2017 Red Hat
@@ -37,7 +41,12 @@
  *
  * Creation arguments:
  *
- * int  priority    The "priority" argument to pass to journal(3).
+ * int          priority    The "priority" argument to pass to journal(3).
+ * bool         augment     True to add extra fields to entries.
+ * bool         stream      True to write to a journal stream.
+ * const char  *recording   Host-unique recording ID.
+ * const char  *username    Name of the user being recorded.
+ * unsigned int session_id  Audit session ID of the recording.
  */
 extern const struct tlog_json_writer_type tlog_journal_json_writer_type;
 
@@ -49,12 +58,18 @@ extern const struct tlog_json_writer_type tlog_journal_json_writer_type;
  * @param priority      The "priority" argument to pass to journal(3).
  * @param augment       True if any fields beside MESSAGE and PRIORITY should
  *                      be added to Journal entries, false otherwise.
+ * @param stream        True if messages should be written as lines to a
+ *                      persistent journal stream connection, see
+ *                      sd_journal_stream_fd(3), false if each message
+ *                      should be sent as a separate entry.
+ *                      Ignored if augment is true, as streams can't carry
+ *                      the extra fields.
  * @param recording     Host-unique recording ID.
- *                      Cannot be NULL, ignored if augment is false
+ *                      Cannot be NULL, ignored if augment is false.
  * @param username      Name of the user being recorded.
- *                      Cannot be NULL, ignored if augment is false
+ *                      Cannot be NULL, ignored if augment is false.
  * @param session_id    Audit session ID of the recording.
- *                      Cannot be zero, ignored if augment is false
+ *                      Cannot be zero, ignored if augment is false.
  *
  * @return Global return code.
  */
@@ -62,6 +77,7 @@ static inline tlog_grc
 tlog_journal_json_writer_create(struct tlog_json_writer **pwriter,
                                 int priority,
                                 bool augment,
+                                bool stream,
                                 const char *recording,
                                 const char *username,
                                 unsigned int session_id)
@@ -72,7 +88,7 @@ tlog_journal_json_writer_create(struct tlog_json_writer **pwriter,
     assert(!augment || username != NULL);
     assert(!augment || session_id != 0);
     return tlog_json_writer_create(pwriter, &tlog_journal_json_writer_type,
-                                   priority, augment,
+                                   priority, augment, stream,
                                    recording, username, session_id);
 }
 
@@ -42,6 +42,15 @@
 /** Minimum value of chunk size */
 #define TLOG_JSON_CHUNK_SIZE_MIN    TLOG_JSON_STREAM_SIZE_MIN
 
+/**
+ * Alignment of chunk buffers and arenas, and of the chunk state,
+ * a common cache line size
+ */
+#define TLOG_JSON_CHUNK_ALIGN       TLOG_JSON_STREAM_ALIGN
+
+/** Number of buffers in a chunk: timing, and text/binary for each stream */
+#define TLOG_JSON_CHUNK_BUF_NUM     5
+
 /** State of the chunk's window handling */
 enum tlog_json_chunk_window_state {
     TLOG_JSON_CHUNK_WINDOW_STATE_UNKNOWN,   /** No window packet was ever
@@ -59,18 +68,22 @@ enum tlog_json_chunk_window_state {
                                                 was empty */
 };
 
-/** Chunk transaction store */
+/**
+ * Chunk state changed by writes, and its transaction store, copied as a
+ * whole. Fits the cache line it is aligned to, with the write cursor and
+ * the remaining space first.
+ */
 TLOG_TRX_BASIC_STORE_SIG(tlog_json_chunk) {
     size_t              rem;        /**< Remaining total buffer space */
     uint8_t            *timing_ptr; /**< Timing output pointer */
-    bool                got_ts;     /**< True if got a timestamp since last
-                                         emptied */
     struct timespec     first_ts;   /**< First timestamp */
     struct timespec     last_ts;    /**< Last timestamp */
 
     enum tlog_json_chunk_window_state   window_state;   /**< Window handling
                                                              state */
 
+    bool                got_ts;     /**< True if got a timestamp since last
+                                         emptied */
     unsigned short int  last_width;     /**< Last window width */
     unsigned short int  last_height;    /**< Last window height */
 };
@@ -79,41 +92,80 @@ TLOG_TRX_BASIC_STORE_SIG(tlog_json_chunk) {
 struct tlog_json_chunk {
     struct tlog_json_dispatcher dispatcher; /**< Dispatcher interface */
 
+    TLOG_TRX_BASIC_STORE_SIG(tlog_json_chunk)
+                        state
+                        __attribute__((aligned(TLOG_JSON_CHUNK_ALIGN)));
+                                    /**< State changed by writes */
+
     size_t              size;       /**< Maximum total data length and
                                          size of each buffer below */
-    size_t              rem;        /**< Remaining total buffer space */
+
+    uint8_t            *arena;      /**< Arena all the buffers are laid
+                                         out in */
+    bool                arena_owned;    /**< True if the arena is owned */
 
     uint8_t            *timing_buf; /**< Timing buffer */
-    uint8_t            *timing_ptr; /**< Timing output pointer */
 
     struct tlog_json_stream     input;  /**< Input stream state and buffer */
     struct tlog_json_stream     output; /**< Output stream state and buffer */
 
-    bool                got_ts;     /**< True if got a timestamp since last
-                                         emptied */
-    struct timespec     first_ts;   /**< First timestamp */
-    struct timespec     last_ts;    /**< Last timestamp */
-
-    enum tlog_json_chunk_window_state   window_state;   /**< Window handling
-                                                             state */
-
-    unsigned short int  last_width;     /**< Last window width */
-    unsigned short int  last_height;    /**< Last window height */
-
     struct tlog_trx_iface   trx_iface;          /**< Transaction interface */
     TLOG_TRX_BASIC_MEMBERS(tlog_json_chunk);    /**< Transaction data */
 };
 
+/** Chunk data buffers, to take the encoded data out of a chunk */
+struct tlog_json_chunk_bufs {
+    uint8_t    *arena;              /**< Arena the buffers are laid out
+                                         in, not owned */
+    uint8_t    *timing_buf;         /**< Timing buffer */
+    size_t      timing_len;         /**< Timing data length */
+    uint8_t    *input_txt_buf;      /**< Input text buffer */
+    size_t      input_txt_len;      /**< Input text data length */
+    uint8_t    *input_bin_buf;      /**< Input binary buffer */
+    size_t      input_bin_len;      /**< Input binary data length */
+    uint8_t    *output_txt_buf;     /**< Output text buffer */
+    size_t      output_txt_len;     /**< Output text data length */
+    uint8_t    *output_bin_buf;     /**< Output binary buffer */
+    size_t      output_bin_len;     /**< Output binary data length */
+};
+
+/**
+ * Get the size of an arena holding all the buffers of a chunk, or of a
+ * chunk data buffer set, each buffer aligned to TLOG_JSON_CHUNK_ALIGN.
+ *
+ * @param size  Size of the chunk.
+ *
+ * @return The arena size, a multiple of TLOG_JSON_CHUNK_ALIGN.
+ */
+extern size_t tlog_json_chunk_arena_size(size_t size);
+
+/**
+ * Initialize a chunk data buffer set, laying out empty buffers in an arena.
+ *
+ * @param bufs  The buffer set to initialize.
+ * @param size  Size of each buffer, must be the same as the size of the
+ *              chunks the set will be swapped with.
+ * @param arena The arena to lay the buffers out in, aligned to
+ *              TLOG_JSON_CHUNK_ALIGN, tlog_json_chunk_arena_size(size)
+ *              bytes long. Owned by the caller.
+ */
+extern void tlog_json_chunk_bufs_init(struct tlog_json_chunk_bufs *bufs,
+                                      size_t size, uint8_t *arena);
+
 /**
  * Initialize a chunk.
  *
  * @param chunk The chunk to initialize.
  * @param size  Size of chunk.
+ * @param arena The arena to lay the chunk buffers out in, aligned to
+ *              TLOG_JSON_CHUNK_ALIGN, tlog_json_chunk_arena_size(size)
+ *              bytes long, and owned by the caller, or NULL to have the
+ *              chunk allocate and own its arena.
  *
  * @return Global return code.
  */
 extern tlog_grc tlog_json_chunk_init(struct tlog_json_chunk *chunk,
-                                     size_t size);
+                                     size_t size, uint8_t *arena);
 
 /**
  * Check if a chunk is valid.
@@ -188,7 +240,22 @@ extern bool tlog_json_chunk_cut(struct tlog_json_chunk *chunk);
 extern void tlog_json_chunk_empty(struct tlog_json_chunk *chunk);
 
 /**
- * Cleanup a chunk (free any allocated data).
+ * Take the encoded data out of a flushed chunk without copying, by
+ * exchanging the chunk's arena with the arena of a set, and empty the
+ * chunk, preparing it for writing a new message. The chunk keeps any
+ * pending incomplete characters.
+ *
+ * @param chunk     The chunk to take the data out of, must not own its
+ *                  arena.
+ * @param bufs      The buffer set to exchange the buffers with, must have
+ *                  the same buffer size as the chunk. Receives the data and
+ *                  its lengths.
+ */
+extern void tlog_json_chunk_swap(struct tlog_json_chunk *chunk,
+                                 struct tlog_json_chunk_bufs *bufs);
+
+/**
+ * Cleanup a chunk (free the arena, if owned).
  *
  * @param chunk     The chunk to cleanup.
  */
@@ -0,0 +1,128 @@
+/**
+ * @file
+ * @brief JSON string escaping.
+ *
+ * A kernel for escaping byte buffers for use inside JSON strings, shared by
+ * the encoders. Spans of bytes which don't need escaping are found in bulk,
+ * using SIMD instructions where available, so they can be copied as is, and
+ * only the bytes in between are escaped one-by-one.
+ */
+/*
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TLOG_JSON_ESC_H
+#define _TLOG_JSON_ESC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <tlog/misc.h>
+
+/** Maximum length of an escaped byte */
+#define TLOG_JSON_ESC_BYTE_LEN_MAX  6
+
+/**
+ * Check if a byte needs escaping inside a JSON string.
+ *
+ * @param b     The byte to check.
+ *
+ * @return True if the byte needs escaping, false otherwise.
+ */
+static inline bool
+tlog_json_esc_byte_is_needed(uint8_t b)
+{
+    return b < 0x20 || b == 0x7f || b == '"' || b == '\\';
+}
+
+/**
+ * Escape a byte for use inside a JSON string, if necessary.
+ *
+ * @param buf   The output buffer, must have space for at least
+ *              TLOG_JSON_ESC_BYTE_LEN_MAX bytes, or be NULL to only
+ *              get the length.
+ * @param b     The byte to escape.
+ *
+ * @return Length of the (to be) escaped byte.
+ */
+static inline size_t
+tlog_json_esc_byte(uint8_t *buf, uint8_t b)
+{
+    uint8_t e;
+
+    switch (b) {
+    case '"':
+    case '\\':
+        e = b;
+        break;
+    case '\b':
+        e = 'b';
+        break;
+    case '\f':
+        e = 'f';
+        break;
+    case '\n':
+        e = 'n';
+        break;
+    case '\r':
+        e = 'r';
+        break;
+    case '\t':
+        e = 't';
+        break;
+    default:
+        if (b < 0x20 || b == 0x7f) {
+            if (buf != NULL) {
+                buf[0] = '\\';
+                buf[1] = 'u';
+                buf[2] = '0';
+                buf[3] = '0';
+                buf[4] = tlog_nibble_digit(b >> 4);
+                buf[5] = tlog_nibble_digit(b & 0xf);
+            }
+            return 6;
+        }
+        if (buf != NULL) {
+            buf[0] = b;
+        }
+        return 1;
+    }
+
+    if (buf != NULL) {
+        buf[0] = '\\';
+        buf[1] = e;
+    }
+    return 2;
+}
+
+/**
+ * Find the length of the span of bytes at the start of a buffer, which
+ * don't need escaping inside a JSON string.
+ *
+ * @param buf   The buffer to scan.
+ * @param len   The buffer length.
+ * @param ascii True if bytes above 0x7f should end the span,
+ *              false if they should be included.
+ *
+ * @return The length of the span, bytes.
+ */
+extern size_t tlog_json_esc_span(const uint8_t *buf, size_t len,
+                                 bool ascii);
+
+#endif /* _TLOG_JSON_ESC_H */
@@ -2,9 +2,11 @@
  * @file
  * @brief JSON message parser.
  *
- * An object representing a single JSON log message being parsed. Gets a
- * struct json_object on creation and provides an interface to read packets
- * from.
+ * An object representing a single JSON log message being parsed. Gets the
+ * message text, or a struct json_object, on creation and provides an
+ * interface to read packets from. The text is parsed in a single pass,
+ * following the message schema, with the strings unescaped and the binary
+ * arrays converted to bytes in place.
  */
 /*
  * Copyright (C) 2015 Red Hat
@@ -43,12 +45,14 @@
  * NOTE: Members are named after JSON properties, where possible.
  */
 struct tlog_json_msg {
-    struct json_object *obj;            /**< The JSON object behind the
-                                             message, NULL for a void
-                                             message */
+    char               *buf;            /**< The message text buffer owned
+                                             by the message, if parsed from
+                                             a JSON object, NULL if the
+                                             text is borrowed */
     unsigned int        ver_major;      /**< Major version number */
     unsigned int        ver_minor;      /**< Minor version number */
-    const char         *host;           /**< Hostname */
+    const char         *host;           /**< Hostname,
+                                             NULL for a void message */
     const char         *rec;            /**< Recording ID,
                                              or NULL if missing */
     const char         *user;           /**< Username */
@@ -63,14 +67,19 @@ struct tlog_json_msg {
     const char         *in_txt_ptr;     /**< Input text string position */
     size_t              in_txt_len;     /**< Input text remaining length */
 
-    struct json_object *in_bin_obj;     /**< Input binary array object */
-    int                 in_bin_pos;     /**< Input binary array position */
+    const uint8_t      *in_bin_ptr;     /**< Input binary byte position */
+    size_t              in_bin_len;     /**< Input binary remaining length,
+                                             up to the first invalid byte */
 
     const char         *out_txt_ptr;    /**< Output text string position */
     size_t              out_txt_len;    /**< Output text remaining length */
 
-    struct json_object *out_bin_obj;    /**< Output binary array object */
-    int                 out_bin_pos;    /**< Output binary array position */
+    const uint8_t      *out_bin_ptr;    /**< Output binary byte position */
+    size_t              out_bin_len;    /**< Output binary remaining length,
+                                             up to the first invalid byte */
+
+    size_t              elided;         /**< Number of bytes elided from the
+                                             output data, zero if none */
 
     bool                output;         /**< True if currently processing an
                                              output timing entry */
@@ -82,23 +91,71 @@ struct tlog_json_msg {
     const char            **ptxt_ptr;   /**< Current text string position */
     size_t                 *ptxt_len;   /**< Current text remaining length */
 
-    struct json_object     *bin_obj;    /**< Current binary array object */
-    int                    *pbin_pos;   /**< Current binary array position */
+    const uint8_t         **pbin_ptr;   /**< Current binary byte position */
+    size_t                 *pbin_len;   /**< Current binary remaining
+                                             length */
+};
+
+/** Message filter, matching messages by their header fields */
+struct tlog_json_msg_filter {
+    const char         *host;           /**< Host name to match,
+                                             NULL for any */
+    const char         *rec;            /**< Recording ID to match, if the
+                                             message has one, NULL for any */
+    const char         *user;           /**< User name to match,
+                                             NULL for any */
+    unsigned int        session;        /**< Audit session ID to match,
+                                             zero for any */
 };
 
 /**
- * Initialize a message.
+ * Check if the text of a JSON message object can match a filter, with a
+ * lightweight scan of the object fields, stopping once the filtered fields
+ * are found, without parsing or modifying the text. Used to skip messages
+ * before parsing them. Only values which can be compared without decoding
+ * them are considered, and anything unexpected is assumed to match, so
+ * the message parsed can still mismatch, or fail to parse.
+ *
+ * @param text      The text to check, doesn't have to be zero-terminated.
+ * @param len       Length of the text.
+ * @param filter    The filter to check against.
+ *
+ * @return False if the message doesn't match the filter, true if it can.
+ */
+extern bool tlog_json_msg_text_may_match(
+                        const char *text, size_t len,
+                        const struct tlog_json_msg_filter *filter);
+
+/**
+ * Initialize a message from a JSON object. The object is formatted into a
+ * text buffer owned by the message, which is then parsed as with
+ * tlog_json_msg_init_text.
  *
  * @param msg   The message to initialize.
  * @param obj   The object to parse, or NULL for void message.
- *              The object's reference count will be increased in case of
- *              success.
  *
  * @return Global return code.
  */
 extern tlog_grc tlog_json_msg_init(struct tlog_json_msg *msg,
                                    struct json_object *obj);
 
+/**
+ * Initialize a message by parsing the text of a JSON message object in
+ * place. Only the first object in the text is parsed, anything after it is
+ * ignored. The text is modified and referenced by the message, and so must
+ * be kept until the message is cleaned up.
+ *
+ * @param msg   The message to initialize.
+ * @param text  The text to parse, doesn't have to be zero-terminated.
+ * @param len   Length of the text.
+ *
+ * @return Global return code. A text ending before the object does is
+ *         reported as TLOG_GRC_FROM(json, json_tokener_continue), a
+ *         syntax error, as another JSON tokener error.
+ */
+extern tlog_grc tlog_json_msg_init_text(struct tlog_json_msg *msg,
+                                        char *text, size_t len);
+
 /**
  * Check if a message is valid.
  *
@@ -135,9 +192,8 @@ extern tlog_grc tlog_json_msg_read(struct tlog_json_msg *msg,
                                    uint8_t *io_buf, size_t io_size);
 
 /**
- * Cleanup a message, "putting" down the JSON object and voiding the message.
- * The referenced object's reference count will be decreased.
- * Can be called repeatedly with no additional effect.
+ * Cleanup a message, freeing the text buffer, if owned, and voiding the
+ * message. Can be called repeatedly with no additional effect.
  *
  * @param msg   The message to cleanup.
  */
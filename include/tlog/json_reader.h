@@ -96,6 +96,26 @@ extern char *tlog_json_reader_loc_fmt(const struct tlog_json_reader *reader,
 extern tlog_grc tlog_json_reader_read(struct tlog_json_reader *reader,
                                       struct json_object **pobject);
 
+/**
+ * Read a message with a reader, parsing the message text directly, if the
+ * reader supports that, or parsing the message from the JSON object read,
+ * otherwise.
+ *
+ * @param reader    The reader to operate on.
+ * @param msg       The message to parse the read message into, void on end
+ *                  of stream, or on error. Can refer to the reader storage,
+ *                  and so must be cleaned up before the next read.
+ * @param filter    The filter to skip messages not matching before parsing
+ *                  them, if the reader parses the message text directly, or
+ *                  NULL for none. Messages returned can still mismatch.
+ *
+ * @return Global return code.
+ */
+extern tlog_grc tlog_json_reader_read_msg(
+                            struct tlog_json_reader *reader,
+                            struct tlog_json_msg *msg,
+                            const struct tlog_json_msg_filter *filter);
+
 /**
  * Cleanup and deallocate a reader.
  *
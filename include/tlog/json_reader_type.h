@@ -34,8 +34,10 @@
 #include <json.h>
 #include <tlog/grc.h>
 
-/* Forward declaration */
+/* Forward declarations */
 struct tlog_json_reader;
+struct tlog_json_msg;
+struct tlog_json_msg_filter;
 
 /**
  * Init function prototype.
@@ -95,6 +97,24 @@ typedef tlog_grc (*tlog_json_reader_type_read_fn)(
                         struct tlog_json_reader *reader,
                         struct json_object **pobject);
 
+/**
+ * Message parsing function prototype.
+ *
+ * @param reader    The reader to operate on.
+ * @param msg       The message to parse the next message text into, void
+ *                  on end of stream, or on error. Can refer to the reader
+ *                  storage, and so must be cleaned up before the next read.
+ * @param filter    The filter to skip message texts not matching, without
+ *                  parsing them, with tlog_json_msg_text_may_match, or NULL
+ *                  to parse all messages.
+ *
+ * @return Global return code.
+ */
+typedef tlog_grc (*tlog_json_reader_type_read_msg_fn)(
+                        struct tlog_json_reader *reader,
+                        struct tlog_json_msg *msg,
+                        const struct tlog_json_msg_filter *filter);
+
 /**
  * Cleanup function prototype.
  *
@@ -117,6 +137,11 @@ struct tlog_json_reader_type {
     tlog_json_reader_type_loc_fmt_fn    loc_fmt;
     /** Reading function */
     tlog_json_reader_type_read_fn       read;
+    /**
+     * Message parsing function, parsing the message text directly,
+     * or NULL, if messages should be parsed from the objects read
+     */
+    tlog_json_reader_type_read_msg_fn   read_msg;
     /** Cleanup function */
     tlog_json_reader_type_cleanup_fn    cleanup;
 };
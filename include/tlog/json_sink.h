@@ -35,6 +35,14 @@
 /** Minimum value of data chunk size */
 #define TLOG_JSON_SINK_CHUNK_SIZE_MIN   TLOG_JSON_CHUNK_SIZE_MIN
 
+/** Rate limit of an I/O stream */
+struct tlog_json_sink_budget {
+    /** Average data rate, bytes per second, zero for unlimited */
+    size_t                      rate;
+    /** Maximum data burst size, bytes */
+    size_t                      burst;
+};
+
 /** JSON sink creation parameters */
 struct tlog_json_sink_params {
     /** JSON log message writer */
@@ -56,6 +64,33 @@ struct tlog_json_sink_params {
     unsigned int                session_id;
     /** Maximum data chunk length */
     size_t                      chunk_size;
+    /**
+     * Number of chunks to fill and write in rotation. If zero or one,
+     * each full chunk is written before the next one fills. Otherwise
+     * full chunks are written on a separate thread, while the next one
+     * keeps receiving data. The first failure to write them is then
+     * reported by the next cut or flush, the latter waiting for all the
+     * messages to be written, or by a write filling the next chunk.
+     */
+    size_t                      chunk_num;
+    /**
+     * Input rate limit. Input exceeding it is not logged, and the number
+     * of bytes throttled is logged in the "in_throttled" field instead.
+     */
+    struct tlog_json_sink_budget    input_budget;
+    /**
+     * Output rate limit. Output exceeding it is not logged, and the number
+     * of bytes throttled is logged in the "out_throttled" field instead.
+     * Bytes throttled since the last message are reported on flush, in a
+     * message without data, if necessary. Bytes are counted against
+     * either limit only once they're written to the chunk.
+     */
+    struct tlog_json_sink_budget    output_budget;
+    /**
+     * True if each message should report the reason it was written for in
+     * the "flush" field: "full", "request", "idle", or "latency".
+     */
+    bool                        report_flush;
 };
 
 /**
@@ -68,9 +103,65 @@ struct tlog_json_sink_params {
 extern bool tlog_json_sink_params_is_valid(
                             const struct tlog_json_sink_params *params);
 
+/**
+ * Parts of a message written by a JSON sink, in the order they're passed
+ * to the writer, with one I/O vector element each. Writers can use them
+ * to locate the I/O data in the messages.
+ */
+enum tlog_json_sink_msg_part {
+    /** Constant fields, up to the "id" value */
+    TLOG_JSON_SINK_MSG_PART_PREFIX,
+    /** The id, pos, time and optional fields, up to the "timing" value */
+    TLOG_JSON_SINK_MSG_PART_FIELDS,
+    /** The "timing" value */
+    TLOG_JSON_SINK_MSG_PART_TIMING,
+    /** Syntax before the "in_txt" value, the start of the I/O data */
+    TLOG_JSON_SINK_MSG_PART_IN_TXT_SEP,
+    /** The "in_txt" value */
+    TLOG_JSON_SINK_MSG_PART_IN_TXT,
+    /** Syntax before the "in_bin" value */
+    TLOG_JSON_SINK_MSG_PART_IN_BIN_SEP,
+    /** The "in_bin" value, without brackets */
+    TLOG_JSON_SINK_MSG_PART_IN_BIN,
+    /** Syntax before the "out_txt" value */
+    TLOG_JSON_SINK_MSG_PART_OUT_TXT_SEP,
+    /** The "out_txt" value */
+    TLOG_JSON_SINK_MSG_PART_OUT_TXT,
+    /** Syntax before the "out_bin" value */
+    TLOG_JSON_SINK_MSG_PART_OUT_BIN_SEP,
+    /** The "out_bin" value, without brackets */
+    TLOG_JSON_SINK_MSG_PART_OUT_BIN,
+    /** Syntax ending the message */
+    TLOG_JSON_SINK_MSG_PART_END,
+    /** Number of parts (not a valid part itself) */
+    TLOG_JSON_SINK_MSG_PART_NUM
+};
+
+/**
+ * Calculate the number of terminal output bytes carried by a message
+ * written by a JSON sink.
+ *
+ * @param iov   The message parts, TLOG_JSON_SINK_MSG_PART_NUM elements.
+ *
+ * @return The number of output bytes in the message.
+ */
+extern size_t tlog_json_sink_msg_output_size(const struct iovec *iov);
+
 /** JSON sink type */
 extern const struct tlog_sink_type tlog_json_sink_type;
 
+/**
+ * Count the bytes of a JSON sink's buffer memory, which are resident in
+ * memory, i.e. not given back to the system since the last flush.
+ *
+ * @param sink      The JSON sink to count the memory of.
+ * @param president Location for the number of resident bytes.
+ *
+ * @return Global return code.
+ */
+extern tlog_grc tlog_json_sink_resident_size(const struct tlog_sink *sink,
+                                             size_t *president);
+
 /**
  * Create (allocate and initialize) a JSON log sink.
  *
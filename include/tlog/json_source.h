@@ -36,6 +36,12 @@
 /** Minimum length of I/O data buffer used in packets */
 #define TLOG_JSON_SOURCE_IO_SIZE_MIN TLOG_JSON_MSG_IO_SIZE_MIN
 
+/**
+ * Maximum number of packets read from a JSON source in one batch, each
+ * using its own I/O data buffer
+ */
+#define TLOG_JSON_SOURCE_BATCH_SIZE 16
+
 /** JSON source type */
 extern const struct tlog_source_type tlog_json_source_type;
 
@@ -72,7 +78,7 @@ struct tlog_json_source_params {
      * message is detected, if false.
      */
     bool                        lax;
-    /** Size of I/O data buffer used in packets */
+    /** Size of I/O data buffer used in each packet */
     size_t                      io_size;
 };
 
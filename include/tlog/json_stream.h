@@ -40,40 +40,44 @@
 /** Minimum stream's text/binary buffer size */
 #define TLOG_JSON_STREAM_SIZE_MIN    32
 
-/** Stream transaction store */
+/** Alignment of the stream state, a common cache line size */
+#define TLOG_JSON_STREAM_ALIGN      64
+
+/**
+ * Stream state changed by writes, and its transaction store, copied as a
+ * whole. The write cursors, the runs and the timestamp go first, to fill
+ * the cache line the state is aligned to, the UTF-8 filter goes after.
+ */
 TLOG_TRX_BASIC_STORE_SIG(tlog_json_stream) {
-    struct tlog_utf8    utf8;           /**< UTF-8 filter */
-    struct timespec     ts;             /**< Character end timestamp */
-    size_t              txt_run;        /**< Text input run in characters */
-    size_t              txt_dig;        /**< Text output run digit limit */
     size_t              txt_len;        /**< Text output length in bytes */
+    size_t              bin_len;        /**< Binary output length in bytes */
+    size_t              txt_run;        /**< Text input run in characters */
     size_t              bin_run;        /**< Binary input run in bytes */
+    size_t              txt_dig;        /**< Text output run digit limit */
     size_t              bin_dig;        /**< Binary output run digit limit */
-    size_t              bin_len;        /**< Binary output length in bytes */
+    struct timespec     ts;             /**< Character end timestamp */
+    struct tlog_utf8    utf8;           /**< UTF-8 filter */
 };
 
 /** I/O stream */
 struct tlog_json_stream {
     struct tlog_json_dispatcher    *dispatcher; /**< Dispatcher to use */
 
+    TLOG_TRX_BASIC_STORE_SIG(tlog_json_stream)
+                        state
+                        __attribute__((aligned(TLOG_JSON_STREAM_ALIGN)));
+                                        /**< State changed by writes */
+
     size_t              size;           /**< Text/binary encoded
                                              buffer size */
 
-    struct tlog_utf8    utf8;           /**< UTF-8 filter */
-    struct timespec     ts;             /**< Character end timestamp */
-
     uint8_t             valid_mark;     /**< Valid text record marker */
     uint8_t             invalid_mark;   /**< Invalid text record marker */
 
-    uint8_t            *txt_buf;        /**< Encoded text buffer */
-    size_t              txt_run;        /**< Text input run in characters */
-    size_t              txt_dig;        /**< Text output run digit limit */
-    size_t              txt_len;        /**< Text output length in bytes */
-
-    uint8_t            *bin_buf;        /**< Encoded binary buffer */
-    size_t              bin_run;        /**< Binary input run in bytes */
-    size_t              bin_dig;        /**< Binary output run digit limit */
-    size_t              bin_len;        /**< Binary output length in bytes */
+    uint8_t            *txt_buf;        /**< Encoded text buffer,
+                                             not owned */
+    uint8_t            *bin_buf;        /**< Encoded binary buffer,
+                                             not owned */
 
     struct tlog_trx_iface   trx_iface;          /**< Transaction interface */
     TLOG_TRX_BASIC_MEMBERS(tlog_json_stream);   /**< Transaction data */
@@ -85,15 +89,17 @@ struct tlog_json_stream {
  * @param stream        The stream to initialize.
  * @param dispatcher    The dispatcher to use.
  * @param size          Text/binary buffer size.
+ * @param txt_buf       Text buffer of the size, owned by the caller.
+ * @param bin_buf       Binary buffer of the size, owned by the caller.
  * @param valid_mark    Valid UTF-8 record marker character.
  * @param invalid_mark  Invalid UTF-8 record marker character.
- *
- * @return Global return code.
  */
-extern tlog_grc tlog_json_stream_init(
+extern void tlog_json_stream_init(
                             struct tlog_json_stream *stream,
                             struct tlog_json_dispatcher *dispatcher,
                             size_t size,
+                            uint8_t *txt_buf,
+                            uint8_t *bin_buf,
                             uint8_t valid_mark,
                             uint8_t invalid_mark);
 
@@ -172,7 +178,8 @@ extern bool tlog_json_stream_cut(tlog_trx_state trx,
 extern void tlog_json_stream_empty(struct tlog_json_stream *stream);
 
 /**
- * Cleanup a stream. Can be called repeatedly.
+ * Cleanup a stream, detaching it from its buffers. Can be called
+ * repeatedly.
  *
  * @param stream    The stream to cleanup.
  */
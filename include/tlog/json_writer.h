@@ -78,6 +78,56 @@ extern tlog_grc tlog_json_writer_write(struct tlog_json_writer *writer,
                                        size_t id,
                                        const uint8_t *buf, size_t len);
 
+/**
+ * Write a message assembled from several buffers with a writer, without
+ * copying them together first, if the writer type supports that.
+ * Atomic, i.e. always writes everything, or nothing,
+ * unless an error beside EINTR occurs.
+ *
+ * @param writer    The writer to write with.
+ * @param id        ID of the message in the buffers. Cannot be zero.
+ * @param iov       The array of buffers making up the message, in order.
+ * @param iovcnt    The number of buffers in the array.
+ *
+ * @return Global return code.
+ *         Can return TLOG_GRC_FROM(errno, EINTR), if writing was interrupted
+ *         by a signal before anything was written.
+ */
+extern tlog_grc tlog_json_writer_writev(struct tlog_json_writer *writer,
+                                        size_t id,
+                                        const struct iovec *iov,
+                                        int iovcnt);
+
+/**
+ * Write a message formatted by a JSON sink with a writer, letting the
+ * writer type locate the fields and the I/O data in it, if it needs to.
+ * Atomic, i.e. always writes everything, or nothing,
+ * unless an error beside EINTR occurs.
+ *
+ * @param writer    The writer to write with.
+ * @param id        ID of the message in the buffers. Cannot be zero.
+ * @param iov       The array of message parts, one per
+ *                  enum tlog_json_sink_msg_part value, in order.
+ *
+ * @return Global return code.
+ *         Can return TLOG_GRC_FROM(errno, EINTR), if writing was interrupted
+ *         by a signal before anything was written.
+ */
+extern tlog_grc tlog_json_writer_write_msg(struct tlog_json_writer *writer,
+                                           size_t id,
+                                           const struct iovec *iov);
+
+/**
+ * Flush a writer, i.e. write out any messages it buffered.
+ *
+ * @param writer    The writer to flush.
+ *
+ * @return Global return code.
+ *         Can return TLOG_GRC_FROM(errno, EINTR), if flushing was
+ *         interrupted by a signal.
+ */
+extern tlog_grc tlog_json_writer_flush(struct tlog_json_writer *writer);
+
 /**
  * Cleanup and deallocate a writer.
  *
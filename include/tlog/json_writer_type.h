@@ -31,6 +31,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <sys/uio.h>
 #include <tlog/grc.h>
 
 /* Forward declaration */
@@ -79,6 +80,61 @@ typedef tlog_grc (*tlog_json_writer_type_write_fn)(
                                 const uint8_t *buf,
                                 size_t len);
 
+/**
+ * Vectored message writing function prototype.
+ * Atomic, i.e. always writes everything, or nothing,
+ * unless an error beside EINTR occurs.
+ *
+ * @param writer    The writer to operate on.
+ * @param id        ID of the message in the buffers. Cannot be zero.
+ * @param iov       The array of buffers making up the message, in order.
+ * @param iovcnt    The number of buffers in the array.
+ *
+ * @return Global return code.
+ *         Can return TLOG_GRC_FROM(errno, EINTR), if writing was interrupted
+ *         by a signal before anything was written.
+ */
+typedef tlog_grc (*tlog_json_writer_type_writev_fn)(
+                                struct tlog_json_writer *writer,
+                                size_t id,
+                                const struct iovec *iov,
+                                int iovcnt);
+
+/**
+ * JSON sink message writing function prototype.
+ * Like the vectored writing function, but the buffers are the parts of a
+ * message formatted by a JSON sink, one per enum tlog_json_sink_msg_part
+ * value, so the writer can locate the fields and the I/O data in it.
+ * Atomic, i.e. always writes everything, or nothing,
+ * unless an error beside EINTR occurs.
+ *
+ * @param writer    The writer to operate on.
+ * @param id        ID of the message in the buffers. Cannot be zero.
+ * @param iov       The array of message parts, TLOG_JSON_SINK_MSG_PART_NUM
+ *                  elements.
+ *
+ * @return Global return code.
+ *         Can return TLOG_GRC_FROM(errno, EINTR), if writing was interrupted
+ *         by a signal before anything was written.
+ */
+typedef tlog_grc (*tlog_json_writer_type_write_msg_fn)(
+                                struct tlog_json_writer *writer,
+                                size_t id,
+                                const struct iovec *iov);
+
+/**
+ * Flushing function prototype.
+ * Write out any messages buffered by the writer.
+ *
+ * @param writer    The writer to operate on.
+ *
+ * @return Global return code.
+ *         Can return TLOG_GRC_FROM(errno, EINTR), if flushing was
+ *         interrupted by a signal.
+ */
+typedef tlog_grc (*tlog_json_writer_type_flush_fn)(
+                                struct tlog_json_writer *writer);
+
 /**
  * Cleanup function prototype.
  *
@@ -93,6 +149,13 @@ struct tlog_json_writer_type {
     tlog_json_writer_type_init_fn      init;       /**< Init function */
     tlog_json_writer_type_is_valid_fn  is_valid;   /**< Validation function */
     tlog_json_writer_type_write_fn     write;      /**< Writing function */
+    tlog_json_writer_type_writev_fn    writev;     /**< Vectored writing
+                                                        function, optional */
+    tlog_json_writer_type_write_msg_fn write_msg;  /**< JSON sink message
+                                                        writing function,
+                                                        optional */
+    tlog_json_writer_type_flush_fn     flush;      /**< Flushing function,
+                                                        optional */
     tlog_json_writer_type_cleanup_fn   cleanup;    /**< Cleanup function */
 };
 
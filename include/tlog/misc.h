@@ -31,6 +31,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <unistd.h>
+#include <sys/uio.h>
 #include <tlog/errs.h>
 #include <tlog/grc.h>
 
@@ -91,6 +92,59 @@ tlog_size_digits(size_t n)
     return d;
 }
 
+/** Maximum number of decimal digits in a uint64_t number */
+#define TLOG_UINT64_DIGITS_MAX  20
+
+/**
+ * Format a uint64_t number as decimal digits, without terminating zero,
+ * two digits at a time.
+ *
+ * @param buf   The buffer to output to, must have space for at least
+ *              TLOG_UINT64_DIGITS_MAX bytes.
+ * @param n     The number to format.
+ *
+ * @return Number of digits output.
+ */
+extern size_t tlog_uint64_fmt(char *buf, uint64_t n);
+
+/**
+ * Release the memory pages lying entirely within a buffer back to the
+ * system, discarding their contents. The buffer stays usable: the pages
+ * are allocated again, zero-filled, once accessed.
+ *
+ * @param ptr   The buffer to release the pages of.
+ * @param len   Length of the buffer.
+ */
+extern void tlog_release_pages(void *ptr, size_t len);
+
+/**
+ * Count the bytes of the memory pages lying entirely within a buffer,
+ * which are resident in memory.
+ *
+ * @param ptr       The buffer to count the resident pages of.
+ * @param len       Length of the buffer.
+ * @param president Location for the number of resident bytes.
+ *
+ * @return Global return code.
+ */
+extern tlog_grc tlog_resident_size(const void *ptr, size_t len,
+                                   size_t *president);
+
+/**
+ * Write buffers to a file descriptor with as few calls as possible.
+ * Atomic, i.e. always writes everything, or nothing,
+ * unless an error beside EINTR occurs.
+ *
+ * @param fd        The file descriptor to write to.
+ * @param iov       The array of buffers to write.
+ * @param iovcnt    The number of buffers in the array.
+ *
+ * @return Global return code.
+ *         Can return TLOG_GRC_FROM(errno, EINTR), if writing was interrupted
+ *         by a signal before anything was written.
+ */
+extern tlog_grc tlog_writev(int fd, const struct iovec *iov, int iovcnt);
+
 /**
  * Retrieve an absolute path to a file either in the build tree, if possible,
  * and if running from the build tree, or at the installed location.
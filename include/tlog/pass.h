@@ -0,0 +1,164 @@
+/**
+ * @file
+ * @brief Terminal data pass-through.
+ *
+ * A pass-through moves data from one FD to another without copying it to
+ * the user space, by splicing it through a pipe with splice(2). Used for
+ * terminal data which is not logged. Falls back to reading and writing
+ * via a buffer, if either FD doesn't support splicing.
+ */
+/*
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TLOG_PASS_H
+#define _TLOG_PASS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <tlog/grc.h>
+
+/**
+ * Maximum number of bytes to move at once, the same as the TTY source reads
+ * at once.
+ */
+#define TLOG_PASS_SIZE  4096
+
+/**
+ * Maximum number of bytes to move per run, while more data is available,
+ * the default capacity of a pipe.
+ */
+#define TLOG_PASS_BURST (16 * TLOG_PASS_SIZE)
+
+/** Pass-through state */
+struct tlog_pass {
+    int         in_fd;          /**< FD to read data from,
+                                     negative if void */
+    int         out_fd;         /**< FD to write data to */
+    int         out_flags;      /**< Output FD status flags to restore on
+                                     cleanup, negative if not changed */
+    bool        out_wait;       /**< True if waiting for the output FD to
+                                     accept the data in place, false if
+                                     it is made non-blocking and watched
+                                     with the epoll FD */
+    int         epoll_fd;       /**< Epoll FD watching the input FD, or
+                                     the output FD, while it doesn't
+                                     accept the data read */
+    bool        out_watched;    /**< True if the epoll FD is watching
+                                     the output FD */
+    int         pipe_fd[2];     /**< Pipe to splice the data through,
+                                     negative FDs if not splicing */
+    size_t      len;            /**< Number of bytes in the pipe, or in
+                                     the buffer, left to write */
+    size_t      pos;            /**< Offset of the bytes left to write
+                                     in the buffer */
+    uint8_t    *buf;            /**< Buffer to copy the data through,
+                                     if not splicing, NULL otherwise */
+};
+
+/** A void pass-through state initializer */
+#define TLOG_PASS_VOID \
+    (struct tlog_pass) {            \
+        .in_fd      = -1,           \
+        .out_fd     = -1,           \
+        .out_flags  = -1,           \
+        .epoll_fd   = -1,           \
+        .pipe_fd    = {-1, -1},     \
+    }
+
+/**
+ * Initialize a pass-through.
+ *
+ * @param pass      The pass-through to initialize.
+ * @param in_fd     FD to read data from, must support epoll(7), or the
+ *                  initialization fails with EPERM.
+ * @param out_fd    FD to write data to.
+ * @param out_wait  True if runs should wait for the output FD to accept
+ *                  the data, e.g. when its reader doesn't depend on the
+ *                  caller, false if the rest should be kept, and the
+ *                  pass-through FD should wait for the output FD instead.
+ *                  In the latter case the output FD is made non-blocking
+ *                  until cleanup, which affects any FDs sharing its open
+ *                  file description.
+ *
+ * @return Global return code.
+ */
+extern tlog_grc tlog_pass_init(struct tlog_pass *pass,
+                               int in_fd, int out_fd, bool out_wait);
+
+/**
+ * Check if a pass-through is void.
+ *
+ * @param pass  The pass-through to check.
+ *
+ * @return True if the pass-through is void, false otherwise.
+ */
+static inline bool
+tlog_pass_is_void(const struct tlog_pass *pass)
+{
+    return pass->in_fd < 0;
+}
+
+/**
+ * Check if a pass-through is valid.
+ *
+ * @param pass  The pass-through to check.
+ *
+ * @return True if the pass-through is valid, false otherwise.
+ */
+extern bool tlog_pass_is_valid(const struct tlog_pass *pass);
+
+/**
+ * Get a file descriptor of a pass-through, which becomes readable when
+ * the pass-through is ready to run, for waiting on it together with other
+ * file descriptors, e.g. with epoll(7).
+ *
+ * @param pass  The pass-through to get the file descriptor of, must not
+ *              be void.
+ *
+ * @return The file descriptor.
+ */
+extern int tlog_pass_get_fd(const struct tlog_pass *pass);
+
+/**
+ * Move the data available on the input FD of a pass-through to its output
+ * FD, up to TLOG_PASS_BURST bytes, to keep up with the other end writing
+ * faster than the input is read at once. If the output FD doesn't accept
+ * all of the data, and the pass-through isn't waiting for it, keep the
+ * rest, whether spliced or copied, and wait for the output FD to accept
+ * it on the next runs, instead of reading more. Should be called once the
+ * pass-through FD is ready.
+ *
+ * @param pass  The pass-through to run, must not be void.
+ * @param peof  Location for the flag set to true, if the input FD has
+ *              reached the end of file, and to false otherwise.
+ *
+ * @return Global return code.
+ */
+extern tlog_grc tlog_pass_run(struct tlog_pass *pass, bool *peof);
+
+/**
+ * Cleanup a pass-through, making it void. Leaves the input and output FDs
+ * open, restoring the output FD blocking mode, if changed.
+ *
+ * @param pass  The pass-through to cleanup.
+ */
+extern void tlog_pass_cleanup(struct tlog_pass *pass);
+
+#endif /* _TLOG_PASS_H */
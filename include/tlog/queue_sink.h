@@ -0,0 +1,109 @@
+/**
+ * @file
+ * @brief Queueing sink.
+ *
+ * Queueing sink accepts packets, copies them into a bounded queue and
+ * returns immediately. The queued packets, cuts and flushes are then
+ * replayed in order to a "below" sink on a separate thread, so a slow
+ * encoder or writer doesn't delay the caller. The action taken when the
+ * queue is full is configurable: the caller can wait for the queue to
+ * drain, the packet data can be discarded, with only its size passed on
+ * for the "below" sink to report, or spilled to a temporary file.
+ */
+/*
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TLOG_QUEUE_SINK_H
+#define _TLOG_QUEUE_SINK_H
+
+#include <assert.h>
+#include <tlog/sink.h>
+
+/** Queue overflow action */
+enum tlog_queue_sink_overflow {
+    /** Wait until the queue has room for the packet */
+    TLOG_QUEUE_SINK_OVERFLOW_BLOCK,
+    /**
+     * Discard the packet data, and have the "below" sink account for its
+     * size, once the queue drains up to it
+     */
+    TLOG_QUEUE_SINK_OVERFLOW_DROP,
+    /** Store the packet in a temporary file, until the queue drains */
+    TLOG_QUEUE_SINK_OVERFLOW_SPILL,
+    /** Number of actions (not a valid action itself) */
+    TLOG_QUEUE_SINK_OVERFLOW_NUM
+};
+
+/**
+ * Check if a queue overflow action is valid.
+ *
+ * @param overflow  The overflow action to check.
+ *
+ * @return True if the action is valid, false otherwise.
+ */
+static inline bool
+tlog_queue_sink_overflow_is_valid(enum tlog_queue_sink_overflow overflow)
+{
+    return overflow < TLOG_QUEUE_SINK_OVERFLOW_NUM;
+}
+
+/** Queueing sink type */
+extern const struct tlog_sink_type tlog_queue_sink_type;
+
+/**
+ * Create (allocate and initialize) a queueing sink.
+ *
+ * @param psink         Location for created sink pointer, set to NULL
+ *                      in case of error.
+ * @param below         The "below" sink to replay the queued operations to.
+ * @param below_owned   True if the "below" sink should be destroyed when
+ *                      the created queueing sink is destroyed.
+ * @param size          Maximum size of the queued packet data, bytes.
+ * @param overflow      The action to take when a packet doesn't fit into
+ *                      the queue.
+ *
+ * @return Global return code.
+ */
+static inline tlog_grc
+tlog_queue_sink_create(struct tlog_sink **psink,
+                       struct tlog_sink *below, bool below_owned,
+                       size_t size,
+                       enum tlog_queue_sink_overflow overflow)
+{
+    assert(psink != NULL);
+    assert(tlog_sink_is_valid(below));
+    assert(size > 0);
+    assert(tlog_queue_sink_overflow_is_valid(overflow));
+    return tlog_sink_create(psink, &tlog_queue_sink_type,
+                            below, below_owned, size, overflow);
+}
+
+/**
+ * Wait until all the operations queued in a queueing sink are replayed to
+ * the "below" sink, and return the result.
+ *
+ * @param sink  The queueing sink to drain.
+ *
+ * @return Global return code of the first failed replayed operation, if
+ *         any, or TLOG_RC_OK.
+ */
+extern tlog_grc tlog_queue_sink_drain(struct tlog_sink *sink);
+
+#endif /* _TLOG_QUEUE_SINK_H */
@@ -47,6 +47,7 @@ typedef enum tlog_rc {
     TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_TIMING,
     TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_TXT,
     TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_BIN,
+    TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_ELIDED,
     TLOG_RC_FD_JSON_READER_INCOMPLETE_LINE,
     TLOG_RC_JSON_SOURCE_MSG_ID_OUT_OF_ORDER,
     TLOG_RC_JSON_SOURCE_PKT_TS_OUT_OF_ORDER,
@@ -54,6 +55,8 @@ typedef enum tlog_rc {
     TLOG_RC_ES_JSON_READER_CURL_INIT_FAILED,
     TLOG_RC_ES_JSON_READER_REPLY_INVALID,
     TLOG_RC_MEM_JSON_READER_INCOMPLETE_LINE,
+    TLOG_RC_RL_SHARED_SEG_UNTRUSTED,
+    TLOG_RC_RL_JSON_WRITER_MSG_TOO_LARGE,
     /* Return code upper boundary (not a valid return code) */
     TLOG_RC_MAX_PLUS_ONE
 } tlog_rc;
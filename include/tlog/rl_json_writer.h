@@ -8,7 +8,13 @@
  * passes, then the message is written to the "below" writer. If it fails the
  * check, then, depending on creation parameters, it is either discarded and
  * the writer reports success, or the write to the "below" writer is delayed
- * until the message conforms to the rate and the burst threshold.
+ * until the message conforms to the rate and the burst threshold, or the
+ * message is put into a bounded backlog, which is written to the "below"
+ * writer on a separate thread, as the rate allows, or the output data is
+ * elided from the message, and the rest is written. With the latter two
+ * actions, a part of the limit is reserved for the messages carrying input
+ * or window changes, so those get through a flood of output. Messages can
+ * additionally be limited by a budget shared with other processes.
  */
 /*
  * Copyright (C) 2017 Red Hat
@@ -35,6 +41,136 @@
 
 #include <assert.h>
 #include <tlog/json_writer.h>
+#include <tlog/rl_shared.h>
+
+/** Action to take on messages exceeding the rate limit */
+enum tlog_rl_json_writer_action {
+    /** Delay writing until the message fits */
+    TLOG_RL_JSON_WRITER_ACTION_DELAY,
+    /**
+     * Discard the message, counting it in the "dropped_msgs" field of the
+     * next message written by a JSON sink. Messages written by a JSON sink
+     * and carrying input or window changes have their output elided
+     * instead, and are limited with the reserve, see
+     * tlog_rl_json_writer_params.reserve.
+     */
+    TLOG_RL_JSON_WRITER_ACTION_DROP,
+    /**
+     * Put the message into the backlog, to be written in background.
+     * The rest of the backlog is written out without limits, when the
+     * writer is destroyed.
+     */
+    TLOG_RL_JSON_WRITER_ACTION_BACKLOG,
+    /**
+     * Elide the output data of the message, keeping the input, the
+     * metadata and timing, and recording the number of elided output bytes
+     * in the "elided" field. The degraded message is limited as usual, with
+     * the reserve, if it carries input or window changes. Messages not
+     * written by a JSON sink, and degraded messages exceeding the rate
+     * limit still, are discarded, as with the "drop" action.
+     */
+    TLOG_RL_JSON_WRITER_ACTION_DEGRADE,
+    /** Number of actions (not a valid action itself) */
+    TLOG_RL_JSON_WRITER_ACTION_NUM
+};
+
+/**
+ * Check if a rate-limiting action is valid.
+ *
+ * @param action    The action to check.
+ *
+ * @return True if the action is valid, false otherwise.
+ */
+static inline bool
+tlog_rl_json_writer_action_is_valid(enum tlog_rl_json_writer_action action)
+{
+    return action < TLOG_RL_JSON_WRITER_ACTION_NUM;
+}
+
+/** Backlog eviction policy */
+enum tlog_rl_json_writer_evict {
+    /** Evict the oldest messages to make space for the new one */
+    TLOG_RL_JSON_WRITER_EVICT_OLDEST,
+    /** Discard the new message */
+    TLOG_RL_JSON_WRITER_EVICT_NEWEST,
+    /** Number of policies (not a valid policy itself) */
+    TLOG_RL_JSON_WRITER_EVICT_NUM
+};
+
+/**
+ * Check if a backlog eviction policy is valid.
+ *
+ * @param evict     The policy to check.
+ *
+ * @return True if the policy is valid, false otherwise.
+ */
+static inline bool
+tlog_rl_json_writer_evict_is_valid(enum tlog_rl_json_writer_evict evict)
+{
+    return evict < TLOG_RL_JSON_WRITER_EVICT_NUM;
+}
+
+/** Rate-limiting writer creation parameters */
+struct tlog_rl_json_writer_params {
+    /** The "below" writer to write messages to */
+    struct tlog_json_writer            *below;
+    /**
+     * True if the "below" writer should be destroyed when the created
+     * rate limit writer is destroyed
+     */
+    bool                                below_owned;
+    /**
+     * ID of the clock to use to calculate message rate and to delay
+     * messages
+     */
+    clockid_t                           clock_id;
+    /** Average message data rate, bytes per second */
+    size_t                              rate;
+    /** Maximum message burst size, bytes */
+    size_t                              burst;
+    /** Action to take on messages exceeding the rate limit */
+    enum tlog_rl_json_writer_action     action;
+    /**
+     * Percentage of the rate and burst limits reserved for the messages
+     * written by a JSON sink, carrying input or window changes, with their
+     * output elided, for "drop" and "degrade" actions. Other messages are
+     * limited to the rest. Not more than 100.
+     */
+    unsigned int                        reserve;
+    /**
+     * Maximum size of the backlog messages, bytes, for "backlog" action.
+     * Writing a larger message fails with
+     * TLOG_RC_RL_JSON_WRITER_MSG_TOO_LARGE.
+     */
+    size_t                              backlog;
+    /** Backlog eviction policy, for "backlog" action */
+    enum tlog_rl_json_writer_evict      evict;
+    /**
+     * Budget shared with other processes to limit messages with as well,
+     * or NULL for none. Destroyed with the created writer.
+     */
+    struct tlog_rl_shared              *shared;
+};
+
+/**
+ * Check if rate-limiting writer creation parameters structure is valid.
+ *
+ * @param params    The parameters structure to check.
+ *
+ * @return True if the parameters structure is valid, false otherwise.
+ */
+static inline bool
+tlog_rl_json_writer_params_is_valid(
+                    const struct tlog_rl_json_writer_params *params)
+{
+    return params != NULL &&
+           tlog_json_writer_is_valid(params->below) &&
+           tlog_rl_json_writer_action_is_valid(params->action) &&
+           params->reserve <= 100 &&
+           tlog_rl_json_writer_evict_is_valid(params->evict) &&
+           (params->shared == NULL ||
+            tlog_rl_shared_is_valid(params->shared));
+}
 
 /** Rate-limiting JSON message writer type */
 extern const struct tlog_json_writer_type tlog_rl_json_writer_type;
@@ -42,31 +178,19 @@ extern const struct tlog_json_writer_type tlog_rl_json_writer_type;
 /**
  * Create an instance of rate-limiting writer.
  *
- * @param pwriter       Location for the pointer to the created writer.
- * @param below         The "below" writer to write messages to.
- * @param below_owned   True if the "below" writer should be destroyed when
- *                      the created rate limit writer is destroyed.
- * @param clock_id      ID of the clock to use to calculate message rate and
- *                      to delay messages.
- * @param rate          Average message data rate, bytes per second.
- * @param burst         Maximum message burst size, bytes.
- * @param drop          False if writing a message exceeding maximum rate
- *                      should be delayed until it fits, true if the message
- *                      should be discarded instead.
+ * @param pwriter   Location for the pointer to the created writer.
+ * @param params    Creation parameters structure.
  *
  * @return Global return code.
  */
 static inline tlog_grc
 tlog_rl_json_writer_create(struct tlog_json_writer **pwriter,
-                           struct tlog_json_writer *below, bool below_owned,
-                           clockid_t clock_id,
-                           size_t rate, size_t burst, bool drop)
+                           const struct tlog_rl_json_writer_params *params)
 {
     assert(pwriter != NULL);
-    assert(tlog_json_writer_is_valid(below));
+    assert(tlog_rl_json_writer_params_is_valid(params));
     return tlog_json_writer_create(pwriter, &tlog_rl_json_writer_type,
-                                   below, below_owned, clock_id,
-                                   rate, burst, drop);
+                                   params);
 }
 
 #endif /* _TLOG_RL_JSON_WRITER_H */
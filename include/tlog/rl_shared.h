@@ -0,0 +1,172 @@
+/**
+ * @file
+ * @brief Shared rate-limiting budget.
+ *
+ * A rate-limiting budget shared by all the processes opening it by the same
+ * name, kept in a POSIX shared memory segment. The budget is a "leaky
+ * bucket", tracked as its "theoretical arrival time" on the monotonic clock,
+ * and updated with atomic compare-and-swap, without locking. Each process
+ * can additionally be limited to an equal share of the budget, counting the
+ * live processes by their PIDs, kept in the segment.
+ *
+ * The segment is accessible only to its owner, and only a segment owned by
+ * the effective user, and not accessible to anyone else, is trusted, so
+ * only the processes running with the same effective user share a budget.
+ */
+/*
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TLOG_RL_SHARED_H
+#define _TLOG_RL_SHARED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+#include <tlog/grc.h>
+
+/**
+ * Format of the name of the shared memory segment of the host-wide budget,
+ * of the processes running with the same effective user
+ */
+#define TLOG_RL_SHARED_NAME_HOST_FMT    "/tlog-rl-host-%u"
+
+/** Format of the name of the shared memory segment of a per-user budget */
+#define TLOG_RL_SHARED_NAME_USER_FMT    "/tlog-rl-%u"
+
+/** Policy of sharing the budget between the processes */
+enum tlog_rl_shared_fairness {
+    /** Let any process use all the budget available */
+    TLOG_RL_SHARED_FAIRNESS_NONE,
+    /** Limit each process to an equal share of the budget */
+    TLOG_RL_SHARED_FAIRNESS_EQUAL,
+    /** Number of policies (not a valid policy itself) */
+    TLOG_RL_SHARED_FAIRNESS_NUM
+};
+
+/**
+ * Check if a budget sharing policy is valid.
+ *
+ * @param fairness  The policy to check.
+ *
+ * @return True if the policy is valid, false otherwise.
+ */
+static inline bool
+tlog_rl_shared_fairness_is_valid(enum tlog_rl_shared_fairness fairness)
+{
+    return fairness < TLOG_RL_SHARED_FAIRNESS_NUM;
+}
+
+/** Shared memory segment contents */
+struct tlog_rl_shared_seg;
+
+/** Shared rate-limiting budget */
+struct tlog_rl_shared {
+    /** The mapped shared memory segment */
+    struct tlog_rl_shared_seg      *seg;
+    /** Time to pour one byte in at the rate, nanoseconds */
+    double                          byte_ns;
+    /** Bucket limit (rate + burst), as time to pour it in, nanoseconds */
+    uint64_t                        limit_ns;
+    /** Budget sharing policy */
+    enum tlog_rl_shared_fairness    fairness;
+    /**
+     * Theoretical arrival time of this process' share of the bucket, for
+     * the "equal" policy, nanoseconds
+     */
+    uint64_t                        own_tat;
+    /** PID of this process */
+    pid_t                           pid;
+    /** Index of the segment slot taken by this process, if any */
+    size_t                          slot;
+    /** Number of processes having the budget open, as counted last */
+    uint64_t                        users;
+    /** Monotonic clock time the processes were counted at, nanoseconds */
+    uint64_t                        users_time;
+};
+
+/**
+ * Open a shared rate-limiting budget, creating its shared memory segment,
+ * if it doesn't exist.
+ *
+ * @param pshared   Location for the opened budget pointer, set to NULL in
+ *                  case of error.
+ * @param name      Name of the shared memory segment, as for shm_open(3),
+ *                  or NULL to create a budget private to the process.
+ * @param rate      Average message data rate, bytes per second.
+ * @param burst     Maximum message burst size, bytes.
+ * @param fairness  Budget sharing policy.
+ *
+ * @return Global return code, TLOG_RC_RL_SHARED_SEG_UNTRUSTED, if the
+ *         segment exists, but is not owned by the effective user, or is
+ *         accessible to anyone else.
+ */
+extern tlog_grc tlog_rl_shared_create(struct tlog_rl_shared **pshared,
+                                      const char *name,
+                                      size_t rate, size_t burst,
+                                      enum tlog_rl_shared_fairness fairness);
+
+/**
+ * Check if a shared rate-limiting budget is valid.
+ *
+ * @param shared    The budget to check.
+ *
+ * @return True if the budget is valid, false otherwise.
+ */
+extern bool tlog_rl_shared_is_valid(const struct tlog_rl_shared *shared);
+
+/**
+ * Take message bytes out of a shared rate-limiting budget, if they fit.
+ * Messages exceeding the burst limit fit into an empty bucket.
+ *
+ * @param shared    The budget to take from.
+ * @param len       Number of bytes to take.
+ * @param ptaken    Location for the flag set to true if the bytes fit
+ *                  and were taken, and to false otherwise.
+ * @param pdelay    Location for the time to wait before the bytes would
+ *                  fit, if they don't fit now.
+ *
+ * @return Global return code.
+ */
+extern tlog_grc tlog_rl_shared_take(struct tlog_rl_shared *shared,
+                                    size_t len, bool *ptaken,
+                                    struct timespec *pdelay);
+
+/**
+ * Take message bytes out of a shared rate-limiting budget, whether they
+ * fit or not, exhausting the budget at most.
+ *
+ * @param shared    The budget to take from.
+ * @param len       Number of bytes to take.
+ *
+ * @return Global return code.
+ */
+extern tlog_grc tlog_rl_shared_force(struct tlog_rl_shared *shared,
+                                     size_t len);
+
+/**
+ * Close a shared rate-limiting budget, leaving its shared memory segment
+ * to the other processes.
+ *
+ * @param shared    The budget to close, can be NULL.
+ */
+extern void tlog_rl_shared_destroy(struct tlog_rl_shared *shared);
+
+#endif /* _TLOG_RL_SHARED_H */
@@ -83,6 +83,49 @@ extern tlog_grc tlog_sink_write(struct tlog_sink *sink,
                                 struct tlog_pkt_pos *ppos,
                                 const struct tlog_pkt_pos *end);
 
+/**
+ * Write a batch of packets to a sink, in order. Sinks without batch
+ * writing support write one packet at a time.
+ *
+ * @param sink      Pointer to the sink to write the packets to.
+ * @param pkt_list  The list of packets to write, none void.
+ * @param pkt_num   Number of packets in the list.
+ * @param pidx      Location of the index of the packet the write should
+ *                  start at (set to zero at the start) / location for the
+ *                  index of the packet the write ended at, pkt_num, if all
+ *                  were written. If NULL, then write will be started from
+ *                  the list beginning and retried until all the packets
+ *                  are written, or an error other than EINTR is
+ *                  encountered.
+ * @param ppos      Location of position in the packet the write should
+ *                  start at (set to TLOG_PKT_POS_VOID at the start) /
+ *                  location for position in the packet the write ended at.
+ *                  Must be NULL if, and only if, pidx is NULL.
+ *
+ * @return Global return code.
+ *         Can return TLOG_GRC_FROM(errno, EINTR), if pidx wasn't NULL, and
+ *         writing was interrupted by a signal before anything was written.
+ */
+extern tlog_grc tlog_sink_write_batch(struct tlog_sink *sink,
+                                      const struct tlog_pkt *pkt_list,
+                                      size_t pkt_num,
+                                      size_t *pidx,
+                                      struct tlog_pkt_pos *ppos);
+
+/**
+ * Account for I/O data dropped before reaching a sink, e.g. by a full
+ * queue, so the sink can report it.
+ *
+ * @param sink  The sink to account the dropped data in.
+ * @param pkt   An I/O packet standing for the dropped data. Only its
+ *              timestamps, stream, and length are used, the buffer can be
+ *              NULL.
+ *
+ * @return Global return code.
+ */
+extern tlog_grc tlog_sink_drop(struct tlog_sink *sink,
+                               const struct tlog_pkt *pkt);
+
 /**
  * Cut a sink I/O - encode pending incomplete characters.
  *
@@ -97,13 +140,16 @@ extern tlog_grc tlog_sink_cut(struct tlog_sink *sink);
 /**
  * Flush data pending in a log sink.
  *
- * @param sink  The sink to flush.
+ * @param sink      The sink to flush.
+ * @param reason    The reason for flushing, to be reported by the sink,
+ *                  if it can.
  *
  * @return Global return code.
  *         Can return TLOG_GRC_FROM(errno, EINTR), if writing was attempted
  *         and interrupted by a signal before anything was written.
  */
-extern tlog_grc tlog_sink_flush(struct tlog_sink *sink);
+extern tlog_grc tlog_sink_flush(struct tlog_sink *sink,
+                                enum tlog_sink_flush_reason reason);
 
 /**
  * Close I/O fd of a tty sink.
@@ -37,6 +37,34 @@
 /* Forward declaration */
 struct tlog_sink;
 
+/** Alignment of sink instances, enough for cache-line-aligned members */
+#define TLOG_SINK_ALIGN 64
+
+/** Reason for flushing a sink */
+enum tlog_sink_flush_reason {
+    /** Flush explicitly requested, e.g. at the end of recording */
+    TLOG_SINK_FLUSH_REASON_REQUEST,
+    /** I/O was idle for the configured time */
+    TLOG_SINK_FLUSH_REASON_IDLE,
+    /** Data was pending for the maximum configured time */
+    TLOG_SINK_FLUSH_REASON_LATENCY,
+    /** Number of reasons (not a valid reason itself) */
+    TLOG_SINK_FLUSH_REASON_NUM
+};
+
+/**
+ * Check if a sink flushing reason is valid.
+ *
+ * @param reason    The reason to check.
+ *
+ * @return True if the reason is valid, false otherwise.
+ */
+static inline bool
+tlog_sink_flush_reason_is_valid(enum tlog_sink_flush_reason reason)
+{
+    return reason < TLOG_SINK_FLUSH_REASON_NUM;
+}
+
 /**
  * Init function prototype.
  *
@@ -76,6 +104,43 @@ typedef tlog_grc (*tlog_sink_type_write_fn)(struct tlog_sink *sink,
                                             struct tlog_pkt_pos *ppos,
                                             const struct tlog_pkt_pos *end);
 
+/**
+ * Packet batch writing function prototype.
+ *
+ * @param sink      Pointer to the sink to write the packets to.
+ * @param pkt_list  The list of packets to write.
+ * @param pkt_num   Number of packets in the list.
+ * @param pidx      Location of the index of the packet the write should
+ *                  start at / location for the index of the packet the
+ *                  write ended at, pkt_num, if all were written.
+ * @param ppos      Location of position in the packet the write should
+ *                  start at (TLOG_PKT_POS_VOID at the packet start) /
+ *                  location for position in the packet the write ended at.
+ *
+ * @return Global return code.
+ *         Can return TLOG_GRC_FROM(errno, EINTR), if writing was interrupted
+ *         by a signal before anything was written.
+ */
+typedef tlog_grc (*tlog_sink_type_write_batch_fn)(
+                                        struct tlog_sink *sink,
+                                        const struct tlog_pkt *pkt_list,
+                                        size_t pkt_num,
+                                        size_t *pidx,
+                                        struct tlog_pkt_pos *ppos);
+
+/**
+ * Dropped I/O accounting function prototype.
+ *
+ * @param sink  The sink to account the dropped I/O in.
+ * @param pkt   An I/O packet standing for the data dropped before reaching
+ *              the sink. Only its timestamps, stream, and length are
+ *              meaningful, the buffer is not.
+ *
+ * @return Global return code.
+ */
+typedef tlog_grc (*tlog_sink_type_drop_fn)(struct tlog_sink *sink,
+                                           const struct tlog_pkt *pkt);
+
 /**
  * I/O-cutting function prototype.
  *
@@ -88,11 +153,14 @@ typedef tlog_grc (*tlog_sink_type_cut_fn)(struct tlog_sink *sink);
 /**
  * Data-flushing function prototype.
  *
- * @param sink  The sink to flush.
+ * @param sink      The sink to flush.
+ * @param reason    The reason for flushing.
  *
  * @return Global return code.
  */
-typedef tlog_grc (*tlog_sink_type_flush_fn)(struct tlog_sink *sink);
+typedef tlog_grc (*tlog_sink_type_flush_fn)(
+                            struct tlog_sink *sink,
+                            enum tlog_sink_flush_reason reason);
 
 /**
  * IO Close function prototype.
@@ -116,6 +184,14 @@ struct tlog_sink_type {
     tlog_sink_type_init_fn      init;       /**< Init function */
     tlog_sink_type_is_valid_fn  is_valid;   /**< Validation function */
     tlog_sink_type_write_fn     write;      /**< Writing function */
+    tlog_sink_type_write_batch_fn
+                                write_batch;    /**< Batch writing
+                                                     function, NULL to
+                                                     write one packet at
+                                                     a time */
+    tlog_sink_type_drop_fn      drop;       /**< Dropped I/O accounting
+                                                 function, NULL to ignore
+                                                 dropped I/O */
     tlog_sink_type_cut_fn       cut;        /**< I/O-cutting function */
     tlog_sink_type_flush_fn     flush;      /**< Flushing function */
     tlog_sink_type_io_close_fn  io_close;   /**< I/O-close function */
@@ -96,6 +96,28 @@ extern char *tlog_source_loc_fmt(const struct tlog_source *source,
 extern tlog_grc tlog_source_read(struct tlog_source *source,
                                  struct tlog_pkt *pkt);
 
+/**
+ * Read a batch of packets from the source: as many as the source has
+ * readily available, up to the list size, but at least one, unless at the
+ * end-of-stream. Sources without batch reading support read one packet.
+ *
+ * Packet data can be referenced from the source, and is only guaranteed
+ * to stay valid until the next read.
+ *
+ * @param source    The source to read from.
+ * @param pkt_list  The list of void packets to write the received data
+ *                  into, will be void in case of error.
+ * @param pkt_size  Number of packets in the list, greater than zero.
+ * @param ppkt_num  Location for the number of packets read, zero on
+ *                  end-of-stream. Not modified in case of error.
+ *
+ * @return Global return code.
+ */
+extern tlog_grc tlog_source_read_batch(struct tlog_source *source,
+                                       struct tlog_pkt *pkt_list,
+                                       size_t pkt_size,
+                                       size_t *ppkt_num);
+
 /**
  * Destroy (cleanup and free) a log source.
  *
@@ -93,6 +93,24 @@ typedef char * (*tlog_source_type_loc_fmt_fn)(
 typedef tlog_grc (*tlog_source_type_read_fn)(struct tlog_source *source,
                                              struct tlog_pkt *pkt);
 
+/**
+ * Packet batch reading function prototype.
+ *
+ * @param source    The source to operate on.
+ * @param pkt_list  The list of void packets to write the received data
+ *                  into, will be void in case of error.
+ * @param pkt_size  Number of packets in the list, greater than zero.
+ * @param ppkt_num  Location for the number of packets read, zero on
+ *                  end-of-stream. Not modified in case of error.
+ *
+ * @return Global return code.
+ */
+typedef tlog_grc (*tlog_source_type_read_batch_fn)(
+                                        struct tlog_source *source,
+                                        struct tlog_pkt *pkt_list,
+                                        size_t pkt_size,
+                                        size_t *ppkt_num);
+
 /**
  * Cleanup function prototype.
  *
@@ -110,6 +128,10 @@ struct tlog_source_type {
     tlog_source_type_loc_fmt_fn     loc_fmt;    /**< Location formatting
                                                      function */
     tlog_source_type_read_fn        read;       /**< Reading function */
+    tlog_source_type_read_batch_fn  read_batch; /**< Batch reading
+                                                     function, NULL to
+                                                     read one packet
+                                                     at a time */
     tlog_source_type_cleanup_fn     cleanup;    /**< Cleanup function */
 };
 
@@ -1,9 +1,12 @@
 /**
  * @file
- * @brief Syslog JSON message writer
+ * @brief Syslog JSON message writer.
  *
- * An implementation of a JSON log message writer which sends messages to
- * syslog.
+ * An implementation of a JSON log message writer which sends messages to a
+ * local syslog socket directly, without going through syslog(3). The
+ * constant parts of the message header are rendered once, the timestamp
+ * once per second, and a batch of messages can be sent with a single
+ * sendmmsg(2) call, when the writer is flushed.
  */
 /*
  * Copyright (C) 2015 Red Hat
@@ -32,13 +35,71 @@
 #include <tlog/syslog_misc.h>
 #include <assert.h>
 
+/** Default path of the syslog socket */
+#define TLOG_SYSLOG_JSON_WRITER_PATH_DEFAULT    "/dev/log"
+
+/** Syslog message format */
+enum tlog_syslog_json_writer_format {
+    /** BSD syslog format, as produced by syslog(3) */
+    TLOG_SYSLOG_JSON_WRITER_FORMAT_RFC3164,
+    /** The syslog protocol format */
+    TLOG_SYSLOG_JSON_WRITER_FORMAT_RFC5424,
+    /** Number of formats (not a valid format itself) */
+    TLOG_SYSLOG_JSON_WRITER_FORMAT_NUM
+};
+
 /**
- * Syslog message writer type
+ * Check if a syslog message format is valid.
  *
- * Creation arguments:
+ * @param format    The format to check.
  *
- * int  priority    The "priority" argument to pass to syslog(3).
+ * @return True if the format is valid, false otherwise.
  */
+static inline bool
+tlog_syslog_json_writer_format_is_valid(
+                            enum tlog_syslog_json_writer_format format)
+{
+    return format < TLOG_SYSLOG_JSON_WRITER_FORMAT_NUM;
+}
+
+/** Syslog writer creation parameters */
+struct tlog_syslog_json_writer_params {
+    /** Syslog facility, as for openlog(3) */
+    int                                 facility;
+    /** Syslog priority, as for syslog(3) */
+    int                                 priority;
+    /** Message format */
+    enum tlog_syslog_json_writer_format format;
+    /**
+     * Path to the local syslog socket, NULL for
+     * TLOG_SYSLOG_JSON_WRITER_PATH_DEFAULT
+     */
+    const char                         *path;
+    /**
+     * Maximum number of messages to collect before sending them,
+     * zero or one to send each message as soon as it arrives
+     */
+    size_t                              batch;
+};
+
+/**
+ * Check if syslog writer creation parameters structure is valid.
+ *
+ * @param params    The parameters structure to check.
+ *
+ * @return True if the parameters structure is valid, false otherwise.
+ */
+static inline bool
+tlog_syslog_json_writer_params_is_valid(
+                    const struct tlog_syslog_json_writer_params *params)
+{
+    return params != NULL &&
+           tlog_syslog_facility_is_valid(params->facility) &&
+           tlog_syslog_priority_is_valid(params->priority) &&
+           tlog_syslog_json_writer_format_is_valid(params->format);
+}
+
+/** Syslog message writer type */
 extern const struct tlog_json_writer_type tlog_syslog_json_writer_type;
 
 /**
@@ -46,18 +107,19 @@ extern const struct tlog_json_writer_type tlog_syslog_json_writer_type;
  *
  * @param pwriter   Location for the created writer pointer, will be set to
  *                  NULL in case of error.
- * @param priority  The "priority" argument to pass to syslog(3).
+ * @param params    Creation parameters structure.
  *
  * @return Global return code.
  */
 static inline tlog_grc
 tlog_syslog_json_writer_create(struct tlog_json_writer **pwriter,
-                               int priority)
+                               const struct tlog_syslog_json_writer_params
+                                                                *params)
 {
     assert(pwriter != NULL);
-    assert(tlog_syslog_priority_is_valid(priority));
+    assert(tlog_syslog_json_writer_params_is_valid(params));
     return tlog_json_writer_create(pwriter, &tlog_syslog_json_writer_type,
-                                   priority);
+                                   params);
 }
 
 #endif /* _TLOG_SYSLOG_JSON_WRITER_H */
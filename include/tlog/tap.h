@@ -29,6 +29,7 @@
 
 #include <tlog/grc.h>
 #include <tlog/errs.h>
+#include <tlog/pass.h>
 #include <termios.h>
 #include <unistd.h>
 #include <time.h>
@@ -36,6 +37,11 @@
 #include <utempter.h>
 #endif
 
+/** Pass the input through to the program, instead of the source */
+#define TLOG_TAP_PASS_IN    (1 << 0)
+/** Pass the program output through, instead of the source */
+#define TLOG_TAP_PASS_OUT   (1 << 1)
+
 /** I/O tap state */
 struct tlog_tap {
     pid_t               pid;            /**< Shell PID */
@@ -47,6 +53,10 @@ struct tlog_tap {
     struct termios      termios_orig;   /**< Original terminal attributes */
     bool                termios_set;    /**< True if terminal attributes were
                                              changed from the original */
+    struct tlog_pass    in_pass;        /**< Input pass-through, void if the
+                                             source reads the input */
+    struct tlog_pass    out_pass;       /**< Output pass-through, void if the
+                                             source reads the output */
 };
 
 /** A void I/O tap state initializer */
@@ -57,6 +67,8 @@ struct tlog_tap {
         .in_fd  = -1,   \
         .out_fd = -1,   \
         .tty_fd = -1,   \
+        .in_pass    = TLOG_PASS_VOID,   \
+        .out_pass   = TLOG_PASS_VOID,   \
     }
 
 /**
@@ -72,6 +84,10 @@ struct tlog_tap {
  * @param in_fd     Stdin to connect to, or -1 if none.
  * @param out_fd    Stdout to connect to, or -1 if none.
  * @param err_fd    Stderr to connect to, or -1 if none.
+ * @param pass      Pass-through options: a bitmask of TLOG_TAP_PASS_*
+ *                  bits, selecting the streams to pass through, instead
+ *                  of reading them with the source. Only streams which
+ *                  can be waited for are passed through.
  * @param clock_id  Clock to use for timestamps.
  *
  * @return Global return code.
@@ -82,7 +98,7 @@ extern tlog_grc tlog_tap_setup(struct tlog_errs **perrs,
                                unsigned int opts,
                                const char *path, char **argv,
                                int in_fd, int out_fd, int err_fd,
-                               clockid_t clock_id);
+                               unsigned int pass, clockid_t clock_id);
 
 /**
  * Teardown an I/O tap state.
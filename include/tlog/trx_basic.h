@@ -90,6 +90,19 @@ typedef unsigned int tlog_trx_basic_mask;
         }                                                   \
     } while (0)
 
+/**
+ * Act on transaction data of a member holding all of the object's
+ * transaction data, of the store type, copying it in one go
+ */
+#define TLOG_TRX_BASIC_ACT_ON_STORE(_name) \
+    do {                                                    \
+        if (act_type == TLOG_TRX_ACT_TYPE_BACKUP) {         \
+            *store = object->_name;                         \
+        } else if (act_type == TLOG_TRX_ACT_TYPE_RESTORE) { \
+            object->_name = *store;                         \
+        }                                                   \
+    } while (0)
+
 /** Act on transaction data of an embedded object member */
 #define TLOG_TRX_BASIC_ACT_ON_OBJ(_name) \
     object->_name.trx_iface.act(level, act_type, &object->_name)
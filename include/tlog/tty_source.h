@@ -34,6 +34,15 @@
 /** Minimum size of the I/O buffer */
 #define TLOG_TTY_SOURCE_IO_SIZE_MIN 32
 
+/**
+ * Maximum number of packets read from a TTY source on one wakeup:
+ * a window size change, input, and output. Batch reads return everything
+ * read on one wakeup, and wait for the next one only once all of it is
+ * returned. A batch of zero packets means nothing has changed on the
+ * wakeup, or all the I/O FDs are closed.
+ */
+#define TLOG_TTY_SOURCE_BATCH_SIZE  3
+
 /** TTY source type */
 extern const struct tlog_source_type tlog_tty_source_type;
 
@@ -65,4 +74,15 @@ tlog_tty_source_create(struct tlog_source **psource,
                               clock_id);
 }
 
+/**
+ * Get a file descriptor of a TTY source, which becomes readable when the
+ * source has I/O or a window change to read, for waiting on it together
+ * with other file descriptors, e.g. with epoll(7).
+ *
+ * @param source    The TTY source to get the file descriptor of.
+ *
+ * @return The file descriptor, owned by the source.
+ */
+extern int tlog_tty_source_get_fd(const struct tlog_source *source);
+
 #endif /* _TLOG_TTY_SOURCE_H */
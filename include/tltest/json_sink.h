@@ -28,10 +28,13 @@
 #define _TLTEST_JSON_SINK_H
 
 #include <tlog/pkt.h>
+#include <tlog/queue_sink.h>
+#include <tlog/json_sink.h>
 
 enum tltest_json_sink_op_type {
     TLTEST_JSON_SINK_OP_TYPE_NONE,
     TLTEST_JSON_SINK_OP_TYPE_WRITE,
+    TLTEST_JSON_SINK_OP_TYPE_DROP,
     TLTEST_JSON_SINK_OP_TYPE_FLUSH,
     TLTEST_JSON_SINK_OP_TYPE_CUT,
     TLTEST_JSON_SINK_OP_TYPE_NUM
@@ -44,6 +47,8 @@ struct tltest_json_sink_op {
     enum tltest_json_sink_op_type type;
     union {
         struct tlog_pkt write;
+        struct tlog_pkt drop;
+        enum tlog_sink_flush_reason flush;
     } data;
 };
 
@@ -57,9 +62,20 @@ struct tltest_json_sink_op {
         .data.write = _pkt                      \
     })
 
+#define TLTEST_JSON_SINK_OP_DROP(_pkt) \
+    ((struct tltest_json_sink_op){              \
+        .type = TLTEST_JSON_SINK_OP_TYPE_DROP,  \
+        .data.drop = _pkt                       \
+    })
+
 #define TLTEST_JSON_SINK_OP_FLUSH \
-    ((struct tltest_json_sink_op)                   \
-        {.type = TLTEST_JSON_SINK_OP_TYPE_FLUSH})
+    TLTEST_JSON_SINK_OP_FLUSH_REASON(TLOG_SINK_FLUSH_REASON_REQUEST)
+
+#define TLTEST_JSON_SINK_OP_FLUSH_REASON(_reason) \
+    ((struct tltest_json_sink_op){              \
+        .type = TLTEST_JSON_SINK_OP_TYPE_FLUSH, \
+        .data.flush = _reason                   \
+    })
 
 #define TLTEST_JSON_SINK_OP_CUT \
     ((struct tltest_json_sink_op)               \
@@ -72,6 +88,19 @@ struct tltest_json_sink_input {
     const char                 *terminal;
     unsigned int                session_id;
     size_t                      chunk_size;
+    /* Number of chunks to fill and write in rotation */
+    size_t                      chunk_num;
+    /* Input and output rate limits */
+    struct tlog_json_sink_budget
+                                input_budget;
+    struct tlog_json_sink_budget
+                                output_budget;
+    /* True if the flush reason should be reported in messages */
+    bool                        report_flush;
+    /* Size of the queue to put above the sink, zero for no queue */
+    size_t                      queue_size;
+    enum tlog_queue_sink_overflow
+                                queue_overflow;
     struct tltest_json_sink_op  op_list[16];
 };
 
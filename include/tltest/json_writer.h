@@ -0,0 +1,173 @@
+/**
+ * @file
+ * @brief Writer test functions.
+ *
+ * Functions and types for running operation lists against JSON writers,
+ * with writer-specific setup and read-back hooks.
+ */
+/*
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TLTEST_JSON_WRITER_H
+#define _TLTEST_JSON_WRITER_H
+
+#include <tlog/json_writer.h>
+#include <tlog/rc.h>
+
+/** Maximum length of the data read back from a tested writer */
+#define TLTEST_JSON_WRITER_BUF_SIZE 4096
+
+enum tltest_json_writer_op_type {
+    TLTEST_JSON_WRITER_OP_TYPE_NONE,
+    TLTEST_JSON_WRITER_OP_TYPE_WRITE,
+    TLTEST_JSON_WRITER_OP_TYPE_WRITE_MSG,
+    TLTEST_JSON_WRITER_OP_TYPE_SLEEP,
+    TLTEST_JSON_WRITER_OP_TYPE_FLUSH,
+    TLTEST_JSON_WRITER_OP_TYPE_CHECK,
+    TLTEST_JSON_WRITER_OP_TYPE_CUSTOM,
+    TLTEST_JSON_WRITER_OP_TYPE_NUM
+};
+
+extern const char *tltest_json_writer_op_type_to_str(
+                        enum tltest_json_writer_op_type type);
+
+struct tltest_json_writer_op {
+    enum tltest_json_writer_op_type type;
+    /**
+     * Message to write, "out_txt" value of the message to write as a JSON
+     * sink would, data expected to be read back, or custom operation
+     * argument
+     */
+    const char                     *str;
+    /** "timing" value of the message to write as a JSON sink would */
+    const char                     *timing;
+    /** "in_txt" value of the message to write as a JSON sink would */
+    const char                     *in_txt;
+    /** "out_bin" value of the message to write as a JSON sink would */
+    const char                     *bin;
+    /** Milliseconds to sleep */
+    long                            ms;
+    /** Expected result of the write */
+    tlog_grc                        exp_grc;
+};
+
+#define TLTEST_JSON_WRITER_OP_NONE \
+    ((struct tltest_json_writer_op){            \
+        .type = TLTEST_JSON_WRITER_OP_TYPE_NONE \
+    })
+
+#define TLTEST_JSON_WRITER_OP_WRITE_FAIL(_str, _exp_grc) \
+    ((struct tltest_json_writer_op){                \
+        .type = TLTEST_JSON_WRITER_OP_TYPE_WRITE,   \
+        .str = _str,                                \
+        .exp_grc = _exp_grc                         \
+    })
+
+#define TLTEST_JSON_WRITER_OP_WRITE(_str) \
+    TLTEST_JSON_WRITER_OP_WRITE_FAIL(_str, TLOG_RC_OK)
+
+/* Write a message with text input, split into parts as a JSON sink does */
+#define TLTEST_JSON_WRITER_OP_WRITE_MSG_IO(_timing, _in_txt, \
+                                           _out_txt, _out_bin) \
+    ((struct tltest_json_writer_op){                    \
+        .type = TLTEST_JSON_WRITER_OP_TYPE_WRITE_MSG,   \
+        .timing = _timing,                              \
+        .in_txt = _in_txt,                              \
+        .str = _out_txt,                                \
+        .bin = _out_bin                                 \
+    })
+
+/* Write a message with output only, split into parts as a JSON sink does */
+#define TLTEST_JSON_WRITER_OP_WRITE_MSG(_timing, _out_txt, _out_bin) \
+    TLTEST_JSON_WRITER_OP_WRITE_MSG_IO(_timing, "", _out_txt, _out_bin)
+
+#define TLTEST_JSON_WRITER_OP_SLEEP(_ms) \
+    ((struct tltest_json_writer_op){                \
+        .type = TLTEST_JSON_WRITER_OP_TYPE_SLEEP,   \
+        .ms = _ms                                   \
+    })
+
+#define TLTEST_JSON_WRITER_OP_FLUSH \
+    ((struct tltest_json_writer_op){                \
+        .type = TLTEST_JSON_WRITER_OP_TYPE_FLUSH    \
+    })
+
+#define TLTEST_JSON_WRITER_OP_CHECK(_str) \
+    ((struct tltest_json_writer_op){                \
+        .type = TLTEST_JSON_WRITER_OP_TYPE_CHECK,   \
+        .str = _str                                 \
+    })
+
+#define TLTEST_JSON_WRITER_OP_CUSTOM(_str) \
+    ((struct tltest_json_writer_op){                \
+        .type = TLTEST_JSON_WRITER_OP_TYPE_CUSTOM,  \
+        .str = _str                                 \
+    })
+
+/** Hooks adapting the harness to a particular writer type */
+struct tltest_json_writer_hooks {
+    /**
+     * Create the writer to test, and whatever is needed to read back what
+     * it writes. Exit on failure.
+     *
+     * @param params    Writer-specific test parameters.
+     * @param pdata     Location for the test state to pass to other hooks.
+     *
+     * @return The created writer.
+     */
+    struct tlog_json_writer *(*setup)(const void *params, void **pdata);
+    /**
+     * Read back what the writer wrote. Exit on failure.
+     *
+     * @param data  The test state.
+     * @param buf   The buffer to read into.
+     * @param size  The size of the buffer.
+     *
+     * @return The length of the data read.
+     */
+    size_t (*read)(void *data, char *buf, size_t size);
+    /**
+     * Execute a custom operation, NULL if none are supported.
+     *
+     * @param data  The test state.
+     * @param str   The operation argument.
+     *
+     * @return Global return code.
+     */
+    tlog_grc (*custom)(void *data, const char *str);
+    /**
+     * Free the test state, after the writer is destroyed.
+     *
+     * @param data  The test state.
+     */
+    void (*teardown)(void *data);
+};
+
+struct tltest_json_writer {
+    const void                     *params;
+    struct tltest_json_writer_op    op_list[16];
+    const char                     *exp_final;
+};
+
+extern bool tltest_json_writer(const char *file, int line, const char *name,
+                               const struct tltest_json_writer_hooks *hooks,
+                               const struct tltest_json_writer test);
+
+#endif /* _TLTEST_JSON_WRITER_H */
@@ -131,7 +131,7 @@ m4_define(
     `M4_TYPE_DOUBLE',
     `
         m4_printl(
-           `            if (type != json_type_double) {',
+           `            if (type != json_type_double && type != json_type_int) {',
            `                tlog_errs_pushf(perrs, "Invalid \"%s\" type: %s",',
            `                                name, json_type_to_name(type));',
            `                return TLOG_RC_FAILURE;',
@@ -25,8 +25,10 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <fcntl.h>
 #include <json_tokener.h>
 #include <tlog/fd_json_reader.h>
+#include <tlog/json_msg.h>
 #include <tlog/rc.h>
 
 /** FD reader data */
@@ -41,6 +43,9 @@ struct tlog_fd_json_reader {
     size_t                  size;       /**< Text buffer size */
     char                   *pos;        /**< Text buffer reading position */
     char                   *end;        /**< End of valid text buffer data */
+    char                   *line_buf;   /**< Buffer for message lines
+                                             crossing the text buffer end */
+    size_t                  line_size;  /**< Line buffer size */
 };
 
 static void
@@ -54,6 +59,8 @@ tlog_fd_json_reader_cleanup(struct tlog_json_reader *reader)
     }
     free(fd_json_reader->buf);
     fd_json_reader->buf = NULL;
+    free(fd_json_reader->line_buf);
+    fd_json_reader->line_buf = NULL;
 
     if (fd_json_reader->match != NULL) {
         free(fd_json_reader->match);
@@ -107,6 +114,9 @@ tlog_fd_json_reader_init(struct tlog_json_reader *reader, va_list ap)
     fd_json_reader->line = 1;
     fd_json_reader->pos = fd_json_reader->end = fd_json_reader->buf;
 
+    /* Ask for aggressive readahead, ignoring failure, e.g. for pipes */
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
     return TLOG_RC_OK;
 
 error:
@@ -240,20 +250,21 @@ static tlog_grc
 tlog_fd_json_reader_skip_line(struct tlog_fd_json_reader *fd_json_reader)
 {
     tlog_grc grc;
+    char *nl;
 
     assert(tlog_fd_json_reader_is_valid(
                     (struct tlog_json_reader *)fd_json_reader));
 
     /* Until EOF */
     do {
-        for (; fd_json_reader->pos < fd_json_reader->end;
-             fd_json_reader->pos++) {
-            if (*fd_json_reader->pos == '\n') {
-                fd_json_reader->pos++;
-                fd_json_reader->line++;
-                return TLOG_RC_OK;
-            }
+        nl = memchr(fd_json_reader->pos, '\n',
+                    fd_json_reader->end - fd_json_reader->pos);
+        if (nl != NULL) {
+            fd_json_reader->pos = nl + 1;
+            fd_json_reader->line++;
+            return TLOG_RC_OK;
         }
+        fd_json_reader->pos = fd_json_reader->end;
 
         grc = tlog_fd_json_reader_refill_buf(fd_json_reader);
         if (grc != TLOG_RC_OK) {
@@ -308,6 +319,9 @@ tlog_fd_json_reader_read_json(struct tlog_fd_json_reader *fd_json_reader,
     struct json_object *object;
     enum json_tokener_error jerr;
     bool got_text = false;
+    const struct tlog_json_msg_filter match_filter = {
+        .rec = fd_json_reader->match
+    };
 
     assert(tlog_fd_json_reader_is_valid(
                     (struct tlog_json_reader *)fd_json_reader));
@@ -319,14 +333,33 @@ tlog_fd_json_reader_read_json(struct tlog_fd_json_reader *fd_json_reader,
     do {
         /* If the buffer is not empty */
         if (fd_json_reader->pos < fd_json_reader->end) {
+            /* Look for a terminating newline */
+            p = memchr(fd_json_reader->pos, '\n',
+                       fd_json_reader->end - fd_json_reader->pos);
+            if (p == NULL) {
+                p = fd_json_reader->end;
+            }
+
+            /* Skip complete lines which can't match, without parsing */
+            if (!got_text && p < fd_json_reader->end &&
+                !tlog_json_msg_text_may_match(fd_json_reader->pos,
+                                              p - fd_json_reader->pos,
+                                              &match_filter)) {
+                fd_json_reader->pos = p;
+                grc = tlog_fd_json_reader_skip_line(fd_json_reader);
+                if (grc != TLOG_RC_OK) {
+                    return grc;
+                }
+                grc = tlog_fd_json_reader_skip_whitespace(fd_json_reader);
+                if (grc != TLOG_RC_OK) {
+                    return grc;
+                }
+                continue;
+            }
+
             /* We got something to parse */
             got_text = true;
 
-            /* Look for a terminating newline */
-            for (p = fd_json_reader->pos;
-                 p < fd_json_reader->end && *p != '\n';
-                 p++);
-
             /* Parse the next piece */
             object = json_tokener_parse_ex(fd_json_reader->tok,
                                            fd_json_reader->pos,
@@ -411,6 +444,162 @@ tlog_fd_json_reader_read(struct tlog_json_reader *reader,
     return read_grc;
 }
 
+/**
+ * Append text to the line buffer of an fd reader, growing it as needed.
+ *
+ * @param fd_json_reader    The fd reader to append to the line buffer of.
+ * @param len               Length of the text already in the line buffer.
+ * @param ptr               The text to append.
+ * @param add               Length of the text to append.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_fd_json_reader_line_append(struct tlog_fd_json_reader *fd_json_reader,
+                                size_t len, const char *ptr, size_t add)
+{
+    size_t size;
+    char *buf;
+
+    if (len + add > fd_json_reader->line_size) {
+        size = fd_json_reader->line_size * 2;
+        if (size < len + add) {
+            size = len + add;
+        }
+        buf = realloc(fd_json_reader->line_buf, size);
+        if (buf == NULL) {
+            return TLOG_GRC_ERRNO;
+        }
+        fd_json_reader->line_buf = buf;
+        fd_json_reader->line_size = size;
+    }
+    memcpy(fd_json_reader->line_buf + len, ptr, add);
+    return TLOG_RC_OK;
+}
+
+/**
+ * Read the next non-empty line of the fd reader text, consuming the
+ * terminating newline, if any. Refer to the line in the text buffer,
+ * if it's there completely, or collect it in the line buffer otherwise.
+ *
+ * @param fd_json_reader    The fd reader to read the line from.
+ * @param pline             Location for the line pointer, set to NULL on
+ *                          EOF. The line is valid until the next read.
+ * @param plen              Location for the line length, without the
+ *                          newline.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_fd_json_reader_read_line(struct tlog_fd_json_reader *fd_json_reader,
+                              char **pline, size_t *plen)
+{
+    tlog_grc grc;
+    char *nl;
+    size_t len = 0;
+
+    assert(tlog_fd_json_reader_is_valid(
+                    (struct tlog_json_reader *)fd_json_reader));
+    assert(pline != NULL);
+    assert(plen != NULL);
+
+    grc = tlog_fd_json_reader_skip_whitespace(fd_json_reader);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+    if (fd_json_reader->pos >= fd_json_reader->end) {
+        *pline = NULL;
+        return TLOG_RC_OK;
+    }
+
+    /* If the line is in the buffer completely */
+    nl = memchr(fd_json_reader->pos, '\n',
+                fd_json_reader->end - fd_json_reader->pos);
+    if (nl != NULL) {
+        *pline = fd_json_reader->pos;
+        *plen = nl - fd_json_reader->pos;
+        fd_json_reader->pos = nl + 1;
+        fd_json_reader->line++;
+        return TLOG_RC_OK;
+    }
+
+    /* Collect the line in the line buffer, until EOF */
+    do {
+        nl = memchr(fd_json_reader->pos, '\n',
+                    fd_json_reader->end - fd_json_reader->pos);
+        grc = tlog_fd_json_reader_line_append(
+                    fd_json_reader, len, fd_json_reader->pos,
+                    (nl == NULL ? fd_json_reader->end : nl) -
+                        fd_json_reader->pos);
+        if (grc != TLOG_RC_OK) {
+            return grc;
+        }
+        if (nl != NULL) {
+            len += nl - fd_json_reader->pos;
+            fd_json_reader->pos = nl + 1;
+            fd_json_reader->line++;
+            break;
+        }
+        len += fd_json_reader->end - fd_json_reader->pos;
+        fd_json_reader->pos = fd_json_reader->end;
+        grc = tlog_fd_json_reader_refill_buf(fd_json_reader);
+        if (grc != TLOG_RC_OK) {
+            return grc;
+        }
+    } while (fd_json_reader->end > fd_json_reader->buf);
+
+    *pline = fd_json_reader->line_buf;
+    *plen = len;
+    return TLOG_RC_OK;
+}
+
+static tlog_grc
+tlog_fd_json_reader_read_msg(struct tlog_json_reader *reader,
+                             struct tlog_json_msg *msg,
+                             const struct tlog_json_msg_filter *filter)
+{
+    struct tlog_fd_json_reader *fd_json_reader =
+                                (struct tlog_fd_json_reader*)reader;
+    const struct tlog_json_msg_filter match_filter = {
+        .rec = fd_json_reader->match
+    };
+    tlog_grc grc;
+    char *line;
+    size_t len;
+
+    while (true) {
+        grc = tlog_fd_json_reader_read_line(fd_json_reader, &line, &len);
+        if (grc != TLOG_RC_OK || line == NULL) {
+            tlog_json_msg_init(msg, NULL);
+            return grc;
+        }
+
+        /* Skip messages which can't match, without parsing */
+        if (!tlog_json_msg_text_may_match(line, len, &match_filter) ||
+            (filter != NULL &&
+             !tlog_json_msg_text_may_match(line, len, filter))) {
+            continue;
+        }
+
+        /* Parse the line in place */
+        grc = tlog_json_msg_init_text(msg, line, len);
+        if (grc == TLOG_GRC_FROM(json, json_tokener_continue)) {
+            return TLOG_RC_FD_JSON_READER_INCOMPLETE_LINE;
+        } else if (grc != TLOG_RC_OK) {
+            return grc;
+        }
+
+        /* Skip non-matching messages */
+        if (fd_json_reader->match != NULL && msg->rec != NULL &&
+            strcmp(msg->rec, fd_json_reader->match) != 0) {
+            tlog_json_msg_cleanup(msg);
+            continue;
+        }
+
+        return TLOG_RC_OK;
+    }
+}
+
 const struct tlog_json_reader_type tlog_fd_json_reader_type = {
     .size       = sizeof(struct tlog_fd_json_reader),
     .init       = tlog_fd_json_reader_init,
@@ -418,5 +607,6 @@ const struct tlog_json_reader_type tlog_fd_json_reader_type = {
     .loc_get    = tlog_fd_json_reader_loc_get,
     .loc_fmt    = tlog_fd_json_reader_loc_fmt,
     .read       = tlog_fd_json_reader_read,
+    .read_msg   = tlog_fd_json_reader_read_msg,
     .cleanup    = tlog_fd_json_reader_cleanup,
 };
@@ -20,9 +20,11 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <config.h>
 #include <unistd.h>
 #include <errno.h>
 #include <tlog/rc.h>
+#include <tlog/misc.h>
 #include <tlog/fd_json_writer.h>
 
 /** FD writer data */
@@ -82,9 +84,20 @@ tlog_fd_json_writer_write(struct tlog_json_writer *writer,
     }
 }
 
+static tlog_grc
+tlog_fd_json_writer_writev(struct tlog_json_writer *writer,
+                           size_t id, const struct iovec *iov, int iovcnt)
+{
+    struct tlog_fd_json_writer *fd_json_writer =
+                                    (struct tlog_fd_json_writer*)writer;
+    (void)id;
+    return tlog_writev(fd_json_writer->fd, iov, iovcnt);
+}
+
 const struct tlog_json_writer_type tlog_fd_json_writer_type = {
     .size       = sizeof(struct tlog_fd_json_writer),
     .init       = tlog_fd_json_writer_init,
     .write      = tlog_fd_json_writer_write,
+    .writev     = tlog_fd_json_writer_writev,
     .cleanup    = tlog_fd_json_writer_cleanup,
 };
@@ -0,0 +1,418 @@
+/*
+ * File message writer.
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <sys/uio.h>
+#include <tlog/rc.h>
+#include <tlog/timespec.h>
+#include <tlog/misc.h>
+#include <tlog/file_json_writer.h>
+
+/** Alignment of the batch buffer, bytes */
+#define TLOG_FILE_JSON_WRITER_ALIGN 4096
+
+/** File writer data */
+struct tlog_file_json_writer {
+    struct tlog_json_writer writer;     /**< Abstract writer instance */
+    int fd;                             /**< FD to write to */
+    bool fd_owned;                      /**< True if FD is owned */
+    enum tlog_file_json_writer_sync sync;   /**< Sync policy */
+    struct timespec interval;           /**< Sync interval */
+    size_t threshold;                   /**< Sync threshold, bytes */
+    size_t prealloc;                    /**< Preallocation size, bytes,
+                                             zero if disabled */
+    off_t prealloc_pos;                 /**< Position the next write
+                                             is expected at */
+    off_t prealloc_end;                 /**< End of the space
+                                             preallocated last */
+    uint8_t *batch_buf;                 /**< Batch buffer, NULL if
+                                             not batching */
+    size_t batch_size;                  /**< Batch buffer size */
+    size_t batch_len;                   /**< Batched data length */
+    size_t unsynced;                    /**< Number of bytes written
+                                             since last sync */
+    struct timespec last_sync;          /**< Last sync timestamp */
+};
+
+/**
+ * Synchronize the data written by a file writer to the storage device.
+ *
+ * @param file_json_writer  The writer to synchronize.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_file_json_writer_sync(struct tlog_file_json_writer *file_json_writer)
+{
+    if (fdatasync(file_json_writer->fd) < 0) {
+        /* If the FD doesn't support synchronization (e.g. a pipe) */
+        if (errno == EINVAL) {
+            file_json_writer->sync = TLOG_FILE_JSON_WRITER_SYNC_NEVER;
+        } else {
+            return TLOG_GRC_ERRNO;
+        }
+    }
+    file_json_writer->unsynced = 0;
+    if (file_json_writer->sync == TLOG_FILE_JSON_WRITER_SYNC_INTERVAL &&
+        clock_gettime(CLOCK_MONOTONIC, &file_json_writer->last_sync) < 0) {
+        return TLOG_GRC_ERRNO;
+    }
+    return TLOG_RC_OK;
+}
+
+/**
+ * Preallocate file space for the data about to be written, if enabled,
+ * and if not preallocated already.
+ *
+ * @param file_json_writer  The writer to preallocate space for.
+ * @param len               The length of the data about to be written.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_file_json_writer_prealloc(
+                        struct tlog_file_json_writer *file_json_writer,
+                        size_t len)
+{
+    off_t end;
+
+    if (file_json_writer->prealloc == 0) {
+        return TLOG_RC_OK;
+    }
+
+    /*
+     * Only look up the file end once our writes are expected to run out of
+     * the space preallocated last. If others append to the file too, our
+     * writes can go past that space before the lookup, which is harmless.
+     */
+    if (file_json_writer->prealloc_pos + (off_t)len <=
+            file_json_writer->prealloc_end) {
+        return TLOG_RC_OK;
+    }
+
+    /* The file is appended to, possibly by others, so find its end */
+    end = lseek(file_json_writer->fd, 0, SEEK_END);
+    if (end < 0) {
+        /* If the FD is not seekable (e.g. a pipe) */
+        if (errno == ESPIPE) {
+            file_json_writer->prealloc = 0;
+            return TLOG_RC_OK;
+        }
+        return TLOG_GRC_ERRNO;
+    }
+    file_json_writer->prealloc_pos = end;
+
+    if (end + (off_t)len <= file_json_writer->prealloc_end) {
+        return TLOG_RC_OK;
+    }
+
+    /* Reserve the space, keeping the file size for appends to work */
+    len = TLOG_MAX(file_json_writer->prealloc, len);
+    if (fallocate(file_json_writer->fd, FALLOC_FL_KEEP_SIZE,
+                  end, (off_t)len) < 0) {
+        /* If the file system or the FD don't support preallocation */
+        if (errno == EOPNOTSUPP || errno == ENOSYS || errno == ENODEV) {
+            file_json_writer->prealloc = 0;
+            return TLOG_RC_OK;
+        }
+        return TLOG_GRC_ERRNO;
+    }
+    file_json_writer->prealloc_end = end + (off_t)len;
+    return TLOG_RC_OK;
+}
+
+/**
+ * Write buffers to the file of a file writer with as few calls as
+ * possible, preallocating file space first, if enabled.
+ * Atomic, i.e. always writes everything, or nothing,
+ * unless an error beside EINTR occurs.
+ *
+ * @param file_json_writer  The writer to write with.
+ * @param iov               The array of buffers to write.
+ * @param iovcnt            The number of buffers in the array.
+ *
+ * @return Global return code.
+ *         Can return TLOG_GRC_FROM(errno, EINTR), if writing was interrupted
+ *         by a signal before anything was written.
+ */
+static tlog_grc
+tlog_file_json_writer_put(struct tlog_file_json_writer *file_json_writer,
+                          const struct iovec *iov, int iovcnt)
+{
+    tlog_grc grc;
+    size_t len = 0;
+    int i;
+
+    for (i = 0; i < iovcnt; i++) {
+        len += iov[i].iov_len;
+    }
+
+    grc = tlog_file_json_writer_prealloc(file_json_writer, len);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+
+    grc = tlog_writev(file_json_writer->fd, iov, iovcnt);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+
+    file_json_writer->prealloc_pos += (off_t)len;
+    file_json_writer->unsynced += len;
+    return TLOG_RC_OK;
+}
+
+/**
+ * Synchronize the data written by a file writer to the storage device, if
+ * any, and if it's due according to the "interval" or "bytes" policy.
+ *
+ * @param file_json_writer  The writer to synchronize.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_file_json_writer_sync_due(
+                        struct tlog_file_json_writer *file_json_writer)
+{
+    struct timespec now;
+    struct timespec elapsed;
+
+    if (file_json_writer->unsynced == 0) {
+        return TLOG_RC_OK;
+    }
+
+    switch (file_json_writer->sync) {
+    case TLOG_FILE_JSON_WRITER_SYNC_INTERVAL:
+        if (clock_gettime(CLOCK_MONOTONIC, &now) < 0) {
+            return TLOG_GRC_ERRNO;
+        }
+        tlog_timespec_sub(&now, &file_json_writer->last_sync, &elapsed);
+        if (tlog_timespec_cmp(&elapsed, &file_json_writer->interval) >= 0) {
+            return tlog_file_json_writer_sync(file_json_writer);
+        }
+        break;
+    case TLOG_FILE_JSON_WRITER_SYNC_BYTES:
+        if (file_json_writer->unsynced >= file_json_writer->threshold) {
+            return tlog_file_json_writer_sync(file_json_writer);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return TLOG_RC_OK;
+}
+
+/**
+ * Write out the batched messages of a file writer, if any.
+ *
+ * @param file_json_writer  The writer to write out the batch of.
+ *
+ * @return Global return code.
+ *         Can return TLOG_GRC_FROM(errno, EINTR), if writing was interrupted
+ *         by a signal before anything was written.
+ */
+static tlog_grc
+tlog_file_json_writer_put_batch(
+                        struct tlog_file_json_writer *file_json_writer)
+{
+    tlog_grc grc;
+    struct iovec iov;
+
+    if (file_json_writer->batch_len == 0) {
+        return TLOG_RC_OK;
+    }
+
+    iov.iov_base = file_json_writer->batch_buf;
+    iov.iov_len = file_json_writer->batch_len;
+    grc = tlog_file_json_writer_put(file_json_writer, &iov, 1);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+    file_json_writer->batch_len = 0;
+
+    return tlog_file_json_writer_sync_due(file_json_writer);
+}
+
+static void
+tlog_file_json_writer_cleanup(struct tlog_json_writer *writer)
+{
+    struct tlog_file_json_writer *file_json_writer =
+                                    (struct tlog_file_json_writer*)writer;
+
+    /* Make an effort to write out the data, the errors can't be reported */
+    tlog_file_json_writer_put_batch(file_json_writer);
+    if (file_json_writer->sync != TLOG_FILE_JSON_WRITER_SYNC_NEVER &&
+        file_json_writer->unsynced > 0) {
+        tlog_file_json_writer_sync(file_json_writer);
+    }
+
+    free(file_json_writer->batch_buf);
+    file_json_writer->batch_buf = NULL;
+    if (file_json_writer->fd_owned) {
+        close(file_json_writer->fd);
+        file_json_writer->fd_owned = false;
+    }
+}
+
+static tlog_grc
+tlog_file_json_writer_init(struct tlog_json_writer *writer, va_list ap)
+{
+    struct tlog_file_json_writer *file_json_writer =
+                                    (struct tlog_file_json_writer*)writer;
+    const struct tlog_file_json_writer_params *params =
+                    va_arg(ap, const struct tlog_file_json_writer_params *);
+    int rc;
+
+    assert(tlog_file_json_writer_params_is_valid(params));
+
+    file_json_writer->sync = params->sync;
+    file_json_writer->interval.tv_sec = params->interval / 1000;
+    file_json_writer->interval.tv_nsec =
+                            (long)(params->interval % 1000) * 1000000;
+    file_json_writer->threshold = params->threshold;
+    file_json_writer->prealloc = params->prealloc;
+
+    if (params->batch > 0) {
+        file_json_writer->batch_size = params->batch;
+        rc = posix_memalign((void **)&file_json_writer->batch_buf,
+                            TLOG_FILE_JSON_WRITER_ALIGN,
+                            file_json_writer->batch_size);
+        if (rc != 0) {
+            file_json_writer->batch_buf = NULL;
+            return TLOG_GRC_FROM(errno, rc);
+        }
+    }
+
+    if (file_json_writer->sync == TLOG_FILE_JSON_WRITER_SYNC_INTERVAL &&
+        clock_gettime(CLOCK_MONOTONIC, &file_json_writer->last_sync) < 0) {
+        free(file_json_writer->batch_buf);
+        file_json_writer->batch_buf = NULL;
+        return TLOG_GRC_ERRNO;
+    }
+
+    /* Take over the FD last, so it's not closed on failure */
+    file_json_writer->fd = params->fd;
+    file_json_writer->fd_owned = params->fd_owned;
+    return TLOG_RC_OK;
+}
+
+static bool
+tlog_file_json_writer_is_valid(const struct tlog_json_writer *writer)
+{
+    struct tlog_file_json_writer *file_json_writer =
+                                    (struct tlog_file_json_writer*)writer;
+    return file_json_writer != NULL &&
+           file_json_writer->fd >= 0 &&
+           tlog_file_json_writer_sync_is_valid(file_json_writer->sync) &&
+           tlog_timespec_is_valid(&file_json_writer->interval) &&
+           (file_json_writer->batch_buf != NULL ||
+            file_json_writer->batch_size == 0) &&
+           file_json_writer->batch_len <= file_json_writer->batch_size;
+}
+
+static tlog_grc
+tlog_file_json_writer_writev(struct tlog_json_writer *writer,
+                             size_t id, const struct iovec *iov, int iovcnt)
+{
+    struct tlog_file_json_writer *file_json_writer =
+                                    (struct tlog_file_json_writer*)writer;
+    tlog_grc grc;
+    size_t len = 0;
+    int i;
+
+    (void)id;
+
+    for (i = 0; i < iovcnt; i++) {
+        len += iov[i].iov_len;
+    }
+
+    /* Write out the batch, if the message doesn't fit */
+    if (file_json_writer->batch_len + len > file_json_writer->batch_size) {
+        grc = tlog_file_json_writer_put_batch(file_json_writer);
+        if (grc != TLOG_RC_OK) {
+            return grc;
+        }
+    }
+
+    /* Write the message directly, if it doesn't fit an empty batch */
+    if (len > file_json_writer->batch_size) {
+        grc = tlog_file_json_writer_put(file_json_writer, iov, iovcnt);
+        if (grc != TLOG_RC_OK) {
+            return grc;
+        }
+        return tlog_file_json_writer_sync_due(file_json_writer);
+    }
+
+    /* Add the message to the batch */
+    for (i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len > 0) {
+            memcpy(file_json_writer->batch_buf + file_json_writer->batch_len,
+                   iov[i].iov_base, iov[i].iov_len);
+            file_json_writer->batch_len += iov[i].iov_len;
+        }
+    }
+    return TLOG_RC_OK;
+}
+
+static tlog_grc
+tlog_file_json_writer_write(struct tlog_json_writer *writer,
+                            size_t id, const uint8_t *buf, size_t len)
+{
+    struct iovec iov = {.iov_base = (void *)buf, .iov_len = len};
+    return tlog_file_json_writer_writev(writer, id, &iov, 1);
+}
+
+static tlog_grc
+tlog_file_json_writer_flush(struct tlog_json_writer *writer)
+{
+    struct tlog_file_json_writer *file_json_writer =
+                                    (struct tlog_file_json_writer*)writer;
+    tlog_grc grc;
+
+    grc = tlog_file_json_writer_put_batch(file_json_writer);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+
+    if (file_json_writer->sync == TLOG_FILE_JSON_WRITER_SYNC_FLUSH &&
+        file_json_writer->unsynced > 0) {
+        return tlog_file_json_writer_sync(file_json_writer);
+    }
+    /* Catch up with the interval, if nothing was written since it passed */
+    return tlog_file_json_writer_sync_due(file_json_writer);
+}
+
+const struct tlog_json_writer_type tlog_file_json_writer_type = {
+    .size       = sizeof(struct tlog_file_json_writer),
+    .init       = tlog_file_json_writer_init,
+    .is_valid   = tlog_file_json_writer_is_valid,
+    .write      = tlog_file_json_writer_write,
+    .writev     = tlog_file_json_writer_writev,
+    .flush      = tlog_file_json_writer_flush,
+    .cleanup    = tlog_file_json_writer_cleanup,
+};
@@ -20,19 +20,55 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <config.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 #include <tlog/journal_json_writer.h>
+#include <tlog/fd_json_writer.h>
 #include <systemd/sd-journal.h>
 #include <tlog/grc.h>
 #include <tlog/rc.h>
+#include <tlog/misc.h>
 
-/** Syslog writer data */
+/** Prefix of the message field */
+#define TLOG_JOURNAL_JSON_WRITER_MSG_PREFIX "MESSAGE="
+
+/** Prefix of the message ID field */
+#define TLOG_JOURNAL_JSON_WRITER_ID_PREFIX  "TLOG_ID="
+
+/** Indexes of the fields in the field list */
+enum tlog_journal_json_writer_field {
+    TLOG_JOURNAL_JSON_WRITER_FIELD_MESSAGE,
+    TLOG_JOURNAL_JSON_WRITER_FIELD_PRIORITY,
+    TLOG_JOURNAL_JSON_WRITER_FIELD_REC,
+    TLOG_JOURNAL_JSON_WRITER_FIELD_USER,
+    TLOG_JOURNAL_JSON_WRITER_FIELD_SESSION,
+    TLOG_JOURNAL_JSON_WRITER_FIELD_ID,
+    TLOG_JOURNAL_JSON_WRITER_FIELD_NUM
+};
+
+/** Journal writer data */
 struct tlog_journal_json_writer {
     struct tlog_json_writer     writer;     /**< Abstract writer instance */
     int                         priority;   /**< Logging priority */
     bool                        augment;    /**< True to add extra fields */
-    char                       *recording;  /**< Recording ID */
-    char                       *username;   /**< Session user name */
-    unsigned int                session_id; /**< Session ID */
+    char                       *priority_field; /**< Priority field */
+    char                       *rec_field;  /**< Recording ID field */
+    char                       *user_field; /**< Session user name field */
+    char                       *session_field;  /**< Session ID field */
+    char                        id_field[sizeof(
+                                    TLOG_JOURNAL_JSON_WRITER_ID_PREFIX) - 1 +
+                                    TLOG_UINT64_DIGITS_MAX];
+                                            /**< Message ID field */
+    char                       *msg_buf;    /**< Message field buffer */
+    size_t                      msg_size;   /**< Message field buffer size */
+    struct iovec                field_list[TLOG_JOURNAL_JSON_WRITER_FIELD_NUM];
+                                            /**< Fields to send, with the
+                                                 constant ones pre-built */
+    int                         field_num;  /**< Number of fields to send */
+    struct tlog_json_writer    *stream;     /**< Journal stream writer,
+                                                 NULL if sending entries */
 };
 
 static void
@@ -40,8 +76,35 @@ tlog_journal_json_writer_cleanup(struct tlog_json_writer *writer)
 {
     struct tlog_journal_json_writer *journal_json_writer =
                                     (struct tlog_journal_json_writer*)writer;
-    free(journal_json_writer->username);
-    free(journal_json_writer->recording);
+    tlog_json_writer_destroy(journal_json_writer->stream);
+    journal_json_writer->stream = NULL;
+    free(journal_json_writer->msg_buf);
+    journal_json_writer->msg_buf = NULL;
+    free(journal_json_writer->session_field);
+    journal_json_writer->session_field = NULL;
+    free(journal_json_writer->user_field);
+    journal_json_writer->user_field = NULL;
+    free(journal_json_writer->rec_field);
+    journal_json_writer->rec_field = NULL;
+    free(journal_json_writer->priority_field);
+    journal_json_writer->priority_field = NULL;
+}
+
+/**
+ * Point a field list entry of a journal writer at a string.
+ *
+ * @param journal_json_writer   The writer to set the field of.
+ * @param field                 The index of the field to set.
+ * @param str                   The field string, "NAME=value".
+ */
+static void
+tlog_journal_json_writer_set_field(
+                        struct tlog_journal_json_writer *journal_json_writer,
+                        enum tlog_journal_json_writer_field field,
+                        char *str)
+{
+    journal_json_writer->field_list[field].iov_base = str;
+    journal_json_writer->field_list[field].iov_len = strlen(str);
 }
 
 static tlog_grc
@@ -52,9 +115,11 @@ tlog_journal_json_writer_init(struct tlog_json_writer *writer, va_list ap)
     tlog_grc grc;
     int priority = va_arg(ap, int);
     bool augment = (bool)va_arg(ap, int);
+    bool stream = (bool)va_arg(ap, int);
     const char *recording = va_arg(ap, const char *);
     const char *username = va_arg(ap, const char *);
     unsigned int session_id = va_arg(ap, unsigned int);
+    int fd;
 
     assert(tlog_syslog_priority_is_valid(priority));
     assert(!augment || recording != NULL);
@@ -63,22 +128,83 @@ tlog_journal_json_writer_init(struct tlog_json_writer *writer, va_list ap)
 
     journal_json_writer->priority = priority;
 
+    /*
+     * Write lines to a journal stream, if requested, and no extra fields
+     * are, as streams can't carry them
+     */
+    if (stream && !augment) {
+        fd = sd_journal_stream_fd(NULL, priority, 0);
+        if (fd < 0) {
+            grc = TLOG_GRC_FROM(systemd, fd);
+            goto cleanup;
+        }
+        grc = tlog_fd_json_writer_create(&journal_json_writer->stream,
+                                         fd, true);
+        if (grc != TLOG_RC_OK) {
+            close(fd);
+            goto cleanup;
+        }
+        grc = TLOG_RC_OK;
+        goto cleanup;
+    }
+
     journal_json_writer->augment = augment;
 
+    /* Build the constant fields once */
+    if (asprintf(&journal_json_writer->priority_field,
+                 "PRIORITY=%d", priority) < 0) {
+        journal_json_writer->priority_field = NULL;
+        grc = TLOG_GRC_ERRNO;
+        goto cleanup;
+    }
+    tlog_journal_json_writer_set_field(
+                            journal_json_writer,
+                            TLOG_JOURNAL_JSON_WRITER_FIELD_PRIORITY,
+                            journal_json_writer->priority_field);
+    journal_json_writer->field_num =
+                            TLOG_JOURNAL_JSON_WRITER_FIELD_PRIORITY + 1;
+
     if (journal_json_writer->augment) {
-        journal_json_writer->recording = strdup(recording);
-        if (journal_json_writer->recording == NULL) {
+        if (asprintf(&journal_json_writer->rec_field,
+                     "TLOG_REC=%s", recording) < 0) {
+            journal_json_writer->rec_field = NULL;
+            grc = TLOG_GRC_ERRNO;
+            goto cleanup;
+        }
+        tlog_journal_json_writer_set_field(
+                                journal_json_writer,
+                                TLOG_JOURNAL_JSON_WRITER_FIELD_REC,
+                                journal_json_writer->rec_field);
+
+        if (asprintf(&journal_json_writer->user_field,
+                     "TLOG_USER=%s", username) < 0) {
+            journal_json_writer->user_field = NULL;
             grc = TLOG_GRC_ERRNO;
             goto cleanup;
         }
+        tlog_journal_json_writer_set_field(
+                                journal_json_writer,
+                                TLOG_JOURNAL_JSON_WRITER_FIELD_USER,
+                                journal_json_writer->user_field);
 
-        journal_json_writer->username = strdup(username);
-        if (journal_json_writer->username == NULL) {
+        if (asprintf(&journal_json_writer->session_field,
+                     "TLOG_SESSION=%u", session_id) < 0) {
+            journal_json_writer->session_field = NULL;
             grc = TLOG_GRC_ERRNO;
             goto cleanup;
         }
+        tlog_journal_json_writer_set_field(
+                                journal_json_writer,
+                                TLOG_JOURNAL_JSON_WRITER_FIELD_SESSION,
+                                journal_json_writer->session_field);
 
-        journal_json_writer->session_id = session_id;
+        memcpy(journal_json_writer->id_field,
+               TLOG_JOURNAL_JSON_WRITER_ID_PREFIX,
+               sizeof(TLOG_JOURNAL_JSON_WRITER_ID_PREFIX) - 1);
+        journal_json_writer->field_list[
+                TLOG_JOURNAL_JSON_WRITER_FIELD_ID].iov_base =
+                                            journal_json_writer->id_field;
+        journal_json_writer->field_num = TLOG_JOURNAL_JSON_WRITER_FIELD_NUM;
     }
 
     grc = TLOG_RC_OK;
@@ -94,46 +220,99 @@ tlog_journal_json_writer_is_valid(const struct tlog_json_writer *writer)
 {
     struct tlog_journal_json_writer *journal_json_writer =
                                     (struct tlog_journal_json_writer*)writer;
-    return tlog_syslog_priority_is_valid(journal_json_writer->priority) &&
+    if (!tlog_syslog_priority_is_valid(journal_json_writer->priority)) {
+        return false;
+    }
+    if (journal_json_writer->stream != NULL) {
+        return tlog_json_writer_is_valid(journal_json_writer->stream);
+    }
+    return journal_json_writer->priority_field != NULL &&
            (!journal_json_writer->augment ||
-            (journal_json_writer->recording != NULL &&
-             journal_json_writer->username != NULL &&
-             journal_json_writer->session_id != 0));
+            (journal_json_writer->rec_field != NULL &&
+             journal_json_writer->user_field != NULL &&
+             journal_json_writer->session_field != NULL));
 }
 
 static tlog_grc
-tlog_journal_json_writer_write(struct tlog_json_writer *writer,
-                               size_t id, const uint8_t *buf, size_t len)
+tlog_journal_json_writer_writev(struct tlog_json_writer *writer,
+                                size_t id,
+                                const struct iovec *iov,
+                                int iovcnt)
 {
     struct tlog_journal_json_writer *journal_json_writer =
                                     (struct tlog_journal_json_writer*)writer;
+    static const char msg_prefix[] = TLOG_JOURNAL_JSON_WRITER_MSG_PREFIX;
+    struct iovec *field;
+    size_t len;
+    size_t size;
+    char *buf;
+    char *p;
+    int i;
     int sd_rc;
 
-#define BASE_ARGS \
-    "PRIORITY=%d", journal_json_writer->priority,   \
-    "MESSAGE=%.*s", len, buf
+    if (journal_json_writer->stream != NULL) {
+        return tlog_json_writer_writev(journal_json_writer->stream,
+                                       id, iov, iovcnt);
+    }
 
-    if (journal_json_writer->augment) {
-        sd_rc = sd_journal_send(
-                    "TLOG_REC=%s", journal_json_writer->recording,
-                    "TLOG_USER=%s", journal_json_writer->username,
-                    "TLOG_SESSION=%u", journal_json_writer->session_id,
-                    "TLOG_ID=%zu", id,
-                    BASE_ARGS,
-                    NULL);
-    } else {
-        sd_rc = sd_journal_send(BASE_ARGS, NULL);
+    /* The message must be a single field, gather it after the prefix */
+    len = sizeof(msg_prefix) - 1;
+    for (i = 0; i < iovcnt; i++) {
+        len += iov[i].iov_len;
+    }
+    if (len > journal_json_writer->msg_size) {
+        size = journal_json_writer->msg_size;
+        if (size == 0) {
+            size = 4096;
+        }
+        while (size < len) {
+            size *= 2;
+        }
+        buf = realloc(journal_json_writer->msg_buf, size);
+        if (buf == NULL) {
+            return TLOG_GRC_ERRNO;
+        }
+        memcpy(buf, msg_prefix, sizeof(msg_prefix) - 1);
+        journal_json_writer->msg_buf = buf;
+        journal_json_writer->msg_size = size;
+    }
+    p = journal_json_writer->msg_buf + sizeof(msg_prefix) - 1;
+    for (i = 0; i < iovcnt; i++) {
+        memcpy(p, iov[i].iov_base, iov[i].iov_len);
+        p += iov[i].iov_len;
     }
 
-#undef BASE_ARGS
+    field = journal_json_writer->field_list;
+    field[TLOG_JOURNAL_JSON_WRITER_FIELD_MESSAGE].iov_base =
+                                            journal_json_writer->msg_buf;
+    field[TLOG_JOURNAL_JSON_WRITER_FIELD_MESSAGE].iov_len = len;
 
+    /* Only the message ID changes between the other fields */
+    if (journal_json_writer->augment) {
+        field[TLOG_JOURNAL_JSON_WRITER_FIELD_ID].iov_len =
+            sizeof(TLOG_JOURNAL_JSON_WRITER_ID_PREFIX) - 1 +
+            tlog_uint64_fmt(journal_json_writer->id_field +
+                            sizeof(TLOG_JOURNAL_JSON_WRITER_ID_PREFIX) - 1,
+                            id);
+    }
+
+    sd_rc = sd_journal_sendv(field, journal_json_writer->field_num);
     return (sd_rc < 0) ? TLOG_GRC_FROM(systemd, sd_rc) : TLOG_RC_OK;
 }
 
+static tlog_grc
+tlog_journal_json_writer_write(struct tlog_json_writer *writer,
+                               size_t id, const uint8_t *buf, size_t len)
+{
+    struct iovec iov = {.iov_base = (void *)buf, .iov_len = len};
+    return tlog_journal_json_writer_writev(writer, id, &iov, 1);
+}
+
 const struct tlog_json_writer_type tlog_journal_json_writer_type = {
     .size       = sizeof(struct tlog_journal_json_writer),
     .init       = tlog_journal_json_writer_init,
     .cleanup    = tlog_journal_json_writer_cleanup,
     .is_valid   = tlog_journal_json_writer_is_valid,
     .write      = tlog_journal_json_writer_write,
+    .writev     = tlog_journal_json_writer_writev,
 };
@@ -22,21 +22,19 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <tlog/timespec.h>
 #include <tlog/json_chunk.h>
 
+_Static_assert(sizeof(TLOG_TRX_BASIC_STORE_SIG(tlog_json_chunk)) <=
+                    TLOG_JSON_CHUNK_ALIGN,
+               "Chunk state doesn't fit a cache line");
+
 static
 TLOG_TRX_BASIC_ACT_SIG(tlog_json_chunk)
 {
     TLOG_TRX_BASIC_ACT_PROLOGUE(tlog_json_chunk);
-    TLOG_TRX_BASIC_ACT_ON_VAR(rem);
-    TLOG_TRX_BASIC_ACT_ON_VAR(timing_ptr);
-    TLOG_TRX_BASIC_ACT_ON_VAR(got_ts);
-    TLOG_TRX_BASIC_ACT_ON_VAR(first_ts);
-    TLOG_TRX_BASIC_ACT_ON_VAR(last_ts);
-    TLOG_TRX_BASIC_ACT_ON_VAR(window_state);
-    TLOG_TRX_BASIC_ACT_ON_VAR(last_width);
-    TLOG_TRX_BASIC_ACT_ON_VAR(last_height);
+    TLOG_TRX_BASIC_ACT_ON_STORE(state);
     TLOG_TRX_BASIC_ACT_ON_OBJ(input);
     TLOG_TRX_BASIC_ACT_ON_OBJ(output);
 }
@@ -69,17 +67,17 @@ tlog_json_chunk_reserve(struct tlog_json_chunk *chunk, size_t len)
     assert(tlog_json_chunk_is_valid(chunk));
 
     /* If we'll have to write the initial window */
-    if (chunk->window_state == TLOG_JSON_CHUNK_WINDOW_STATE_KNOWN) {
+    if (chunk->state.window_state == TLOG_JSON_CHUNK_WINDOW_STATE_KNOWN) {
         len += tlog_json_chunk_sprint_window(NULL, 0,
-                                             chunk->last_width,
-                                             chunk->last_height);
+                                             chunk->state.last_width,
+                                             chunk->state.last_height);
     }
-    if (len > chunk->rem) {
+    if (len > chunk->state.rem) {
         return false;
     }
-    chunk->rem -= len;
-    if (chunk->window_state == TLOG_JSON_CHUNK_WINDOW_STATE_KNOWN) {
-        chunk->window_state = TLOG_JSON_CHUNK_WINDOW_STATE_RESERVED;
+    chunk->state.rem -= len;
+    if (chunk->state.window_state == TLOG_JSON_CHUNK_WINDOW_STATE_KNOWN) {
+        chunk->state.window_state = TLOG_JSON_CHUNK_WINDOW_STATE_RESERVED;
     }
     return true;
 }
@@ -90,11 +88,11 @@ tlog_json_chunk_write_timing_raw(struct tlog_json_chunk *chunk,
 {
     assert(tlog_json_chunk_is_valid(chunk));
     assert(ptr != NULL || len == 0);
-    assert((chunk->timing_ptr - chunk->timing_buf + len) <=
-                (chunk->size - chunk->rem));
+    assert((chunk->state.timing_ptr - chunk->timing_buf + len) <=
+                (chunk->size - chunk->state.rem));
 
-    memcpy(chunk->timing_ptr, ptr, len);
-    chunk->timing_ptr += len;
+    memcpy(chunk->state.timing_ptr, ptr, len);
+    chunk->state.timing_ptr += len;
 }
 
 static void
@@ -102,16 +100,16 @@ tlog_json_chunk_write_timing(struct tlog_json_chunk *chunk,
                              const uint8_t *ptr, size_t len)
 {
     /* If we have to write the (reserved) initial window */
-    if (chunk->window_state == TLOG_JSON_CHUNK_WINDOW_STATE_RESERVED) {
+    if (chunk->state.window_state == TLOG_JSON_CHUNK_WINDOW_STATE_RESERVED) {
         /* Window string buffer (max: "=65535x65535") */
         uint8_t buf[16];
         size_t len;
         len = tlog_json_chunk_sprint_window(buf, sizeof(buf),
-                                            chunk->last_width,
-                                            chunk->last_height);
+                                            chunk->state.last_width,
+                                            chunk->state.last_height);
         assert(len < sizeof(buf));
         tlog_json_chunk_write_timing_raw(chunk, buf, len);
-        chunk->window_state = TLOG_JSON_CHUNK_WINDOW_STATE_WRITTEN;
+        chunk->state.window_state = TLOG_JSON_CHUNK_WINDOW_STATE_WRITTEN;
     }
     tlog_json_chunk_write_timing_raw(chunk, ptr, len);
 }
@@ -141,19 +139,19 @@ tlog_json_chunk_advance(tlog_trx_state trx,
     TLOG_TRX_FRAME_BEGIN(trx);
 
     /* If this is the first write */
-    if (!chunk->got_ts) {
-        chunk->got_ts = true;
-        chunk->first_ts = *ts;
-        chunk->last_ts = *ts;
+    if (!chunk->state.got_ts) {
+        chunk->state.got_ts = true;
+        chunk->state.first_ts = *ts;
+        chunk->state.last_ts = *ts;
         delay_rc = 0;
     } else {
-        if (tlog_timespec_cmp(ts, &chunk->last_ts) > 0) {
+        if (tlog_timespec_cmp(ts, &chunk->state.last_ts) > 0) {
             struct timespec delay;
             long sec;
             long msec;
 
-            tlog_timespec_sub(ts, &chunk->last_ts, &delay);
-            chunk->last_ts = *ts;
+            tlog_timespec_sub(ts, &chunk->state.last_ts, &delay);
+            chunk->state.last_ts = *ts;
             sec = (long)delay.tv_sec;
             msec = delay.tv_nsec / 1000000;
             if (sec != 0) {
@@ -259,16 +257,115 @@ tlog_json_chunk_dispatcher_advance(tlog_trx_state trx,
     return tlog_json_chunk_advance(trx, chunk, ts);
 }
 
+/**
+ * Get the size of a chunk buffer laid out in an arena, rounded up to
+ * keep the next buffer aligned.
+ *
+ * @param size  Size of the chunk.
+ *
+ * @return The buffer size.
+ */
+static size_t
+tlog_json_chunk_buf_size(size_t size)
+{
+    return (size + TLOG_JSON_CHUNK_ALIGN - 1) &
+           ~(size_t)(TLOG_JSON_CHUNK_ALIGN - 1);
+}
+
+size_t
+tlog_json_chunk_arena_size(size_t size)
+{
+    assert(size >= TLOG_JSON_CHUNK_SIZE_MIN);
+    return tlog_json_chunk_buf_size(size) * TLOG_JSON_CHUNK_BUF_NUM;
+}
+
+/**
+ * Lay out chunk buffers in an arena, adjacent to each other.
+ *
+ * @param arena     The arena to lay the buffers out in.
+ * @param size      Size of the chunk.
+ * @param pbuf_list List of locations for the buffer pointers, in order of
+ *                  the buffers in the arena.
+ */
+static void
+tlog_json_chunk_arena_lay_out(uint8_t *arena, size_t size,
+                              uint8_t **pbuf_list[TLOG_JSON_CHUNK_BUF_NUM])
+{
+    size_t i;
+
+    assert(arena != NULL);
+    assert((uintptr_t)arena % TLOG_JSON_CHUNK_ALIGN == 0);
+
+    for (i = 0; i < TLOG_JSON_CHUNK_BUF_NUM; i++) {
+        *pbuf_list[i] = arena + tlog_json_chunk_buf_size(size) * i;
+    }
+}
+
+void
+tlog_json_chunk_bufs_init(struct tlog_json_chunk_bufs *bufs,
+                          size_t size, uint8_t *arena)
+{
+    uint8_t **pbuf_list[TLOG_JSON_CHUNK_BUF_NUM] = {
+        &bufs->timing_buf,
+        &bufs->input_txt_buf,
+        &bufs->input_bin_buf,
+        &bufs->output_txt_buf,
+        &bufs->output_bin_buf,
+    };
+
+    assert(bufs != NULL);
+    assert(size >= TLOG_JSON_CHUNK_SIZE_MIN);
+
+    memset(bufs, 0, sizeof(*bufs));
+    bufs->arena = arena;
+    tlog_json_chunk_arena_lay_out(arena, size, pbuf_list);
+}
+
+/**
+ * Lay out the buffers of a chunk and its streams in an arena.
+ *
+ * @param chunk The chunk to lay out the buffers of.
+ * @param arena The arena to lay the buffers out in.
+ */
+static void
+tlog_json_chunk_lay_out(struct tlog_json_chunk *chunk, uint8_t *arena)
+{
+    uint8_t **pbuf_list[TLOG_JSON_CHUNK_BUF_NUM] = {
+        &chunk->timing_buf,
+        &chunk->input.txt_buf,
+        &chunk->input.bin_buf,
+        &chunk->output.txt_buf,
+        &chunk->output.bin_buf,
+    };
+    chunk->arena = arena;
+    tlog_json_chunk_arena_lay_out(arena, chunk->size, pbuf_list);
+}
+
 tlog_grc
-tlog_json_chunk_init(struct tlog_json_chunk *chunk, size_t size)
+tlog_json_chunk_init(struct tlog_json_chunk *chunk, size_t size,
+                     uint8_t *arena)
 {
-    tlog_grc grc;
+    struct tlog_json_chunk_bufs bufs;
+    int rc;
 
     assert(chunk != NULL);
     assert(size >= TLOG_JSON_CHUNK_SIZE_MIN);
 
     memset(chunk, 0, sizeof(*chunk));
 
+    /* Allocate the arena, if not provided */
+    if (arena == NULL) {
+        void *ptr;
+        rc = posix_memalign(&ptr, TLOG_JSON_CHUNK_ALIGN,
+                            tlog_json_chunk_arena_size(size));
+        if (rc != 0) {
+            return TLOG_GRC_FROM(errno, rc);
+        }
+        arena = ptr;
+        chunk->arena_owned = true;
+    }
+    tlog_json_chunk_bufs_init(&bufs, size, arena);
+
     chunk->trx_iface = TLOG_TRX_BASIC_IFACE(tlog_json_chunk);
     tlog_json_dispatcher_init(&chunk->dispatcher,
                               tlog_json_chunk_dispatcher_advance,
@@ -276,31 +373,19 @@ tlog_json_chunk_init(struct tlog_json_chunk *chunk, size_t size)
                               tlog_json_chunk_dispatcher_write,
                               chunk, &chunk->trx_iface);
     chunk->size = size;
-    chunk->rem = size;
+    chunk->state.rem = size;
+    chunk->arena = arena;
+    chunk->timing_buf = bufs.timing_buf;
+    chunk->state.timing_ptr = chunk->timing_buf;
 
-    grc = tlog_json_stream_init(&chunk->input, &chunk->dispatcher,
-                                size, '<', '[');
-    if (grc != TLOG_RC_OK) {
-        goto error;
-    }
-    grc = tlog_json_stream_init(&chunk->output, &chunk->dispatcher,
-                                size, '>', ']');
-    if (grc != TLOG_RC_OK) {
-        goto error;
-    }
-    chunk->timing_buf = malloc(size);
-    if (chunk->timing_buf == NULL) {
-        grc = TLOG_GRC_ERRNO;
-        goto error;
-    }
-    chunk->timing_ptr = chunk->timing_buf;
+    tlog_json_stream_init(&chunk->input, &chunk->dispatcher, size,
+                          bufs.input_txt_buf, bufs.input_bin_buf, '<', '[');
+    tlog_json_stream_init(&chunk->output, &chunk->dispatcher, size,
+                          bufs.output_txt_buf, bufs.output_bin_buf,
+                          '>', ']');
 
     assert(tlog_json_chunk_is_valid(chunk));
     return TLOG_RC_OK;
-
-error:
-    tlog_json_chunk_cleanup(chunk);
-    return grc;
 }
 
 bool
@@ -309,16 +394,17 @@ tlog_json_chunk_is_valid(const struct tlog_json_chunk *chunk)
     return chunk != NULL &&
            tlog_json_dispatcher_is_valid(&chunk->dispatcher) &&
            chunk->size >= TLOG_JSON_CHUNK_SIZE_MIN &&
+           chunk->arena != NULL &&
            tlog_json_stream_is_valid(&chunk->input) &&
            tlog_json_stream_is_valid(&chunk->output) &&
            chunk->timing_buf != NULL &&
-           chunk->timing_ptr >= chunk->timing_buf &&
-           chunk->timing_ptr <= chunk->timing_buf + chunk->size &&
-           chunk->rem <= chunk->size &&
-           ((chunk->timing_ptr - chunk->timing_buf) +
-            chunk->input.txt_len + chunk->input.bin_len +
-            chunk->output.txt_len + chunk->output.bin_len) <=
-                (chunk->size - chunk->rem);
+           chunk->state.timing_ptr >= chunk->timing_buf &&
+           chunk->state.timing_ptr <= chunk->timing_buf + chunk->size &&
+           chunk->state.rem <= chunk->size &&
+           ((chunk->state.timing_ptr - chunk->timing_buf) +
+            chunk->input.state.txt_len + chunk->input.state.bin_len +
+            chunk->output.state.txt_len + chunk->output.state.bin_len) <=
+                (chunk->size - chunk->state.rem);
 }
 
 bool
@@ -333,7 +419,7 @@ bool
 tlog_json_chunk_is_empty(const struct tlog_json_chunk *chunk)
 {
     assert(tlog_json_chunk_is_valid(chunk));
-    return chunk->rem >= chunk->size;
+    return chunk->state.rem >= chunk->size;
 }
 
 /**
@@ -377,9 +463,9 @@ tlog_json_chunk_write_window(tlog_trx_state trx,
 
     TLOG_TRX_FRAME_BEGIN(trx);
 
-    if (chunk->window_state >= TLOG_JSON_CHUNK_WINDOW_STATE_KNOWN) {
-        if (pkt->data.window.width == chunk->last_width &&
-            pkt->data.window.height == chunk->last_height) {
+    if (chunk->state.window_state >= TLOG_JSON_CHUNK_WINDOW_STATE_KNOWN) {
+        if (pkt->data.window.width == chunk->state.last_width &&
+            pkt->data.window.height == chunk->state.last_height) {
             goto success;
         }
     }
@@ -400,17 +486,17 @@ tlog_json_chunk_write_window(tlog_trx_state trx,
     }
 
     /* Signal we're reserving space for a window right now */
-    chunk->window_state = TLOG_JSON_CHUNK_WINDOW_STATE_RESERVED;
+    chunk->state.window_state = TLOG_JSON_CHUNK_WINDOW_STATE_RESERVED;
     if (!tlog_json_chunk_reserve(chunk, len)) {
         goto failure;
     }
 
     /* Signal we're writing a window right now */
-    chunk->window_state = TLOG_JSON_CHUNK_WINDOW_STATE_WRITTEN;
+    chunk->state.window_state = TLOG_JSON_CHUNK_WINDOW_STATE_WRITTEN;
     tlog_json_chunk_write_timing(chunk, buf, len);
 
-    chunk->last_width = pkt->data.window.width;
-    chunk->last_height = pkt->data.window.height;
+    chunk->state.last_width = pkt->data.window.width;
+    chunk->state.last_height = pkt->data.window.height;
 
 success:
     tlog_pkt_pos_move_past(ppos, pkt);
@@ -492,8 +578,8 @@ tlog_json_chunk_write(struct tlog_json_chunk *chunk,
     assert(tlog_pkt_pos_is_valid(end));
     assert(tlog_pkt_pos_is_compatible(end, pkt));
     assert(tlog_pkt_pos_is_reachable(end, pkt));
-    assert(!chunk->got_ts ||
-           tlog_timespec_cmp(&chunk->last_ts, &pkt->timestamp) <= 0);
+    assert(!chunk->state.got_ts ||
+           tlog_timespec_cmp(&chunk->state.last_ts, &pkt->timestamp) <= 0);
 
     TLOG_TRX_FRAME_BEGIN(trx);
 
@@ -559,25 +645,55 @@ void
 tlog_json_chunk_empty(struct tlog_json_chunk *chunk)
 {
     assert(tlog_json_chunk_is_valid(chunk));
-    chunk->rem = chunk->size;
-    chunk->timing_ptr = chunk->timing_buf;
+    chunk->state.rem = chunk->size;
+    chunk->state.timing_ptr = chunk->timing_buf;
     tlog_json_stream_empty(&chunk->input);
     tlog_json_stream_empty(&chunk->output);
-    chunk->got_ts = false;
-    chunk->first_ts = TLOG_TIMESPEC_ZERO;
-    chunk->last_ts = TLOG_TIMESPEC_ZERO;
-    if (chunk->window_state > TLOG_JSON_CHUNK_WINDOW_STATE_KNOWN) {
-        chunk->window_state = TLOG_JSON_CHUNK_WINDOW_STATE_KNOWN;
+    chunk->state.got_ts = false;
+    chunk->state.first_ts = TLOG_TIMESPEC_ZERO;
+    chunk->state.last_ts = TLOG_TIMESPEC_ZERO;
+    if (chunk->state.window_state > TLOG_JSON_CHUNK_WINDOW_STATE_KNOWN) {
+        chunk->state.window_state = TLOG_JSON_CHUNK_WINDOW_STATE_KNOWN;
     }
     assert(tlog_json_chunk_is_valid(chunk));
 }
 
+void
+tlog_json_chunk_swap(struct tlog_json_chunk *chunk,
+                     struct tlog_json_chunk_bufs *bufs)
+{
+    uint8_t *arena;
+    size_t timing_len;
+
+    assert(tlog_json_chunk_is_valid(chunk));
+    assert(!chunk->arena_owned);
+    assert(bufs != NULL);
+
+    /* Hand the chunk's arena over to the set, and take the set's */
+    arena = bufs->arena;
+    timing_len = chunk->state.timing_ptr - chunk->timing_buf;
+    tlog_json_chunk_bufs_init(bufs, chunk->size, chunk->arena);
+    bufs->timing_len = timing_len;
+    bufs->input_txt_len = chunk->input.state.txt_len;
+    bufs->input_bin_len = chunk->input.state.bin_len;
+    bufs->output_txt_len = chunk->output.state.txt_len;
+    bufs->output_bin_len = chunk->output.state.bin_len;
+    tlog_json_chunk_lay_out(chunk, arena);
+    chunk->state.timing_ptr = chunk->timing_buf;
+
+    tlog_json_chunk_empty(chunk);
+}
+
 void
 tlog_json_chunk_cleanup(struct tlog_json_chunk *chunk)
 {
     assert(chunk != NULL);
     tlog_json_stream_cleanup(&chunk->input);
     tlog_json_stream_cleanup(&chunk->output);
-    free(chunk->timing_buf);
+    if (chunk->arena_owned) {
+        free(chunk->arena);
+        chunk->arena_owned = false;
+    }
+    chunk->arena = NULL;
     chunk->timing_buf = NULL;
 }
@@ -0,0 +1,161 @@
+/*
+ * JSON string escaping.
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <assert.h>
+#include <tlog/json_esc.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define TLOG_JSON_ESC_AVX2
+#endif
+
+/**
+ * Find the length of the span of bytes not needing escaping at the start of
+ * a buffer, one byte at a time.
+ *
+ * @param buf   The buffer to scan.
+ * @param len   The buffer length.
+ * @param ascii True if bytes above 0x7f should end the span.
+ *
+ * @return The length of the span.
+ */
+static size_t
+tlog_json_esc_span_scalar(const uint8_t *buf, size_t len, bool ascii)
+{
+    size_t pos = 0;
+    while (pos < len &&
+           !tlog_json_esc_byte_is_needed(buf[pos]) &&
+           !(ascii && buf[pos] >= 0x80)) {
+        pos++;
+    }
+    return pos;
+}
+
+#if defined(__SSE2__)
+/**
+ * Find the length of the span of bytes not needing escaping at the start of
+ * a buffer, 16 bytes at a time.
+ *
+ * @param buf   The buffer to scan.
+ * @param len   The buffer length.
+ * @param ascii True if bytes above 0x7f should end the span.
+ *
+ * @return The length of the span.
+ */
+static size_t
+tlog_json_esc_span_sse2(const uint8_t *buf, size_t len, bool ascii)
+{
+    const __m128i ctl_max = _mm_set1_epi8(0x1f);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i del = _mm_set1_epi8(0x7f);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    __m128i v;
+    unsigned int mask;
+    size_t pos;
+
+    for (pos = 0; pos + 16 <= len; pos += 16) {
+        v = _mm_loadu_si128((const __m128i *)(buf + pos));
+        /* Saturated subtraction leaves zero for control characters only */
+        mask = (unsigned int)_mm_movemask_epi8(
+                    _mm_or_si128(
+                        _mm_or_si128(
+                            _mm_cmpeq_epi8(_mm_subs_epu8(v, ctl_max), zero),
+                            _mm_cmpeq_epi8(v, del)),
+                        _mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                     _mm_cmpeq_epi8(v, backslash))));
+        if (ascii) {
+            mask |= (unsigned int)_mm_movemask_epi8(v);
+        }
+        if (mask != 0) {
+            return pos + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return pos + tlog_json_esc_span_scalar(buf + pos, len - pos, ascii);
+}
+#endif
+
+#ifdef TLOG_JSON_ESC_AVX2
+/**
+ * Find the length of the span of bytes not needing escaping at the start of
+ * a buffer, 32 bytes at a time. Must only be called if the CPU supports AVX2.
+ *
+ * @param buf   The buffer to scan.
+ * @param len   The buffer length.
+ * @param ascii True if bytes above 0x7f should end the span.
+ *
+ * @return The length of the span.
+ */
+__attribute__((target("avx2")))
+static size_t
+tlog_json_esc_span_avx2(const uint8_t *buf, size_t len, bool ascii)
+{
+    const __m256i ctl_max = _mm256_set1_epi8(0x1f);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    __m256i v;
+    unsigned int mask;
+    size_t pos;
+
+    for (pos = 0; pos + 32 <= len; pos += 32) {
+        v = _mm256_loadu_si256((const __m256i *)(buf + pos));
+        /* Saturated subtraction leaves zero for control characters only */
+        mask = (unsigned int)_mm256_movemask_epi8(
+                    _mm256_or_si256(
+                        _mm256_or_si256(
+                            _mm256_cmpeq_epi8(_mm256_subs_epu8(v, ctl_max),
+                                              zero),
+                            _mm256_cmpeq_epi8(v, del)),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+                                        _mm256_cmpeq_epi8(v, backslash))));
+        if (ascii) {
+            mask |= (unsigned int)_mm256_movemask_epi8(v);
+        }
+        if (mask != 0) {
+            return pos + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return pos + tlog_json_esc_span_scalar(buf + pos, len - pos, ascii);
+}
+#endif
+
+size_t
+tlog_json_esc_span(const uint8_t *buf, size_t len, bool ascii)
+{
+    assert(buf != NULL || len == 0);
+#ifdef TLOG_JSON_ESC_AVX2
+    if (len >= 32 && __builtin_cpu_supports("avx2")) {
+        return tlog_json_esc_span_avx2(buf, len, ascii);
+    }
+#endif
+#if defined(__SSE2__)
+    return tlog_json_esc_span_sse2(buf, len, ascii);
+#else
+    return tlog_json_esc_span_scalar(buf, len, ascii);
+#endif
+}
@@ -22,6 +22,7 @@
 
 #include <config.h>
 #include <tlog/json_misc.h>
+#include <tlog/json_esc.h>
 #include <tlog/rc.h>
 #include <tlog/utf8.h>
 #include <tlog/misc.h>
@@ -348,7 +349,8 @@ tlog_json_esc_buf(char *out_ptr, size_t out_len,
 {
     bool out_of_space = false;
     size_t res_len = 0;
-    struct tlog_utf8 utf8 = TLOG_UTF8_INIT;
+    const uint8_t *in = (const uint8_t *)in_ptr;
+    size_t l;
 
     assert(out_ptr != NULL || out_len == 0);
     assert(in_ptr != NULL || in_len == 0);
@@ -358,69 +360,41 @@ tlog_json_esc_buf(char *out_ptr, size_t out_len,
     tlog_json_esc_buf_req(&res_len, &out_of_space, &out_len, (_n))
 
     while (in_len > 0) {
-        if (tlog_utf8_add(&utf8, *(const uint8_t *)in_ptr)) {
-            in_len--;
-            in_ptr++;
-        }
-        if (!tlog_utf8_is_ended(&utf8)) {
-            continue;
-        }
-        assert(utf8.len != 0);
-
-        if (!tlog_utf8_is_complete(&utf8) || utf8.len != 1) {
-            if (REQ(utf8.len)) {
-                memcpy(out_ptr, utf8.buf, utf8.len);
-                out_ptr += utf8.len;
-            }
-        } else {
-            uint8_t c = *utf8.buf;
-            switch (c) {
-            case '"':
-            case '\\':
-                if (REQ(2)) {
-                    *out_ptr++ = '\\';
-                    *out_ptr++ = c;
-                }
-                break;
-#define ESC_CASE(_c, _e) \
-            case _c:                    \
-                if (REQ(2)) {             \
-                    *out_ptr++ = '\\';  \
-                    *out_ptr++ = _e;    \
-                }                       \
-                break;
-            ESC_CASE('\b', 'b');
-            ESC_CASE('\f', 'f');
-            ESC_CASE('\n', 'n');
-            ESC_CASE('\r', 'r');
-            ESC_CASE('\t', 't');
-#undef ESC
-            default:
-                if (c < 0x20 || c == 0x7f) {
-                    if (REQ(6)) {
-                        *out_ptr++ = '\\';
-                        *out_ptr++ = 'u';
-                        *out_ptr++ = '0';
-                        *out_ptr++ = '0';
-                        *out_ptr++ = tlog_nibble_digit(c >> 4);
-                        *out_ptr++ = tlog_nibble_digit(c & 0xf);
-                    }
-                } else {
-                    if (REQ(1)) {
-                        *out_ptr++ = c;
+        /* Copy the span not needing escaping, as much as fits */
+        l = tlog_json_esc_span(in, in_len, false);
+        if (l > 0) {
+            res_len += l;
+            if (!out_of_space) {
+                size_t fit = l;
+                if (out_len <= l) {
+                    /* Cut before the first character that doesn't fit */
+                    fit = out_len > 0 ? out_len - 1 : 0;
+                    while (fit > 0 && (in[fit] & 0xc0) == 0x80) {
+                        fit--;
                     }
+                    out_of_space = true;
                 }
+                if (fit > 0) {
+                    memcpy(out_ptr, in, fit);
+                    out_ptr += fit;
+                    out_len -= fit;
+                }
+            }
+            in += l;
+            in_len -= l;
+            if (in_len == 0) {
                 break;
             }
         }
-        tlog_utf8_reset(&utf8);
-    }
 
-    if (tlog_utf8_is_started(&utf8) && !tlog_utf8_is_ended(&utf8)) {
-        if (REQ(utf8.len)) {
-            memcpy(out_ptr, utf8.buf, utf8.len);
-            out_ptr += utf8.len;
+        /* Escape the byte ending the span */
+        l = tlog_json_esc_byte(NULL, *in);
+        if (REQ(l)) {
+            tlog_json_esc_byte((uint8_t *)out_ptr, *in);
+            out_ptr += l;
         }
+        in++;
+        in_len--;
     }
 
     if (out_len > 0) {
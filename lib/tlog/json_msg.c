@@ -23,8 +23,7 @@
 #include <assert.h>
 #include <string.h>
 #include <limits.h>
-#include <float.h>
-#include <stdio.h>
+#include <json_tokener.h>
 #include <tlog/rc.h>
 #include <tlog/timespec.h>
 #include <tlog/delay.h>
@@ -38,181 +37,1237 @@ tlog_json_msg_is_valid(const struct tlog_json_msg *msg)
         return false;
     }
 
-    if (msg->obj == NULL) {
-        return true;
+    if (msg->host == NULL) {
+        return msg->buf == NULL;
     }
 
-    return msg->host != NULL &&
-           msg->user != NULL &&
+    return msg->user != NULL &&
            msg->term != NULL &&
            msg->session > 0 &&
            msg->timing_ptr != NULL &&
            msg->in_txt_ptr != NULL &&
-           msg->in_bin_obj != NULL &&
-           msg->in_bin_pos >= 0 &&
+           msg->in_bin_ptr != NULL &&
            msg->out_txt_ptr != NULL &&
-           msg->out_bin_obj != NULL &&
-           msg->out_bin_pos >= 0;
+           msg->out_bin_ptr != NULL;
 }
 
 bool
 tlog_json_msg_is_void(const struct tlog_json_msg *msg)
 {
     assert(tlog_json_msg_is_valid(msg));
-    return msg->obj == NULL;
+    return msg->host == NULL;
 }
 
-tlog_grc
-tlog_json_msg_init(struct tlog_json_msg *msg, struct json_object *obj)
+/** Global return code of a syntax error in a message text */
+#define TLOG_JSON_MSG_GRC_SYNTAX \
+    TLOG_GRC_FROM(json, json_tokener_error_parse_unexpected)
+
+/** Global return code of a message text ending prematurely */
+#define TLOG_JSON_MSG_GRC_EOF \
+    TLOG_GRC_FROM(json, json_tokener_continue)
+
+/** Maximum nesting depth of skipped values, the json-c default */
+#define TLOG_JSON_MSG_DEPTH_MAX 32
+
+/** Message fields, in the order they're validated in */
+enum tlog_json_msg_field {
+    TLOG_JSON_MSG_FIELD_VER,
+    TLOG_JSON_MSG_FIELD_HOST,
+    TLOG_JSON_MSG_FIELD_REC,
+    TLOG_JSON_MSG_FIELD_USER,
+    TLOG_JSON_MSG_FIELD_TERM,
+    TLOG_JSON_MSG_FIELD_SESSION,
+    TLOG_JSON_MSG_FIELD_ID,
+    TLOG_JSON_MSG_FIELD_POS,
+    TLOG_JSON_MSG_FIELD_TIME,
+    TLOG_JSON_MSG_FIELD_TIMING,
+    TLOG_JSON_MSG_FIELD_IN_TXT,
+    TLOG_JSON_MSG_FIELD_IN_BIN,
+    TLOG_JSON_MSG_FIELD_OUT_TXT,
+    TLOG_JSON_MSG_FIELD_OUT_BIN,
+    TLOG_JSON_MSG_FIELD_ELIDED,
+    TLOG_JSON_MSG_FIELD_NUM
+};
+
+/** Message field descriptions, indexed by enum tlog_json_msg_field */
+static const struct {
+    const char *name;       /**< Field (property) name */
+    bool        required;   /**< True if the field is required */
+} tlog_json_msg_field_list[TLOG_JSON_MSG_FIELD_NUM] = {
+    [TLOG_JSON_MSG_FIELD_VER]       = {"ver",       true},
+    [TLOG_JSON_MSG_FIELD_HOST]      = {"host",      true},
+    [TLOG_JSON_MSG_FIELD_REC]       = {"rec",       false},
+    [TLOG_JSON_MSG_FIELD_USER]      = {"user",      true},
+    [TLOG_JSON_MSG_FIELD_TERM]      = {"term",      true},
+    [TLOG_JSON_MSG_FIELD_SESSION]   = {"session",   true},
+    [TLOG_JSON_MSG_FIELD_ID]        = {"id",        true},
+    [TLOG_JSON_MSG_FIELD_POS]       = {"pos",       true},
+    [TLOG_JSON_MSG_FIELD_TIME]      = {"time",      false},
+    [TLOG_JSON_MSG_FIELD_TIMING]    = {"timing",    true},
+    [TLOG_JSON_MSG_FIELD_IN_TXT]    = {"in_txt",    false},
+    [TLOG_JSON_MSG_FIELD_IN_BIN]    = {"in_bin",    true},
+    [TLOG_JSON_MSG_FIELD_OUT_TXT]   = {"out_txt",   false},
+    [TLOG_JSON_MSG_FIELD_OUT_BIN]   = {"out_bin",   true},
+    [TLOG_JSON_MSG_FIELD_ELIDED]    = {"elided",    false},
+};
+
+/**
+ * Look up a message field by name, starting with the specified field, as
+ * the fields usually come in the same order.
+ *
+ * @param name  The field name to look up.
+ * @param len   Length of the name.
+ * @param first The field to start looking with.
+ *
+ * @return The field found, or TLOG_JSON_MSG_FIELD_NUM, if none.
+ */
+static enum tlog_json_msg_field
+tlog_json_msg_field_lookup(const char *name, size_t len,
+                           enum tlog_json_msg_field first)
 {
-    struct json_object *o;
-    int rc;
-    const char *str;
-    int end;
-    int64_t session;
-    int64_t id;
-    int64_t pos;
-    double time;
+    size_t i;
+    size_t field;
 
-    assert(msg != NULL);
+    for (i = 0; i < TLOG_JSON_MSG_FIELD_NUM; i++) {
+        field = (first + i) % TLOG_JSON_MSG_FIELD_NUM;
+        if (strlen(tlog_json_msg_field_list[field].name) == len &&
+            memcmp(tlog_json_msg_field_list[field].name, name, len) == 0) {
+            return field;
+        }
+    }
 
-    memset(msg, 0, sizeof(*msg));
+    return TLOG_JSON_MSG_FIELD_NUM;
+}
 
-    if (obj == NULL) {
-        assert(tlog_json_msg_is_valid(msg));
-        return true;
+/**
+ * Check if a character is a decimal digit, regardless of the locale.
+ *
+ * @param c The character to check.
+ *
+ * @return True if the character is a digit, false otherwise.
+ */
+static inline bool
+tlog_json_msg_is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * Skip whitespace in a message text.
+ *
+ * @param p     The text position to skip whitespace from.
+ * @param end   The end of the text.
+ *
+ * @return The text position after the whitespace.
+ */
+static char *
+tlog_json_msg_skip_space(char *p, const char *end)
+{
+    for (; p < end; p++) {
+        switch (*p) {
+        case ' ':
+        case '\f':
+        case '\n':
+        case '\r':
+        case '\t':
+        case '\v':
+            continue;
+        }
+        break;
     }
+    return p;
+}
 
-#define GET_FIELD(_name_token, _type_token) \
-    do {                                                            \
-        if (!json_object_object_get_ex(obj, #_name_token, &o)) {    \
-            return TLOG_RC_JSON_MSG_FIELD_MISSING;                  \
-        }                                                           \
-        if (json_object_get_type(o) != json_type_##_type_token) {   \
-            return TLOG_RC_JSON_MSG_FIELD_INVALID_TYPE;             \
-        }                                                           \
-    } while (0)
+/**
+ * Parse four hexadecimal digits of a string escape in a message text.
+ *
+ * @param p     The text position of the digits, at least four characters
+ *              long.
+ * @param pval  Location for the parsed value.
+ *
+ * @return True if the digits were valid, false otherwise.
+ */
+static bool
+tlog_json_msg_parse_hex4(const char *p, unsigned int *pval)
+{
+    unsigned int val = 0;
+    size_t i;
+    char c;
 
-#define GET_FIELD_ALT_TYPE2(_name_token, _type_token1, _type_token2) \
-    do {                                                                \
-        if (!json_object_object_get_ex(obj, #_name_token, &o)) {        \
-            return TLOG_RC_JSON_MSG_FIELD_MISSING;                      \
-        }                                                               \
-        if (json_object_get_type(o) != json_type_##_type_token1 &&      \
-            json_object_get_type(o) != json_type_##_type_token2) {      \
-            return TLOG_RC_JSON_MSG_FIELD_INVALID_TYPE;                 \
-        }                                                               \
-    } while (0)
+    for (i = 0; i < 4; i++) {
+        c = p[i];
+        if (c >= '0' && c <= '9') {
+            val = (val << 4) | (c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            val = (val << 4) | (c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            val = (val << 4) | (c - 'A' + 10);
+        } else {
+            return false;
+        }
+    }
+
+    *pval = val;
+    return true;
+}
+
+/**
+ * Parse a string in a message text, unescaping and zero-terminating it in
+ * place. As an escape sequence is never shorter than the character it
+ * encodes, the unescaped string always fits in place of the escaped one.
+ *
+ * @param ppos  Location of the text position of the opening quote, will
+ *              be set to the position after the closing quote.
+ * @param end   The end of the text.
+ * @param pstr  Location for the unescaped string pointer.
+ * @param plen  Location for the unescaped string length.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_json_msg_parse_str(char **ppos, const char *end,
+                        char **pstr, size_t *plen)
+{
+    char *start = *ppos + 1;
+    char *p = start;
+    char *o;
+    unsigned int c;
+    unsigned int low;
 
-#define GET_OPTIONAL_FIELD(_name_token, _type_token) \
-    do {                                                            \
-        if (json_object_object_get_ex(obj, #_name_token, &o) &&     \
-            json_object_get_type(o) != json_type_##_type_token) {   \
-            return TLOG_RC_JSON_MSG_FIELD_INVALID_TYPE;             \
-        }                                                           \
+    assert(**ppos == '"');
+
+    /* Skip to the end, or to the first escape, without moving anything */
+    while (p < end && *p != '"' && *p != '\\') {
+        p++;
+    }
+
+    /* Unescape the rest, if any */
+    for (o = p; ; ) {
+        if (p >= end) {
+            return TLOG_JSON_MSG_GRC_EOF;
+        } else if (*p == '"') {
+            break;
+        } else if (*p != '\\') {
+            *o++ = *p++;
+            continue;
+        }
+        p++;
+        if (p >= end) {
+            return TLOG_JSON_MSG_GRC_EOF;
+        }
+        switch (*p++) {
+        case '"':
+            *o++ = '"';
+            break;
+        case '\\':
+            *o++ = '\\';
+            break;
+        case '/':
+            *o++ = '/';
+            break;
+        case 'b':
+            *o++ = '\b';
+            break;
+        case 'f':
+            *o++ = '\f';
+            break;
+        case 'n':
+            *o++ = '\n';
+            break;
+        case 'r':
+            *o++ = '\r';
+            break;
+        case 't':
+            *o++ = '\t';
+            break;
+        case 'u':
+            if (end - p < 4) {
+                return TLOG_JSON_MSG_GRC_EOF;
+            }
+            if (!tlog_json_msg_parse_hex4(p, &c)) {
+                return TLOG_JSON_MSG_GRC_SYNTAX;
+            }
+            p += 4;
+            /* Combine surrogate pairs, replace unpaired surrogates */
+            if (c >= 0xd800 && c <= 0xdbff) {
+                if (end - p >= 6 && p[0] == '\\' && p[1] == 'u' &&
+                    tlog_json_msg_parse_hex4(p + 2, &low) &&
+                    low >= 0xdc00 && low <= 0xdfff) {
+                    c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+                    p += 6;
+                } else {
+                    c = 0xfffd;
+                }
+            } else if (c >= 0xdc00 && c <= 0xdfff) {
+                c = 0xfffd;
+            }
+            /* Encode as UTF-8 */
+            if (c < 0x80) {
+                *o++ = c;
+            } else if (c < 0x800) {
+                *o++ = 0xc0 | (c >> 6);
+                *o++ = 0x80 | (c & 0x3f);
+            } else if (c < 0x10000) {
+                *o++ = 0xe0 | (c >> 12);
+                *o++ = 0x80 | ((c >> 6) & 0x3f);
+                *o++ = 0x80 | (c & 0x3f);
+            } else {
+                *o++ = 0xf0 | (c >> 18);
+                *o++ = 0x80 | ((c >> 12) & 0x3f);
+                *o++ = 0x80 | ((c >> 6) & 0x3f);
+                *o++ = 0x80 | (c & 0x3f);
+            }
+            break;
+        default:
+            return TLOG_JSON_MSG_GRC_SYNTAX;
+        }
+    }
+
+    /* Terminate over the closing quote, or the leftover escapes */
+    *o = '\0';
+    *pstr = start;
+    *plen = o - start;
+    *ppos = p + 1;
+    return TLOG_RC_OK;
+}
+
+/**
+ * Parse a number in a message text, without converting it.
+ *
+ * @param ppos      Location of the text position of the number, will be
+ *                  set to the position after it.
+ * @param end       The end of the text.
+ * @param pint      Location for the flag set to true if the number is an
+ *                  integer, i.e. has no fraction or exponent, and to false
+ *                  otherwise.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_json_msg_parse_num(char **ppos, const char *end, bool *pint)
+{
+    char *p = *ppos;
+    bool is_int = true;
+
+#define DIGITS \
+    do {                                            \
+        if (p >= end) {                             \
+            return TLOG_JSON_MSG_GRC_EOF;           \
+        }                                           \
+        if (!tlog_json_msg_is_digit(*p)) {          \
+            return TLOG_JSON_MSG_GRC_SYNTAX;        \
+        }                                           \
+        do {                                        \
+            p++;                                    \
+        } while (p < end && tlog_json_msg_is_digit(*p)); \
     } while (0)
 
-    GET_FIELD_ALT_TYPE2(ver, string, int);
-    /* NOTE: Converting number to string can fail */
-    str = json_object_get_string(o);
-    if (str == NULL) {
-        return TLOG_GRC_ERRNO;
+    if (p < end && *p == '-') {
+        p++;
     }
-    end = 0;
-    rc = sscanf(str, "%u%n.%u%n",
-                &msg->ver_major, &end, &msg->ver_minor, &end);
-    if (rc < 1 || str[end] != '\0' || msg->ver_major > 2) {
-        return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_VER;
+    DIGITS;
+    if (p < end && *p == '.') {
+        p++;
+        is_int = false;
+        DIGITS;
     }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        is_int = false;
+        if (p < end && (*p == '+' || *p == '-')) {
+            p++;
+        }
+        DIGITS;
+    }
+
+#undef DIGITS
 
-    GET_FIELD(host, string);
-    msg->host = json_object_get_string(o);
+    *ppos = p;
+    *pint = is_int;
+    return TLOG_RC_OK;
+}
 
-    GET_OPTIONAL_FIELD(rec, string);
-    msg->rec = json_object_get_string(o);
+/**
+ * Convert an integer number from a message text, saturating on overflow.
+ *
+ * @param p     The number text position.
+ * @param end   The end of the number text.
+ *
+ * @return The number value.
+ */
+static int64_t
+tlog_json_msg_num_to_int(const char *p, const char *end)
+{
+    bool neg = (*p == '-');
+    uint64_t max = (uint64_t)INT64_MAX + neg;
+    uint64_t val = 0;
+    unsigned int d;
 
-    GET_FIELD(user, string);
-    msg->user = json_object_get_string(o);
+    for (p += neg; p < end; p++) {
+        d = *p - '0';
+        if (val > (max - d) / 10) {
+            return neg ? INT64_MIN : INT64_MAX;
+        }
+        val = val * 10 + d;
+    }
 
-    GET_FIELD(term, string);
-    msg->term = json_object_get_string(o);
+    return neg ? (int64_t)(0 - val) : (int64_t)val;
+}
 
-    GET_FIELD(session, int);
-    session = json_object_get_int64(o);
-    if (session < 1 || session > UINT_MAX) {
-        return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_SESSION;
+/**
+ * Convert a non-negative number from a message text to a timespec, exactly,
+ * up to nanoseconds.
+ *
+ * @param p     The number text position.
+ * @param end   The end of the number text.
+ * @param pts   Location for the converted timespec.
+ *
+ * @return True if the number was converted, false if it is negative, or
+ *         is out of range.
+ */
+static bool
+tlog_json_msg_num_to_timespec(const char *p, const char *end,
+                              struct timespec *pts)
+{
+    bool neg = false;
+    bool zero = true;
+    const char *int_ptr;
+    size_t int_len;
+    const char *frac_ptr = "";
+    size_t frac_len = 0;
+    long exp = 0;
+    long point;
+    long i;
+    char d;
+    struct timespec ts = TLOG_TIMESPEC_ZERO;
+
+    if (*p == '-') {
+        neg = true;
+        p++;
+    }
+    for (int_ptr = p; p < end && tlog_json_msg_is_digit(*p); p++);
+    int_len = p - int_ptr;
+    if (p < end && *p == '.') {
+        for (frac_ptr = ++p; p < end && tlog_json_msg_is_digit(*p); p++);
+        frac_len = p - frac_ptr;
+    }
+    if (p < end) {
+        bool exp_neg = false;
+        p++;
+        if (*p == '+' || *p == '-') {
+            exp_neg = (*p++ == '-');
+        }
+        for (; p < end; p++) {
+            if (exp < 1000) {
+                exp = exp * 10 + (*p - '0');
+            }
+        }
+        if (exp_neg) {
+            exp = -exp;
+        }
     }
-    msg->session = (unsigned int)session;
 
-    GET_FIELD(id, int);
-    id = json_object_get_int64(o);
-    if (id < 0
+    /*
+     * Collect the digits before and after the decimal point, moved by the
+     * exponent, as the seconds and the nanoseconds
+     */
+    point = (long)int_len + exp;
+    if (point > 18) {
+        return false;
+    }
+    for (i = (point < 0 ? point : 0); i < point + 9; i++) {
+        if (i < 0 || (size_t)i >= int_len + frac_len) {
+            d = '0';
+        } else if ((size_t)i < int_len) {
+            d = int_ptr[i];
+        } else {
+            d = frac_ptr[i - int_len];
+        }
+        if (d != '0') {
+            zero = false;
+        }
+        if (i < point) {
+            ts.tv_sec = ts.tv_sec * 10 + (d - '0');
+        } else {
+            ts.tv_nsec = ts.tv_nsec * 10 + (d - '0');
+        }
+    }
+
+    if (neg && !zero) {
+        return false;
+    }
+    *pts = ts;
+    return true;
+}
+
+/**
+ * Skip a literal in a message text.
+ *
+ * @param ppos  Location of the text position of the literal, will be set
+ *              to the position after it.
+ * @param end   The end of the text.
+ * @param lit   The literal to skip.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_json_msg_skip_lit(char **ppos, const char *end, const char *lit)
+{
+    size_t len = strlen(lit);
+    size_t avail = end - *ppos;
+
+    if (avail < len) {
+        return memcmp(*ppos, lit, avail) == 0
+                    ? TLOG_JSON_MSG_GRC_EOF
+                    : TLOG_JSON_MSG_GRC_SYNTAX;
+    }
+    if (memcmp(*ppos, lit, len) != 0) {
+        return TLOG_JSON_MSG_GRC_SYNTAX;
+    }
+    *ppos += len;
+    return TLOG_RC_OK;
+}
+
+/**
+ * Skip a value of any type in a message text.
+ *
+ * @param ppos  Location of the text position of the value, will be set to
+ *              the position after it.
+ * @param end   The end of the text.
+ * @param depth Nesting depth of the value.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_json_msg_skip_value(char **ppos, const char *end, size_t depth)
+{
+    tlog_grc grc;
+    char *p = *ppos;
+    char *str;
+    size_t len;
+    bool is_int;
+    char close;
+
+    if (p >= end) {
+        return TLOG_JSON_MSG_GRC_EOF;
+    }
+
+    switch (*p) {
+    case '"':
+        return tlog_json_msg_parse_str(ppos, end, &str, &len);
+    case 't':
+        return tlog_json_msg_skip_lit(ppos, end, "true");
+    case 'f':
+        return tlog_json_msg_skip_lit(ppos, end, "false");
+    case 'n':
+        return tlog_json_msg_skip_lit(ppos, end, "null");
+    case '[':
+    case '{':
+        break;
+    default:
+        return tlog_json_msg_parse_num(ppos, end, &is_int);
+    }
+
+    /* Skip an array or an object */
+    if (depth >= TLOG_JSON_MSG_DEPTH_MAX) {
+        return TLOG_GRC_FROM(json, json_tokener_error_depth);
+    }
+    close = (*p == '[') ? ']' : '}';
+    p = tlog_json_msg_skip_space(p + 1, end);
+    if (p < end && *p == close) {
+        *ppos = p + 1;
+        return TLOG_RC_OK;
+    }
+    while (true) {
+        if (close == '}') {
+            if (p >= end) {
+                return TLOG_JSON_MSG_GRC_EOF;
+            } else if (*p != '"') {
+                return TLOG_JSON_MSG_GRC_SYNTAX;
+            }
+            grc = tlog_json_msg_parse_str(&p, end, &str, &len);
+            if (grc != TLOG_RC_OK) {
+                return grc;
+            }
+            p = tlog_json_msg_skip_space(p, end);
+            if (p >= end) {
+                return TLOG_JSON_MSG_GRC_EOF;
+            } else if (*p != ':') {
+                return TLOG_JSON_MSG_GRC_SYNTAX;
+            }
+            p = tlog_json_msg_skip_space(p + 1, end);
+        }
+        grc = tlog_json_msg_skip_value(&p, end, depth + 1);
+        if (grc != TLOG_RC_OK) {
+            return grc;
+        }
+        p = tlog_json_msg_skip_space(p, end);
+        if (p >= end) {
+            return TLOG_JSON_MSG_GRC_EOF;
+        } else if (*p == close) {
+            break;
+        } else if (*p != ',') {
+            return TLOG_JSON_MSG_GRC_SYNTAX;
+        }
+        p = tlog_json_msg_skip_space(p + 1, end);
+    }
+
+    *ppos = p + 1;
+    return TLOG_RC_OK;
+}
+
+/**
+ * Parse a binary array in a message text, converting it to bytes in place.
+ * As every array element takes at least two characters, except the last
+ * one, the bytes always fit in place of the array. Stop converting at the
+ * first element which is not a byte value, leaving the rest to fail the
+ * reading of the message, once it reaches them.
+ *
+ * @param ppos  Location of the text position of the opening bracket, will
+ *              be set to the position after the closing bracket.
+ * @param end   The end of the text.
+ * @param pptr  Location for the pointer to the bytes.
+ * @param plen  Location for the number of the bytes, up to the first
+ *              invalid element.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_json_msg_parse_bin(char **ppos, const char *end,
+                        const uint8_t **pptr, size_t *plen)
+{
+    tlog_grc grc;
+    uint8_t *o = (uint8_t *)*ppos;
+    char *p = *ppos;
+    char *start;
+    bool valid = true;
+    bool is_int;
+    size_t len = 0;
+    int64_t val;
+
+    assert(*p == '[');
+
+    p = tlog_json_msg_skip_space(p + 1, end);
+    if (p < end && *p == ']') {
+        p++;
+    } else {
+        while (true) {
+            start = p;
+            if (p < end && (*p == '-' || tlog_json_msg_is_digit(*p))) {
+                grc = tlog_json_msg_parse_num(&p, end, &is_int);
+                if (grc != TLOG_RC_OK) {
+                    return grc;
+                }
+                if (valid && is_int) {
+                    val = tlog_json_msg_num_to_int(start, p);
+                    if (val >= 0 && val <= UINT8_MAX) {
+                        o[len++] = (uint8_t)val;
+                    } else {
+                        valid = false;
+                    }
+                } else {
+                    valid = false;
+                }
+            } else {
+                grc = tlog_json_msg_skip_value(&p, end, 1);
+                if (grc != TLOG_RC_OK) {
+                    return grc;
+                }
+                valid = false;
+            }
+            p = tlog_json_msg_skip_space(p, end);
+            if (p >= end) {
+                return TLOG_JSON_MSG_GRC_EOF;
+            } else if (*p == ']') {
+                p++;
+                break;
+            } else if (*p != ',') {
+                return TLOG_JSON_MSG_GRC_SYNTAX;
+            }
+            p = tlog_json_msg_skip_space(p + 1, end);
+        }
+    }
+
+    *pptr = o;
+    *plen = len;
+    *ppos = p;
+    return TLOG_RC_OK;
+}
+
+/**
+ * Parse a message version text.
+ *
+ * @param msg   The message to store the version in.
+ * @param p     The version text position.
+ * @param end   The end of the version text.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_json_msg_parse_ver(struct tlog_json_msg *msg,
+                        const char *p, const char *end)
+{
+    unsigned int *pnum = &msg->ver_major;
+
+    while (true) {
+        if (p >= end || !tlog_json_msg_is_digit(*p)) {
+            return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_VER;
+        }
+        for (*pnum = 0; p < end && tlog_json_msg_is_digit(*p); p++) {
+            if (*pnum > (UINT_MAX - 9) / 10) {
+                return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_VER;
+            }
+            *pnum = *pnum * 10 + (*p - '0');
+        }
+        if (p >= end) {
+            break;
+        } else if (*p != '.' || pnum == &msg->ver_minor) {
+            return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_VER;
+        }
+        p++;
+        pnum = &msg->ver_minor;
+    }
+
+    return msg->ver_major > 2
+                ? TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_VER
+                : TLOG_RC_OK;
+}
+
+/**
+ * Parse a message field value in a message text.
+ *
+ * @param msg           The message to store the field value in.
+ * @param field         The field to parse the value of.
+ * @param ppos          Location of the text position of the value, will
+ *                      be set to the position after it.
+ * @param end           The end of the text.
+ * @param pfield_grc    Location for the result of the field validation.
+ *
+ * @return Global return code of the text parsing.
+ */
+static tlog_grc
+tlog_json_msg_parse_field(struct tlog_json_msg *msg,
+                          enum tlog_json_msg_field field,
+                          char **ppos, const char *end,
+                          tlog_grc *pfield_grc)
+{
+    tlog_grc grc;
+    char *start = *ppos;
+    char *str;
+    size_t len;
+    bool is_int;
+    int64_t val;
+
+    assert(start < end);
+
+    /* Parse the value of the expected type */
+    switch (field) {
+    case TLOG_JSON_MSG_FIELD_VER:
+        if (*start == '"') {
+            grc = tlog_json_msg_parse_str(ppos, end, &str, &len);
+            if (grc == TLOG_RC_OK) {
+                *pfield_grc = tlog_json_msg_parse_ver(msg, str, str + len);
+            }
+            return grc;
+        }
+        /* FALLTHROUGH */
+    case TLOG_JSON_MSG_FIELD_SESSION:
+    case TLOG_JSON_MSG_FIELD_ID:
+    case TLOG_JSON_MSG_FIELD_POS:
+    case TLOG_JSON_MSG_FIELD_ELIDED:
+        if (*start != '-' && !tlog_json_msg_is_digit(*start)) {
+            break;
+        }
+        grc = tlog_json_msg_parse_num(ppos, end, &is_int);
+        if (grc != TLOG_RC_OK) {
+            return grc;
+        }
+        if (!is_int) {
+            *pfield_grc = TLOG_RC_JSON_MSG_FIELD_INVALID_TYPE;
+            return TLOG_RC_OK;
+        }
+        if (field == TLOG_JSON_MSG_FIELD_VER) {
+            *pfield_grc = tlog_json_msg_parse_ver(msg, start, *ppos);
+            return TLOG_RC_OK;
+        }
+        val = tlog_json_msg_num_to_int(start, *ppos);
+        *pfield_grc = TLOG_RC_OK;
+        if (field == TLOG_JSON_MSG_FIELD_SESSION) {
+            if (val < 1 || val > UINT_MAX) {
+                *pfield_grc = TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_SESSION;
+            }
+            msg->session = (unsigned int)val;
+        } else if (field == TLOG_JSON_MSG_FIELD_POS) {
+            if (val < 0 || val > TLOG_DELAY_MAX_MS_NUM) {
+                *pfield_grc = TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_POS;
+            }
+            msg->pos.tv_sec = val / 1000;
+            msg->pos.tv_nsec = val % 1000 * 1000000;
+        } else {
+            if (val < 0
 #if INT64_MAX > SIZE_MAX
-        || id > (int64_t)SIZE_MAX
+                || val > (int64_t)SIZE_MAX
 #endif
-    ) {
-        return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_ID;
+            ) {
+                *pfield_grc = (field == TLOG_JSON_MSG_FIELD_ID)
+                        ? TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_ID
+                        : TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_ELIDED;
+            }
+            if (field == TLOG_JSON_MSG_FIELD_ID) {
+                msg->id = (size_t)val;
+            } else {
+                msg->elided = (size_t)val;
+            }
+        }
+        return TLOG_RC_OK;
+    case TLOG_JSON_MSG_FIELD_TIME:
+        if (*start != '-' && !tlog_json_msg_is_digit(*start)) {
+            break;
+        }
+        grc = tlog_json_msg_parse_num(ppos, end, &is_int);
+        if (grc != TLOG_RC_OK) {
+            return grc;
+        }
+        if (is_int) {
+            *pfield_grc = TLOG_RC_JSON_MSG_FIELD_INVALID_TYPE;
+        } else if (!tlog_json_msg_num_to_timespec(start, *ppos,
+                                                  &msg->time)) {
+            *pfield_grc = TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_TIME;
+        } else {
+            *pfield_grc = TLOG_RC_OK;
+        }
+        return TLOG_RC_OK;
+    case TLOG_JSON_MSG_FIELD_IN_BIN:
+    case TLOG_JSON_MSG_FIELD_OUT_BIN:
+        if (*start != '[') {
+            break;
+        }
+        *pfield_grc = TLOG_RC_OK;
+        return (field == TLOG_JSON_MSG_FIELD_IN_BIN)
+                ? tlog_json_msg_parse_bin(ppos, end, &msg->in_bin_ptr,
+                                          &msg->in_bin_len)
+                : tlog_json_msg_parse_bin(ppos, end, &msg->out_bin_ptr,
+                                          &msg->out_bin_len);
+    default:
+        if (*start != '"') {
+            break;
+        }
+        grc = tlog_json_msg_parse_str(ppos, end, &str, &len);
+        if (grc != TLOG_RC_OK) {
+            return grc;
+        }
+        *pfield_grc = TLOG_RC_OK;
+        switch (field) {
+        case TLOG_JSON_MSG_FIELD_HOST:
+            msg->host = str;
+            break;
+        case TLOG_JSON_MSG_FIELD_REC:
+            msg->rec = str;
+            break;
+        case TLOG_JSON_MSG_FIELD_USER:
+            msg->user = str;
+            break;
+        case TLOG_JSON_MSG_FIELD_TERM:
+            msg->term = str;
+            break;
+        case TLOG_JSON_MSG_FIELD_TIMING:
+            msg->timing_ptr = str;
+            break;
+        case TLOG_JSON_MSG_FIELD_IN_TXT:
+            msg->in_txt_ptr = str;
+            msg->in_txt_len = len;
+            break;
+        case TLOG_JSON_MSG_FIELD_OUT_TXT:
+            msg->out_txt_ptr = str;
+            msg->out_txt_len = len;
+            break;
+        default:
+            assert(false);
+        }
+        return TLOG_RC_OK;
     }
-    msg->id = (size_t)id;
 
-    GET_FIELD(pos, int);
-    pos = json_object_get_int64(o);
-    if (pos < 0 || pos > TLOG_DELAY_MAX_MS_NUM) {
-        return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_POS;
+    /* Skip the value of unexpected type */
+    *pfield_grc = TLOG_RC_JSON_MSG_FIELD_INVALID_TYPE;
+    return tlog_json_msg_skip_value(ppos, end, 1);
+}
+
+tlog_grc
+tlog_json_msg_init_text(struct tlog_json_msg *msg, char *text, size_t len)
+{
+    tlog_grc grc;
+    tlog_grc field_grc[TLOG_JSON_MSG_FIELD_NUM];
+    enum tlog_json_msg_field field;
+    enum tlog_json_msg_field next_field = 0;
+    const char *end = text + len;
+    char *p;
+    char *key;
+    size_t key_len;
+
+    assert(msg != NULL);
+    assert(text != NULL || len == 0);
+
+    memset(msg, 0, sizeof(*msg));
+
+    for (field = 0; field < TLOG_JSON_MSG_FIELD_NUM; field++) {
+        field_grc[field] = tlog_json_msg_field_list[field].required
+                                ? TLOG_RC_JSON_MSG_FIELD_MISSING
+                                : TLOG_RC_OK;
     }
-    msg->pos.tv_sec = pos / 1000;
-    msg->pos.tv_nsec = pos % 1000 * 1000000;
 
-    GET_OPTIONAL_FIELD(time, double);
-    time = json_object_get_double(o);
-    if (time < 0 || time > DBL_MAX) {
-        return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_TIME;
+    p = tlog_json_msg_skip_space(text, end);
+    if (p >= end) {
+        grc = TLOG_JSON_MSG_GRC_EOF;
+        goto error;
     }
-    str = json_object_get_string(o);
-    if (str == NULL) {
-        msg->time = TLOG_TIMESPEC_ZERO;
+
+    /* Treat any other value as an object missing the fields */
+    if (*p != '{') {
+        grc = tlog_json_msg_skip_value(&p, end, 0);
+        if (grc == TLOG_RC_OK) {
+            grc = TLOG_RC_JSON_MSG_FIELD_MISSING;
+        }
+        goto error;
+    }
+
+    /* Parse the object, in a single pass */
+    p = tlog_json_msg_skip_space(p + 1, end);
+    if (p < end && *p == '}') {
+        p++;
     } else {
-        rc = sscanf(str, "%ld.%03ld",
-                    &msg->time.tv_sec, &msg->time.tv_nsec);
-        if (rc < 1) {
-            return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_TIME;
+        while (true) {
+            if (p >= end) {
+                grc = TLOG_JSON_MSG_GRC_EOF;
+                goto error;
+            } else if (*p != '"') {
+                grc = TLOG_JSON_MSG_GRC_SYNTAX;
+                goto error;
+            }
+            grc = tlog_json_msg_parse_str(&p, end, &key, &key_len);
+            if (grc != TLOG_RC_OK) {
+                goto error;
+            }
+            p = tlog_json_msg_skip_space(p, end);
+            if (p >= end) {
+                grc = TLOG_JSON_MSG_GRC_EOF;
+                goto error;
+            } else if (*p != ':') {
+                grc = TLOG_JSON_MSG_GRC_SYNTAX;
+                goto error;
+            }
+            p = tlog_json_msg_skip_space(p + 1, end);
+            if (p >= end) {
+                grc = TLOG_JSON_MSG_GRC_EOF;
+                goto error;
+            }
+
+            field = tlog_json_msg_field_lookup(key, key_len, next_field);
+            if (field < TLOG_JSON_MSG_FIELD_NUM) {
+                grc = tlog_json_msg_parse_field(msg, field, &p, end,
+                                                &field_grc[field]);
+                next_field = (field + 1) % TLOG_JSON_MSG_FIELD_NUM;
+            } else {
+                grc = tlog_json_msg_skip_value(&p, end, 1);
+            }
+            if (grc != TLOG_RC_OK) {
+                goto error;
+            }
+
+            p = tlog_json_msg_skip_space(p, end);
+            if (p >= end) {
+                grc = TLOG_JSON_MSG_GRC_EOF;
+                goto error;
+            } else if (*p == '}') {
+                break;
+            } else if (*p != ',') {
+                grc = TLOG_JSON_MSG_GRC_SYNTAX;
+                goto error;
+            }
+            p = tlog_json_msg_skip_space(p + 1, end);
         }
     }
 
-    GET_FIELD(timing, string);
-    msg->timing_ptr = json_object_get_string(o);
+    /* Report the first invalid field */
+    for (field = 0; field < TLOG_JSON_MSG_FIELD_NUM; field++) {
+        if (field_grc[field] != TLOG_RC_OK) {
+            grc = field_grc[field];
+            goto error;
+        }
+    }
 
-    GET_OPTIONAL_FIELD(in_txt, string);
-    if (o == NULL) {
+    /* Default the optional fields */
+    if (msg->in_txt_ptr == NULL) {
         msg->in_txt_ptr = "";
-        msg->in_txt_len = 0;
-    } else {
-        msg->in_txt_ptr = json_object_get_string(o);
-        msg->in_txt_len = (size_t)json_object_get_string_len(o);
     }
+    if (msg->out_txt_ptr == NULL) {
+        msg->out_txt_ptr = "";
+    }
+
+    assert(tlog_json_msg_is_valid(msg));
+    return TLOG_RC_OK;
 
-    GET_FIELD(in_bin, array);
-    msg->in_bin_obj = o;
-    msg->in_bin_pos = 0;
+error:
+    memset(msg, 0, sizeof(*msg));
+    return grc;
+}
 
-    GET_OPTIONAL_FIELD(out_txt, string);
-    if (o == NULL) {
-        msg->out_txt_ptr = "";
-        msg->out_txt_len = 0;
-    } else {
-        msg->out_txt_ptr = json_object_get_string(o);
-        msg->out_txt_len = (size_t)json_object_get_string_len(o);
+/**
+ * Scan past a string in a message text, without unescaping it.
+ *
+ * @param p     The text position of the opening quote.
+ * @param end   The end of the text.
+ *
+ * @return The text position after the closing quote, or NULL if the
+ *         string is not terminated.
+ */
+static const char *
+tlog_json_msg_scan_str(const char *p, const char *end)
+{
+    const char *q;
+    const char *e;
+
+    assert(*p == '"');
+
+    for (p++; ; p = q + 1) {
+        q = memchr(p, '"', end - p);
+        if (q == NULL) {
+            return NULL;
+        }
+        /* The quote is escaped, if preceded by an odd number of escapes */
+        for (e = q; e > p && e[-1] == '\\'; e--);
+        if ((q - e) % 2 == 0) {
+            return q + 1;
+        }
     }
+}
 
-    GET_FIELD(out_bin, array);
-    msg->out_bin_obj = o;
-    msg->out_bin_pos = 0;
+/**
+ * Scan past a value of any type in a message text, without validating it.
+ *
+ * @param p     The text position of the value.
+ * @param end   The end of the text.
+ *
+ * @return The text position after the value, or NULL if the value is not
+ *         terminated.
+ */
+static const char *
+tlog_json_msg_scan_value(const char *p, const char *end)
+{
+    size_t depth = 0;
 
-#undef GET_OPTIONAL_FIELD
-#undef GET_FIELD_ALT_TYPE2
-#undef GET_FIELD
+    for (; p < end; p++) {
+        switch (*p) {
+        case '"':
+            p = tlog_json_msg_scan_str(p, end);
+            if (p == NULL) {
+                return NULL;
+            }
+            if (depth == 0) {
+                return p;
+            }
+            p--;
+            break;
+        case '[':
+        case '{':
+            depth++;
+            break;
+        case ']':
+        case '}':
+            if (depth == 0) {
+                return p;
+            }
+            if (--depth == 0) {
+                return p + 1;
+            }
+            break;
+        case ',':
+        case ' ':
+        case '\f':
+        case '\n':
+        case '\r':
+        case '\t':
+        case '\v':
+            if (depth == 0) {
+                return p;
+            }
+            break;
+        }
+    }
+
+    return depth == 0 ? p : NULL;
+}
+
+/**
+ * Check if a scanned message text value can be equal to a string.
+ *
+ * @param p     The text position of the value.
+ * @param end   The text position after the value.
+ * @param str   The string to compare the value to.
+ *
+ * @return False if the value is a string not equal to the specified one,
+ *         true otherwise.
+ */
+static bool
+tlog_json_msg_scan_str_may_equal(const char *p, const char *end,
+                                 const char *str)
+{
+    size_t len = end - p - 2;
+
+    /* Leave anything but strings without escapes to parsing */
+    if (*p != '"' || memchr(p + 1, '\\', len) != NULL) {
+        return true;
+    }
+    return strlen(str) == len && memcmp(p + 1, str, len) == 0;
+}
+
+/**
+ * Check if a scanned message text value can be equal to an unsigned
+ * integer.
+ *
+ * @param p     The text position of the value.
+ * @param end   The text position after the value.
+ * @param num   The number to compare the value to.
+ *
+ * @return False if the value is an integer not equal to the specified
+ *         one, true otherwise.
+ */
+static bool
+tlog_json_msg_scan_uint_may_equal(const char *p, const char *end,
+                                  unsigned int num)
+{
+    uint64_t val = 0;
+
+    /* Leave anything but short unsigned integers to parsing */
+    if (end - p > 10) {
+        return true;
+    }
+    for (; p < end; p++) {
+        if (!tlog_json_msg_is_digit(*p)) {
+            return true;
+        }
+        val = val * 10 + (*p - '0');
+    }
+    return val == num;
+}
+
+bool
+tlog_json_msg_text_may_match(const char *text, size_t len,
+                             const struct tlog_json_msg_filter *filter)
+{
+    const char *end = text + len;
+    const char *p;
+    const char *key;
+    const char *value;
+    size_t key_len;
+    size_t left;
+    bool filtered;
+    bool match;
+
+    assert(text != NULL || len == 0);
+    assert(filter != NULL);
+
+    left = (filter->host != NULL) + (filter->rec != NULL) +
+           (filter->user != NULL) + (filter->session != 0);
+    if (left == 0) {
+        return true;
+    }
+
+    p = tlog_json_msg_skip_space((char *)text, end);
+    if (p >= end || *p != '{') {
+        return true;
+    }
+    p = tlog_json_msg_skip_space((char *)p + 1, end);
+
+    /* Until all filtered fields are seen */
+    while (left > 0) {
+        if (p >= end || *p != '"') {
+            return true;
+        }
+        key = p + 1;
+        p = tlog_json_msg_scan_str(p, end);
+        if (p == NULL) {
+            return true;
+        }
+        key_len = p - 1 - key;
+        p = tlog_json_msg_skip_space((char *)p, end);
+        if (p >= end || *p != ':') {
+            return true;
+        }
+        value = tlog_json_msg_skip_space((char *)p + 1, end);
+        p = tlog_json_msg_scan_value(value, end);
+        if (p == NULL || p == value) {
+            return true;
+        }
+
+#define FIELD_IS(_name) \
+    (key_len == sizeof(_name) - 1 && memcmp(key, _name, key_len) == 0)
+        filtered = true;
+        if (filter->host != NULL && FIELD_IS("host")) {
+            match = tlog_json_msg_scan_str_may_equal(value, p, filter->host);
+        } else if (filter->rec != NULL && FIELD_IS("rec")) {
+            match = tlog_json_msg_scan_str_may_equal(value, p, filter->rec);
+        } else if (filter->user != NULL && FIELD_IS("user")) {
+            match = tlog_json_msg_scan_str_may_equal(value, p, filter->user);
+        } else if (filter->session != 0 && FIELD_IS("session")) {
+            match = tlog_json_msg_scan_uint_may_equal(value, p,
+                                                      filter->session);
+        } else {
+            filtered = false;
+            match = true;
+        }
+#undef FIELD_IS
+        if (!match) {
+            return false;
+        }
+        if (filtered) {
+            left--;
+        }
+
+        p = tlog_json_msg_skip_space((char *)p, end);
+        if (p >= end || *p != ',') {
+            return true;
+        }
+        p = tlog_json_msg_skip_space((char *)p + 1, end);
+    }
+
+    return true;
+}
+
+tlog_grc
+tlog_json_msg_init(struct tlog_json_msg *msg, struct json_object *obj)
+{
+    tlog_grc grc;
+    const char *str;
+    size_t len;
+    char *buf;
+
+    assert(msg != NULL);
+
+    memset(msg, 0, sizeof(*msg));
+
+    if (obj == NULL) {
+        assert(tlog_json_msg_is_valid(msg));
+        return TLOG_RC_OK;
+    }
+
+    str = json_object_to_json_string_ext(obj, JSON_C_TO_STRING_PLAIN);
+    if (str == NULL) {
+        return TLOG_GRC_ERRNO;
+    }
+    len = strlen(str);
+    buf = malloc(len);
+    if (buf == NULL) {
+        return TLOG_GRC_ERRNO;
+    }
+    memcpy(buf, str, len);
+
+    grc = tlog_json_msg_init_text(msg, buf, len);
+    if (grc != TLOG_RC_OK) {
+        free(buf);
+        return grc;
+    }
+    msg->buf = buf;
 
-    msg->obj = json_object_get(obj);
     assert(tlog_json_msg_is_valid(msg));
     return TLOG_RC_OK;
 }
@@ -240,6 +1295,88 @@ tlog_json_msg_utf8_len(uint8_t b)
     }
 };
 
+/**
+ * Decode an unsigned decimal number of a timing record.
+ *
+ * @param pptr  Location of the timing string position of the number, will
+ *              be set to the position after it.
+ * @param pval  Location for the number, saturated to UINT64_MAX on
+ *              overflow.
+ *
+ * @return True if the number was decoded, false if there were no digits.
+ */
+static inline bool
+tlog_json_msg_timing_num(const char **pptr, uint64_t *pval)
+{
+    const char *p = *pptr;
+    uint64_t val = 0;
+    unsigned int d;
+
+    d = (unsigned char)*p - '0';
+    if (d > 9) {
+        return false;
+    }
+    do {
+        val = (val > (UINT64_MAX - d) / 10) ? UINT64_MAX : val * 10 + d;
+        d = (unsigned char)*++p - '0';
+    } while (d <= 9);
+
+    *pptr = p;
+    *pval = val;
+    return true;
+}
+
+/**
+ * Decode a timing record: a type character followed by a number, and by
+ * a separator and another number, for binary I/O and window records.
+ *
+ * @param pptr      Location of the timing string position of the record,
+ *                  will be set to the position after it.
+ * @param ptype     Location for the record type character.
+ * @param pfirst    Location for the first number.
+ * @param psecond   Location for the second number, zero if none.
+ *
+ * @return True if the record was decoded, false if it is invalid.
+ */
+static bool
+tlog_json_msg_timing_decode(const char **pptr, char *ptype,
+                            uint64_t *pfirst, uint64_t *psecond)
+{
+    const char *p = *pptr;
+    char type = *p++;
+    char sep;
+
+    switch (type) {
+    case '[':
+    case ']':
+        sep = '/';
+        break;
+    case '=':
+        sep = 'x';
+        break;
+    case '<':
+    case '>':
+    case '+':
+        sep = 0;
+        break;
+    default:
+        return false;
+    }
+
+    if (!tlog_json_msg_timing_num(&p, pfirst)) {
+        return false;
+    }
+    if (sep == 0) {
+        *psecond = 0;
+    } else if (*p++ != sep || !tlog_json_msg_timing_num(&p, psecond)) {
+        return false;
+    }
+
+    *pptr = p;
+    *ptype = type;
+    return true;
+}
+
 tlog_grc
 tlog_json_msg_read(struct tlog_json_msg *msg, struct tlog_pkt *pkt,
                    uint8_t *io_buf, size_t io_size)
@@ -262,9 +1399,7 @@ tlog_json_msg_read(struct tlog_json_msg *msg, struct tlog_pkt *pkt,
          * Read next timing record if the current one is spent
          */
         if (msg->rem == 0) {
-            char            type_buf[2];
             char            type;
-            int             read;
             uint64_t        first_val;
             uint64_t        second_val;
             struct timespec delay;
@@ -293,26 +1428,10 @@ tlog_json_msg_read(struct tlog_json_msg *msg, struct tlog_pkt *pkt,
                 break;
             }
 
-            if (sscanf(timing_ptr, "%1[][><+=]%" SCNu64 "%n",
-                       type_buf, &first_val, &read) < 2) {
+            if (!tlog_json_msg_timing_decode(&timing_ptr, &type,
+                                             &first_val, &second_val)) {
                 return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_TIMING;
             }
-            type = *type_buf;
-            timing_ptr += read;
-
-            if (type == '[' || type == ']') {
-                if (sscanf(timing_ptr, "/%" SCNu64 "%n", &second_val, &read) < 1) {
-                    return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_TIMING;
-                }
-                timing_ptr += read;
-            } else if (type == '=') {
-                if (sscanf(timing_ptr, "x%" SCNu64 "%n", &second_val, &read) < 1) {
-                    return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_TIMING;
-                }
-                timing_ptr += read;
-            } else {
-                second_val = 0;
-            }
 
             /* If it is a delay record */
             if (type == '+') {
@@ -377,8 +1496,8 @@ tlog_json_msg_read(struct tlog_json_msg *msg, struct tlog_pkt *pkt,
                 msg->rem = second_val;
                 msg->ptxt_ptr = &msg->in_txt_ptr;
                 msg->ptxt_len = &msg->in_txt_len;
-                msg->bin_obj = msg->in_bin_obj;
-                msg->pbin_pos = &msg->in_bin_pos;
+                msg->pbin_ptr = &msg->in_bin_ptr;
+                msg->pbin_len = &msg->in_bin_len;
             /* If it is a text output record */
             } else if (type == '>') {
                 if (first_val > SIZE_MAX) {
@@ -399,8 +1518,8 @@ tlog_json_msg_read(struct tlog_json_msg *msg, struct tlog_pkt *pkt,
                 msg->rem = second_val;
                 msg->ptxt_ptr = &msg->out_txt_ptr;
                 msg->ptxt_len = &msg->out_txt_len;
-                msg->bin_obj = msg->out_bin_obj;
-                msg->pbin_pos = &msg->out_bin_pos;
+                msg->pbin_ptr = &msg->out_bin_ptr;
+                msg->pbin_len = &msg->out_bin_len;
             } else {
                 assert(false);
                 return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_TIMING;
@@ -409,6 +1528,15 @@ tlog_json_msg_read(struct tlog_json_msg *msg, struct tlog_pkt *pkt,
             /* Timing record consumed */
             msg->timing_ptr = timing_ptr;
 
+            /*
+             * If the output data was elided, skip the output record,
+             * keeping the delays, the input and the windows
+             */
+            if (msg->elided > 0 && msg->output) {
+                msg->rem = 0;
+                continue;
+            }
+
             if (msg->binary) {
                 size_t l;
                 /* Skip replacement characters */
@@ -449,30 +1577,24 @@ tlog_json_msg_read(struct tlog_json_msg *msg, struct tlog_pkt *pkt,
          * Append (a piece of) I/O to the output buffer
          */
         if (msg->binary) {
-            struct json_object *o;
-            int32_t n;
-
-            for (; msg->rem > 0; msg->rem--, io_len++, (*msg->pbin_pos)++) {
-                o = json_object_array_get_idx(msg->bin_obj, *msg->pbin_pos);
-                /* If not enough bytes */
-                if (o == NULL) {
-                    return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_BIN;
-                }
-                /* If supposed byte is not an int */
-                if (json_object_get_type(o) != json_type_int) {
-                    return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_BIN;
-                }
-                n = json_object_get_int(o);
-                /* If supposed byte value is out of range */
-                if (n < 0 || n > UINT8_MAX) {
-                    return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_BIN;
-                }
-                io_buf[io_len] = (uint8_t)n;
-                /* If the I/O buffer is full */
-                if (io_len >= io_size) {
-                    io_full = true;
-                    break;
-                }
+            size_t n;
+
+            n = io_size - io_len;
+            if (n > msg->rem) {
+                n = msg->rem;
+            }
+            /* If not enough (valid) bytes */
+            if (n > *msg->pbin_len) {
+                return TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_BIN;
+            }
+            memcpy(io_buf + io_len, *msg->pbin_ptr, n);
+            io_len += n;
+            msg->rem -= n;
+            *msg->pbin_ptr += n;
+            *msg->pbin_len -= n;
+            /* If the I/O buffer is full */
+            if (msg->rem > 0) {
+                io_full = true;
             }
         } else {
             uint8_t b;
@@ -521,9 +1643,7 @@ void
 tlog_json_msg_cleanup(struct tlog_json_msg *msg)
 {
     assert(tlog_json_msg_is_valid(msg));
-    if (msg->obj != NULL) {
-        json_object_put(msg->obj);
-        msg->obj = NULL;
-    }
+    free(msg->buf);
+    memset(msg, 0, sizeof(*msg));
     assert(tlog_json_msg_is_valid(msg));
 }
@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <tlog/json_reader.h>
+#include <tlog/json_msg.h>
 #include <tlog/rc.h>
 
 tlog_grc
@@ -115,6 +116,34 @@ tlog_json_reader_read(struct tlog_json_reader *reader,
     return grc;
 }
 
+tlog_grc
+tlog_json_reader_read_msg(struct tlog_json_reader *reader,
+                          struct tlog_json_msg *msg,
+                          const struct tlog_json_msg_filter *filter)
+{
+    tlog_grc grc;
+    struct json_object *obj = NULL;
+
+    assert(tlog_json_reader_is_valid(reader));
+    assert(msg != NULL);
+
+    if (reader->type->read_msg != NULL) {
+        grc = reader->type->read_msg(reader, msg, filter);
+    } else {
+        grc = reader->type->read(reader, &obj);
+        if (grc == TLOG_RC_OK) {
+            grc = tlog_json_msg_init(msg, obj);
+            json_object_put(obj);
+        } else {
+            tlog_json_msg_init(msg, NULL);
+        }
+    }
+    assert(tlog_json_msg_is_valid(msg));
+    assert(grc == TLOG_RC_OK || tlog_json_msg_is_void(msg));
+    assert(tlog_json_reader_is_valid(reader));
+    return grc;
+}
+
 void
 tlog_json_reader_destroy(struct tlog_json_reader *reader)
 {
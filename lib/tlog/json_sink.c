@@ -20,6 +20,7 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <config.h>
 #include <errno.h>
 #include <string.h>
 #include <assert.h>
@@ -28,7 +29,10 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <signal.h>
+#include <pthread.h>
 #include <syslog.h>
+#include <sys/uio.h>
 #include <tlog/json_sink.h>
 #include <tlog/json_misc.h>
 #include <tlog/timespec.h>
@@ -53,18 +57,70 @@ tlog_json_sink_params_is_valid(const struct tlog_json_sink_params *params)
            params->chunk_size >= TLOG_JSON_SINK_CHUNK_SIZE_MIN;
 }
 
+/**
+ * Size of the buffer for the id, pos, time, throttled and dropped byte
+ * count, and flush reason fields of a message
+ */
+#define TLOG_JSON_SINK_NUM_SIZE 320
+
+/** Flush reason reported for a message written because its chunk filled */
+#define TLOG_JSON_SINK_FLUSH_REASON_FULL    "full"
+
+/** Flush reasons reported in messages, indexed by the sink flush reason */
+static const char *tlog_json_sink_flush_reason_list[] = {
+    [TLOG_SINK_FLUSH_REASON_REQUEST]    = "request",
+    [TLOG_SINK_FLUSH_REASON_IDLE]       = "idle",
+    [TLOG_SINK_FLUSH_REASON_LATENCY]    = "latency",
+};
+
+/** Rate limiter of an I/O stream */
+struct tlog_json_sink_limit {
+    struct timespec             rate;           /**< Average rate, bytes
+                                                     per second, in
+                                                     tv_sec, zero for
+                                                     unlimited */
+    struct timespec             limit;          /**< Bucket limit (rate +
+                                                     burst), bytes, in
+                                                     tv_sec */
+    struct timespec             bucket;         /**< "Leaky bucket" of
+                                                     data logged, bytes,
+                                                     in fixed point */
+    bool                        synced;         /**< True if the bucket
+                                                     was synced before */
+    struct timespec             last_sync;      /**< Packet timestamp of
+                                                     the last sync */
+    size_t                      throttled;      /**< Number of bytes
+                                                     throttled since the
+                                                     last message */
+};
+
+/** Message formatted from a chunk */
+struct tlog_json_sink_msg {
+    size_t                      id;             /**< Message ID */
+    char                        num_buf[TLOG_JSON_SINK_NUM_SIZE];
+                                                /**< The id, pos and time
+                                                     fields, up to the
+                                                     timing value,
+                                                     including the
+                                                     throttled and
+                                                     dropped byte
+                                                     counts and the
+                                                     flush reason */
+    size_t                      num_len;        /**< Length of num_buf
+                                                     contents */
+    struct tlog_json_chunk_bufs bufs;           /**< Encoded data */
+};
+
 /** JSON sink instance */
 struct tlog_json_sink {
     struct tlog_sink            sink;           /**< Abstract sink instance */
     struct tlog_json_writer    *writer;         /**< Log message writer */
     bool                        writer_owned;   /**< True if writer is owned */
-    char                       *hostname;       /**< Hostname, JSON-escaped */
-    char                       *recording;      /**< Recording ID,
-                                                     JSON-escaped */
-    char                       *username;       /**< Username, JSON-escaped */
-    char                       *terminal;       /**< Terminal type,
-                                                     JSON-escaped */
-    unsigned int                session_id;     /**< Session ID */
+    char                       *prefix_buf;     /**< Pre-rendered message
+                                                     prefix, up to and
+                                                     including the "id"
+                                                     field name */
+    size_t                      prefix_len;     /**< Message prefix length */
     size_t                      message_id;     /**< Next message ID */
     bool                        started;        /**< True if a packet
                                                      was written */
@@ -72,33 +128,250 @@ struct tlog_json_sink {
                                                      elapsed timestamp */
     struct timespec             start_real;     /**< First packet
                                                      real timestamp */
+    uint8_t                    *arena;          /**< Arena holding the
+                                                     buffers of the chunk
+                                                     and the messages,
+                                                     one set after
+                                                     another, its pages
+                                                     given back on idle
+                                                     flushes */
+    size_t                      arena_size;     /**< Size of the arena */
     struct tlog_json_chunk      chunk;          /**< Chunk buffer */
-    uint8_t                    *message_buf;    /**< Message buffer pointer */
-    size_t                      message_len;    /**< Message buffer length */
+    struct tlog_json_sink_limit input_limit;    /**< Input rate limiter */
+    struct tlog_json_sink_limit output_limit;   /**< Output rate limiter */
+    size_t                      input_dropped;  /**< Number of input
+                                                     bytes dropped before
+                                                     reaching the sink
+                                                     since the last
+                                                     message */
+    size_t                      output_dropped; /**< Number of output
+                                                     bytes dropped before
+                                                     reaching the sink
+                                                     since the last
+                                                     message */
+    struct timespec             throttled_ts;   /**< Timestamp of the
+                                                     first packet throttled
+                                                     or dropped since the
+                                                     last message, to
+                                                     position a message
+                                                     with the throttled
+                                                     and dropped byte
+                                                     counts only */
+    bool                        report_flush;   /**< True if the flush
+                                                     reason is reported
+                                                     in messages */
+
+    /*
+     * Writing of messages on a separate thread, if more than one chunk
+     */
+    size_t                      msg_size;       /**< Number of messages
+                                                     in the ring, zero if
+                                                     writing synchronously */
+    struct tlog_json_sink_msg  *msg_list;       /**< Ring of messages
+                                                     formatted from full
+                                                     chunks */
+    size_t                      msg_first;      /**< Index of the first
+                                                     message to write */
+    size_t                      msg_num;        /**< Number of messages
+                                                     to write */
+    pthread_mutex_t             mutex;          /**< Ring mutex */
+    bool                        mutex_init;     /**< True if mutex is
+                                                     initialized */
+    pthread_cond_t              work_cond;      /**< Signalled when a
+                                                     message is added */
+    bool                        work_cond_init; /**< True if work_cond
+                                                     is initialized */
+    pthread_cond_t              done_cond;      /**< Signalled when a
+                                                     message is written */
+    bool                        done_cond_init; /**< True if done_cond
+                                                     is initialized */
+    pthread_t                   thread;         /**< Writing thread */
+    bool                        thread_started; /**< True if thread was
+                                                     started */
+    bool                        stop;           /**< True if thread
+                                                     should exit once
+                                                     the ring drains */
+    tlog_grc                    grc;            /**< Result of the first
+                                                     failed write */
 };
 
+/* Sink instances must be allocated aligned to the chunk state */
+_Static_assert(_Alignof(struct tlog_json_sink) <= TLOG_SINK_ALIGN,
+               "JSON sink alignment exceeds sink instance alignment");
+
 static void
 tlog_json_sink_cleanup(struct tlog_sink *sink)
 {
     struct tlog_json_sink *json_sink = (struct tlog_json_sink *)sink;
+
     assert(json_sink != NULL);
+
+    /* Let the thread write the remaining messages and exit */
+    if (json_sink->thread_started) {
+        pthread_mutex_lock(&json_sink->mutex);
+        json_sink->stop = true;
+        pthread_cond_signal(&json_sink->work_cond);
+        pthread_mutex_unlock(&json_sink->mutex);
+        pthread_join(json_sink->thread, NULL);
+        json_sink->thread_started = false;
+    }
+    if (json_sink->done_cond_init) {
+        pthread_cond_destroy(&json_sink->done_cond);
+        json_sink->done_cond_init = false;
+    }
+    if (json_sink->work_cond_init) {
+        pthread_cond_destroy(&json_sink->work_cond);
+        json_sink->work_cond_init = false;
+    }
+    if (json_sink->mutex_init) {
+        pthread_mutex_destroy(&json_sink->mutex);
+        json_sink->mutex_init = false;
+    }
+    free(json_sink->msg_list);
+    json_sink->msg_list = NULL;
+
     tlog_json_chunk_cleanup(&json_sink->chunk);
-    free(json_sink->message_buf);
-    json_sink->message_buf = NULL;
-    free(json_sink->terminal);
-    json_sink->terminal = NULL;
-    free(json_sink->username);
-    json_sink->username = NULL;
-    free(json_sink->recording);
-    json_sink->recording = NULL;
-    free(json_sink->hostname);
-    json_sink->hostname = NULL;
+    free(json_sink->arena);
+    json_sink->arena = NULL;
+    free(json_sink->prefix_buf);
+    json_sink->prefix_buf = NULL;
     if (json_sink->writer_owned) {
         tlog_json_writer_destroy(json_sink->writer);
         json_sink->writer_owned = false;
     }
 }
 
+/**
+ * Initialize an I/O stream rate limiter of a JSON sink.
+ *
+ * @param limit     The limiter to initialize.
+ * @param budget    The rate limit to apply.
+ */
+static void
+tlog_json_sink_limit_init(struct tlog_json_sink_limit *limit,
+                          const struct tlog_json_sink_budget *budget)
+{
+    memset(limit, 0, sizeof(*limit));
+    limit->rate.tv_sec = (time_t)budget->rate;
+    limit->limit.tv_sec = (time_t)(budget->rate + budget->burst);
+}
+
+/**
+ * Get the offset of a position in the data of an I/O packet.
+ *
+ * @param pos   The position to get the offset of.
+ *
+ * @return The offset, bytes.
+ */
+static size_t
+tlog_json_sink_pos_off(const struct tlog_pkt_pos *pos)
+{
+    return (pos->type == TLOG_PKT_TYPE_IO) ? pos->val : 0;
+}
+
+/**
+ * Fit a part of an I/O packet into an I/O stream rate limiter of a JSON
+ * sink, draining its bucket on the packet timestamps. Nothing is poured
+ * into the bucket or counted as throttled, until the part is written, see
+ * tlog_json_sink_limit_commit().
+ *
+ * @param limit     The limiter to fit into.
+ * @param pkt       The I/O packet to limit.
+ * @param pos       Position of the start of the part to limit.
+ * @param end       Position of the end of the part to limit.
+ * @param pcut      Location for the position the logged part should end
+ *                  at, not after end.
+ */
+static void
+tlog_json_sink_limit_fit(struct tlog_json_sink_limit *limit,
+                         const struct tlog_pkt *pkt,
+                         const struct tlog_pkt_pos *pos,
+                         const struct tlog_pkt_pos *end,
+                         struct tlog_pkt_pos *pcut)
+{
+    size_t start = tlog_json_sink_pos_off(pos);
+    size_t len = tlog_json_sink_pos_off(end) - start;
+    struct timespec headroom;
+    size_t allowed;
+
+    assert(pkt->type == TLOG_PKT_TYPE_IO);
+
+    *pcut = *end;
+    if (limit->rate.tv_sec == 0 || len == 0) {
+        return;
+    }
+
+    /* Drain the bucket by the time elapsed between the packets */
+    if (limit->synced) {
+        struct timespec elapsed;
+        struct timespec drained;
+        tlog_timespec_sub(&pkt->timestamp, &limit->last_sync, &elapsed);
+        tlog_timespec_fp_mul(&elapsed, &limit->rate, &drained);
+        tlog_timespec_sub(&limit->bucket, &drained, &limit->bucket);
+        if (tlog_timespec_is_negative(&limit->bucket)) {
+            limit->bucket = TLOG_TIMESPEC_ZERO;
+        }
+    } else {
+        limit->synced = true;
+    }
+    limit->last_sync = pkt->timestamp;
+
+    /* Fit as much as possible, without splitting characters */
+    tlog_timespec_sub(&limit->limit, &limit->bucket, &headroom);
+    allowed = tlog_timespec_is_negative(&headroom)
+                    ? 0 : (size_t)headroom.tv_sec;
+    if (allowed < len) {
+        while (allowed > 0 &&
+               (pkt->data.io.buf[start + allowed] & 0xc0) == 0x80) {
+            allowed--;
+        }
+        *pcut = *pos;
+        tlog_pkt_pos_move(pcut, pkt, (ssize_t)allowed);
+    }
+}
+
+/**
+ * Commit a part of an I/O packet written through an I/O stream rate
+ * limiter of a JSON sink: pour the logged bytes into its bucket, and count
+ * the bytes skipped, if any, as throttled.
+ *
+ * @param limit     The limiter to commit to.
+ * @param pos       Position the written part started at.
+ * @param written   Position the written part ended at.
+ * @param end       Position the part ends at, including the skipped
+ *                  bytes.
+ */
+static void
+tlog_json_sink_limit_commit(struct tlog_json_sink_limit *limit,
+                            const struct tlog_pkt_pos *pos,
+                            const struct tlog_pkt_pos *written,
+                            const struct tlog_pkt_pos *end)
+{
+    if (limit->rate.tv_sec == 0) {
+        return;
+    }
+    limit->bucket.tv_sec += (time_t)(tlog_json_sink_pos_off(written) -
+                                     tlog_json_sink_pos_off(pos));
+    limit->throttled += tlog_json_sink_pos_off(end) -
+                        tlog_json_sink_pos_off(written);
+}
+
+/**
+ * Check if a JSON sink has throttled or dropped bytes not reported yet.
+ *
+ * @param json_sink The JSON sink to check.
+ *
+ * @return True if there are unreported throttled or dropped bytes.
+ */
+static bool
+tlog_json_sink_has_skipped(const struct tlog_json_sink *json_sink)
+{
+    return json_sink->input_limit.throttled != 0 ||
+           json_sink->output_limit.throttled != 0 ||
+           json_sink->input_dropped != 0 ||
+           json_sink->output_dropped != 0;
+}
+
 static tlog_grc
 tlog_json_sink_init(struct tlog_sink *sink, va_list ap)
 {
@@ -106,58 +379,144 @@ tlog_json_sink_init(struct tlog_sink *sink, va_list ap)
     const struct tlog_json_sink_params *params =
                         va_arg(ap, const struct tlog_json_sink_params *);
     tlog_grc grc;
+    char *hostname = NULL;
+    char *recording = NULL;
+    char *username = NULL;
+    char *terminal = NULL;
+    int len;
+    int rc;
+    size_t i;
+    size_t arena_size;
+    void *arena;
 
     assert(json_sink != NULL);
     assert(tlog_json_sink_params_is_valid(params));
 
-    json_sink->hostname = tlog_json_aesc_str(params->hostname);
-    if (json_sink->hostname == NULL) {
+    hostname = tlog_json_aesc_str(params->hostname);
+    if (hostname == NULL) {
         grc = TLOG_GRC_ERRNO;
         goto error;
     }
 
-    json_sink->recording = tlog_json_aesc_str(params->recording);
-    if (json_sink->recording == NULL) {
+    recording = tlog_json_aesc_str(params->recording);
+    if (recording == NULL) {
         grc = TLOG_GRC_ERRNO;
         goto error;
     }
 
-    json_sink->username = tlog_json_aesc_str(params->username);
-    if (json_sink->username == NULL) {
+    username = tlog_json_aesc_str(params->username);
+    if (username == NULL) {
         grc = TLOG_GRC_ERRNO;
         goto error;
     }
 
-    json_sink->terminal = tlog_json_aesc_str(params->terminal);
-    if (json_sink->terminal == NULL) {
+    terminal = tlog_json_aesc_str(params->terminal);
+    if (terminal == NULL) {
         grc = TLOG_GRC_ERRNO;
         goto error;
     }
 
-    json_sink->session_id = params->session_id;
+    /* Render the part of the message which never changes */
+    len = asprintf(&json_sink->prefix_buf,
+                   "{"
+                       "\"ver\":"      "\"2.3\","
+                       "\"host\":"     "\"%s\","
+                       "\"rec\":"      "\"%s\","
+                       "\"user\":"     "\"%s\","
+                       "\"term\":"     "\"%s\","
+                       "\"session\":"  "%u,"
+                       "\"id\":",
+                   hostname, recording, username, terminal,
+                   params->session_id);
+    if (len < 0) {
+        json_sink->prefix_buf = NULL;
+        grc = TLOG_GRC_ERRNO;
+        goto error;
+    }
+    json_sink->prefix_len = (size_t)len;
 
     json_sink->message_id = 1;
 
-    /* NOTE: approximate size */
-    json_sink->message_len = params->chunk_size + 1024;
-    json_sink->message_buf = malloc(json_sink->message_len);
-    if (json_sink->message_buf == NULL) {
-        grc = TLOG_GRC_ERRNO;
+    tlog_json_sink_limit_init(&json_sink->input_limit,
+                              &params->input_budget);
+    tlog_json_sink_limit_init(&json_sink->output_limit,
+                              &params->output_budget);
+    json_sink->report_flush = params->report_flush;
+
+    /*
+     * Allocate the buffers of the chunk and the messages at once, on a
+     * page boundary, to be able to give all of its memory back when idle
+     */
+    arena_size = tlog_json_chunk_arena_size(params->chunk_size);
+    json_sink->arena_size = arena_size * (params->chunk_num > 1
+                                            ? params->chunk_num : 1);
+    rc = posix_memalign(&arena,
+                        TLOG_MAX((size_t)sysconf(_SC_PAGESIZE),
+                                 (size_t)TLOG_JSON_CHUNK_ALIGN),
+                        json_sink->arena_size);
+    if (rc != 0) {
+        grc = TLOG_GRC_FROM(errno, rc);
         goto error;
     }
+    json_sink->arena = arena;
 
-    grc = tlog_json_chunk_init(&json_sink->chunk, params->chunk_size);
+    grc = tlog_json_chunk_init(&json_sink->chunk, params->chunk_size,
+                               json_sink->arena);
     if (grc != TLOG_RC_OK) {
         goto error;
     }
 
+    /* Prepare the messages to swap the full chunk buffers into, if any */
+    if (params->chunk_num > 1) {
+        json_sink->msg_list = calloc(params->chunk_num - 1,
+                                     sizeof(*json_sink->msg_list));
+        if (json_sink->msg_list == NULL) {
+            grc = TLOG_GRC_ERRNO;
+            goto error;
+        }
+        json_sink->msg_size = params->chunk_num - 1;
+        for (i = 0; i < json_sink->msg_size; i++) {
+            tlog_json_chunk_bufs_init(&json_sink->msg_list[i].bufs,
+                                      params->chunk_size,
+                                      json_sink->arena +
+                                        arena_size * (i + 1));
+        }
+
+        rc = pthread_mutex_init(&json_sink->mutex, NULL);
+        if (rc != 0) {
+            grc = TLOG_GRC_FROM(errno, rc);
+            goto error;
+        }
+        json_sink->mutex_init = true;
+
+        rc = pthread_cond_init(&json_sink->work_cond, NULL);
+        if (rc != 0) {
+            grc = TLOG_GRC_FROM(errno, rc);
+            goto error;
+        }
+        json_sink->work_cond_init = true;
+
+        rc = pthread_cond_init(&json_sink->done_cond, NULL);
+        if (rc != 0) {
+            grc = TLOG_GRC_FROM(errno, rc);
+            goto error;
+        }
+        json_sink->done_cond_init = true;
+    }
+
     json_sink->writer = params->writer;
     json_sink->writer_owned = params->writer_owned;
 
-    return TLOG_RC_OK;
+    grc = TLOG_RC_OK;
+    goto cleanup;
 
 error:
     tlog_json_sink_cleanup(sink);
+cleanup:
+    free(terminal);
+    free(username);
+    free(recording);
+    free(hostname);
     return grc;
 }
 
@@ -167,97 +526,539 @@ tlog_json_sink_is_valid(const struct tlog_sink *sink)
     struct tlog_json_sink *json_sink = (struct tlog_json_sink *)sink;
     return json_sink != NULL &&
            tlog_json_writer_is_valid(json_sink->writer) &&
-           json_sink->hostname != NULL &&
-           json_sink->recording != NULL &&
-           json_sink->username != NULL &&
-           json_sink->terminal != NULL &&
-           json_sink->message_buf != NULL &&
-           tlog_json_chunk_is_valid(&json_sink->chunk);
+           json_sink->prefix_buf != NULL &&
+           tlog_json_chunk_is_valid(&json_sink->chunk) &&
+           (json_sink->msg_size == 0 ||
+            (json_sink->msg_list != NULL &&
+             json_sink->mutex_init &&
+             json_sink->work_cond_init &&
+             json_sink->done_cond_init));
 }
 
-static tlog_grc
-tlog_json_sink_flush(struct tlog_sink *sink)
+/**
+ * Output a signed number as decimal digits, without terminating zero.
+ *
+ * @param p     The buffer to output to, must have space for at least
+ *              TLOG_UINT64_DIGITS_MAX + 1 bytes.
+ * @param n     The number to output.
+ *
+ * @return The pointer to the byte right after the output.
+ */
+static char *
+tlog_json_sink_put_int(char *p, long long int n)
 {
-    struct tlog_json_sink *json_sink = (struct tlog_json_sink *)sink;
-    tlog_grc grc;
-    char pos_buf[32];
-    int len;
+    if (n < 0) {
+        *p++ = '-';
+        return p + tlog_uint64_fmt(p, -(uint64_t)n);
+    } else {
+        return p + tlog_uint64_fmt(p, (uint64_t)n);
+    }
+}
+
+/**
+ * Output a number of milliseconds below one second as three decimal
+ * digits, zero-padded, without terminating zero.
+ *
+ * @param p     The buffer to output to, must have space for at least three
+ *              bytes.
+ * @param ms    The number of milliseconds to output, 0-999.
+ *
+ * @return The pointer to the byte right after the output.
+ */
+static char *
+tlog_json_sink_put_ms(char *p, long int ms)
+{
+    assert(ms >= 0 && ms < 1000);
+    p[0] = '0' + (char)(ms / 100);
+    p[1] = '0' + (char)(ms / 10 % 10);
+    p[2] = '0' + (char)(ms % 10);
+    return p + 3;
+}
+
+/**
+ * Output a string literal, without terminating zero.
+ *
+ * @param _p    The pointer to the buffer to output to, advanced past the
+ *              output.
+ * @param _s    The string literal to output.
+ */
+#define TLOG_JSON_SINK_PUT_STR(_p, _s) \
+    do {                                    \
+        memcpy(_p, _s, sizeof(_s) - 1);     \
+        (_p) += sizeof(_s) - 1;             \
+    } while (0)
+
+/**
+ * Fill an I/O vector element with a constant buffer.
+ *
+ * @param _iov  The I/O vector element to fill.
+ * @param _buf  The pointer to the buffer.
+ * @param _len  The length of the buffer.
+ */
+#define TLOG_JSON_SINK_IOV(_iov, _buf, _len) \
+    do {                                            \
+        (_iov).iov_base = (void *)(_buf);           \
+        (_iov).iov_len = (_len);                    \
+    } while (0)
+
+/**
+ * Count the bytes a JSON string value of a message written by a JSON sink
+ * represents, knowing the sink escapes only ASCII characters.
+ *
+ * @param iov   The message part holding the value, without quotes.
+ *
+ * @return The number of bytes represented.
+ */
+static size_t
+tlog_json_sink_txt_size(const struct iovec *iov)
+{
+    const uint8_t *p = iov->iov_base;
+    const uint8_t *end = p + iov->iov_len;
+    size_t size = 0;
+
+    while (p < end) {
+        if (*p == '\\') {
+            p += (p + 1 < end && p[1] == 'u') ? 6 : 2;
+        } else {
+            p++;
+        }
+        size++;
+    }
+    return size;
+}
+
+/**
+ * Count the bytes in a JSON byte array value of a message written by a
+ * JSON sink.
+ *
+ * @param iov   The message part holding the value, without brackets.
+ *
+ * @return The number of bytes in the array.
+ */
+static size_t
+tlog_json_sink_bin_size(const struct iovec *iov)
+{
+    const uint8_t *p = iov->iov_base;
+    const uint8_t *end = p + iov->iov_len;
+    size_t size;
+
+    if (p == end) {
+        return 0;
+    }
+    for (size = 1; p < end; p++) {
+        size += (*p == ',');
+    }
+    return size;
+}
+
+size_t
+tlog_json_sink_msg_output_size(const struct iovec *iov)
+{
+    /* Length of the replacement character, U+FFFD, in UTF-8 */
+    static const size_t repl_len = 3;
+    const uint8_t *p;
+    const uint8_t *end;
+    size_t repl_num = 0;
+    size_t n;
+
+    assert(iov != NULL);
+
+    /* Count the replacement characters standing in for binary output */
+    p = iov[TLOG_JSON_SINK_MSG_PART_TIMING].iov_base;
+    end = p + iov[TLOG_JSON_SINK_MSG_PART_TIMING].iov_len;
+    while (p < end) {
+        if (*p != ']') {
+            p++;
+            continue;
+        }
+        for (n = 0, p++; p < end && *p >= '0' && *p <= '9'; p++) {
+            n = n * 10 + (*p - '0');
+        }
+        repl_num += n;
+    }
+
+    return tlog_json_sink_txt_size(&iov[TLOG_JSON_SINK_MSG_PART_OUT_TXT]) -
+           repl_num * repl_len +
+           tlog_json_sink_bin_size(&iov[TLOG_JSON_SINK_MSG_PART_OUT_BIN]);
+}
+
+/**
+ * Render the id, pos and time fields of the message to be formatted from
+ * the flushed chunk of a JSON sink, assigning the next message ID. Add the
+ * numbers of bytes throttled and dropped since the previous message, if
+ * any, and reset them. Add the flush reason, if reporting it.
+ *
+ * @param json_sink The JSON sink to render the fields for.
+ * @param msg       The message to render the fields into.
+ * @param reason    The reason for flushing the chunk.
+ */
+static void
+tlog_json_sink_msg_render(struct tlog_json_sink *json_sink,
+                          struct tlog_json_sink_msg *msg,
+                          const char *reason)
+{
+    size_t len;
     struct timespec pos;
     struct timespec real_ts;
+    char *p;
 
-    if (tlog_json_chunk_is_empty(&json_sink->chunk)) {
+    tlog_timespec_sub(json_sink->chunk.state.got_ts
+                            ? &json_sink->chunk.state.first_ts
+                            : &json_sink->throttled_ts,
+                      &json_sink->start, &pos);
+    tlog_timespec_add(&json_sink->start_real, &pos, &real_ts);
+
+    msg->id = json_sink->message_id;
+    p = msg->num_buf;
+    p += tlog_uint64_fmt(p, msg->id);
+    TLOG_JSON_SINK_PUT_STR(p, ",\"pos\":");
+    if (pos.tv_sec == 0) {
+        p = tlog_json_sink_put_int(p, pos.tv_nsec / 1000000);
+    } else {
+        p = tlog_json_sink_put_int(p, (long long int)pos.tv_sec);
+        p = tlog_json_sink_put_ms(p, pos.tv_nsec / 1000000);
+    }
+    TLOG_JSON_SINK_PUT_STR(p, ",\"time\":");
+    p = tlog_json_sink_put_int(p, (long long int)real_ts.tv_sec);
+    *p++ = '.';
+    p = tlog_json_sink_put_ms(p, real_ts.tv_nsec / 1000000);
+    if (json_sink->input_limit.throttled != 0) {
+        TLOG_JSON_SINK_PUT_STR(p, ",\"in_throttled\":");
+        p += tlog_uint64_fmt(p, json_sink->input_limit.throttled);
+        json_sink->input_limit.throttled = 0;
+    }
+    if (json_sink->output_limit.throttled != 0) {
+        TLOG_JSON_SINK_PUT_STR(p, ",\"out_throttled\":");
+        p += tlog_uint64_fmt(p, json_sink->output_limit.throttled);
+        json_sink->output_limit.throttled = 0;
+    }
+    if (json_sink->input_dropped != 0) {
+        TLOG_JSON_SINK_PUT_STR(p, ",\"in_dropped\":");
+        p += tlog_uint64_fmt(p, json_sink->input_dropped);
+        json_sink->input_dropped = 0;
+    }
+    if (json_sink->output_dropped != 0) {
+        TLOG_JSON_SINK_PUT_STR(p, ",\"out_dropped\":");
+        p += tlog_uint64_fmt(p, json_sink->output_dropped);
+        json_sink->output_dropped = 0;
+    }
+    if (json_sink->report_flush) {
+        TLOG_JSON_SINK_PUT_STR(p, ",\"flush\":\"");
+        len = strlen(reason);
+        memcpy(p, reason, len);
+        p += len;
+        *p++ = '"';
+    }
+    TLOG_JSON_SINK_PUT_STR(p, ",\"timing\":\"");
+    assert(p <= msg->num_buf + sizeof(msg->num_buf));
+    msg->num_len = p - msg->num_buf;
+}
+
+/**
+ * Write a message with the writer of a JSON sink.
+ *
+ * @param json_sink The JSON sink to write the message for.
+ * @param msg       The message to write.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_json_sink_msg_write(struct tlog_json_sink *json_sink,
+                         const struct tlog_json_sink_msg *msg)
+{
+    static const char in_txt_sep[] = "\",\"in_txt\":\"";
+    static const char in_bin_sep[] = "\",\"in_bin\":[";
+    static const char out_txt_sep[] = "],\"out_txt\":\"";
+    static const char out_bin_sep[] = "\",\"out_bin\":[";
+    static const char end[] = "]}\n";
+    const struct tlog_json_chunk_bufs *bufs = &msg->bufs;
+    struct iovec iov[TLOG_JSON_SINK_MSG_PART_NUM];
+
+    /* Point the message parts directly at the data buffers */
+    TLOG_JSON_SINK_IOV(iov[TLOG_JSON_SINK_MSG_PART_PREFIX],
+                       json_sink->prefix_buf, json_sink->prefix_len);
+    TLOG_JSON_SINK_IOV(iov[TLOG_JSON_SINK_MSG_PART_FIELDS],
+                       msg->num_buf, msg->num_len);
+    TLOG_JSON_SINK_IOV(iov[TLOG_JSON_SINK_MSG_PART_TIMING],
+                       bufs->timing_buf, bufs->timing_len);
+    TLOG_JSON_SINK_IOV(iov[TLOG_JSON_SINK_MSG_PART_IN_TXT_SEP],
+                       in_txt_sep, sizeof(in_txt_sep) - 1);
+    TLOG_JSON_SINK_IOV(iov[TLOG_JSON_SINK_MSG_PART_IN_TXT],
+                       bufs->input_txt_buf, bufs->input_txt_len);
+    TLOG_JSON_SINK_IOV(iov[TLOG_JSON_SINK_MSG_PART_IN_BIN_SEP],
+                       in_bin_sep, sizeof(in_bin_sep) - 1);
+    TLOG_JSON_SINK_IOV(iov[TLOG_JSON_SINK_MSG_PART_IN_BIN],
+                       bufs->input_bin_buf, bufs->input_bin_len);
+    TLOG_JSON_SINK_IOV(iov[TLOG_JSON_SINK_MSG_PART_OUT_TXT_SEP],
+                       out_txt_sep, sizeof(out_txt_sep) - 1);
+    TLOG_JSON_SINK_IOV(iov[TLOG_JSON_SINK_MSG_PART_OUT_TXT],
+                       bufs->output_txt_buf, bufs->output_txt_len);
+    TLOG_JSON_SINK_IOV(iov[TLOG_JSON_SINK_MSG_PART_OUT_BIN_SEP],
+                       out_bin_sep, sizeof(out_bin_sep) - 1);
+    TLOG_JSON_SINK_IOV(iov[TLOG_JSON_SINK_MSG_PART_OUT_BIN],
+                       bufs->output_bin_buf, bufs->output_bin_len);
+    TLOG_JSON_SINK_IOV(iov[TLOG_JSON_SINK_MSG_PART_END],
+                       end, sizeof(end) - 1);
+
+    return tlog_json_writer_write_msg(json_sink->writer, msg->id, iov);
+}
+
+/**
+ * Writing thread function: write the messages in the ring, in order,
+ * until asked to stop and the ring is empty.
+ *
+ * @param arg   The JSON sink to write the messages of.
+ *
+ * @return NULL.
+ */
+static void *
+tlog_json_sink_thread(void *arg)
+{
+    struct tlog_json_sink *json_sink = (struct tlog_json_sink *)arg;
+    struct tlog_json_sink_msg *msg;
+    tlog_grc grc;
+
+    pthread_mutex_lock(&json_sink->mutex);
+    while (true) {
+        /* Wait for work */
+        while (json_sink->msg_num == 0 && !json_sink->stop) {
+            pthread_cond_wait(&json_sink->work_cond, &json_sink->mutex);
+        }
+        if (json_sink->msg_num == 0) {
+            break;
+        }
+        /* The message stays in the ring until written */
+        msg = &json_sink->msg_list[json_sink->msg_first];
+        grc = json_sink->grc;
+        pthread_mutex_unlock(&json_sink->mutex);
+
+        /* Write, unless failed before */
+        if (grc == TLOG_RC_OK) {
+            do {
+                grc = tlog_json_sink_msg_write(json_sink, msg);
+            } while (grc == TLOG_GRC_FROM(errno, EINTR));
+        }
+
+        pthread_mutex_lock(&json_sink->mutex);
+        if (grc != TLOG_RC_OK && json_sink->grc == TLOG_RC_OK) {
+            json_sink->grc = grc;
+        }
+        json_sink->msg_first = (json_sink->msg_first + 1) %
+                               json_sink->msg_size;
+        json_sink->msg_num--;
+        pthread_cond_broadcast(&json_sink->done_cond);
+    }
+    pthread_mutex_unlock(&json_sink->mutex);
+
+    return NULL;
+}
+
+/**
+ * Start the writing thread, if not started yet.
+ * Must be called with the mutex locked.
+ *
+ * The thread is started lazily, to let the creator fork safely before the
+ * sink is first used.
+ *
+ * @param json_sink The JSON sink to start the thread for.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_json_sink_start(struct tlog_json_sink *json_sink)
+{
+    sigset_t all_set;
+    sigset_t orig_set;
+    int rc;
+
+    if (json_sink->thread_started) {
+        return TLOG_RC_OK;
+    }
+
+    /* Have the thread inherit a mask blocking all signals */
+    sigfillset(&all_set);
+    rc = pthread_sigmask(SIG_SETMASK, &all_set, &orig_set);
+    if (rc != 0) {
+        return TLOG_GRC_FROM(errno, rc);
+    }
+    rc = pthread_create(&json_sink->thread, NULL,
+                        tlog_json_sink_thread, json_sink);
+    pthread_sigmask(SIG_SETMASK, &orig_set, NULL);
+    if (rc != 0) {
+        return TLOG_GRC_FROM(errno, rc);
+    }
+
+    json_sink->thread_started = true;
+    return TLOG_RC_OK;
+}
+
+/**
+ * Format the data accumulated in the chunk of a JSON sink into a message
+ * and write it with the writer, if the chunk is not empty, or if there
+ * are throttled or dropped bytes not reported yet. If writing on a separate
+ * thread, hand the chunk buffers over to it instead, waiting for a free
+ * place in the ring, if necessary.
+ *
+ * @param json_sink The JSON sink to flush the chunk of.
+ * @param reason    The reason for flushing, to report in the message.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_json_sink_flush_chunk(struct tlog_json_sink *json_sink,
+                           const char *reason)
+{
+    struct tlog_json_chunk *chunk = &json_sink->chunk;
+    struct tlog_json_sink_msg *msg;
+    tlog_grc grc;
+
+    if (tlog_json_chunk_is_empty(chunk) &&
+        !tlog_json_sink_has_skipped(json_sink)) {
         return TLOG_RC_OK;
     }
 
     /* Write terminating metadata records to reserved space */
-    tlog_json_chunk_flush(&json_sink->chunk);
+    tlog_json_chunk_flush(chunk);
 
-    tlog_timespec_sub(&json_sink->chunk.first_ts, &json_sink->start, &pos);
+    /* If writing synchronously */
+    if (json_sink->msg_size == 0) {
+        struct tlog_json_sink_msg sync_msg = {
+            .bufs = {
+                .arena = chunk->arena,
+                .timing_buf = chunk->timing_buf,
+                .timing_len = chunk->state.timing_ptr - chunk->timing_buf,
+                .input_txt_buf = chunk->input.txt_buf,
+                .input_txt_len = chunk->input.state.txt_len,
+                .input_bin_buf = chunk->input.bin_buf,
+                .input_bin_len = chunk->input.state.bin_len,
+                .output_txt_buf = chunk->output.txt_buf,
+                .output_txt_len = chunk->output.state.txt_len,
+                .output_bin_buf = chunk->output.bin_buf,
+                .output_bin_len = chunk->output.state.bin_len,
+            },
+        };
+        tlog_json_sink_msg_render(json_sink, &sync_msg, reason);
+        grc = tlog_json_sink_msg_write(json_sink, &sync_msg);
+        if (grc != TLOG_RC_OK) {
+            return grc;
+        }
+        json_sink->message_id++;
+        tlog_json_chunk_empty(chunk);
+        return TLOG_RC_OK;
+    }
 
-    if (pos.tv_sec == 0) {
-        len = snprintf(pos_buf, sizeof(pos_buf), "%ld",
-                       pos.tv_nsec / 1000000);
-    } else {
-        len = snprintf(pos_buf, sizeof(pos_buf), "%lld%03ld",
-                       (long long int)pos.tv_sec, pos.tv_nsec / 1000000);
+    pthread_mutex_lock(&json_sink->mutex);
+
+    grc = tlog_json_sink_start(json_sink);
+    if (grc != TLOG_RC_OK) {
+        goto cleanup;
     }
 
-    if ((size_t)len >= sizeof(pos_buf)) {
-        return TLOG_GRC_FROM(errno, ENOMEM);
+    /* Wait for a free message, reporting earlier write failures */
+    while (json_sink->grc == TLOG_RC_OK &&
+           json_sink->msg_num == json_sink->msg_size) {
+        pthread_cond_wait(&json_sink->done_cond, &json_sink->mutex);
+    }
+    grc = json_sink->grc;
+    if (grc != TLOG_RC_OK) {
+        goto cleanup;
     }
 
-    tlog_timespec_add(&json_sink->start_real, &pos, &real_ts);
+    /* Take the data out of the chunk and queue the message */
+    msg = &json_sink->msg_list[(json_sink->msg_first + json_sink->msg_num) %
+                               json_sink->msg_size];
+    tlog_json_sink_msg_render(json_sink, msg, reason);
+    tlog_json_chunk_swap(chunk, &msg->bufs);
+    json_sink->msg_num++;
+    json_sink->message_id++;
+    pthread_cond_signal(&json_sink->work_cond);
 
-    len = snprintf(
-        (char *)json_sink->message_buf, json_sink->message_len,
-        "{"
-            "\"ver\":"      "\"2.3\","
-            "\"host\":"     "\"%s\","
-            "\"rec\":"      "\"%s\","
-            "\"user\":"     "\"%s\","
-            "\"term\":"     "\"%s\","
-            "\"session\":"  "%u,"
-            "\"id\":"       "%zu,"
-            "\"pos\":"      "%s,"
-            "\"time\":"     "%ld.%03ld,"
-            "\"timing\":"   "\"%.*s\","
-            "\"in_txt\":"   "\"%.*s\","
-            "\"in_bin\":"   "[%.*s],"
-            "\"out_txt\":"  "\"%.*s\","
-            "\"out_bin\":"  "[%.*s]"
-        "}\n",
-        json_sink->hostname,
-        json_sink->recording,
-        json_sink->username,
-        json_sink->terminal,
-        json_sink->session_id,
-        json_sink->message_id,
-        pos_buf,
-        real_ts.tv_sec, real_ts.tv_nsec / 1000000,
-        (int)(json_sink->chunk.timing_ptr - json_sink->chunk.timing_buf),
-        json_sink->chunk.timing_buf,
-        (int)json_sink->chunk.input.txt_len, json_sink->chunk.input.txt_buf,
-        (int)json_sink->chunk.input.bin_len, json_sink->chunk.input.bin_buf,
-        (int)json_sink->chunk.output.txt_len, json_sink->chunk.output.txt_buf,
-        (int)json_sink->chunk.output.bin_len, json_sink->chunk.output.bin_buf);
-    if (len < 0) {
-        return TLOG_RC_FAILURE;
+cleanup:
+    pthread_mutex_unlock(&json_sink->mutex);
+    return grc;
+}
+
+/**
+ * Wait for the writing thread of a JSON sink to write all the messages in
+ * the ring, if writing on a separate thread.
+ *
+ * @param json_sink The JSON sink to wait for.
+ *
+ * @return Global return code of the first failed write, if any,
+ *         or TLOG_RC_OK.
+ */
+static tlog_grc
+tlog_json_sink_drain(struct tlog_json_sink *json_sink)
+{
+    tlog_grc grc;
+
+    if (json_sink->msg_size == 0) {
+        return TLOG_RC_OK;
     }
-    if ((size_t)len >= json_sink->message_len) {
-        return TLOG_GRC_FROM(errno, ENOMEM);
+
+    pthread_mutex_lock(&json_sink->mutex);
+    while (json_sink->msg_num > 0) {
+        pthread_cond_wait(&json_sink->done_cond, &json_sink->mutex);
     }
+    grc = json_sink->grc;
+    pthread_mutex_unlock(&json_sink->mutex);
+
+    return grc;
+}
 
-    grc = tlog_json_writer_write(json_sink->writer,
-                                 json_sink->message_id,
-                                 json_sink->message_buf, len);
+/**
+ * Get the result of the first failed write on the writing thread of a
+ * JSON sink, without waiting for the messages in the ring, if writing on a
+ * separate thread.
+ *
+ * @param json_sink The JSON sink to check.
+ *
+ * @return Global return code of the first failed write, if any,
+ *         or TLOG_RC_OK.
+ */
+static tlog_grc
+tlog_json_sink_check(struct tlog_json_sink *json_sink)
+{
+    tlog_grc grc;
+
+    if (json_sink->msg_size == 0) {
+        return TLOG_RC_OK;
+    }
+
+    pthread_mutex_lock(&json_sink->mutex);
+    grc = json_sink->grc;
+    pthread_mutex_unlock(&json_sink->mutex);
+
+    return grc;
+}
+
+static tlog_grc
+tlog_json_sink_flush(struct tlog_sink *sink,
+                     enum tlog_sink_flush_reason reason)
+{
+    struct tlog_json_sink *json_sink = (struct tlog_json_sink *)sink;
+    tlog_grc grc;
+
+    grc = tlog_json_sink_flush_chunk(json_sink,
+                                     tlog_json_sink_flush_reason_list[reason]);
     if (grc != TLOG_RC_OK) {
         return grc;
     }
 
-    json_sink->message_id++;
-    tlog_json_chunk_empty(&json_sink->chunk);
+    grc = tlog_json_sink_drain(json_sink);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
 
-    return TLOG_RC_OK;
+    /*
+     * Give the memory of the buffers, all empty now, back, to have it
+     * allocated again only as data comes. Flushing is rare while data
+     * flows, as buffers fill, and a session idling at a prompt is flushed
+     * by latency, unless idle flushing is enabled.
+     */
+    tlog_release_pages(json_sink->arena, json_sink->arena_size);
+
+    return tlog_json_writer_flush(json_sink->writer);
 }
 
 static tlog_grc
@@ -267,13 +1068,15 @@ tlog_json_sink_cut(struct tlog_sink *sink)
     tlog_grc grc;
 
     while (!tlog_json_chunk_cut(&json_sink->chunk)) {
-        grc = tlog_json_sink_flush(sink);
+        grc = tlog_json_sink_flush_chunk(json_sink,
+                                         TLOG_JSON_SINK_FLUSH_REASON_FULL);
         if (grc != TLOG_RC_OK) {
             return grc;
         }
     }
 
-    return TLOG_RC_OK;
+    /* Report messages failed to be written so far */
+    return tlog_json_sink_check(json_sink);
 }
 
 static tlog_grc
@@ -283,6 +1086,9 @@ tlog_json_sink_write(struct tlog_sink *sink,
                      const struct tlog_pkt_pos *end)
 {
     struct tlog_json_sink *json_sink = (struct tlog_json_sink *)sink;
+    struct tlog_json_sink_limit *limit = NULL;
+    struct tlog_pkt_pos start;
+    struct tlog_pkt_pos cut;
     tlog_grc grc;
 
     assert(!tlog_pkt_is_void(pkt));
@@ -300,13 +1106,81 @@ tlog_json_sink_write(struct tlog_sink *sink,
         json_sink->start_real = pkt->real_ts;
     }
 
-    /* While the packet is not yet written completely */
-    while (!tlog_json_chunk_write(&json_sink->chunk, pkt, ppos, end)) {
-        grc = tlog_json_sink_flush(sink);
+    /* Fit the packet into the limit of its I/O stream, if any */
+    if (pkt->type == TLOG_PKT_TYPE_IO) {
+        limit = pkt->data.io.output ? &json_sink->output_limit
+                                    : &json_sink->input_limit;
+        start = *ppos;
+        tlog_json_sink_limit_fit(limit, pkt, &start, end, &cut);
+    } else {
+        cut = *end;
+    }
+
+    /* While the packet is not yet written up to the cut */
+    while (!tlog_json_chunk_write(&json_sink->chunk, pkt, ppos, &cut)) {
+        grc = tlog_json_sink_flush_chunk(json_sink,
+                                         TLOG_JSON_SINK_FLUSH_REASON_FULL);
         if (grc != TLOG_RC_OK) {
+            /* Charge only what was written, the rest is retried */
+            if (limit != NULL) {
+                tlog_json_sink_limit_commit(limit, &start, ppos, ppos);
+            }
             return grc;
         }
     }
+
+    /* Charge the written part, and skip the throttled part */
+    if (limit != NULL) {
+        if (tlog_json_sink_pos_off(&cut) < tlog_json_sink_pos_off(end) &&
+            !tlog_json_sink_has_skipped(json_sink)) {
+            json_sink->throttled_ts = pkt->timestamp;
+        }
+        tlog_json_sink_limit_commit(limit, &start, &cut, end);
+    }
+    *ppos = *end;
+    return TLOG_RC_OK;
+}
+
+static tlog_grc
+tlog_json_sink_drop(struct tlog_sink *sink, const struct tlog_pkt *pkt)
+{
+    struct tlog_json_sink *json_sink = (struct tlog_json_sink *)sink;
+
+    if (!json_sink->started) {
+        json_sink->started = true;
+        json_sink->start = pkt->timestamp;
+        json_sink->start_real = pkt->real_ts;
+    }
+    if (!tlog_json_sink_has_skipped(json_sink)) {
+        json_sink->throttled_ts = pkt->timestamp;
+    }
+    if (pkt->data.io.output) {
+        json_sink->output_dropped += pkt->data.io.len;
+    } else {
+        json_sink->input_dropped += pkt->data.io.len;
+    }
+    return TLOG_RC_OK;
+}
+
+static tlog_grc
+tlog_json_sink_write_batch(struct tlog_sink *sink,
+                           const struct tlog_pkt *pkt_list, size_t pkt_num,
+                           size_t *pidx, struct tlog_pkt_pos *ppos)
+{
+    const struct tlog_pkt *pkt;
+    struct tlog_pkt_pos end;
+    tlog_grc grc;
+
+    for (; *pidx < pkt_num; (*pidx)++, *ppos = TLOG_PKT_POS_VOID) {
+        pkt = &pkt_list[*pidx];
+        end = TLOG_PKT_POS_VOID;
+        tlog_pkt_pos_move_past(&end, pkt);
+        grc = tlog_json_sink_write(sink, pkt, ppos, &end);
+        if (grc != TLOG_RC_OK) {
+            return grc;
+        }
+    }
+
     return TLOG_RC_OK;
 }
 
@@ -316,6 +1190,20 @@ const struct tlog_sink_type tlog_json_sink_type = {
     .cleanup    = tlog_json_sink_cleanup,
     .is_valid   = tlog_json_sink_is_valid,
     .write      = tlog_json_sink_write,
+    .write_batch = tlog_json_sink_write_batch,
+    .drop       = tlog_json_sink_drop,
     .cut        = tlog_json_sink_cut,
     .flush      = tlog_json_sink_flush,
 };
+
+tlog_grc
+tlog_json_sink_resident_size(const struct tlog_sink *sink,
+                             size_t *president)
+{
+    const struct tlog_json_sink *json_sink =
+                                    (const struct tlog_json_sink *)sink;
+    assert(tlog_sink_is_valid(sink));
+    assert(sink->type == &tlog_json_sink_type);
+    return tlog_resident_size(json_sink->arena, json_sink->arena_size,
+                              president);
+}
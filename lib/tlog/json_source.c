@@ -57,6 +57,9 @@ struct tlog_json_source {
                                              messages, NULL for any */
     unsigned int        session_id;     /**< Session ID to filter messages by,
                                              NULL for unfiltered */
+    struct tlog_json_msg_filter filter; /**< Filter skipping messages
+                                             before parsing them, referring
+                                             to the above */
 
     bool                lax;            /**< Ignore missing messages, i.e.
                                              message ID jumps, if true */
@@ -70,8 +73,13 @@ struct tlog_json_source {
 
     struct tlog_json_msg    msg;        /**< Message parsing state */
 
-    uint8_t            *io_buf;         /**< I/O data buffer used in packets */
+    uint8_t            *io_buf;         /**< I/O data buffers used in
+                                             packets of a batch, one
+                                             after another */
     size_t              io_size;        /**< I/O data buffer length */
+    tlog_grc            grc;            /**< Failure to report on the next
+                                             read, deferred to return the
+                                             packets read before it */
 };
 
 static bool
@@ -149,10 +157,18 @@ tlog_json_source_init(struct tlog_source *source, va_list ap)
     json_source->session_id = params->session_id;
     json_source->lax = params->lax;
 
+    json_source->filter = (struct tlog_json_msg_filter){
+        .host       = json_source->hostname,
+        .rec        = json_source->recording,
+        .user       = json_source->username,
+        .session    = json_source->session_id,
+    };
+
     tlog_json_msg_init(&json_source->msg, NULL);
 
     json_source->io_size = params->io_size;
-    json_source->io_buf = malloc(params->io_size);
+    json_source->io_buf = malloc(params->io_size *
+                                 TLOG_JSON_SOURCE_BATCH_SIZE);
     if (json_source->io_buf == NULL) {
         grc = TLOG_GRC_ERRNO;
         goto error;
@@ -196,26 +212,21 @@ tlog_json_source_read_msg(struct tlog_source *source)
     struct tlog_json_source *json_source =
                                 (struct tlog_json_source *)source;
     tlog_grc grc;
-    struct json_object *obj;
 
     assert(tlog_json_source_is_valid(source));
     assert(tlog_json_msg_is_void(&json_source->msg));
 
     for (; ; tlog_json_msg_cleanup(&json_source->msg)) {
-        grc = tlog_json_reader_read(json_source->reader, &obj);
+        grc = tlog_json_reader_read_msg(json_source->reader,
+                                        &json_source->msg,
+                                        &json_source->filter);
         if (grc != TLOG_RC_OK) {
             return grc;
         }
-        if (obj == NULL) {
+        if (tlog_json_msg_is_void(&json_source->msg)) {
             return TLOG_RC_OK;
         }
 
-        grc = tlog_json_msg_init(&json_source->msg, obj);
-        json_object_put(obj);
-        if (grc != TLOG_RC_OK) {
-            return grc;
-        }
-
         if (json_source->hostname != NULL &&
             strcmp(json_source->msg.host, json_source->hostname) != 0) {
             continue;
@@ -244,8 +255,19 @@ tlog_json_source_read_msg(struct tlog_source *source)
     }
 }
 
+/**
+ * Read a packet from a JSON source.
+ *
+ * @param source    The source to read from.
+ * @param pkt       The packet to write the received data into, must be void,
+ *                  will be void on end-of-stream, or in case of error.
+ * @param io_buf    The I/O data buffer to use in the packet, io_size long.
+ *
+ * @return Global return code.
+ */
 static tlog_grc
-tlog_json_source_read(struct tlog_source *source, struct tlog_pkt *pkt)
+tlog_json_source_read_pkt(struct tlog_source *source, struct tlog_pkt *pkt,
+                          uint8_t *io_buf)
 {
     struct tlog_json_source *json_source =
                                 (struct tlog_json_source *)source;
@@ -279,8 +301,7 @@ tlog_json_source_read(struct tlog_source *source, struct tlog_pkt *pkt)
             json_source->last_msg_id = msg->id;
         }
 
-        grc = tlog_json_msg_read(msg, pkt,
-                                 json_source->io_buf, json_source->io_size);
+        grc = tlog_json_msg_read(msg, pkt, io_buf, json_source->io_size);
         if (grc != TLOG_RC_OK) {
             tlog_json_msg_cleanup(msg);
             return grc;
@@ -322,12 +343,63 @@ tlog_json_source_read(struct tlog_source *source, struct tlog_pkt *pkt)
     }
 }
 
+static tlog_grc
+tlog_json_source_read_batch(struct tlog_source *source,
+                            struct tlog_pkt *pkt_list, size_t pkt_size,
+                            size_t *ppkt_num)
+{
+    struct tlog_json_source *json_source =
+                                (struct tlog_json_source *)source;
+    tlog_grc grc;
+    size_t i;
+
+    /* Report the failure deferred by the previous batch, if any */
+    if (json_source->grc != TLOG_RC_OK) {
+        grc = json_source->grc;
+        json_source->grc = TLOG_RC_OK;
+        return grc;
+    }
+
+    if (pkt_size > TLOG_JSON_SOURCE_BATCH_SIZE) {
+        pkt_size = TLOG_JSON_SOURCE_BATCH_SIZE;
+    }
+
+    /* Read packets until the list is full, or the stream ends */
+    for (i = 0; i < pkt_size; i++) {
+        grc = tlog_json_source_read_pkt(
+                        source, &pkt_list[i],
+                        json_source->io_buf + json_source->io_size * i);
+        if (grc != TLOG_RC_OK) {
+            /* Return the packets read so far, if any, first */
+            if (i == 0) {
+                return grc;
+            }
+            json_source->grc = grc;
+            break;
+        }
+        if (tlog_pkt_is_void(&pkt_list[i])) {
+            break;
+        }
+    }
+
+    *ppkt_num = i;
+    return TLOG_RC_OK;
+}
+
+static tlog_grc
+tlog_json_source_read(struct tlog_source *source, struct tlog_pkt *pkt)
+{
+    size_t pkt_num;
+    return tlog_json_source_read_batch(source, pkt, 1, &pkt_num);
+}
+
 const struct tlog_source_type tlog_json_source_type = {
     .size       = sizeof(struct tlog_json_source),
     .init       = tlog_json_source_init,
     .cleanup    = tlog_json_source_cleanup,
     .is_valid   = tlog_json_source_is_valid,
     .read       = tlog_json_source_read,
+    .read_batch = tlog_json_source_read_batch,
     .loc_get    = tlog_json_source_loc_get,
     .loc_fmt    = tlog_json_source_loc_fmt,
 };
@@ -21,18 +21,23 @@
  */
 
 #include <errno.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <tlog/misc.h>
 #include <tlog/json_stream.h>
+#include <tlog/json_esc.h>
 #include <tlog/rc.h>
 
+/* Everything but the UTF-8 filter must fit the first state cache line */
+_Static_assert(offsetof(TLOG_TRX_BASIC_STORE_SIG(tlog_json_stream), utf8) <=
+                    TLOG_JSON_STREAM_ALIGN,
+               "Stream write cursors don't fit a cache line");
+
 void
 tlog_json_stream_cleanup(struct tlog_json_stream *stream)
 {
     assert(stream != NULL);
-    free(stream->txt_buf);
     stream->txt_buf = NULL;
-    free(stream->bin_buf);
     stream->bin_buf = NULL;
 }
 
@@ -41,116 +46,193 @@ tlog_json_stream_is_valid(const struct tlog_json_stream *stream)
 {
     return stream != NULL &&
            stream->size >= TLOG_JSON_STREAM_SIZE_MIN &&
-           tlog_utf8_is_valid(&stream->utf8) &&
+           tlog_utf8_is_valid(&stream->state.utf8) &&
            stream->valid_mark != stream->invalid_mark &&
            stream->txt_buf != NULL &&
            stream->bin_buf != NULL &&
-           (stream->txt_len + stream->bin_len) <= stream->size &&
-           stream->txt_run <= stream->txt_len &&
-           stream->bin_run <= stream->bin_len &&
+           (stream->state.txt_len + stream->state.bin_len) <= stream->size &&
+           stream->state.txt_run <= stream->state.txt_len &&
+           stream->state.bin_run <= stream->state.bin_len &&
            /* Text buffer cannot be empty if binary is not */
-           (stream->bin_run == 0 || stream->txt_run != 0);
+           (stream->state.bin_run == 0 || stream->state.txt_run != 0);
 }
 
 bool
 tlog_json_stream_is_pending(const struct tlog_json_stream *stream)
 {
     assert(tlog_json_stream_is_valid(stream));
-    assert(!tlog_utf8_is_ended(&stream->utf8));
-    return tlog_utf8_is_started(&stream->utf8);
+    assert(!tlog_utf8_is_ended(&stream->state.utf8));
+    return tlog_utf8_is_started(&stream->state.utf8);
 }
 
 bool
 tlog_json_stream_is_empty(const struct tlog_json_stream *stream)
 {
     assert(tlog_json_stream_is_valid(stream));
-    return stream->txt_len == 0 && stream->bin_len == 0;
+    return stream->state.txt_len == 0 && stream->state.bin_len == 0;
 }
 
 static
 TLOG_TRX_BASIC_ACT_SIG(tlog_json_stream)
 {
     TLOG_TRX_BASIC_ACT_PROLOGUE(tlog_json_stream);
-    TLOG_TRX_BASIC_ACT_ON_VAR(utf8);
-    TLOG_TRX_BASIC_ACT_ON_VAR(ts);
-    TLOG_TRX_BASIC_ACT_ON_VAR(txt_run);
-    TLOG_TRX_BASIC_ACT_ON_VAR(txt_dig);
-    TLOG_TRX_BASIC_ACT_ON_VAR(txt_len);
-    TLOG_TRX_BASIC_ACT_ON_VAR(bin_run);
-    TLOG_TRX_BASIC_ACT_ON_VAR(bin_dig);
-    TLOG_TRX_BASIC_ACT_ON_VAR(bin_len);
+    TLOG_TRX_BASIC_ACT_ON_STORE(state);
     TLOG_TRX_BASIC_ACT_ON_PTR(dispatcher);
 }
 
-tlog_grc
+void
 tlog_json_stream_init(struct tlog_json_stream *stream,
                       struct tlog_json_dispatcher *dispatcher,
-                      size_t size, uint8_t valid_mark, uint8_t invalid_mark)
+                      size_t size, uint8_t *txt_buf, uint8_t *bin_buf,
+                      uint8_t valid_mark, uint8_t invalid_mark)
 {
-    tlog_grc grc;
     assert(stream != NULL);
     assert(tlog_json_dispatcher_is_valid(dispatcher));
     assert(size >= TLOG_JSON_STREAM_SIZE_MIN);
+    assert(txt_buf != NULL);
+    assert(bin_buf != NULL);
     assert(valid_mark != invalid_mark);
 
     memset(stream, 0, sizeof(*stream));
 
     stream->dispatcher = dispatcher;
     stream->size = size;
+    stream->txt_buf = txt_buf;
+    stream->bin_buf = bin_buf;
     stream->valid_mark = valid_mark;
     stream->invalid_mark = invalid_mark;
     stream->trx_iface = TLOG_TRX_BASIC_IFACE(tlog_json_stream);
 
-    stream->txt_buf = malloc(size);
-    if (stream->txt_buf == NULL) {
-        grc = TLOG_GRC_ERRNO;
-        goto error;
-    }
-
-    stream->bin_buf = malloc(size);
-    if (stream->bin_buf == NULL) {
-        grc = TLOG_GRC_ERRNO;
-        goto error;
-    }
-
     assert(tlog_json_stream_is_valid(stream));
-    return TLOG_RC_OK;
-error:
-    tlog_json_stream_cleanup(stream);
-    return grc;
 }
 
+/** Decimal representation of a byte */
+struct tlog_json_stream_dec {
+    uint8_t len;        /**< Representation length */
+    uint8_t str[4];     /**< Representation characters,
+                             zero-terminated */
+};
+
+/** Decimal representations of all byte values */
+static const struct tlog_json_stream_dec tlog_json_stream_dec_list[256] = {
+    {1, "0"}, {1, "1"}, {1, "2"}, {1, "3"}, {1, "4"}, {1, "5"}, {1, "6"},
+    {1, "7"}, {1, "8"}, {1, "9"}, {2, "10"}, {2, "11"}, {2, "12"}, {2, "13"},
+    {2, "14"}, {2, "15"}, {2, "16"}, {2, "17"}, {2, "18"}, {2, "19"},
+    {2, "20"}, {2, "21"}, {2, "22"}, {2, "23"}, {2, "24"}, {2, "25"},
+    {2, "26"}, {2, "27"}, {2, "28"}, {2, "29"}, {2, "30"}, {2, "31"},
+    {2, "32"}, {2, "33"}, {2, "34"}, {2, "35"}, {2, "36"}, {2, "37"},
+    {2, "38"}, {2, "39"}, {2, "40"}, {2, "41"}, {2, "42"}, {2, "43"},
+    {2, "44"}, {2, "45"}, {2, "46"}, {2, "47"}, {2, "48"}, {2, "49"},
+    {2, "50"}, {2, "51"}, {2, "52"}, {2, "53"}, {2, "54"}, {2, "55"},
+    {2, "56"}, {2, "57"}, {2, "58"}, {2, "59"}, {2, "60"}, {2, "61"},
+    {2, "62"}, {2, "63"}, {2, "64"}, {2, "65"}, {2, "66"}, {2, "67"},
+    {2, "68"}, {2, "69"}, {2, "70"}, {2, "71"}, {2, "72"}, {2, "73"},
+    {2, "74"}, {2, "75"}, {2, "76"}, {2, "77"}, {2, "78"}, {2, "79"},
+    {2, "80"}, {2, "81"}, {2, "82"}, {2, "83"}, {2, "84"}, {2, "85"},
+    {2, "86"}, {2, "87"}, {2, "88"}, {2, "89"}, {2, "90"}, {2, "91"},
+    {2, "92"}, {2, "93"}, {2, "94"}, {2, "95"}, {2, "96"}, {2, "97"},
+    {2, "98"}, {2, "99"}, {3, "100"}, {3, "101"}, {3, "102"}, {3, "103"},
+    {3, "104"}, {3, "105"}, {3, "106"}, {3, "107"}, {3, "108"}, {3, "109"},
+    {3, "110"}, {3, "111"}, {3, "112"}, {3, "113"}, {3, "114"}, {3, "115"},
+    {3, "116"}, {3, "117"}, {3, "118"}, {3, "119"}, {3, "120"}, {3, "121"},
+    {3, "122"}, {3, "123"}, {3, "124"}, {3, "125"}, {3, "126"}, {3, "127"},
+    {3, "128"}, {3, "129"}, {3, "130"}, {3, "131"}, {3, "132"}, {3, "133"},
+    {3, "134"}, {3, "135"}, {3, "136"}, {3, "137"}, {3, "138"}, {3, "139"},
+    {3, "140"}, {3, "141"}, {3, "142"}, {3, "143"}, {3, "144"}, {3, "145"},
+    {3, "146"}, {3, "147"}, {3, "148"}, {3, "149"}, {3, "150"}, {3, "151"},
+    {3, "152"}, {3, "153"}, {3, "154"}, {3, "155"}, {3, "156"}, {3, "157"},
+    {3, "158"}, {3, "159"}, {3, "160"}, {3, "161"}, {3, "162"}, {3, "163"},
+    {3, "164"}, {3, "165"}, {3, "166"}, {3, "167"}, {3, "168"}, {3, "169"},
+    {3, "170"}, {3, "171"}, {3, "172"}, {3, "173"}, {3, "174"}, {3, "175"},
+    {3, "176"}, {3, "177"}, {3, "178"}, {3, "179"}, {3, "180"}, {3, "181"},
+    {3, "182"}, {3, "183"}, {3, "184"}, {3, "185"}, {3, "186"}, {3, "187"},
+    {3, "188"}, {3, "189"}, {3, "190"}, {3, "191"}, {3, "192"}, {3, "193"},
+    {3, "194"}, {3, "195"}, {3, "196"}, {3, "197"}, {3, "198"}, {3, "199"},
+    {3, "200"}, {3, "201"}, {3, "202"}, {3, "203"}, {3, "204"}, {3, "205"},
+    {3, "206"}, {3, "207"}, {3, "208"}, {3, "209"}, {3, "210"}, {3, "211"},
+    {3, "212"}, {3, "213"}, {3, "214"}, {3, "215"}, {3, "216"}, {3, "217"},
+    {3, "218"}, {3, "219"}, {3, "220"}, {3, "221"}, {3, "222"}, {3, "223"},
+    {3, "224"}, {3, "225"}, {3, "226"}, {3, "227"}, {3, "228"}, {3, "229"},
+    {3, "230"}, {3, "231"}, {3, "232"}, {3, "233"}, {3, "234"}, {3, "235"},
+    {3, "236"}, {3, "237"}, {3, "238"}, {3, "239"}, {3, "240"}, {3, "241"},
+    {3, "242"}, {3, "243"}, {3, "244"}, {3, "245"}, {3, "246"}, {3, "247"},
+    {3, "248"}, {3, "249"}, {3, "250"}, {3, "251"}, {3, "252"}, {3, "253"},
+    {3, "254"}, {3, "255"}
+};
+
 size_t
 tlog_json_stream_btoa(uint8_t *buf, size_t len, uint8_t b)
 {
-    size_t l = 0;
-    if (b >= 100) {
-        if (len > 0) {
-            len--;
-            *buf++ = '0' + b/100;
-        }
-        b %= 100;
-        l++;
+    const struct tlog_json_stream_dec *dec = &tlog_json_stream_dec_list[b];
+    if (len > 0) {
+        memcpy(buf, dec->str, len < dec->len ? len : dec->len);
     }
-    if (b >= 10) {
-        if (len > 0) {
-            len--;
-            *buf++ = '0' + b/10;
+    return dec->len;
+}
+
+/**
+ * Find the run of complete and valid UTF-8 characters at the start of a
+ * buffer, and calculate its length once escaped for a JSON string.
+ *
+ * @param buf   The buffer to scan.
+ * @param len   The buffer length.
+ * @param pchr  Location for the number of characters in the run.
+ * @param pesc  Location for the escaped length of the run, bytes.
+ *
+ * @return The length of the run, bytes.
+ */
+static size_t
+tlog_json_stream_scan_run(const uint8_t *buf, size_t len,
+                          size_t *pchr, size_t *pesc)
+{
+    struct tlog_utf8 utf8;
+    size_t pos = 0;
+    size_t chr = 0;
+    size_t esc = 0;
+    size_t l;
+
+    assert(buf != NULL || len == 0);
+    assert(pchr != NULL);
+    assert(pesc != NULL);
+
+    while (pos < len) {
+        /* Skip ASCII not needing escaping */
+        l = tlog_json_esc_span(buf + pos, len - pos, true);
+        pos += l;
+        chr += l;
+        esc += l;
+        if (pos >= len) {
+            break;
         }
-        b %= 10;
-        l++;
-    } else if (l > 0) {
-        if (len > 0) {
-            len--;
-            *buf++ = '0';
+
+        /* Skip ASCII needing escaping */
+        if (buf[pos] < 0x80) {
+            esc += tlog_json_esc_byte(NULL, buf[pos]);
+            pos++;
+            chr++;
+            continue;
         }
-        l++;
-    }
-    if (len > 0) {
-        *buf = '0' + b;
+
+        /* Skip a multi-byte character, if it's complete and valid */
+        utf8 = TLOG_UTF8_INIT;
+        l = 0;
+        do {
+            if (pos + l >= len || !tlog_utf8_add(&utf8, buf[pos + l])) {
+                break;
+            }
+            l++;
+        } while (!tlog_utf8_is_ended(&utf8));
+        if (!tlog_utf8_is_ended(&utf8) || !tlog_utf8_is_complete(&utf8)) {
+            break;
+        }
+        pos += l;
+        chr++;
+        esc += l;
     }
-    l++;
-    return l;
+
+    *pchr = chr;
+    *pesc = esc;
+    return pos;
 }
 
 #define REQ(_dispatcher, _l) \
@@ -173,11 +255,11 @@ tlog_json_stream_enc_bin(tlog_trx_state trx,
                          size_t *pirun, size_t *pidig,
                          const uint8_t *ibuf, size_t ilen)
 {
-    size_t olen;
+    const struct tlog_json_stream_dec *dec;
     size_t irun;
     size_t idig;
+    size_t i;
     size_t l;
-    TLOG_TRX_FRAME_DEF_SINGLE(dispatcher);
 
     assert(obuf != NULL);
     assert(polen != NULL);
@@ -185,46 +267,58 @@ tlog_json_stream_enc_bin(tlog_trx_state trx,
     assert(pidig != NULL);
     assert(ibuf != NULL || ilen == 0);
 
+    /* A single reservation leaves nothing to roll back */
+    (void)trx;
+
     if (ilen == 0) {
         return true;
     }
 
-    TLOG_TRX_FRAME_BEGIN(trx);
-    olen = *polen;
     irun = *pirun;
     idig = *pidig;
+    l = 0;
 
     /* If this is the start of a run */
     if (irun == 0) {
         idig = 10;
         /* Reserve space for the marker and single digit run */
-        REQ(dispatcher, 2);
+        l += 2;
+    }
+
+    /* Reserve space for each digit the run counter gains */
+    irun += ilen;
+    while (irun >= idig) {
+        l++;
+        idig *= 10;
     }
 
+    /* Reserve space for the separating commas and the numbers */
+    l += (*polen > 0) ? ilen : ilen - 1;
+    for (i = 0; i < ilen; i++) {
+        l += tlog_json_stream_dec_list[ibuf[i]].len;
+    }
+
+    REQ(dispatcher, l);
+
+    l = 0;
+    if (*polen == 0) {
+        dec = &tlog_json_stream_dec_list[*ibuf++];
+        memcpy(obuf, dec->str, dec->len);
+        l += dec->len;
+        ilen--;
+    }
     for (; ilen > 0; ilen--) {
-        irun++;
-        if (irun >= idig) {
-            REQ(dispatcher, 1);
-            idig *= 10;
-        }
-        if (olen > 0) {
-            ADV(dispatcher, 1);
-            *obuf++ = ',';
-        }
-        l = tlog_json_stream_btoa(NULL, 0, *ibuf);
-        ADV(dispatcher, l);
-        tlog_json_stream_btoa(obuf, l, *ibuf);
-        ibuf++;
-        obuf += l;
+        dec = &tlog_json_stream_dec_list[*ibuf++];
+        obuf[l++] = ',';
+        memcpy(obuf + l, dec->str, dec->len);
+        l += dec->len;
     }
 
-    *polen = olen;
+    *polen += l;
     *pirun = irun;
     *pidig = idig;
-    TLOG_TRX_FRAME_COMMIT(trx);
     return true;
 failure:
-    TLOG_TRX_FRAME_ABORT(trx);
     return false;
 }
 
@@ -235,7 +329,6 @@ tlog_json_stream_enc_txt(tlog_trx_state trx,
                          size_t *pirun, size_t *pidig,
                          const uint8_t *ibuf, size_t ilen)
 {
-    uint8_t c;
     size_t olen;
     size_t irun;
     size_t idig;
@@ -273,42 +366,8 @@ tlog_json_stream_enc_txt(tlog_trx_state trx,
         ADV(dispatcher, ilen);
         memcpy(obuf, ibuf, ilen);
     } else {
-        c = *ibuf;
-        switch (c) {
-        case '"':
-        case '\\':
-            ADV(dispatcher, 2);
-            *obuf++ = '\\';
-            *obuf = c;
-            break;
-#define ESC_CASE(_c, _e) \
-        case _c:                \
-            ADV(dispatcher, 2); \
-            *obuf++ = '\\';     \
-            *obuf = _e;         \
-            break;
-        ESC_CASE('\b', 'b');
-        ESC_CASE('\f', 'f');
-        ESC_CASE('\n', 'n');
-        ESC_CASE('\r', 'r');
-        ESC_CASE('\t', 't');
-#undef ESC
-        default:
-            if (c < 0x20 || c == 0x7f) {
-                ADV(dispatcher, 6);
-                *obuf++ = '\\';
-                *obuf++ = 'u';
-                *obuf++ = '0';
-                *obuf++ = '0';
-                *obuf++ = tlog_nibble_digit(c >> 4);
-                *obuf = tlog_nibble_digit(c & 0xf);
-                break;
-            } else {
-                ADV(dispatcher, 1);
-                *obuf = c;
-            }
-            break;
-        }
+        ADV(dispatcher, tlog_json_esc_byte(NULL, *ibuf));
+        tlog_json_esc_byte(obuf, *ibuf);
     }
 
     *polen = olen;
@@ -321,6 +380,90 @@ failure:
     return false;
 }
 
+/**
+ * Encode a run of complete and valid UTF-8 characters into a JSON string
+ * buffer, with a single reservation, copying the spans not needing escaping
+ * as is. Reserve space for adding input length in decimal characters.
+ *
+ * @param dispatcher    The dispatcher to reserve space from.
+ * @param obuf          Output buffer.
+ * @param polen         Location of/for output byte counter.
+ * @param pirun         Location of/for input character counter.
+ * @param pidig         Location of/for the next digit input counter limit.
+ * @param ibuf          Input buffer.
+ * @param ilen          Input length, bytes.
+ * @param ichr          Input length, characters.
+ * @param iesc          Input length once escaped, bytes.
+ *
+ * @return True if the run and the new counter did fit into the remaining
+ *         output space, false if nothing was written.
+ */
+static bool
+tlog_json_stream_enc_txt_run(struct tlog_json_dispatcher *dispatcher,
+                             uint8_t *obuf, size_t *polen,
+                             size_t *pirun, size_t *pidig,
+                             const uint8_t *ibuf, size_t ilen,
+                             size_t ichr, size_t iesc)
+{
+    size_t irun;
+    size_t idig;
+    size_t l;
+
+    assert(obuf != NULL);
+    assert(polen != NULL);
+    assert(pirun != NULL);
+    assert(pidig != NULL);
+    assert(ibuf != NULL || ilen == 0);
+    assert(ichr <= ilen);
+    assert(iesc >= ilen);
+
+    if (ilen == 0) {
+        return true;
+    }
+
+    irun = *pirun;
+    idig = *pidig;
+    l = iesc;
+
+    /* If this is the start of a run */
+    if (irun == 0) {
+        idig = 10;
+        /* Reserve space for the marker and single digit run */
+        l += 2;
+    }
+
+    /* Reserve space for each digit the run counter gains */
+    irun += ichr;
+    while (irun >= idig) {
+        l++;
+        idig *= 10;
+    }
+
+    REQ(dispatcher, l);
+
+    /* Copy the spans not needing escaping, escape the bytes in between */
+    while (true) {
+        l = tlog_json_esc_span(ibuf, ilen, false);
+        memcpy(obuf, ibuf, l);
+        obuf += l;
+        ibuf += l;
+        ilen -= l;
+        if (ilen == 0) {
+            break;
+        }
+        obuf += tlog_json_esc_byte(obuf, *ibuf);
+        ibuf++;
+        ilen--;
+    }
+
+    *polen += iesc;
+    *pirun = irun;
+    *pidig = idig;
+    return true;
+failure:
+    return false;
+}
+
 #undef ADV
 #undef REQ
 
@@ -371,7 +514,8 @@ tlog_json_stream_flush(struct tlog_json_stream *stream)
     assert(tlog_json_stream_is_valid(stream));
     tlog_json_stream_write_meta(stream->dispatcher,
                                 stream->valid_mark, stream->invalid_mark,
-                                &stream->txt_run, &stream->bin_run);
+                                &stream->state.txt_run,
+                                &stream->state.bin_run);
 }
 
 /**
@@ -408,10 +552,11 @@ tlog_json_stream_write_seq(tlog_trx_state trx,
     TLOG_TRX_FRAME_BEGIN(trx);
 
     /* Cut the run, if changing type */
-    if ((!valid) != (stream->bin_run != 0)) {
+    if ((!valid) != (stream->state.bin_run != 0)) {
         tlog_json_stream_write_meta(stream->dispatcher,
                                     stream->valid_mark, stream->invalid_mark,
-                                    &stream->txt_run, &stream->bin_run);
+                                    &stream->state.txt_run,
+                                    &stream->state.bin_run);
     }
 
     /* Advance the time */
@@ -423,9 +568,10 @@ tlog_json_stream_write_seq(tlog_trx_state trx,
         /* Write the character to the text buffer */
         if (!tlog_json_stream_enc_txt(trx,
                                       stream->dispatcher,
-                                      stream->txt_buf + stream->txt_len,
-                                      &stream->txt_len,
-                                      &stream->txt_run, &stream->txt_dig,
+                                      stream->txt_buf + stream->state.txt_len,
+                                      &stream->state.txt_len,
+                                      &stream->state.txt_run,
+                                      &stream->state.txt_dig,
                                       buf, len)) {
             goto failure;
         }
@@ -433,9 +579,10 @@ tlog_json_stream_write_seq(tlog_trx_state trx,
         /* Write the replacement character to the text buffer */
         if (!tlog_json_stream_enc_txt(trx,
                                       stream->dispatcher,
-                                      stream->txt_buf + stream->txt_len,
-                                      &stream->txt_len,
-                                      &stream->txt_run, &stream->txt_dig,
+                                      stream->txt_buf + stream->state.txt_len,
+                                      &stream->state.txt_len,
+                                      &stream->state.txt_run,
+                                      &stream->state.txt_dig,
                                       repl_buf, sizeof(repl_buf))) {
             goto failure;
         }
@@ -443,9 +590,10 @@ tlog_json_stream_write_seq(tlog_trx_state trx,
         /* Write bytes to the binary buffer */
         if (!tlog_json_stream_enc_bin(trx,
                                       stream->dispatcher,
-                                      stream->bin_buf + stream->bin_len,
-                                      &stream->bin_len,
-                                      &stream->bin_run, &stream->bin_dig,
+                                      stream->bin_buf + stream->state.bin_len,
+                                      &stream->state.bin_len,
+                                      &stream->state.bin_run,
+                                      &stream->state.bin_dig,
                                       buf, len)) {
             goto failure;
         }
@@ -459,6 +607,70 @@ failure:
     return false;
 }
 
+/**
+ * Atomically write a run of complete and valid UTF-8 characters to a
+ * stream. Account for any (potentially) used total remaining
+ * space.
+ *
+ * @param trx       Transaction to act within.
+ * @param stream    The stream to write to.
+ * @param ts        The run timestamp.
+ * @param buf       Run buffer pointer.
+ * @param len       Run buffer length, bytes.
+ * @param chr       Run length, characters.
+ * @param esc       Run length once escaped, bytes.
+ *
+ * @return True if the run was written, false otherwise.
+ */
+static bool
+tlog_json_stream_write_run(tlog_trx_state trx,
+                           struct tlog_json_stream *stream,
+                           const struct timespec *ts,
+                           const uint8_t *buf, size_t len,
+                           size_t chr, size_t esc)
+{
+    TLOG_TRX_FRAME_DEF_SINGLE(stream);
+
+    assert(tlog_json_stream_is_valid(stream));
+    assert(buf != NULL || len == 0);
+
+    if (len == 0) {
+        return true;
+    }
+
+    TLOG_TRX_FRAME_BEGIN(trx);
+
+    /* Cut the run, if changing type */
+    if (stream->state.bin_run != 0) {
+        tlog_json_stream_write_meta(stream->dispatcher,
+                                    stream->valid_mark, stream->invalid_mark,
+                                    &stream->state.txt_run,
+                                    &stream->state.bin_run);
+    }
+
+    /* Advance the time */
+    if (!tlog_json_dispatcher_advance(trx, stream->dispatcher, ts)) {
+        goto failure;
+    }
+
+    /* Write the characters to the text buffer */
+    if (!tlog_json_stream_enc_txt_run(stream->dispatcher,
+                                      stream->txt_buf + stream->state.txt_len,
+                                      &stream->state.txt_len,
+                                      &stream->state.txt_run,
+                                      &stream->state.txt_dig,
+                                      buf, len, chr, esc)) {
+        goto failure;
+    }
+    stream->state.ts = *ts;
+
+    TLOG_TRX_FRAME_COMMIT(trx);
+    return true;
+
+failure:
+    TLOG_TRX_FRAME_ABORT(trx);
+    return false;
+}
 
 size_t
 tlog_json_stream_write(tlog_trx_state trx,
@@ -470,6 +682,10 @@ tlog_json_stream_write(tlog_trx_state trx,
     size_t len;
     struct tlog_utf8 *utf8;
     size_t written;
+    bool bulk = true;
+    size_t run_len;
+    size_t run_chr;
+    size_t run_esc;
     TLOG_TRX_FRAME_DEF_SINGLE(stream);
 
     assert(tlog_json_stream_is_valid(stream));
@@ -479,7 +695,7 @@ tlog_json_stream_write(tlog_trx_state trx,
 
     buf = *pbuf;
     len = *plen;
-    utf8 = &stream->utf8;
+    utf8 = &stream->state.utf8;
     assert(!tlog_utf8_is_ended(utf8));
 
     /*
@@ -490,6 +706,26 @@ tlog_json_stream_write(tlog_trx_state trx,
         const uint8_t *start_buf = buf;
         size_t start_len = len;
 
+        /*
+         * If we're between characters, try writing the run of complete
+         * characters in one go, and fall back to writing them one-by-one,
+         * so as many as possible fit, if the run doesn't.
+         */
+        if (bulk && !tlog_utf8_is_started(utf8)) {
+            run_len = tlog_json_stream_scan_run(buf, len,
+                                                &run_chr, &run_esc);
+            if (run_len > 0) {
+                if (tlog_json_stream_write_run(trx, stream, ts,
+                                               buf, run_len,
+                                               run_chr, run_esc)) {
+                    buf += run_len;
+                    len -= run_len;
+                    continue;
+                }
+                bulk = false;
+            }
+        }
+
         TLOG_TRX_FRAME_BEGIN(trx);
 
         /*
@@ -508,7 +744,7 @@ tlog_json_stream_write(tlog_trx_state trx,
                 buf++;
                 len--;
                 /* Record last added byte timestamp */
-                stream->ts = *ts;
+                stream->state.ts = *ts;
             }
         } while (!tlog_utf8_is_ended(utf8));
 
@@ -523,7 +759,7 @@ tlog_json_stream_write(tlog_trx_state trx,
             len--;
         } else {
             /* If the (in)complete character doesn't fit into output */
-            if (!tlog_json_stream_write_seq(trx, stream, &stream->ts,
+            if (!tlog_json_stream_write_seq(trx, stream, &stream->state.ts,
                                             tlog_utf8_is_complete(utf8),
                                             utf8->buf, utf8->len)) {
                 /* Back up unwritten data */
@@ -555,11 +791,11 @@ tlog_json_stream_cut(tlog_trx_state trx,
 
     assert(tlog_json_stream_is_valid(stream));
 
-    utf8 = &stream->utf8;
+    utf8 = &stream->state.utf8;
     assert(!tlog_utf8_is_ended(utf8));
 
     TLOG_TRX_FRAME_BEGIN(trx);
-    if (tlog_json_stream_write_seq(trx, stream, &stream->ts,
+    if (tlog_json_stream_write_seq(trx, stream, &stream->state.ts,
                                    false, utf8->buf, utf8->len)) {
         tlog_utf8_reset(utf8);
         TLOG_TRX_FRAME_COMMIT(trx);
@@ -574,8 +810,8 @@ void
 tlog_json_stream_empty(struct tlog_json_stream *stream)
 {
     assert(tlog_json_stream_is_valid(stream));
-    stream->txt_run = 0;
-    stream->txt_len = 0;
-    stream->bin_run = 0;
-    stream->bin_len = 0;
+    stream->state.txt_run = 0;
+    stream->state.txt_len = 0;
+    stream->state.bin_run = 0;
+    stream->state.bin_len = 0;
 }
@@ -22,8 +22,10 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <string.h>
 #include <tlog/rc.h>
 #include <tlog/json_writer.h>
+#include <tlog/json_sink.h>
 
 tlog_grc
 tlog_json_writer_create(struct tlog_json_writer **pwriter,
@@ -82,6 +84,89 @@ tlog_json_writer_write(struct tlog_json_writer *writer,
     return writer->type->write(writer, id, buf, len);
 }
 
+/** Size of the on-stack buffer for gathering vectored writes */
+#define TLOG_JSON_WRITER_GATHER_SIZE    4096
+
+tlog_grc
+tlog_json_writer_writev(struct tlog_json_writer *writer,
+                        size_t id,
+                        const struct iovec *iov,
+                        int iovcnt)
+{
+    uint8_t stack_buf[TLOG_JSON_WRITER_GATHER_SIZE];
+    uint8_t *buf;
+    uint8_t *p;
+    size_t len;
+    int i;
+    tlog_grc grc;
+
+    assert(tlog_json_writer_is_valid(writer));
+    assert(id > 0);
+    assert(iov != NULL || iovcnt == 0);
+    assert(iovcnt >= 0);
+
+    if (writer->type->writev != NULL) {
+        return writer->type->writev(writer, id, iov, iovcnt);
+    }
+
+    /* Gather the buffers for a writer type which can't do it itself */
+    len = 0;
+    for (i = 0; i < iovcnt; i++) {
+        len += iov[i].iov_len;
+    }
+    if (len == 0) {
+        return writer->type->write(writer, id, NULL, 0);
+    } else if (len <= sizeof(stack_buf)) {
+        buf = stack_buf;
+    } else {
+        buf = malloc(len);
+        if (buf == NULL) {
+            return TLOG_GRC_ERRNO;
+        }
+    }
+    p = buf;
+    for (i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len > 0) {
+            memcpy(p, iov[i].iov_base, iov[i].iov_len);
+            p += iov[i].iov_len;
+        }
+    }
+
+    grc = writer->type->write(writer, id, buf, len);
+
+    if (buf != stack_buf) {
+        free(buf);
+    }
+    return grc;
+}
+
+tlog_grc
+tlog_json_writer_write_msg(struct tlog_json_writer *writer,
+                           size_t id,
+                           const struct iovec *iov)
+{
+    assert(tlog_json_writer_is_valid(writer));
+    assert(id > 0);
+    assert(iov != NULL);
+
+    if (writer->type->write_msg != NULL) {
+        return writer->type->write_msg(writer, id, iov);
+    }
+    return tlog_json_writer_writev(writer, id, iov,
+                                   TLOG_JSON_SINK_MSG_PART_NUM);
+}
+
+tlog_grc
+tlog_json_writer_flush(struct tlog_json_writer *writer)
+{
+    assert(tlog_json_writer_is_valid(writer));
+
+    if (writer->type->flush == NULL) {
+        return TLOG_RC_OK;
+    }
+    return writer->type->flush(writer);
+}
+
 void
 tlog_json_writer_destroy(struct tlog_json_writer *writer)
 {
@@ -22,8 +22,10 @@
 
 #include <config.h>
 #include <stdio.h>
+#include <string.h>
 #include <json_tokener.h>
 #include <tlog/mem_json_reader.h>
+#include <tlog/json_msg.h>
 #include <tlog/rc.h>
 
 /** Memory buffer reader data */
@@ -33,6 +35,9 @@ struct tlog_mem_json_reader {
     size_t                  line;   /**< Number of the line being read */
     const char             *pos;    /**< Buffer reading position */
     const char             *end;    /**< End of buffer */
+    char                   *line_buf;   /**< Buffer for the message line
+                                             being parsed */
+    size_t                  line_size;  /**< Line buffer size */
 };
 
 static void
@@ -44,6 +49,8 @@ tlog_mem_json_reader_cleanup(struct tlog_json_reader *reader)
         json_tokener_free(mem_json_reader->tok);
         mem_json_reader->tok = NULL;
     }
+    free(mem_json_reader->line_buf);
+    mem_json_reader->line_buf = NULL;
 }
 
 static tlog_grc
@@ -221,6 +228,65 @@ tlog_mem_json_reader_read(struct tlog_json_reader *reader,
     return grc;
 }
 
+static tlog_grc
+tlog_mem_json_reader_read_msg(struct tlog_json_reader *reader,
+                              struct tlog_json_msg *msg,
+                              const struct tlog_json_msg_filter *filter)
+{
+    struct tlog_mem_json_reader *mem_json_reader =
+                                (struct tlog_mem_json_reader*)reader;
+    tlog_grc grc;
+    const char *p;
+    size_t len;
+
+    while (true) {
+        /* Skip leading whitespace */
+        tlog_mem_json_reader_skip_whitespace(mem_json_reader);
+
+        /* Look for a terminating newline */
+        p = memchr(mem_json_reader->pos, '\n',
+                   mem_json_reader->end - mem_json_reader->pos);
+        len = (p == NULL ? mem_json_reader->end : p) - mem_json_reader->pos;
+
+        /* If the line is empty */
+        if (len == 0) {
+            /* Report EOF */
+            tlog_json_msg_init(msg, NULL);
+            return TLOG_RC_OK;
+        }
+
+        /* Stop, unless the line can't match */
+        if (filter == NULL ||
+            tlog_json_msg_text_may_match(mem_json_reader->pos, len, filter)) {
+            break;
+        }
+        mem_json_reader->pos += len;
+        tlog_mem_json_reader_skip_line(mem_json_reader);
+    }
+
+    /* Copy the line to be parsed in place */
+    if (len > mem_json_reader->line_size) {
+        char *buf = realloc(mem_json_reader->line_buf, len);
+        if (buf == NULL) {
+            tlog_json_msg_init(msg, NULL);
+            return TLOG_GRC_ERRNO;
+        }
+        mem_json_reader->line_buf = buf;
+        mem_json_reader->line_size = len;
+    }
+    memcpy(mem_json_reader->line_buf, mem_json_reader->pos, len);
+    mem_json_reader->pos += len;
+
+    /* Throw away the rest of the line */
+    tlog_mem_json_reader_skip_line(mem_json_reader);
+
+    /* Parse the line */
+    grc = tlog_json_msg_init_text(msg, mem_json_reader->line_buf, len);
+    return (grc == TLOG_GRC_FROM(json, json_tokener_continue))
+                ? TLOG_RC_MEM_JSON_READER_INCOMPLETE_LINE
+                : grc;
+}
+
 const struct tlog_json_reader_type tlog_mem_json_reader_type = {
     .size       = sizeof(struct tlog_mem_json_reader),
     .init       = tlog_mem_json_reader_init,
@@ -228,5 +294,6 @@ const struct tlog_json_reader_type tlog_mem_json_reader_type = {
     .loc_get    = tlog_mem_json_reader_loc_get,
     .loc_fmt    = tlog_mem_json_reader_loc_fmt,
     .read       = tlog_mem_json_reader_read,
+    .read_msg   = tlog_mem_json_reader_read_msg,
     .cleanup    = tlog_mem_json_reader_cleanup,
 };
@@ -51,16 +51,21 @@ tlog_mem_json_writer_init(struct tlog_json_writer *writer, va_list ap)
     return TLOG_RC_OK;
 }
 
+/**
+ * Make sure a memory writer buffer has space for the specified number of
+ * bytes more.
+ *
+ * @param mem_json_writer   The memory writer to grow the buffer of.
+ * @param len               The number of bytes to make space for.
+ *
+ * @return Global return code.
+ */
 static tlog_grc
-tlog_mem_json_writer_write(struct tlog_json_writer *writer,
-                           size_t id, const uint8_t *buf, size_t len)
+tlog_mem_json_writer_grow(struct tlog_mem_json_writer *mem_json_writer,
+                          size_t len)
 {
-    struct tlog_mem_json_writer *mem_json_writer =
-                                    (struct tlog_mem_json_writer*)writer;
     size_t new_len = *mem_json_writer->plen + len;
 
-    (void)id;
-
     if (new_len > mem_json_writer->size) {
         size_t new_size;
         char *new_buf;
@@ -75,8 +80,57 @@ tlog_mem_json_writer_write(struct tlog_json_writer *writer,
         mem_json_writer->size = new_size;
     }
 
+    return TLOG_RC_OK;
+}
+
+static tlog_grc
+tlog_mem_json_writer_write(struct tlog_json_writer *writer,
+                           size_t id, const uint8_t *buf, size_t len)
+{
+    struct tlog_mem_json_writer *mem_json_writer =
+                                    (struct tlog_mem_json_writer*)writer;
+    tlog_grc grc;
+
+    (void)id;
+
+    grc = tlog_mem_json_writer_grow(mem_json_writer, len);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+
     memcpy(*mem_json_writer->pbuf + *mem_json_writer->plen, buf, len);
-    *mem_json_writer->plen = new_len;
+    *mem_json_writer->plen += len;
+    return TLOG_RC_OK;
+}
+
+static tlog_grc
+tlog_mem_json_writer_writev(struct tlog_json_writer *writer,
+                            size_t id, const struct iovec *iov, int iovcnt)
+{
+    struct tlog_mem_json_writer *mem_json_writer =
+                                    (struct tlog_mem_json_writer*)writer;
+    tlog_grc grc;
+    size_t len = 0;
+    int i;
+
+    (void)id;
+
+    for (i = 0; i < iovcnt; i++) {
+        len += iov[i].iov_len;
+    }
+
+    grc = tlog_mem_json_writer_grow(mem_json_writer, len);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+
+    for (i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len > 0) {
+            memcpy(*mem_json_writer->pbuf + *mem_json_writer->plen,
+                   iov[i].iov_base, iov[i].iov_len);
+            *mem_json_writer->plen += iov[i].iov_len;
+        }
+    }
     return TLOG_RC_OK;
 }
 
@@ -84,4 +138,5 @@ const struct tlog_json_writer_type tlog_mem_json_writer_type = {
     .size   = sizeof(struct tlog_mem_json_writer),
     .init   = tlog_mem_json_writer_init,
     .write  = tlog_mem_json_writer_write,
+    .writev = tlog_mem_json_writer_writev,
 };
@@ -24,7 +24,10 @@
 #include <tlog/rc.h>
 #include <tlog/misc.h>
 #include <unistd.h>
+#include <errno.h>
+#include <limits.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <libgen.h>
 #include <string.h>
 #include <stdlib.h>
@@ -40,6 +43,158 @@ const char *tlog_version =
         "you are free to change and redistribute it.\n"
     "There is NO WARRANTY, to the extent permitted by law.\n";
 
+size_t
+tlog_uint64_fmt(char *buf, uint64_t n)
+{
+    static const char pair_list[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+    size_t len;
+    uint64_t m;
+    char *p;
+    size_t i;
+
+    assert(buf != NULL);
+
+    len = 1;
+    m = n;
+    while (m > 9) {
+        len++;
+        m /= 10;
+    }
+
+    p = buf + len;
+    while (n >= 100) {
+        i = (size_t)(n % 100) * 2;
+        n /= 100;
+        *--p = pair_list[i + 1];
+        *--p = pair_list[i];
+    }
+    if (n >= 10) {
+        i = (size_t)n * 2;
+        *--p = pair_list[i + 1];
+        *--p = pair_list[i];
+    } else {
+        *--p = '0' + (char)n;
+    }
+
+    return len;
+}
+
+void
+tlog_release_pages(void *ptr, size_t len)
+{
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = ((uintptr_t)ptr + page - 1) & ~(page - 1);
+    uintptr_t end = ((uintptr_t)ptr + len) & ~(page - 1);
+
+    assert(ptr != NULL || len == 0);
+
+    /* Nothing to do if the advice is not taken */
+    if (end > start) {
+        madvise((void *)start, end - start, MADV_DONTNEED);
+    }
+}
+
+tlog_grc
+tlog_resident_size(const void *ptr, size_t len, size_t *president)
+{
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = ((uintptr_t)ptr + page - 1) & ~(page - 1);
+    uintptr_t end = ((uintptr_t)ptr + len) & ~(page - 1);
+    unsigned char *vec;
+    size_t num;
+    size_t i;
+    size_t resident = 0;
+
+    assert(ptr != NULL || len == 0);
+    assert(president != NULL);
+
+    if (end > start) {
+        num = (end - start) / page;
+        vec = malloc(num);
+        if (vec == NULL) {
+            return TLOG_GRC_ERRNO;
+        }
+        if (mincore((void *)start, end - start, vec) < 0) {
+            free(vec);
+            return TLOG_GRC_ERRNO;
+        }
+        for (i = 0; i < num; i++) {
+            if (vec[i] & 1) {
+                resident += page;
+            }
+        }
+        free(vec);
+    }
+
+    *president = resident;
+    return TLOG_RC_OK;
+}
+
+tlog_grc
+tlog_writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    ssize_t rc;
+    size_t done;
+    const uint8_t *p;
+    size_t len;
+    bool written = false;
+
+    assert(iov != NULL || iovcnt == 0);
+
+    while (iovcnt > 0) {
+        rc = writev(fd, iov, iovcnt < IOV_MAX ? iovcnt : IOV_MAX);
+        if (rc < 0) {
+            /* If interrupted after writing something */
+            if (errno == EINTR && written) {
+                continue;
+            } else {
+                return TLOG_GRC_ERRNO;
+            }
+        }
+        written = written || rc > 0;
+
+        /* Skip the buffers written completely */
+        done = (size_t)rc;
+        while (iovcnt > 0 && done >= iov->iov_len) {
+            done -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+
+        /* Finish the buffer written partially, if any */
+        if (done > 0) {
+            p = (const uint8_t *)iov->iov_base + done;
+            len = iov->iov_len - done;
+            while (len > 0) {
+                rc = write(fd, p, len);
+                if (rc < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    } else {
+                        return TLOG_GRC_ERRNO;
+                    }
+                }
+                p += rc;
+                len -= (size_t)rc;
+            }
+            iov++;
+            iovcnt--;
+        }
+    }
+
+    return TLOG_RC_OK;
+}
+
 tlog_grc
 tlog_build_or_inst_path(char          **ppath,
                         const char     *prog_path,
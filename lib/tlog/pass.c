@@ -0,0 +1,356 @@
+/*
+ * Terminal data pass-through.
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <tlog/rc.h>
+#include <tlog/misc.h>
+#include <tlog/pass.h>
+
+tlog_grc
+tlog_pass_init(struct tlog_pass *pass, int in_fd, int out_fd, bool out_wait)
+{
+    tlog_grc grc;
+    struct epoll_event ev = {.events = EPOLLIN};
+
+    assert(pass != NULL);
+    assert(in_fd >= 0);
+    assert(out_fd >= 0);
+
+    *pass = TLOG_PASS_VOID;
+
+    pass->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (pass->epoll_fd < 0) {
+        grc = TLOG_GRC_ERRNO;
+        goto error;
+    }
+    if (epoll_ctl(pass->epoll_fd, EPOLL_CTL_ADD, in_fd, &ev) < 0) {
+        grc = TLOG_GRC_ERRNO;
+        goto error;
+    }
+    if (pipe2(pass->pipe_fd, O_CLOEXEC) < 0) {
+        grc = TLOG_GRC_ERRNO;
+        goto error;
+    }
+    /*
+     * Make the output FD non-blocking, unless waiting for it, so neither
+     * splicing nor writing blocks when it doesn't accept the data
+     */
+    if (!out_wait) {
+        int flags = fcntl(out_fd, F_GETFL);
+        if (flags < 0) {
+            grc = TLOG_GRC_ERRNO;
+            goto error;
+        }
+        if (!(flags & O_NONBLOCK)) {
+            if (fcntl(out_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+                grc = TLOG_GRC_ERRNO;
+                goto error;
+            }
+            pass->out_flags = flags;
+        }
+    }
+    pass->in_fd = in_fd;
+    pass->out_fd = out_fd;
+    pass->out_wait = out_wait;
+
+    assert(tlog_pass_is_valid(pass));
+    return TLOG_RC_OK;
+
+error:
+    tlog_pass_cleanup(pass);
+    return grc;
+}
+
+bool
+tlog_pass_is_valid(const struct tlog_pass *pass)
+{
+    return pass != NULL &&
+           (tlog_pass_is_void(pass)
+                ? (pass->epoll_fd < 0 &&
+                   pass->pipe_fd[0] < 0 && pass->pipe_fd[1] < 0 &&
+                   pass->buf == NULL)
+                : (pass->out_fd >= 0 && pass->epoll_fd >= 0 &&
+                   pass->len <= TLOG_PASS_SIZE &&
+                   (pass->buf != NULL || pass->pos == 0) &&
+                   pass->pos <= TLOG_PASS_SIZE - pass->len &&
+                   (pass->buf != NULL ||
+                    (pass->pipe_fd[0] >= 0 && pass->pipe_fd[1] >= 0))));
+}
+
+int
+tlog_pass_get_fd(const struct tlog_pass *pass)
+{
+    assert(tlog_pass_is_valid(pass));
+    assert(!tlog_pass_is_void(pass));
+    return pass->epoll_fd;
+}
+
+/**
+ * Switch the epoll FD of a pass-through to watching either its input or
+ * its output FD.
+ *
+ * @param pass  The pass-through to switch.
+ * @param out   True to watch the output FD, false to watch the input FD.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_pass_watch(struct tlog_pass *pass, bool out)
+{
+    struct epoll_event ev = {.events = out ? EPOLLOUT : EPOLLIN};
+
+    if (pass->out_watched == out) {
+        return TLOG_RC_OK;
+    }
+    if (epoll_ctl(pass->epoll_fd, EPOLL_CTL_DEL,
+                  out ? pass->in_fd : pass->out_fd, NULL) < 0 ||
+        epoll_ctl(pass->epoll_fd, EPOLL_CTL_ADD,
+                  out ? pass->out_fd : pass->in_fd, &ev) < 0) {
+        return TLOG_GRC_ERRNO;
+    }
+    pass->out_watched = out;
+    return TLOG_RC_OK;
+}
+
+/**
+ * Handle the output FD of a pass-through not accepting more data: either
+ * wait for it to become writable, if the pass-through waits for it, or
+ * switch the epoll FD to watching it.
+ *
+ * @param pass      The pass-through to handle the output FD of.
+ * @param pwatched  Location for the flag set to true if the epoll FD was
+ *                  switched to watching the output FD, and the run should
+ *                  return, keeping the rest of the data, or to false if
+ *                  the output FD should be retried.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_pass_wait_out(struct tlog_pass *pass, bool *pwatched)
+{
+    struct pollfd pfd = {.fd = pass->out_fd, .events = POLLOUT};
+
+    if (!pass->out_wait) {
+        *pwatched = true;
+        return tlog_pass_watch(pass, true);
+    }
+    *pwatched = false;
+    if (poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+        return TLOG_GRC_ERRNO;
+    }
+    return TLOG_RC_OK;
+}
+
+/**
+ * Switch a pass-through from splicing to copying the data via a buffer,
+ * moving the data already spliced into the pipe, if any, to the buffer.
+ *
+ * @param pass  The pass-through to switch.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_pass_fall_back(struct tlog_pass *pass)
+{
+    size_t pos = 0;
+    ssize_t rc;
+
+    pass->buf = malloc(TLOG_PASS_SIZE);
+    if (pass->buf == NULL) {
+        return TLOG_GRC_ERRNO;
+    }
+
+    while (pos < pass->len) {
+        rc = read(pass->pipe_fd[0], pass->buf + pos, pass->len - pos);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return TLOG_GRC_ERRNO;
+        }
+        pos += rc;
+    }
+
+    close(pass->pipe_fd[0]);
+    pass->pipe_fd[0] = -1;
+    close(pass->pipe_fd[1]);
+    pass->pipe_fd[1] = -1;
+    return TLOG_RC_OK;
+}
+
+tlog_grc
+tlog_pass_run(struct tlog_pass *pass, bool *peof)
+{
+    tlog_grc grc;
+    ssize_t rc;
+    size_t moved = 0;
+    bool watched;
+
+    assert(tlog_pass_is_valid(pass));
+    assert(!tlog_pass_is_void(pass));
+    assert(peof != NULL);
+
+    *peof = false;
+
+    while (moved < TLOG_PASS_BURST) {
+        /* Read new data, unless the output hasn't accepted the last yet */
+        if (pass->len == 0) {
+            /*
+             * Stop, if there is no more data after the first read, checking
+             * explicitly, as SPLICE_F_NONBLOCK doesn't make reading a
+             * blocking input FD, such as a terminal, non-blocking
+             */
+            if (moved > 0) {
+                struct pollfd pfd = {.fd = pass->in_fd, .events = POLLIN};
+                do {
+                    rc = poll(&pfd, 1, 0);
+                } while (rc < 0 && errno == EINTR);
+                if (rc < 0) {
+                    return TLOG_GRC_ERRNO;
+                } else if (rc == 0) {
+                    break;
+                }
+            }
+            rc = -1;
+            /* Splice the data into the pipe, unless fell back to copying */
+            if (pass->buf == NULL) {
+                do {
+                    rc = splice(pass->in_fd, NULL, pass->pipe_fd[1], NULL,
+                                TLOG_PASS_SIZE,
+                                SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                } while (rc < 0 && errno == EINTR);
+                if (rc < 0) {
+                    /* If the input FD shares a non-blocking description */
+                    if (errno == EAGAIN) {
+                        break;
+                    /* If the input FD doesn't support splicing */
+                    } else if (errno != EINVAL) {
+                        return TLOG_GRC_ERRNO;
+                    }
+                    grc = tlog_pass_fall_back(pass);
+                    if (grc != TLOG_RC_OK) {
+                        return grc;
+                    }
+                }
+            }
+            /* Read the data into the buffer, if not spliced */
+            if (rc < 0) {
+                do {
+                    rc = read(pass->in_fd, pass->buf, TLOG_PASS_SIZE);
+                } while (rc < 0 && errno == EINTR);
+                if (rc < 0) {
+                    /* If the input FD shares a non-blocking description */
+                    if (errno == EAGAIN) {
+                        break;
+                    }
+                    return TLOG_GRC_ERRNO;
+                }
+            }
+            if (rc == 0) {
+                *peof = true;
+                return TLOG_RC_OK;
+            }
+            pass->len = rc;
+        }
+        moved += pass->len;
+
+        /* Splice the data out of the pipe, unless fell back to copying */
+        while (pass->buf == NULL && pass->len > 0) {
+            rc = splice(pass->pipe_fd[0], NULL, pass->out_fd, NULL,
+                        pass->len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (rc < 0) {
+                if (errno == EINTR) {
+                    continue;
+                /* If the output FD doesn't accept more, wait for it */
+                } else if (errno == EAGAIN) {
+                    grc = tlog_pass_wait_out(pass, &watched);
+                    if (grc != TLOG_RC_OK || watched) {
+                        return grc;
+                    }
+                    continue;
+                /* If the output FD doesn't support splicing */
+                } else if (errno == EINVAL) {
+                    grc = tlog_pass_fall_back(pass);
+                    if (grc != TLOG_RC_OK) {
+                        return grc;
+                    }
+                    break;
+                }
+                return TLOG_GRC_ERRNO;
+            }
+            pass->len -= rc;
+        }
+
+        /* Write the data out of the buffer, if copying */
+        while (pass->buf != NULL && pass->len > 0) {
+            rc = write(pass->out_fd, pass->buf + pass->pos, pass->len);
+            if (rc < 0) {
+                if (errno == EINTR) {
+                    continue;
+                /* If the output doesn't accept more, keep the rest */
+                } else if (errno == EAGAIN) {
+                    grc = tlog_pass_wait_out(pass, &watched);
+                    if (grc != TLOG_RC_OK || watched) {
+                        return grc;
+                    }
+                    continue;
+                }
+                return TLOG_GRC_ERRNO;
+            }
+            pass->pos += rc;
+            pass->len -= rc;
+        }
+        pass->pos = 0;
+    }
+
+    return tlog_pass_watch(pass, false);
+}
+
+void
+tlog_pass_cleanup(struct tlog_pass *pass)
+{
+    size_t i;
+
+    assert(pass != NULL);
+
+    /* Restore the output FD blocking mode, if changed */
+    if (pass->out_flags >= 0 && pass->out_fd >= 0) {
+        fcntl(pass->out_fd, F_SETFL, pass->out_flags);
+    }
+    if (pass->epoll_fd >= 0) {
+        close(pass->epoll_fd);
+    }
+    for (i = 0; i < TLOG_ARRAY_SIZE(pass->pipe_fd); i++) {
+        if (pass->pipe_fd[i] >= 0) {
+            close(pass->pipe_fd[i]);
+        }
+    }
+    free(pass->buf);
+    *pass = TLOG_PASS_VOID;
+}
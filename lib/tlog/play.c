@@ -959,13 +959,17 @@ tlog_play_run(struct tlog_errs **perrs, int *psignal)
 {
     tlog_grc grc;
     ssize_t rc;
+    size_t i;
     /** Local time now */
     struct timespec local_this_ts;
     /** Local time of packet output next */
     struct timespec local_next_ts;
     /** Delay to the packet output next */
     struct timespec pkt_delay_ts;
-    struct tlog_pkt pkt = TLOG_PKT_VOID;
+    struct tlog_pkt pkt_list[TLOG_JSON_SOURCE_BATCH_SIZE];
+    size_t pkt_num = 0;
+    size_t pkt_idx = 0;
+    struct tlog_pkt *pkt;
     struct tlog_pkt_pos pos = TLOG_PKT_POS_VOID;
     size_t loc_num;
     char *loc_str = NULL;
@@ -979,6 +983,10 @@ tlog_play_run(struct tlog_errs **perrs, int *psignal)
 
     assert(tlog_play_initialized);
 
+    for (i = 0; i < TLOG_ARRAY_SIZE(pkt_list); i++) {
+        pkt_list[i] = TLOG_PKT_VOID;
+    }
+
     tlog_play_exit_signum = 0;
     tlog_play_io_caught = 0;
 
@@ -1014,8 +1022,8 @@ tlog_play_run(struct tlog_errs **perrs, int *psignal)
             }
         }
 
-        /* If there is no data in the packet */
-        if (tlog_pkt_is_void(&pkt)) {
+        /* If there are no packets left */
+        if (pkt_idx >= pkt_num) {
             /* Wait for next read, if necessary */
             if (!tlog_timespec_is_zero(&read_wait)) {
                 rc = clock_nanosleep(CLOCK_MONOTONIC, 0,
@@ -1029,9 +1037,15 @@ tlog_play_run(struct tlog_errs **perrs, int *psignal)
                     TLOG_ERRS_RAISECS(grc, "Failed sleeping");
                 }
             }
-            /* Read a packet */
+            /* Read a batch of packets */
+            for (i = 0; i < pkt_num; i++) {
+                tlog_pkt_cleanup(&pkt_list[i]);
+            }
+            pkt_num = 0;
+            pkt_idx = 0;
             loc_num = tlog_source_loc_get(tlog_play_source);
-            grc = tlog_source_read(tlog_play_source, &pkt);
+            grc = tlog_source_read_batch(tlog_play_source, pkt_list,
+                                         TLOG_ARRAY_SIZE(pkt_list), &pkt_num);
             if (grc == TLOG_GRC_FROM(errno, EINTR)) {
                 continue;
             } else if (grc != TLOG_RC_OK) {
@@ -1040,7 +1054,7 @@ tlog_play_run(struct tlog_errs **perrs, int *psignal)
                 TLOG_ERRS_RAISEF("Failed reading the source at %s", loc_str);
             }
             /* If hit the end of stream */
-            if (tlog_pkt_is_void(&pkt)) {
+            if (pkt_num == 0) {
                 tlog_play_goto_active = false;
                 if (tlog_play_follow) {
                     read_wait = (struct timespec){POLL_PERIOD, 0};
@@ -1051,11 +1065,13 @@ tlog_play_run(struct tlog_errs **perrs, int *psignal)
                     break;
                 }
             }
-            /* If it's not the output */
-            if (pkt.type != TLOG_PKT_TYPE_IO || !pkt.data.io.output) {
-                tlog_pkt_cleanup(&pkt);
-                continue;
-            }
+        }
+
+        /* Skip the packet, if it's not the output */
+        pkt = &pkt_list[pkt_idx];
+        if (pkt->type != TLOG_PKT_TYPE_IO || !pkt->data.io.output) {
+            pkt_idx++;
+            continue;
         }
 
         /* Get current time */
@@ -1074,13 +1090,13 @@ tlog_play_run(struct tlog_errs **perrs, int *psignal)
             /* Skip the time */
             tlog_play_local_last_ts = local_this_ts;
             /* If we reached the target time */
-            if (tlog_timespec_cmp(&pkt.timestamp, &tlog_play_goto_ts) >= 0) {
+            if (tlog_timespec_cmp(&pkt->timestamp, &tlog_play_goto_ts) >= 0) {
                 tlog_play_goto_active = false;
                 tlog_play_pkt_last_ts = tlog_play_goto_ts;
                 continue;
             }
         } else {
-            tlog_timespec_sub(&pkt.timestamp, &tlog_play_pkt_last_ts, &pkt_delay_ts);
+            tlog_timespec_sub(&pkt->timestamp, &tlog_play_pkt_last_ts, &pkt_delay_ts);
             tlog_timespec_fp_div(&pkt_delay_ts, &tlog_play_speed, &pkt_delay_ts);
             tlog_timespec_cap_add(&tlog_play_local_last_ts, &pkt_delay_ts,
                                   &local_next_ts);
@@ -1139,7 +1155,7 @@ tlog_play_run(struct tlog_errs **perrs, int *psignal)
         }
         /* Output the packet */
         rc = write(STDOUT_FILENO,
-                   pkt.data.io.buf + pos.val, pkt.data.io.len - pos.val);
+                   pkt->data.io.buf + pos.val, pkt->data.io.len - pos.val);
         if (rc < 0) {
             if (errno == EINTR) {
                 continue;
@@ -1148,12 +1164,12 @@ tlog_play_run(struct tlog_errs **perrs, int *psignal)
                 TLOG_ERRS_RAISECS(grc, "Failed writing output");
             }
         }
-        tlog_play_pkt_last_ts = pkt.timestamp;
+        tlog_play_pkt_last_ts = pkt->timestamp;
         /* Consume the output part (or the whole) of the packet */
-        tlog_pkt_pos_move(&pos, &pkt, rc);
-        if (tlog_pkt_pos_is_past(&pos, &pkt)) {
+        tlog_pkt_pos_move(&pos, pkt, rc);
+        if (tlog_pkt_pos_is_past(&pos, pkt)) {
             pos = TLOG_PKT_POS_VOID;
-            tlog_pkt_cleanup(&pkt);
+            pkt_idx++;
         }
     }
 
@@ -1164,7 +1180,9 @@ tlog_play_run(struct tlog_errs **perrs, int *psignal)
 
 cleanup:
     free(loc_str);
-    tlog_pkt_cleanup(&pkt);
+    for (i = 0; i < pkt_num; i++) {
+        tlog_pkt_cleanup(&pkt_list[i]);
+    }
 
     return grc;
 }
@@ -0,0 +1,858 @@
+/*
+ * Queueing sink
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+#include <assert.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <tlog/rc.h>
+#include <tlog/misc.h>
+#include <tlog/queue_sink.h>
+
+/** Queued operation */
+enum tlog_queue_sink_op {
+    TLOG_QUEUE_SINK_OP_WRITE,   /**< Write a packet */
+    TLOG_QUEUE_SINK_OP_DROP,    /**< Account for dropped I/O */
+    TLOG_QUEUE_SINK_OP_CUT,     /**< Cut I/O */
+    TLOG_QUEUE_SINK_OP_FLUSH,   /**< Flush data */
+};
+
+/** Queued operation record, as stored in the spill file */
+struct tlog_queue_sink_rec {
+    enum tlog_queue_sink_op     op;     /**< Operation */
+    /**
+     * Packet to write, for TLOG_QUEUE_SINK_OP_WRITE. I/O data follows the
+     * record, the buffer pointer is not meaningful. The first packet
+     * dropped, for TLOG_QUEUE_SINK_OP_DROP, without data.
+     */
+    struct tlog_pkt             pkt;
+    /**
+     * Numbers of input and output bytes dropped, indexed by the packet
+     * "output" flag, for TLOG_QUEUE_SINK_OP_DROP
+     */
+    size_t                      dropped[2];
+    /** Flushing reason, for TLOG_QUEUE_SINK_OP_FLUSH */
+    enum tlog_sink_flush_reason reason;
+};
+
+/** Queue item */
+struct tlog_queue_sink_item {
+    struct tlog_queue_sink_item    *next;   /**< Next item, NULL if last */
+    size_t                          size;   /**< Allocated size, bytes */
+    struct tlog_queue_sink_rec      rec;    /**< Operation record, I/O data
+                                                 follows the item */
+};
+
+/** Queueing sink instance */
+struct tlog_queue_sink {
+    struct tlog_sink                sink;           /**< Abstract sink */
+    struct tlog_sink               *below;          /**< "Below" sink */
+    bool                            below_owned;    /**< True if "below"
+                                                         sink is ours */
+    size_t                          size;           /**< Max queued bytes */
+    enum tlog_queue_sink_overflow   overflow;       /**< Overflow action */
+
+    pthread_mutex_t                 mutex;          /**< State mutex */
+    bool                            mutex_init;     /**< True if mutex is
+                                                         initialized */
+    pthread_cond_t                  work_cond;      /**< Signalled when
+                                                         work is queued */
+    bool                            work_cond_init; /**< True if work_cond
+                                                         is initialized */
+    pthread_cond_t                  done_cond;      /**< Signalled when
+                                                         work is done */
+    bool                            done_cond_init; /**< True if done_cond
+                                                         is initialized */
+    pthread_t                       thread;         /**< Replaying thread */
+    bool                            started;        /**< True if thread was
+                                                         started */
+    bool                            stop;           /**< True if thread
+                                                         should exit once
+                                                         the queue drains */
+    bool                            busy;           /**< True if thread is
+                                                         replaying an item */
+    tlog_grc                        grc;            /**< Result of the
+                                                         first failed
+                                                         replay */
+
+    struct tlog_queue_sink_item    *head;           /**< First item */
+    struct tlog_queue_sink_item    *tail;           /**< Last item */
+    size_t                          used;           /**< Queued bytes */
+
+    int                             spill_fd;       /**< Spill file FD,
+                                                         or -1 */
+    off_t                           spill_rd;       /**< Spill read offset */
+    off_t                           spill_wr;       /**< Spill write offset */
+};
+
+/**
+ * Get the size of the I/O data following an operation record.
+ *
+ * @param rec   The record to get the data size of.
+ *
+ * @return The data size, bytes.
+ */
+static size_t
+tlog_queue_sink_rec_data_size(const struct tlog_queue_sink_rec *rec)
+{
+    return (rec->op == TLOG_QUEUE_SINK_OP_WRITE &&
+            rec->pkt.type == TLOG_PKT_TYPE_IO) ? rec->pkt.data.io.len : 0;
+}
+
+/**
+ * Allocate a queue item with room for I/O data following it.
+ *
+ * @param pitem     Location for the allocated item pointer.
+ * @param rec       The operation record to copy into the item.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_queue_sink_item_alloc(struct tlog_queue_sink_item **pitem,
+                           const struct tlog_queue_sink_rec *rec)
+{
+    struct tlog_queue_sink_item *item;
+    size_t size = sizeof(*item) + tlog_queue_sink_rec_data_size(rec);
+
+    assert(pitem != NULL);
+    assert(rec != NULL);
+
+    item = malloc(size);
+    if (item == NULL) {
+        return TLOG_GRC_ERRNO;
+    }
+    item->next = NULL;
+    item->size = size;
+    item->rec = *rec;
+    if (rec->op == TLOG_QUEUE_SINK_OP_WRITE &&
+        rec->pkt.type == TLOG_PKT_TYPE_IO) {
+        item->rec.pkt.data.io.buf = (uint8_t *)(item + 1);
+        item->rec.pkt.data.io.buf_owned = false;
+    }
+
+    *pitem = item;
+    return TLOG_RC_OK;
+}
+
+/**
+ * Check if the spill file has any unread records.
+ * Must be called with the mutex locked.
+ *
+ * @param queue_sink    The queueing sink to check.
+ *
+ * @return True if the spill file has unread records.
+ */
+static bool
+tlog_queue_sink_spilled(const struct tlog_queue_sink *queue_sink)
+{
+    return queue_sink->spill_rd < queue_sink->spill_wr;
+}
+
+/**
+ * Write a buffer to the spill file at specified offset, completely.
+ *
+ * @param fd    The spill file descriptor.
+ * @param buf   The buffer to write.
+ * @param len   The length of the buffer.
+ * @param off   The offset to write at.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_queue_sink_spill_write(int fd, const void *buf, size_t len, off_t off)
+{
+    ssize_t rc;
+
+    while (len > 0) {
+        rc = pwrite(fd, buf, len, off);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return TLOG_GRC_ERRNO;
+        }
+        buf = (const uint8_t *)buf + rc;
+        len -= rc;
+        off += rc;
+    }
+    return TLOG_RC_OK;
+}
+
+/**
+ * Read a buffer from the spill file at specified offset, completely.
+ *
+ * @param fd    The spill file descriptor.
+ * @param buf   The buffer to read into.
+ * @param len   The length of the buffer.
+ * @param off   The offset to read at.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_queue_sink_spill_read(int fd, void *buf, size_t len, off_t off)
+{
+    ssize_t rc;
+
+    while (len > 0) {
+        rc = pread(fd, buf, len, off);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return TLOG_GRC_ERRNO;
+        } else if (rc == 0) {
+            return TLOG_GRC_FROM(errno, EIO);
+        }
+        buf = (uint8_t *)buf + rc;
+        len -= rc;
+        off += rc;
+    }
+    return TLOG_RC_OK;
+}
+
+/**
+ * Append an operation to the spill file.
+ * Must be called with the mutex locked.
+ *
+ * @param queue_sink    The queueing sink to spill to.
+ * @param rec           The operation record to spill.
+ * @param data          The I/O data following the record.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_queue_sink_spill(struct tlog_queue_sink *queue_sink,
+                      const struct tlog_queue_sink_rec *rec,
+                      const uint8_t *data)
+{
+    tlog_grc grc;
+    size_t data_size = tlog_queue_sink_rec_data_size(rec);
+
+    if (queue_sink->spill_fd < 0) {
+        FILE *file;
+        int fd;
+
+        file = tmpfile();
+        if (file == NULL) {
+            return TLOG_GRC_ERRNO;
+        }
+        fd = dup(fileno(file));
+        fclose(file);
+        if (fd < 0) {
+            return TLOG_GRC_ERRNO;
+        }
+        if (fcntl(fd, F_SETFD, FD_CLOEXEC) < 0) {
+            grc = TLOG_GRC_ERRNO;
+            close(fd);
+            return grc;
+        }
+        queue_sink->spill_fd = fd;
+    }
+
+    grc = tlog_queue_sink_spill_write(queue_sink->spill_fd,
+                                      rec, sizeof(*rec),
+                                      queue_sink->spill_wr);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+    grc = tlog_queue_sink_spill_write(queue_sink->spill_fd,
+                                      data, data_size,
+                                      queue_sink->spill_wr + sizeof(*rec));
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+    queue_sink->spill_wr += sizeof(*rec) + data_size;
+
+    return TLOG_RC_OK;
+}
+
+/**
+ * Take the next operation out of the spill file.
+ * Must be called with the mutex locked.
+ *
+ * @param queue_sink    The queueing sink to unspill from.
+ * @param pitem         Location for the allocated item.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_queue_sink_unspill(struct tlog_queue_sink *queue_sink,
+                        struct tlog_queue_sink_item **pitem)
+{
+    tlog_grc grc;
+    struct tlog_queue_sink_rec rec;
+    struct tlog_queue_sink_item *item;
+    size_t data_size;
+
+    assert(tlog_queue_sink_spilled(queue_sink));
+
+    grc = tlog_queue_sink_spill_read(queue_sink->spill_fd,
+                                     &rec, sizeof(rec),
+                                     queue_sink->spill_rd);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+    grc = tlog_queue_sink_item_alloc(&item, &rec);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+    data_size = tlog_queue_sink_rec_data_size(&rec);
+    grc = tlog_queue_sink_spill_read(queue_sink->spill_fd,
+                                     item + 1, data_size,
+                                     queue_sink->spill_rd + sizeof(rec));
+    if (grc != TLOG_RC_OK) {
+        free(item);
+        return grc;
+    }
+    queue_sink->spill_rd += sizeof(rec) + data_size;
+
+    /* Reuse the file from the start, once it's completely read */
+    if (!tlog_queue_sink_spilled(queue_sink)) {
+        queue_sink->spill_rd = 0;
+        queue_sink->spill_wr = 0;
+        if (ftruncate(queue_sink->spill_fd, 0) < 0) {
+            free(item);
+            return TLOG_GRC_ERRNO;
+        }
+    }
+
+    *pitem = item;
+    return TLOG_RC_OK;
+}
+
+/**
+ * Replay a dropped I/O accounting operation to the "below" sink, one
+ * stream at a time.
+ *
+ * @param queue_sink    The queueing sink to replay the operation for.
+ * @param rec           The operation record to replay.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_queue_sink_replay_drop(struct tlog_queue_sink *queue_sink,
+                            const struct tlog_queue_sink_rec *rec)
+{
+    tlog_grc grc;
+    struct tlog_pkt pkt = rec->pkt;
+    size_t i;
+
+    for (i = 0; i < TLOG_ARRAY_SIZE(rec->dropped); i++) {
+        if (rec->dropped[i] == 0) {
+            continue;
+        }
+        pkt.data.io.output = i != 0;
+        pkt.data.io.len = rec->dropped[i];
+        do {
+            grc = tlog_sink_drop(queue_sink->below, &pkt);
+        } while (grc == TLOG_GRC_FROM(errno, EINTR));
+        if (grc != TLOG_RC_OK) {
+            return grc;
+        }
+    }
+
+    return TLOG_RC_OK;
+}
+
+/**
+ * Replay an operation to the "below" sink.
+ *
+ * @param queue_sink    The queueing sink to replay the operation for.
+ * @param rec           The operation record to replay.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_queue_sink_replay(struct tlog_queue_sink *queue_sink,
+                       const struct tlog_queue_sink_rec *rec)
+{
+    tlog_grc grc;
+
+    do {
+        switch (rec->op) {
+        case TLOG_QUEUE_SINK_OP_WRITE:
+            grc = tlog_sink_write(queue_sink->below, &rec->pkt, NULL, NULL);
+            break;
+        case TLOG_QUEUE_SINK_OP_DROP:
+            grc = tlog_queue_sink_replay_drop(queue_sink, rec);
+            break;
+        case TLOG_QUEUE_SINK_OP_CUT:
+            grc = tlog_sink_cut(queue_sink->below);
+            break;
+        case TLOG_QUEUE_SINK_OP_FLUSH:
+            grc = tlog_sink_flush(queue_sink->below, rec->reason);
+            break;
+        default:
+            assert(false);
+            grc = TLOG_RC_FAILURE;
+            break;
+        }
+    } while (grc == TLOG_GRC_FROM(errno, EINTR));
+
+    return grc;
+}
+
+/**
+ * Replaying thread function: replay the queued operations to the "below"
+ * sink, until asked to stop and the queue is empty.
+ *
+ * @param arg   The queueing sink to replay the operations of.
+ *
+ * @return NULL.
+ */
+static void *
+tlog_queue_sink_thread(void *arg)
+{
+    struct tlog_queue_sink *queue_sink = (struct tlog_queue_sink *)arg;
+    struct tlog_queue_sink_item *item;
+    bool spilled;
+    tlog_grc grc;
+
+    pthread_mutex_lock(&queue_sink->mutex);
+    while (true) {
+        /* Wait for work */
+        while (queue_sink->head == NULL &&
+               !tlog_queue_sink_spilled(queue_sink) &&
+               !queue_sink->stop) {
+            pthread_cond_wait(&queue_sink->work_cond, &queue_sink->mutex);
+        }
+
+        /* Take the oldest item: queued items predate the spilled ones */
+        item = queue_sink->head;
+        spilled = false;
+        if (item != NULL) {
+            queue_sink->head = item->next;
+            if (queue_sink->head == NULL) {
+                queue_sink->tail = NULL;
+            }
+            grc = TLOG_RC_OK;
+        } else if (tlog_queue_sink_spilled(queue_sink)) {
+            spilled = true;
+            grc = tlog_queue_sink_unspill(queue_sink, &item);
+        } else {
+            break;
+        }
+        queue_sink->busy = true;
+        pthread_mutex_unlock(&queue_sink->mutex);
+
+        /* Replay, unless failed before */
+        if (grc == TLOG_RC_OK && queue_sink->grc == TLOG_RC_OK) {
+            grc = tlog_queue_sink_replay(queue_sink, &item->rec);
+        }
+
+        pthread_mutex_lock(&queue_sink->mutex);
+        if (grc != TLOG_RC_OK && queue_sink->grc == TLOG_RC_OK) {
+            queue_sink->grc = grc;
+        }
+        /* Forget the spill file contents after a failure */
+        if (queue_sink->grc != TLOG_RC_OK) {
+            queue_sink->spill_rd = queue_sink->spill_wr;
+        }
+        if (item != NULL) {
+            if (!spilled) {
+                queue_sink->used -= item->size;
+            }
+            free(item);
+        }
+        queue_sink->busy = false;
+        pthread_cond_broadcast(&queue_sink->done_cond);
+    }
+    pthread_mutex_unlock(&queue_sink->mutex);
+
+    return NULL;
+}
+
+/**
+ * Start the replaying thread, if not started yet.
+ * Must be called with the mutex locked.
+ *
+ * The thread is started lazily, to let the creator fork safely before the
+ * sink is first used.
+ *
+ * @param queue_sink    The queueing sink to start the thread for.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_queue_sink_start(struct tlog_queue_sink *queue_sink)
+{
+    sigset_t all_set;
+    sigset_t orig_set;
+    int rc;
+
+    if (queue_sink->started) {
+        return TLOG_RC_OK;
+    }
+
+    /* Have the thread inherit a mask blocking all signals */
+    sigfillset(&all_set);
+    rc = pthread_sigmask(SIG_SETMASK, &all_set, &orig_set);
+    if (rc != 0) {
+        return TLOG_GRC_FROM(errno, rc);
+    }
+    rc = pthread_create(&queue_sink->thread, NULL,
+                        tlog_queue_sink_thread, queue_sink);
+    pthread_sigmask(SIG_SETMASK, &orig_set, NULL);
+    if (rc != 0) {
+        return TLOG_GRC_FROM(errno, rc);
+    }
+
+    queue_sink->started = true;
+    return TLOG_RC_OK;
+}
+
+/**
+ * Queue an operation, applying the overflow action if it doesn't fit.
+ *
+ * @param queue_sink    The queueing sink to queue the operation in.
+ * @param rec           The operation record to queue.
+ * @param data          The I/O data following the record.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_queue_sink_push(struct tlog_queue_sink *queue_sink,
+                     const struct tlog_queue_sink_rec *rec,
+                     const uint8_t *data)
+{
+    tlog_grc grc;
+    struct tlog_queue_sink_item *item = NULL;
+    struct tlog_queue_sink_rec drop_rec;
+    size_t data_size = tlog_queue_sink_rec_data_size(rec);
+    size_t size = sizeof(*item) + data_size;
+    bool fits;
+
+    pthread_mutex_lock(&queue_sink->mutex);
+
+    /* Report earlier replay failures */
+    grc = queue_sink->grc;
+    if (grc != TLOG_RC_OK) {
+        goto cleanup;
+    }
+
+    grc = tlog_queue_sink_start(queue_sink);
+    if (grc != TLOG_RC_OK) {
+        goto cleanup;
+    }
+
+    while (true) {
+        /* Operations without data are small and never dropped or blocked */
+        fits = data_size == 0 ||
+               queue_sink->used == 0 ||
+               queue_sink->used + size <= queue_sink->size;
+        /* Keep the order: don't overtake the spilled operations */
+        if (fits && !tlog_queue_sink_spilled(queue_sink)) {
+            break;
+        }
+        switch (queue_sink->overflow) {
+        case TLOG_QUEUE_SINK_OVERFLOW_BLOCK:
+            pthread_cond_wait(&queue_sink->done_cond, &queue_sink->mutex);
+            grc = queue_sink->grc;
+            if (grc != TLOG_RC_OK) {
+                goto cleanup;
+            }
+            continue;
+        case TLOG_QUEUE_SINK_OVERFLOW_DROP:
+            /* Queue an account of the dropped data instead */
+            if (data_size != 0) {
+                drop_rec = (struct tlog_queue_sink_rec){
+                    .op = TLOG_QUEUE_SINK_OP_DROP,
+                    .pkt = rec->pkt,
+                };
+                drop_rec.pkt.data.io.len = 0;
+                drop_rec.dropped[rec->pkt.data.io.output] = data_size;
+                rec = &drop_rec;
+                data = NULL;
+                data_size = 0;
+            }
+            break;
+        case TLOG_QUEUE_SINK_OVERFLOW_SPILL:
+            grc = tlog_queue_sink_spill(queue_sink, rec, data);
+            if (grc == TLOG_RC_OK) {
+                pthread_cond_signal(&queue_sink->work_cond);
+            }
+            goto cleanup;
+        default:
+            assert(false);
+            break;
+        }
+        break;
+    }
+
+    /* Merge consecutive drops, the last item is not replayed yet */
+    if (rec->op == TLOG_QUEUE_SINK_OP_DROP &&
+        queue_sink->tail != NULL &&
+        queue_sink->tail->rec.op == TLOG_QUEUE_SINK_OP_DROP &&
+        !tlog_queue_sink_spilled(queue_sink)) {
+        queue_sink->tail->rec.dropped[0] += rec->dropped[0];
+        queue_sink->tail->rec.dropped[1] += rec->dropped[1];
+        grc = TLOG_RC_OK;
+        goto cleanup;
+    }
+
+    grc = tlog_queue_sink_item_alloc(&item, rec);
+    if (grc != TLOG_RC_OK) {
+        goto cleanup;
+    }
+    if (data_size > 0) {
+        memcpy(item + 1, data, data_size);
+    }
+
+    if (queue_sink->tail == NULL) {
+        queue_sink->head = item;
+    } else {
+        queue_sink->tail->next = item;
+    }
+    queue_sink->tail = item;
+    queue_sink->used += item->size;
+    pthread_cond_signal(&queue_sink->work_cond);
+
+cleanup:
+    pthread_mutex_unlock(&queue_sink->mutex);
+    return grc;
+}
+
+static bool
+tlog_queue_sink_is_valid(const struct tlog_sink *sink)
+{
+    struct tlog_queue_sink *queue_sink =
+                                (struct tlog_queue_sink *)sink;
+    return queue_sink != NULL &&
+           tlog_sink_is_valid(queue_sink->below) &&
+           queue_sink->size > 0 &&
+           tlog_queue_sink_overflow_is_valid(queue_sink->overflow) &&
+           queue_sink->mutex_init &&
+           queue_sink->work_cond_init &&
+           queue_sink->done_cond_init;
+}
+
+static void
+tlog_queue_sink_cleanup(struct tlog_sink *sink)
+{
+    struct tlog_queue_sink *queue_sink =
+                                (struct tlog_queue_sink *)sink;
+    struct tlog_queue_sink_item *item;
+
+    assert(queue_sink != NULL);
+
+    /* Let the thread finish the queue and exit */
+    if (queue_sink->started) {
+        pthread_mutex_lock(&queue_sink->mutex);
+        queue_sink->stop = true;
+        pthread_cond_signal(&queue_sink->work_cond);
+        pthread_mutex_unlock(&queue_sink->mutex);
+        pthread_join(queue_sink->thread, NULL);
+        queue_sink->started = false;
+    }
+
+    while (queue_sink->head != NULL) {
+        item = queue_sink->head;
+        queue_sink->head = item->next;
+        free(item);
+    }
+    queue_sink->tail = NULL;
+    queue_sink->used = 0;
+
+    if (queue_sink->spill_fd >= 0) {
+        close(queue_sink->spill_fd);
+        queue_sink->spill_fd = -1;
+    }
+
+    if (queue_sink->done_cond_init) {
+        pthread_cond_destroy(&queue_sink->done_cond);
+        queue_sink->done_cond_init = false;
+    }
+    if (queue_sink->work_cond_init) {
+        pthread_cond_destroy(&queue_sink->work_cond);
+        queue_sink->work_cond_init = false;
+    }
+    if (queue_sink->mutex_init) {
+        pthread_mutex_destroy(&queue_sink->mutex);
+        queue_sink->mutex_init = false;
+    }
+
+    if (queue_sink->below_owned) {
+        tlog_sink_destroy(queue_sink->below);
+        queue_sink->below_owned = false;
+    }
+    queue_sink->below = NULL;
+}
+
+static tlog_grc
+tlog_queue_sink_init(struct tlog_sink *sink, va_list ap)
+{
+    struct tlog_queue_sink *queue_sink =
+                                (struct tlog_queue_sink *)sink;
+    tlog_grc grc;
+    int rc;
+
+    queue_sink->spill_fd = -1;
+    queue_sink->below = va_arg(ap, struct tlog_sink *);
+    queue_sink->below_owned = va_arg(ap, int) != 0;
+    queue_sink->size = va_arg(ap, size_t);
+    queue_sink->overflow = va_arg(ap, enum tlog_queue_sink_overflow);
+
+    rc = pthread_mutex_init(&queue_sink->mutex, NULL);
+    if (rc != 0) {
+        grc = TLOG_GRC_FROM(errno, rc);
+        goto error;
+    }
+    queue_sink->mutex_init = true;
+
+    rc = pthread_cond_init(&queue_sink->work_cond, NULL);
+    if (rc != 0) {
+        grc = TLOG_GRC_FROM(errno, rc);
+        goto error;
+    }
+    queue_sink->work_cond_init = true;
+
+    rc = pthread_cond_init(&queue_sink->done_cond, NULL);
+    if (rc != 0) {
+        grc = TLOG_GRC_FROM(errno, rc);
+        goto error;
+    }
+    queue_sink->done_cond_init = true;
+
+    return TLOG_RC_OK;
+
+error:
+    /* Don't destroy the "below" sink on failure */
+    queue_sink->below_owned = false;
+    tlog_queue_sink_cleanup(sink);
+    return grc;
+}
+
+static tlog_grc
+tlog_queue_sink_write(struct tlog_sink *sink,
+                      const struct tlog_pkt *pkt,
+                      struct tlog_pkt_pos *ppos,
+                      const struct tlog_pkt_pos *end)
+{
+    struct tlog_queue_sink *queue_sink =
+                                (struct tlog_queue_sink *)sink;
+    tlog_grc grc;
+    struct tlog_queue_sink_rec rec = {.op = TLOG_QUEUE_SINK_OP_WRITE,
+                                      .pkt = *pkt};
+    const uint8_t *data = NULL;
+
+    if (tlog_pkt_pos_cmp(ppos, end) >= 0) {
+        return TLOG_RC_OK;
+    }
+
+    /* Queue only the requested part of the packet */
+    if (pkt->type == TLOG_PKT_TYPE_IO) {
+        data = pkt->data.io.buf + ppos->val;
+        rec.pkt.data.io.buf = NULL;
+        rec.pkt.data.io.buf_owned = false;
+        rec.pkt.data.io.len = end->val - ppos->val;
+    }
+
+    grc = tlog_queue_sink_push(queue_sink, &rec, data);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+
+    if (pkt->type == TLOG_PKT_TYPE_IO) {
+        tlog_pkt_pos_move(ppos, pkt, end->val - ppos->val);
+    } else {
+        tlog_pkt_pos_move_past(ppos, pkt);
+    }
+    return TLOG_RC_OK;
+}
+
+static tlog_grc
+tlog_queue_sink_drop(struct tlog_sink *sink, const struct tlog_pkt *pkt)
+{
+    struct tlog_queue_sink *queue_sink =
+                                (struct tlog_queue_sink *)sink;
+    struct tlog_queue_sink_rec rec = {.op = TLOG_QUEUE_SINK_OP_DROP,
+                                      .pkt = *pkt};
+
+    if (pkt->data.io.len == 0) {
+        return TLOG_RC_OK;
+    }
+    rec.pkt.data.io.buf = NULL;
+    rec.pkt.data.io.buf_owned = false;
+    rec.pkt.data.io.len = 0;
+    rec.dropped[pkt->data.io.output] = pkt->data.io.len;
+    return tlog_queue_sink_push(queue_sink, &rec, NULL);
+}
+
+static tlog_grc
+tlog_queue_sink_cut(struct tlog_sink *sink)
+{
+    struct tlog_queue_sink *queue_sink =
+                                (struct tlog_queue_sink *)sink;
+    struct tlog_queue_sink_rec rec = {.op = TLOG_QUEUE_SINK_OP_CUT};
+    return tlog_queue_sink_push(queue_sink, &rec, NULL);
+}
+
+static tlog_grc
+tlog_queue_sink_flush(struct tlog_sink *sink,
+                      enum tlog_sink_flush_reason reason)
+{
+    struct tlog_queue_sink *queue_sink =
+                                (struct tlog_queue_sink *)sink;
+    struct tlog_queue_sink_rec rec = {.op = TLOG_QUEUE_SINK_OP_FLUSH,
+                                      .reason = reason};
+    return tlog_queue_sink_push(queue_sink, &rec, NULL);
+}
+
+tlog_grc
+tlog_queue_sink_drain(struct tlog_sink *sink)
+{
+    struct tlog_queue_sink *queue_sink =
+                                (struct tlog_queue_sink *)sink;
+    tlog_grc grc;
+
+    assert(tlog_sink_is_valid(sink));
+    assert(sink->type == &tlog_queue_sink_type);
+
+    pthread_mutex_lock(&queue_sink->mutex);
+    if (queue_sink->started) {
+        while (queue_sink->head != NULL ||
+               tlog_queue_sink_spilled(queue_sink) ||
+               queue_sink->busy) {
+            pthread_cond_wait(&queue_sink->done_cond, &queue_sink->mutex);
+        }
+    }
+    grc = queue_sink->grc;
+    pthread_mutex_unlock(&queue_sink->mutex);
+
+    return grc;
+}
+
+const struct tlog_sink_type tlog_queue_sink_type = {
+    .size       = sizeof(struct tlog_queue_sink),
+    .init       = tlog_queue_sink_init,
+    .is_valid   = tlog_queue_sink_is_valid,
+    .write      = tlog_queue_sink_write,
+    .drop       = tlog_queue_sink_drop,
+    .cut        = tlog_queue_sink_cut,
+    .flush      = tlog_queue_sink_flush,
+    .cleanup    = tlog_queue_sink_cleanup,
+};
@@ -49,6 +49,8 @@ static const char *tlog_rc_desc_list[TLOG_RC_MAX_PLUS_ONE - TLOG_RC_MIN] = {
         "Message has invalid \"in_txt\" or \"out_txt\" field value",
     [TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_BIN] =
         "Message has invalid \"in_bin\" or \"out_bin\" field value",
+    [TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_ELIDED] =
+        "Message has invalid \"elided\" field value",
     [TLOG_RC_FD_JSON_READER_INCOMPLETE_LINE] =
         "Incomplete message object line encountered",
     [TLOG_RC_JSON_SOURCE_MSG_ID_OUT_OF_ORDER] =
@@ -63,6 +65,10 @@ static const char *tlog_rc_desc_list[TLOG_RC_MAX_PLUS_ONE - TLOG_RC_MIN] = {
         "Invalid reply received from HTTP server",
     [TLOG_RC_MEM_JSON_READER_INCOMPLETE_LINE] =
         "Incomplete message object line encountered",
+    [TLOG_RC_RL_SHARED_SEG_UNTRUSTED] =
+        "Shared memory segment has untrusted owner or permissions",
+    [TLOG_RC_RL_JSON_WRITER_MSG_TOO_LARGE] =
+        "Message is larger than the rate-limiting backlog",
 };
 
 const char *
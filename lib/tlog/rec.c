@@ -24,65 +24,46 @@
 #include <tlog/rec.h>
 #include <tlog/rec_item.h>
 #include <tlog/json_sink.h>
+#include <tlog/queue_sink.h>
 #include <tlog/syslog_json_writer.h>
 #ifdef TLOG_JOURNAL_ENABLED
 #include <tlog/journal_json_writer.h>
 #endif
-#include <tlog/fd_json_writer.h>
+#include <tlog/file_json_writer.h>
 #include <tlog/rl_json_writer.h>
 #include <tlog/source.h>
 #include <tlog/syslog_misc.h>
 #include <tlog/session.h>
 #include <tlog/tap.h>
+#include <tlog/tty_source.h>
 #include <tlog/timespec.h>
 #include <tlog/delay.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
-#include <syslog.h>
+#include <sys/timerfd.h>
 #include <pwd.h>
 #include <fcntl.h>
 #include <netdb.h>
+#include <poll.h>
 #include <signal.h>
+#include <pthread.h>
 #include <limits.h>
 #include <unistd.h>
 #include <string.h>
 #include <ctype.h>
 #include <assert.h>
 
-/**< Number of the signal causing exit */
-static volatile sig_atomic_t tlog_rec_exit_signum;
-
-static void
-tlog_rec_exit_sighandler(int signum)
-{
-    if (tlog_rec_exit_signum == 0) {
-        tlog_rec_exit_signum = signum;
-    }
-}
-
-/* True if an alarm was set, but not yet delivered */
-static volatile sig_atomic_t tlog_rec_alarm_set;
-
-/* Number of ALRM signals caught */
-static volatile sig_atomic_t tlog_rec_alarm_caught;
-
-/* True if child stopped or terminated */
-static volatile sig_atomic_t tlog_rec_child_exited;
-
-static void
-tlog_rec_alarm_sighandler(int signum)
-{
-    (void)signum;
-    tlog_rec_alarm_set = false;
-    tlog_rec_alarm_caught++;
-}
-
-static void
-tlog_rec_sigchld_handler(int signum)
-{
-    (void)signum;
-    tlog_rec_child_exited = true;
-}
+/** Transfer loop epoll event data */
+enum tlog_rec_ev {
+    TLOG_REC_EV_SOURCE,     /**< TTY source is ready */
+    TLOG_REC_EV_SIGNAL,     /**< A signal is received */
+    TLOG_REC_EV_TIMER,      /**< Latency timer expired */
+    TLOG_REC_EV_IDLE,       /**< Idle timer expired */
+    TLOG_REC_EV_PASS_IN,    /**< Input pass-through is ready */
+    TLOG_REC_EV_PASS_OUT    /**< Output pass-through is ready */
+};
 
 /**
  * Get fully-qualified name of this host.
@@ -296,10 +277,62 @@ tlog_rec_create_file_json_writer(struct tlog_errs **perrs,
     const char *str;
     struct tlog_json_writer *writer = NULL;
     int fd = -1;
+    struct tlog_file_json_writer_params params = {
+        .fd_owned = true,
+    };
 
     assert(pwriter != NULL);
     assert(conf != NULL);
 
+    /* Get the batch size */
+    if (!json_object_object_get_ex(conf, "batch", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Log file batch size is not specified");
+    }
+    params.batch = (size_t)json_object_get_int64(obj);
+
+    /* Get the sync policy */
+    if (!json_object_object_get_ex(conf, "sync", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Log file sync policy is not specified");
+    }
+    str = json_object_get_string(obj);
+    if (strcasecmp(str, "never") == 0) {
+        params.sync = TLOG_FILE_JSON_WRITER_SYNC_NEVER;
+    } else if (strcasecmp(str, "interval") == 0) {
+        params.sync = TLOG_FILE_JSON_WRITER_SYNC_INTERVAL;
+    } else if (strcasecmp(str, "bytes") == 0) {
+        params.sync = TLOG_FILE_JSON_WRITER_SYNC_BYTES;
+    } else if (strcasecmp(str, "flush") == 0) {
+        params.sync = TLOG_FILE_JSON_WRITER_SYNC_FLUSH;
+    } else {
+        assert(!"Unknown log file sync policy");
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISEF("Unknown log file sync policy is specified: %s",
+                         str);
+    }
+
+    /* Get the sync interval */
+    if (!json_object_object_get_ex(conf, "interval", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Log file sync interval is not specified");
+    }
+    params.interval = (unsigned int)json_object_get_int64(obj);
+
+    /* Get the sync threshold */
+    if (!json_object_object_get_ex(conf, "threshold", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Log file sync threshold is not specified");
+    }
+    params.threshold = (size_t)json_object_get_int64(obj);
+
+    /* Get the preallocation size */
+    if (!json_object_object_get_ex(conf, "prealloc", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Log file preallocation size is not specified");
+    }
+    params.prealloc = (size_t)json_object_get_int64(obj);
+
     /* Get the file path */
     if (!json_object_object_get_ex(conf, "path", &obj)) {
         grc = TLOG_RC_FAILURE;
@@ -329,7 +362,8 @@ tlog_rec_create_file_json_writer(struct tlog_errs **perrs,
     }
 
     /* Create the writer, letting it take over the FD */
-    grc = tlog_fd_json_writer_create(&writer, fd, true);
+    params.fd = fd;
+    grc = tlog_file_json_writer_create(&writer, &params);
     if (grc != TLOG_RC_OK) {
         TLOG_ERRS_RAISECS(grc, "Failed creating file writer");
     }
@@ -365,8 +399,10 @@ tlog_rec_create_syslog_json_writer(struct tlog_errs **perrs,
     struct json_object *obj;
     const char *str;
     struct tlog_json_writer *writer = NULL;
-    int facility;
-    int priority;
+    struct tlog_syslog_json_writer_params params = {
+        .path = TLOG_SYSLOG_JSON_WRITER_PATH_DEFAULT,
+    };
+    int64_t num;
 
     assert(pwriter != NULL);
     assert(conf != NULL);
@@ -377,8 +413,8 @@ tlog_rec_create_syslog_json_writer(struct tlog_errs **perrs,
         TLOG_ERRS_RAISES("Syslog facility is not specified");
     }
     str = json_object_get_string(obj);
-    facility = tlog_syslog_facility_from_str(str);
-    if (facility < 0) {
+    params.facility = tlog_syslog_facility_from_str(str);
+    if (params.facility < 0) {
         grc = TLOG_RC_FAILURE;
         TLOG_ERRS_RAISEF("Unknown syslog facility: %s", str);
     }
@@ -389,15 +425,42 @@ tlog_rec_create_syslog_json_writer(struct tlog_errs **perrs,
         TLOG_ERRS_RAISES("Syslog priority is not specified");
     }
     str = json_object_get_string(obj);
-    priority = tlog_syslog_priority_from_str(str);
-    if (priority < 0) {
+    params.priority = tlog_syslog_priority_from_str(str);
+    if (params.priority < 0) {
         grc = TLOG_RC_FAILURE;
         TLOG_ERRS_RAISEF("Unknown syslog priority: %s", str);
     }
 
+    /* Get format */
+    if (!json_object_object_get_ex(conf, "format", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Syslog format is not specified");
+    }
+    str = json_object_get_string(obj);
+    if (strcmp(str, "rfc3164") == 0) {
+        params.format = TLOG_SYSLOG_JSON_WRITER_FORMAT_RFC3164;
+    } else if (strcmp(str, "rfc5424") == 0) {
+        params.format = TLOG_SYSLOG_JSON_WRITER_FORMAT_RFC5424;
+    } else {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISEF("Unknown syslog format: %s", str);
+    }
+
+    /* Get the socket path, if specified */
+    if (json_object_object_get_ex(conf, "path", &obj)) {
+        params.path = json_object_get_string(obj);
+    }
+
+    /* Get the batch size */
+    if (!json_object_object_get_ex(conf, "batch", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Syslog batch size is not specified");
+    }
+    num = json_object_get_int64(obj);
+    params.batch = (size_t)num;
+
     /* Create the writer */
-    openlog("tlog", LOG_NDELAY, facility);
-    grc = tlog_syslog_json_writer_create(&writer, priority);
+    grc = tlog_syslog_json_writer_create(&writer, &params);
     if (grc != TLOG_RC_OK) {
         TLOG_ERRS_RAISECS(grc, "Failed creating syslog writer");
     }
@@ -437,6 +500,7 @@ tlog_rec_create_journal_json_writer(struct tlog_errs **perrs,
     const char *str;
     struct tlog_json_writer *writer = NULL;
     bool augment;
+    bool stream;
     int priority;
 
     assert(pwriter != NULL);
@@ -452,6 +516,14 @@ tlog_rec_create_journal_json_writer(struct tlog_errs **perrs,
         TLOG_ERRS_RAISES("\"Augment\" flag is not specified");
     }
 
+    /* Get the "stream" flag */
+    if (json_object_object_get_ex(conf, "stream", &obj)) {
+        stream = json_object_get_boolean(obj);
+    } else {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("\"Stream\" flag is not specified");
+    }
+
     /* Get priority */
     if (!json_object_object_get_ex(conf, "priority", &obj)) {
         grc = TLOG_RC_FAILURE;
@@ -465,7 +537,8 @@ tlog_rec_create_journal_json_writer(struct tlog_errs **perrs,
     }
 
     /* Create the writer */
-    grc = tlog_journal_json_writer_create(&writer, priority, augment,
+    grc = tlog_journal_json_writer_create(&writer, priority,
+                                          augment, stream,
                                           id, username, session_id);
     if (grc != TLOG_RC_OK) {
         TLOG_ERRS_RAISECS(grc, "Failed creating journal writer");
@@ -481,6 +554,119 @@ cleanup:
 }
 #endif
 
+/**
+ * Open a rate-limiting budget shared with other recording processes,
+ * if configured.
+ *
+ * @param perrs         Location for the error stack. Can be NULL.
+ * @param pshared       Location for the opened budget pointer, set to NULL
+ *                      if the budget is not shared.
+ * @param euid          EUID to use while opening the budget.
+ * @param egid          EGID to use while opening the budget.
+ * @param conf          Shared budget configuration JSON object.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_rec_create_rl_shared(struct tlog_errs **perrs,
+                          struct tlog_rl_shared **pshared,
+                          uid_t euid, gid_t egid,
+                          struct json_object *conf)
+{
+    tlog_grc grc;
+    struct json_object *obj;
+    const char *str;
+    char name[32];
+    size_t rate;
+    size_t burst;
+    enum tlog_rl_shared_fairness fairness;
+
+    assert(pshared != NULL);
+    assert(conf != NULL);
+
+    *pshared = NULL;
+
+    /* Get the scope */
+    if (!json_object_object_get_ex(conf, "scope", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Shared logging limit scope is not specified");
+    }
+    str = json_object_get_string(obj);
+    if (strcmp(str, "none") == 0) {
+        grc = TLOG_RC_OK;
+        goto cleanup;
+    } else if (strcmp(str, "host") == 0) {
+        snprintf(name, sizeof(name), TLOG_RL_SHARED_NAME_HOST_FMT,
+                 (unsigned int)euid);
+    } else if (strcmp(str, "user") == 0) {
+        snprintf(name, sizeof(name), TLOG_RL_SHARED_NAME_USER_FMT,
+                 (unsigned int)getuid());
+    } else {
+        assert(!"Unknown shared logging limit scope");
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISEF("Unknown shared logging limit scope "
+                         "is specified: %s", str);
+    }
+
+    /* Get the rate */
+    if (!json_object_object_get_ex(conf, "rate", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Shared logging rate limit is not specified");
+    }
+    rate = (size_t)json_object_get_int64(obj);
+
+    /* Get the burst threshold */
+    if (!json_object_object_get_ex(conf, "burst", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Shared logging burst threshold is not specified");
+    }
+    burst = (size_t)json_object_get_int64(obj);
+
+    /* Get the fairness policy */
+    if (!json_object_object_get_ex(conf, "fairness", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Shared logging limit fairness is not specified");
+    }
+    str = json_object_get_string(obj);
+    if (strcmp(str, "none") == 0) {
+        fairness = TLOG_RL_SHARED_FAIRNESS_NONE;
+    } else if (strcmp(str, "equal") == 0) {
+        fairness = TLOG_RL_SHARED_FAIRNESS_EQUAL;
+    } else {
+        assert(!"Unknown shared logging limit fairness");
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISEF("Unknown shared logging limit fairness "
+                         "is specified: %s", str);
+    }
+
+    /* Open the budget with the privileged user's permissions */
+    TLOG_EVAL_WITH_EUID_EGID(euid, egid,
+                             grc = tlog_rl_shared_create(pshared, name,
+                                                         rate, burst,
+                                                         fairness));
+    /*
+     * Never trust a budget someone else could have tampered with, but
+     * don't let them stop the recording either: warn, and limit the
+     * process on its own
+     */
+    if (grc == TLOG_RC_RL_SHARED_SEG_UNTRUSTED) {
+        struct tlog_errs *warn = NULL;
+        tlog_errs_pushc(&warn, grc);
+        tlog_errs_pushf(&warn, "Not sharing logging limit \"%s\", "
+                        "limiting this process only", name);
+        tlog_errs_print(stderr, warn);
+        tlog_errs_destroy(&warn);
+        grc = tlog_rl_shared_create(pshared, NULL, rate, burst, fairness);
+    }
+    if (grc != TLOG_RC_OK) {
+        TLOG_ERRS_RAISECF(grc, "Failed opening shared logging limit \"%s\"",
+                          name);
+    }
+
+cleanup:
+    return grc;
+}
+
 /**
  * Create a rate-limiting JSON message writer, if configured.
  *
@@ -489,6 +675,8 @@ cleanup:
  *                      the rate-limiting writer, and for the created
  *                      rate-limiting writer pointer, if rate-limiting is
  *                      enabled. Otherwise the pointer stays unchanged.
+ * @param euid          EUID to use while opening the shared budget.
+ * @param egid          EGID to use while opening the shared budget.
  * @param conf          Rate-limiting configuration JSON object.
  * @param clock_id      The clock to use for rate-limiting.
  *
@@ -497,6 +685,7 @@ cleanup:
 static tlog_grc
 tlog_rec_create_rl_json_writer(struct tlog_errs **perrs,
                                struct tlog_json_writer **pwriter,
+                               uid_t euid, gid_t egid,
                                struct json_object *conf,
                                clockid_t clock_id)
 {
@@ -504,9 +693,12 @@ tlog_rec_create_rl_json_writer(struct tlog_errs **perrs,
     struct json_object *obj;
     const char *str;
     struct tlog_json_writer *writer = NULL;
-    bool drop;
-    uint64_t rate;
-    uint64_t burst;
+    struct tlog_rl_shared *shared = NULL;
+    struct tlog_rl_json_writer_params params = {
+        .below = *pwriter,
+        .below_owned = true,
+        .clock_id = clock_id,
+    };
 
     assert(pwriter != NULL);
     assert(tlog_json_writer_is_valid(*pwriter));
@@ -523,9 +715,13 @@ tlog_rec_create_rl_json_writer(struct tlog_errs **perrs,
         grc = TLOG_RC_OK;
         goto cleanup;
     } else if (strcasecmp(str, "delay") == 0) {
-        drop = false;
+        params.action = TLOG_RL_JSON_WRITER_ACTION_DELAY;
     } else if (strcasecmp(str, "drop") == 0) {
-        drop = true;
+        params.action = TLOG_RL_JSON_WRITER_ACTION_DROP;
+    } else if (strcasecmp(str, "backlog") == 0) {
+        params.action = TLOG_RL_JSON_WRITER_ACTION_BACKLOG;
+    } else if (strcasecmp(str, "degrade") == 0) {
+        params.action = TLOG_RL_JSON_WRITER_ACTION_DEGRADE;
     } else {
         assert(!"Unknown limit action");
         grc = TLOG_RC_FAILURE;
@@ -537,23 +733,74 @@ tlog_rec_create_rl_json_writer(struct tlog_errs **perrs,
         grc = TLOG_RC_FAILURE;
         TLOG_ERRS_RAISES("Logging rate limit is not specified");
     }
-    rate = json_object_get_int64(obj);
+    params.rate = (size_t)json_object_get_int64(obj);
 
     /* Get the burst threshold */
     if (!json_object_object_get_ex(conf, "burst", &obj)) {
         grc = TLOG_RC_FAILURE;
         TLOG_ERRS_RAISES("Logging burst threshold is not specified");
     }
-    burst = json_object_get_int64(obj);
+    params.burst = (size_t)json_object_get_int64(obj);
+
+    /* Get the input and window changes reserve */
+    if (!json_object_object_get_ex(conf, "reserve", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Logging limit reserve is not specified");
+    }
+    if (json_object_get_int64(obj) > 100) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Logging limit reserve is more than 100 percent");
+    }
+    params.reserve = (unsigned int)json_object_get_int64(obj);
+
+    /* Get the backlog size */
+    if (!json_object_object_get_ex(conf, "backlog", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Logging backlog size is not specified");
+    }
+    params.backlog = (size_t)json_object_get_int64(obj);
+
+    /* Get the backlog eviction policy */
+    if (!json_object_object_get_ex(conf, "evict", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Logging backlog eviction policy is not specified");
+    }
+    str = json_object_get_string(obj);
+    if (strcasecmp(str, "oldest") == 0) {
+        params.evict = TLOG_RL_JSON_WRITER_EVICT_OLDEST;
+    } else if (strcasecmp(str, "newest") == 0) {
+        params.evict = TLOG_RL_JSON_WRITER_EVICT_NEWEST;
+    } else {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISEF("Unknown backlog eviction policy: %s", str);
+    }
+
+    /* Open the shared budget, if configured */
+    if (!json_object_object_get_ex(conf, "shared", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Shared logging limit parameters "
+                         "are not specified");
+    }
+    grc = tlog_rec_create_rl_shared(perrs, &shared, euid, egid, obj);
+    if (grc != TLOG_RC_OK) {
+        goto cleanup;
+    }
+    params.shared = shared;
 
-    /* Superimpose the writer, transfer ownership of below writer */
-    grc = tlog_rl_json_writer_create(pwriter, *pwriter, true, clock_id,
-                                     (size_t)rate, (size_t)burst, drop);
+    /*
+     * Superimpose the writer,
+     * transfer ownership of below writer and the shared budget
+     */
+    grc = tlog_rl_json_writer_create(&writer, &params);
     if (grc != TLOG_RC_OK) {
         TLOG_ERRS_RAISECS(grc, "Failed creating rate-limiting writer");
     }
+    shared = NULL;
+    *pwriter = writer;
+    writer = NULL;
 
 cleanup:
+    tlog_rl_shared_destroy(shared);
     tlog_json_writer_destroy(writer);
     return grc;
 }
@@ -658,8 +905,8 @@ tlog_rec_create_json_writer(struct tlog_errs **perrs,
     }
 
     /* Create rate-limiting writer */
-    grc = tlog_rec_create_rl_json_writer(perrs, &writer, writer_conf,
-                                         CLOCK_MONOTONIC);
+    grc = tlog_rec_create_rl_json_writer(perrs, &writer, euid, egid,
+                                         writer_conf, CLOCK_MONOTONIC);
     if (grc != TLOG_RC_OK) {
         goto cleanup;
     }
@@ -673,6 +920,112 @@ cleanup:
     return grc;
 }
 
+/**
+ * Read an I/O stream rate limit from the configuration.
+ *
+ * @param perrs     Location for the error stack. Can be NULL.
+ * @param pbudget   Location for the read rate limit.
+ * @param conf      Stream limit configuration JSON object.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_rec_get_budget(struct tlog_errs **perrs,
+                    struct tlog_json_sink_budget *pbudget,
+                    struct json_object *conf)
+{
+    tlog_grc grc;
+    struct json_object *obj;
+
+    assert(pbudget != NULL);
+    assert(conf != NULL);
+
+    if (!json_object_object_get_ex(conf, "rate", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Stream rate limit is not specified");
+    }
+    pbudget->rate = (size_t)json_object_get_int64(obj);
+
+    if (!json_object_object_get_ex(conf, "burst", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Stream burst limit is not specified");
+    }
+    pbudget->burst = (size_t)json_object_get_int64(obj);
+
+    grc = TLOG_RC_OK;
+cleanup:
+    return grc;
+}
+
+/**
+ * Create a queueing sink, if configured.
+ *
+ * @param perrs         Location for the error stack. Can be NULL.
+ * @param psink         Location of the "below" sink pointer to attach under
+ *                      the queueing sink, and for the created queueing sink
+ *                      pointer, if queueing is enabled. Otherwise the
+ *                      pointer stays unchanged.
+ * @param conf          Queueing configuration JSON object.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_rec_create_queue_sink(struct tlog_errs **perrs,
+                           struct tlog_sink **psink,
+                           struct json_object *conf)
+{
+    tlog_grc grc;
+    struct json_object *obj;
+    const char *str;
+    int64_t size;
+    enum tlog_queue_sink_overflow overflow;
+
+    assert(psink != NULL);
+    assert(tlog_sink_is_valid(*psink));
+    assert(conf != NULL);
+
+    /* Get the size */
+    if (!json_object_object_get_ex(conf, "size", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Logging queue size is not specified");
+    }
+    size = json_object_get_int64(obj);
+    if (size == 0) {
+        grc = TLOG_RC_OK;
+        goto cleanup;
+    }
+
+    /* Get the overflow action */
+    if (!json_object_object_get_ex(conf, "overflow", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Logging queue overflow action is not specified");
+    }
+    str = json_object_get_string(obj);
+
+    if (strcasecmp(str, "block") == 0) {
+        overflow = TLOG_QUEUE_SINK_OVERFLOW_BLOCK;
+    } else if (strcasecmp(str, "drop") == 0) {
+        overflow = TLOG_QUEUE_SINK_OVERFLOW_DROP;
+    } else if (strcasecmp(str, "spill") == 0) {
+        overflow = TLOG_QUEUE_SINK_OVERFLOW_SPILL;
+    } else {
+        assert(!"Unknown queue overflow action");
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISEF("Unknown queue overflow action is specified: %s",
+                         str);
+    }
+
+    /* Superimpose the sink, transfer ownership of below sink */
+    grc = tlog_queue_sink_create(psink, *psink, true,
+                                 (size_t)size, overflow);
+    if (grc != TLOG_RC_OK) {
+        TLOG_ERRS_RAISECS(grc, "Failed creating queueing sink");
+    }
+
+cleanup:
+    return grc;
+}
+
 /**
  * Create a log sink according to configuration.
  *
@@ -694,7 +1047,12 @@ tlog_rec_create_log_sink(struct tlog_errs **perrs,
 {
     tlog_grc grc;
     int64_t num;
+    int64_t buffers;
     struct json_object *obj;
+    struct json_object *limit_conf;
+    struct tlog_json_sink_budget input_budget;
+    struct tlog_json_sink_budget output_budget;
+    bool report_flush;
     struct tlog_sink *sink = NULL;
     struct tlog_json_writer *writer = NULL;
     char *fqdn = NULL;
@@ -766,6 +1124,43 @@ tlog_rec_create_log_sink(struct tlog_errs **perrs,
     }
     num = json_object_get_int64(obj);
 
+    /* Get the number of payload buffers */
+    if (!json_object_object_get_ex(conf, "buffers", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Number of payload buffers is not specified");
+    }
+    buffers = json_object_get_int64(obj);
+
+    /* Get the input and output stream limits */
+    if (!json_object_object_get_ex(conf, "limit", &limit_conf)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Logging limit parameters are not specified");
+    }
+    if (!json_object_object_get_ex(limit_conf, "input", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Input limit parameters are not specified");
+    }
+    grc = tlog_rec_get_budget(perrs, &input_budget, obj);
+    if (grc != TLOG_RC_OK) {
+        TLOG_ERRS_RAISES("Failed reading input limit");
+    }
+    if (!json_object_object_get_ex(limit_conf, "output", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Output limit parameters are not specified");
+    }
+    grc = tlog_rec_get_budget(perrs, &output_budget, obj);
+    if (grc != TLOG_RC_OK) {
+        TLOG_ERRS_RAISES("Failed reading output limit");
+    }
+
+    /* Check if flush reasons should be reported */
+    if (!json_object_object_get_ex(conf, "flush", &obj) ||
+        !json_object_object_get_ex(obj, "report", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Flush reason reporting flag is not specified");
+    }
+    report_flush = json_object_get_boolean(obj);
+
     /* Create the sink, letting it take over the writer */
     {
         struct tlog_json_sink_params params = {
@@ -777,6 +1172,10 @@ tlog_rec_create_log_sink(struct tlog_errs **perrs,
             .terminal = term,
             .session_id = session_id,
             .chunk_size = num,
+            .chunk_num = buffers,
+            .input_budget = input_budget,
+            .output_budget = output_budget,
+            .report_flush = report_flush,
         };
         grc = tlog_json_sink_create(&sink, &params);
         if (grc != TLOG_RC_OK) {
@@ -785,6 +1184,21 @@ tlog_rec_create_log_sink(struct tlog_errs **perrs,
     }
     writer = NULL;
 
+    /*
+     * Put the queue above the sink, if requested
+     */
+    /* Get queue conf container */
+    if (!json_object_object_get_ex(conf, "queue", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Logging queue parameters are not specified");
+    }
+
+    /* Create queueing sink */
+    grc = tlog_rec_create_queue_sink(perrs, &sink, obj);
+    if (grc != TLOG_RC_OK) {
+        goto cleanup;
+    }
+
     *psink = sink;
     sink = NULL;
     grc = TLOG_RC_OK;
@@ -800,11 +1214,30 @@ cleanup:
 /**
  * Transfer and log terminal data until interrupted or either end closes.
  *
+ * Waits for the TTY source, the signals, and the latency and idle timers in
+ * a single epoll loop, receiving the signals via a signalfd, and tracking
+ * the latency and idle time with timerfds. Reads everything available from
+ * the TTY source on each wakeup, and transfers the packets in one pass:
+ * logs them in one batch, then delivers them in another. Moves the streams
+ * which are not logged with their pass-throughs, if any, bypassing the
+ * source and the sink.
+ *
+ * Logged data is flushed once I/O stays idle for the idle time, if any, but
+ * never later than the latency after it is first logged. The idle timer is
+ * armed at the time of the last logged packet, and is re-armed on expiry if
+ * more packets were logged since, instead of re-arming it for each packet.
+ *
  * @param perrs         Location for the error stack. Can be NULL.
  * @param tty_source    TTY data source.
  * @param log_sink      Log sink.
  * @param tty_sink      TTY data sink.
- * @param latency       Number of seconds to wait before flushing logged data.
+ * @param in_pass       Input pass-through, void if input is read from the
+ *                      source.
+ * @param out_pass      Output pass-through, void if output is read from the
+ *                      source.
+ * @param latency       Time to wait before flushing logged data.
+ * @param idle          Time I/O has to stay idle to flush logged data
+ *                      earlier than latency, zero for no idle flushing.
  * @param item_mask     Logging mask with bits indexed by enum tlog_rec_item.
  * @param psignal       Location for the number of signal which caused
  *                      transfer termination, or for zero, if terminated for
@@ -814,33 +1247,77 @@ cleanup:
  * @return Global return code.
  */
 static tlog_grc
-tlog_rec_transfer(struct tlog_errs    **perrs,
-                  struct tlog_source   *tty_source,
-                  struct tlog_sink     *log_sink,
-                  struct tlog_sink     *tty_sink,
-                  unsigned int          latency,
-                  unsigned              item_mask,
-                  int                   in_fd,
-                  int                  *psignal)
+tlog_rec_transfer(struct tlog_errs        **perrs,
+                  struct tlog_source       *tty_source,
+                  struct tlog_sink         *log_sink,
+                  struct tlog_sink         *tty_sink,
+                  struct tlog_pass         *in_pass,
+                  struct tlog_pass         *out_pass,
+                  const struct timespec    *latency,
+                  const struct timespec    *idle,
+                  unsigned                  item_mask,
+                  int                       in_fd,
+                  int                      *psignal)
 {
     const int exit_sig[] = {SIGINT, SIGTERM, SIGHUP};
+    const struct itimerspec timer_arm = {.it_value = *latency};
+    const struct itimerspec timer_disarm = {.it_value = {0, 0}};
+    struct itimerspec idle_arm = {.it_value = {0, 0}};
     tlog_grc return_grc = TLOG_RC_OK;
     tlog_grc grc = TLOG_RC_OK;
-    size_t i, j;
+    size_t i;
+    int rc;
     struct sigaction sa;
+    sigset_t sig_set;
+    sigset_t orig_sig_set;
+    bool sig_set_blocked = false;
+    int sig_fd = -1;
+    int timer_fd = -1;
+    int idle_fd = -1;
+    int epoll_fd = -1;
+    struct epoll_event ev_list[6];
+    int ev_num;
+    int exit_signum = 0;
+    bool child_exited = false;
+    bool source_ready = false;
+    bool in_pass_ready = false;
+    bool out_pass_ready = false;
+    bool pass_eof;
     bool log_pending = false;
-    sig_atomic_t last_alarm_caught = 0;
-    sig_atomic_t new_alarm_caught;
-    struct tlog_pkt pkt = TLOG_PKT_VOID;
+    bool timer_armed = false;
+    bool timer_expired = false;
+    bool idle_armed = false;
+    bool idle_expired = false;
+    struct timespec last_io = {0, 0};
+    struct timespec idle_io = {0, 0};
+    /* Packets read, owning their data */
+    struct tlog_pkt pkt_list[TLOG_TTY_SOURCE_BATCH_SIZE];
+    size_t pkt_num = 0;
+    /* Packets read, except the ends of streams, to deliver */
+    struct tlog_pkt tty_list[TLOG_TTY_SOURCE_BATCH_SIZE];
+    size_t tty_num = 0;
+    size_t tty_idx = 0;
     struct tlog_pkt_pos tty_pos = TLOG_PKT_POS_VOID;
+    /* Packets to deliver, which should be logged */
+    struct tlog_pkt log_list[TLOG_TTY_SOURCE_BATCH_SIZE];
+    size_t log_num = 0;
+    size_t log_idx = 0;
     struct tlog_pkt_pos log_pos = TLOG_PKT_POS_VOID;
+    /* True if the last packet read was an end of stream */
+    bool eof_read = false;
+    /* True if the streams which ended were closed */
+    bool eof_done = true;
+    bool output_eof = false;
 
-    tlog_rec_exit_signum = 0;
-    tlog_rec_alarm_set = false;
-    tlog_rec_alarm_caught = 0;
-    tlog_rec_child_exited = false;
+    for (i = 0; i < TLOG_ARRAY_SIZE(pkt_list); i++) {
+        pkt_list[i] = TLOG_PKT_VOID;
+    }
 
-    /* Setup signal handlers to terminate gracefully */
+    /*
+     * Receive the exit signals, unless ignored, and SIGCHLD via a
+     * signalfd, instead of handlers interrupting system calls
+     */
+    sigemptyset(&sig_set);
     for (i = 0; i < TLOG_ARRAY_SIZE(exit_sig); i++) {
         if (sigaction(exit_sig[i], NULL, &sa) == -1) {
             grc = TLOG_GRC_ERRNO;
@@ -848,79 +1325,197 @@ tlog_rec_transfer(struct tlog_errs    **perrs,
                               "Failed to retrieve an exit signal action");
         }
         if (sa.sa_handler != SIG_IGN) {
-            sa.sa_handler = tlog_rec_exit_sighandler;
-            sigemptyset(&sa.sa_mask);
-            for (j = 0; j < TLOG_ARRAY_SIZE(exit_sig); j++) {
-                sigaddset(&sa.sa_mask, exit_sig[j]);
-            }
-            /* NOTE: no SA_RESTART on purpose */
-            sa.sa_flags = 0;
-            if(sigaction(exit_sig[i], &sa, NULL) == -1) {
-                grc = TLOG_GRC_ERRNO;
-                TLOG_ERRS_RAISECS(grc,
-                                  "Failed to set an exit signal action");
-            }
+            sigaddset(&sig_set, exit_sig[i]);
         }
     }
+    sigaddset(&sig_set, SIGCHLD);
+    rc = pthread_sigmask(SIG_BLOCK, &sig_set, &orig_sig_set);
+    if (rc != 0) {
+        grc = TLOG_GRC_FROM(errno, rc);
+        TLOG_ERRS_RAISECS(grc, "Failed blocking signals");
+    }
+    sig_set_blocked = true;
+    sig_fd = signalfd(-1, &sig_set, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sig_fd < 0) {
+        grc = TLOG_GRC_ERRNO;
+        TLOG_ERRS_RAISECS(grc, "Failed creating a signalfd");
+    }
 
-    /* Setup ALRM signal handler */
-    sa.sa_handler = tlog_rec_alarm_sighandler;
-    sigemptyset(&sa.sa_mask);
-    /* NOTE: no SA_RESTART on purpose */
-    sa.sa_flags = 0;
-    if(sigaction(SIGALRM, &sa, NULL) == -1) {
+    /* Create the latency timer */
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0) {
         grc = TLOG_GRC_ERRNO;
-        TLOG_ERRS_RAISECS(grc,
-                          "Failed to set a SIGALRM signal action");
+        TLOG_ERRS_RAISECS(grc, "Failed creating a timerfd");
     }
 
-    /* Setup SIGCHLD signal handler */
-    sa.sa_handler = tlog_rec_sigchld_handler;
-    sigemptyset(&sa.sa_mask);
-    /* NOTE: no SA_RESTART on purpose */
-    sa.sa_flags = 0;
-    if(sigaction(SIGCHLD, &sa, NULL) == -1) {
+    /* Create the idle timer, on the base of the packet timestamp clock */
+    idle_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (idle_fd < 0) {
+        grc = TLOG_GRC_ERRNO;
+        TLOG_ERRS_RAISECS(grc, "Failed creating a timerfd");
+    }
+
+    /*
+     * Wait for the TTY source, the pass-throughs, the signals, and the
+     * timers together
+     */
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
         grc = TLOG_GRC_ERRNO;
-        TLOG_ERRS_RAISECS(grc,
-                          "Failed to set a SIGCHLD signal action");
+        TLOG_ERRS_RAISECS(grc, "Failed creating an epoll FD");
     }
+    {
+        const struct {
+            int                 fd;
+            enum tlog_rec_ev    ev;
+        } watch_list[] = {
+            {tlog_tty_source_get_fd(tty_source), TLOG_REC_EV_SOURCE},
+            {sig_fd, TLOG_REC_EV_SIGNAL},
+            {timer_fd, TLOG_REC_EV_TIMER},
+            {idle_fd, TLOG_REC_EV_IDLE},
+            {tlog_pass_is_void(in_pass) ? -1 : tlog_pass_get_fd(in_pass),
+             TLOG_REC_EV_PASS_IN},
+            {tlog_pass_is_void(out_pass) ? -1 : tlog_pass_get_fd(out_pass),
+             TLOG_REC_EV_PASS_OUT},
+        };
+        for (i = 0; i < TLOG_ARRAY_SIZE(watch_list); i++) {
+            struct epoll_event ev = {.events = EPOLLIN,
+                                     .data.u32 = watch_list[i].ev};
+            if (watch_list[i].fd < 0) {
+                continue;
+            }
+            if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD,
+                          watch_list[i].fd, &ev) < 0) {
+                grc = TLOG_GRC_ERRNO;
+                TLOG_ERRS_RAISECS(grc, "Failed watching an FD");
+            }
+        }
+    }
+
     if (isatty(in_fd)) {
 #ifdef HAVE_UTEMPTER
-        raise(SIGCHLD);
+        /* Act as if SIGCHLD was received */
+        child_exited = true;
 #endif
     }
 
     /*
      * Transfer I/O and window changes
      */
-    while (tlog_rec_exit_signum == 0) {
-        /* Expected exit conditions */
-        if (tlog_rec_child_exited) {
-            if (grc == TLOG_GRC_FROM(errno, EIO) || (tlog_pkt_is_eof(&pkt))) {
+    while (exit_signum == 0) {
+        /*
+         * Expected exit conditions, once the packets read are transferred,
+         * and unless the output is passed through, and can still end
+         */
+        if (child_exited &&
+            log_idx >= log_num && tty_idx >= tty_num && eof_done) {
+            if (grc == TLOG_GRC_FROM(errno, EIO) ||
+                (eof_read && tlog_pass_is_void(out_pass))) {
                 break;
             }
         }
 
-        /* Handle latency limit */
-        new_alarm_caught = tlog_rec_alarm_caught;
-        if (new_alarm_caught != last_alarm_caught) {
-            grc = tlog_sink_flush(log_sink);
-            if (grc == TLOG_GRC_FROM(errno, EINTR)) {
-                continue;
-            } else if (grc != TLOG_RC_OK) {
-                return_grc = grc;
-                TLOG_ERRS_RAISECS(grc, "Failed flushing log");
+        /* Wait for idle time since the last I/O, if any came after arming */
+        if (idle_expired && !timer_expired &&
+            tlog_timespec_cmp(&last_io, &idle_io) != 0) {
+            idle_expired = false;
+        }
+
+        /* Handle latency limit and idle I/O */
+        if (timer_expired || idle_expired) {
+            if (log_pending) {
+                grc = tlog_sink_flush(log_sink,
+                                      timer_expired
+                                        ? TLOG_SINK_FLUSH_REASON_LATENCY
+                                        : TLOG_SINK_FLUSH_REASON_IDLE);
+                if (grc == TLOG_GRC_FROM(errno, EINTR)) {
+                    continue;
+                } else if (grc != TLOG_RC_OK) {
+                    return_grc = grc;
+                    TLOG_ERRS_RAISECS(grc, "Failed flushing log");
+                }
+            }
+            /* Disarm the other timer */
+            if (timer_armed) {
+                timerfd_settime(timer_fd, 0, &timer_disarm, NULL);
+                timer_armed = false;
             }
-            last_alarm_caught = new_alarm_caught;
+            if (idle_armed) {
+                timerfd_settime(idle_fd, 0, &timer_disarm, NULL);
+                idle_armed = false;
+            }
+            timer_expired = false;
+            idle_expired = false;
             log_pending = false;
-        } else if (log_pending && !tlog_rec_alarm_set) {
-            tlog_rec_alarm_set = true;
-            alarm(latency);
+        } else if (log_pending) {
+            if (!timer_armed) {
+                if (timerfd_settime(timer_fd, 0, &timer_arm, NULL) < 0) {
+                    grc = TLOG_GRC_ERRNO;
+                    TLOG_ERRS_RAISECS(grc,
+                                      "Failed arming the latency timer");
+                }
+                timer_armed = true;
+            }
+            if (!idle_armed && !tlog_timespec_is_zero(idle)) {
+                idle_io = last_io;
+                tlog_timespec_add(&last_io, idle, &idle_arm.it_value);
+                if (timerfd_settime(idle_fd, TFD_TIMER_ABSTIME,
+                                    &idle_arm, NULL) < 0) {
+                    grc = TLOG_GRC_ERRNO;
+                    TLOG_ERRS_RAISECS(grc, "Failed arming the idle timer");
+                }
+                idle_armed = true;
+            }
+        }
+
+        /* Log the packets read, if any */
+        if (log_idx < log_num) {
+            grc = tlog_sink_write_batch(log_sink, log_list, log_num,
+                                        &log_idx, &log_pos);
+            if (grc == TLOG_RC_OK) {
+                log_pending = true;
+                last_io = log_list[log_num - 1].timestamp;
+            } else if (grc != TLOG_GRC_FROM(errno, EINTR)) {
+                return_grc = grc;
+                TLOG_ERRS_RAISECS(grc, "Failed logging terminal data");
+            }
+            continue;
         }
 
-        /* Deliver logged data if any */
-        if (tlog_pkt_pos_cmp(&tty_pos, &log_pos) < 0) {
-            grc = tlog_sink_write(tty_sink, &pkt, &tty_pos, &log_pos);
+        /* Pass the output not logged through, if ready */
+        if (out_pass_ready) {
+            out_pass_ready = false;
+            grc = tlog_pass_run(out_pass, &pass_eof);
+            if (grc == TLOG_RC_OK) {
+                /* Finish, if the output ended */
+                if (pass_eof) {
+                    break;
+                }
+            } else if (grc != TLOG_GRC_FROM(errno, EIO)) {
+                tlog_errs_pushc(perrs, grc);
+                tlog_errs_pushs(perrs, "Failed passing terminal output");
+                return_grc = grc;
+                break;
+            }
+            continue;
+        }
+
+        /* Deliver the packets read, once logged */
+        if (tty_idx < tty_num) {
+            /*
+             * Pass the output through first, if ready, so the child isn't
+             * stuck writing it, while we're writing the child's input
+             */
+            if (!tlog_pass_is_void(out_pass)) {
+                struct pollfd pfd = {.fd = tlog_pass_get_fd(out_pass),
+                                     .events = POLLIN};
+                if (poll(&pfd, 1, 0) > 0) {
+                    out_pass_ready = true;
+                    continue;
+                }
+            }
+            grc = tlog_sink_write_batch(tty_sink, tty_list, tty_num,
+                                        &tty_idx, &tty_pos);
             if (grc != TLOG_RC_OK) {
                 if (grc == TLOG_GRC_FROM(errno, EINTR)) {
                     continue;
@@ -935,28 +1530,104 @@ tlog_rec_transfer(struct tlog_errs    **perrs,
             continue;
         }
 
-        /* Log the received data, if any */
-        if (tlog_pkt_pos_is_in(&log_pos, &pkt)) {
-            /* If asked to log this type of packet */
-            if (item_mask & (1 << tlog_rec_item_from_pkt(&pkt))) {
-                grc = tlog_sink_write(log_sink, &pkt, &log_pos, NULL);
-                if (grc == TLOG_RC_OK) {
-                    log_pending = true;
-                } else if (grc != TLOG_GRC_FROM(errno, EINTR)) {
-                    return_grc = grc;
-                    TLOG_ERRS_RAISECS(grc, "Failed logging terminal data");
+        /* Close the streams which ended, once the rest is delivered */
+        if (!eof_done) {
+            eof_done = true;
+            for (i = 0; i < pkt_num; i++) {
+                if (tlog_pkt_is_eof(&pkt_list[i])) {
+                    tlog_sink_io_close(tty_sink, pkt_list[i].data.io.output);
+                    output_eof = output_eof || pkt_list[i].data.io.output;
                 }
-            } else {
-                tlog_pkt_pos_move_past(&log_pos, &pkt);
+            }
+            /* Continue if only input was closed */
+            if (output_eof) {
+                break;
             }
             continue;
         }
 
-        /* Read new data */
-        tlog_pkt_cleanup(&pkt);
-        log_pos = TLOG_PKT_POS_VOID;
+        /* Pass the input not logged through, if ready */
+        if (in_pass_ready) {
+            in_pass_ready = false;
+            grc = tlog_pass_run(in_pass, &pass_eof);
+            if (grc == TLOG_RC_OK) {
+                /* Stop watching the input and close it, if ended */
+                if (pass_eof) {
+                    epoll_ctl(epoll_fd, EPOLL_CTL_DEL,
+                              tlog_pass_get_fd(in_pass), NULL);
+                    tlog_pass_cleanup(in_pass);
+                    tlog_sink_io_close(tty_sink, false);
+                }
+            } else if (grc != TLOG_GRC_FROM(errno, EIO)) {
+                tlog_errs_pushc(perrs, grc);
+                tlog_errs_pushs(perrs, "Failed passing terminal input");
+                return_grc = grc;
+                break;
+            }
+            continue;
+        }
+
+        /* Wait for new data, a signal, or a timer */
+        if (!source_ready) {
+            ev_num = epoll_wait(epoll_fd, ev_list,
+                                TLOG_ARRAY_SIZE(ev_list), -1);
+            if (ev_num < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                grc = TLOG_GRC_ERRNO;
+                TLOG_ERRS_RAISECS(grc, "Failed waiting for events");
+            }
+            for (i = 0; i < (size_t)ev_num; i++) {
+                if (ev_list[i].data.u32 == TLOG_REC_EV_SOURCE) {
+                    source_ready = true;
+                } else if (ev_list[i].data.u32 == TLOG_REC_EV_PASS_IN) {
+                    in_pass_ready = true;
+                } else if (ev_list[i].data.u32 == TLOG_REC_EV_PASS_OUT) {
+                    out_pass_ready = true;
+                } else if (ev_list[i].data.u32 == TLOG_REC_EV_SIGNAL) {
+                    struct signalfd_siginfo info;
+                    while (read(sig_fd, &info, sizeof(info)) > 0) {
+                        if (info.ssi_signo == SIGCHLD) {
+                            child_exited = true;
+                        } else if (exit_signum == 0) {
+                            exit_signum = (int)info.ssi_signo;
+                        }
+                    }
+                } else if (ev_list[i].data.u32 == TLOG_REC_EV_TIMER) {
+                    uint64_t expirations;
+                    if (read(timer_fd, &expirations,
+                             sizeof(expirations)) > 0) {
+                        timer_armed = false;
+                        timer_expired = true;
+                    }
+                } else if (ev_list[i].data.u32 == TLOG_REC_EV_IDLE) {
+                    uint64_t expirations;
+                    if (read(idle_fd, &expirations,
+                             sizeof(expirations)) > 0) {
+                        idle_armed = false;
+                        idle_expired = true;
+                    }
+                }
+            }
+            continue;
+        }
+
+        /* Read all the new data */
+        source_ready = false;
+        for (i = 0; i < pkt_num; i++) {
+            tlog_pkt_cleanup(&pkt_list[i]);
+        }
+        pkt_num = 0;
+        tty_num = 0;
+        tty_idx = 0;
         tty_pos = TLOG_PKT_POS_VOID;
-        grc = tlog_source_read(tty_source, &pkt);
+        log_num = 0;
+        log_idx = 0;
+        log_pos = TLOG_PKT_POS_VOID;
+        eof_read = false;
+        grc = tlog_source_read_batch(tty_source, pkt_list,
+                                     TLOG_ARRAY_SIZE(pkt_list), &pkt_num);
         if (grc != TLOG_RC_OK) {
             if (grc == TLOG_GRC_FROM(errno, EINTR)) {
                 continue;
@@ -966,19 +1637,32 @@ tlog_rec_transfer(struct tlog_errs    **perrs,
                 tlog_errs_pushs(perrs, "Failed reading terminal data");
                 return_grc = grc;
             }
-        } else if (tlog_pkt_is_eof(&pkt)) {
-            tlog_sink_io_close(tty_sink, pkt.data.io.output);
-            /* Continue if only input was closed */
-            if (pkt.data.io.output) {
-                break;
+            continue;
+        }
+
+        /* Sort the packets for delivering, logging, and closing streams */
+        for (i = 0; i < pkt_num; i++) {
+            eof_read = tlog_pkt_is_eof(&pkt_list[i]);
+            if (eof_read) {
+                eof_done = false;
+                continue;
+            }
+            tty_list[tty_num++] = pkt_list[i];
+            /* If asked to log this type of packet */
+            if (item_mask & (1 << tlog_rec_item_from_pkt(&pkt_list[i]))) {
+                log_list[log_num++] = pkt_list[i];
             }
         }
     }
 
-    /* Cancel pending alarm, if any, to avoid interruptions */
-    if (tlog_rec_alarm_set) {
-        alarm(0);
-        tlog_rec_alarm_set = false;
+    /* Cancel pending timers, if any */
+    if (timer_armed) {
+        timerfd_settime(timer_fd, 0, &timer_disarm, NULL);
+        timer_armed = false;
+    }
+    if (idle_armed) {
+        timerfd_settime(idle_fd, 0, &timer_disarm, NULL);
+        idle_armed = false;
     }
 
     /* Cut the log (write incomplete characters as binary) */
@@ -993,7 +1677,11 @@ tlog_rec_transfer(struct tlog_errs    **perrs,
     }
 
     /* Flush the log */
-    grc = tlog_sink_flush(log_sink);
+    grc = tlog_sink_flush(log_sink, TLOG_SINK_FLUSH_REASON_REQUEST);
+    /* Wait for the queued log to be written, if queueing */
+    if (grc == TLOG_RC_OK && log_sink->type == &tlog_queue_sink_type) {
+        grc = tlog_queue_sink_drain(log_sink);
+    }
     if (grc != TLOG_RC_OK) {
         if (grc == (TLOG_GRC_FROM(systemd, -ENOENT))) {
             tlog_errs_pushc(perrs, grc);
@@ -1009,28 +1697,33 @@ tlog_rec_transfer(struct tlog_errs    **perrs,
     }
 
     if (psignal != NULL) {
-        *psignal = tlog_rec_exit_signum;
+        *psignal = exit_signum;
     }
 
 cleanup:
 
-    tlog_pkt_cleanup(&pkt);
-    /* Stop the timer, if any */
-    if (tlog_rec_alarm_set) {
-        alarm(0);
-        tlog_rec_alarm_set = false;
+    for (i = 0; i < TLOG_ARRAY_SIZE(pkt_list); i++) {
+        tlog_pkt_cleanup(&pkt_list[i]);
     }
-    /* Restore signal handlers */
-    signal(SIGALRM, SIG_DFL);
-    signal(SIGCHLD, SIG_DFL);
-    for (i = 0; i < TLOG_ARRAY_SIZE(exit_sig); i++) {
-        sigaction(exit_sig[i], NULL, &sa);
-        if (sa.sa_handler != SIG_IGN) {
-            signal(exit_sig[i], SIG_DFL);
-        }
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+    }
+    if (timer_fd >= 0) {
+        close(timer_fd);
+    }
+    if (idle_fd >= 0) {
+        close(idle_fd);
+    }
+    if (sig_fd >= 0) {
+        close(sig_fd);
+    }
+    /* Restore the signal mask */
+    if (sig_set_blocked) {
+        pthread_sigmask(SIG_SETMASK, &orig_sig_set, NULL);
     }
 
-    return return_grc;
+    /* Report setup failures too */
+    return return_grc != TLOG_RC_OK ? return_grc : grc;
 }
 
 /**
@@ -1132,8 +1825,8 @@ tlog_rec(struct tlog_errs **perrs, uid_t euid, gid_t egid,
     unsigned int session_id;
     bool lock_acquired = false;
     struct json_object *obj;
-    int64_t num;
-    unsigned int latency;
+    struct timespec latency;
+    struct timespec idle;
     unsigned int item_mask;
     int signal = 0;
     struct tlog_sink *log_sink = NULL;
@@ -1175,16 +1868,27 @@ tlog_rec(struct tlog_errs **perrs, uid_t euid, gid_t egid,
     }
 
     /*
-     * Choose the clock: try to use coarse monotonic clock (which is faster),
-     * if it provides the required resolution.
+     * Choose the clock: use coarse monotonic clock (which is faster), if
+     * asked to, or if asked to choose, and it provides the required
+     * resolution.
      */
+    if (!json_object_object_get_ex(conf, "clock", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Timestamp clock is not specified");
+    }
     {
+        const char *str = json_object_get_string(obj);
 #ifdef CLOCK_MONOTONIC_COARSE
         struct timespec timestamp;
         if (clock_getres(CLOCK_MONOTONIC_COARSE, &timestamp) == 0 &&
-            tlog_timespec_cmp(&timestamp, &tlog_delay_min_timespec) <= 0) {
+            (strcmp(str, "coarse") == 0 ||
+             (strcmp(str, "auto") == 0 &&
+              tlog_timespec_cmp(&timestamp,
+                                &tlog_delay_min_timespec) <= 0))) {
             clock_id = CLOCK_MONOTONIC_COARSE;
         } else {
+#else
+        (void)str;
 #endif
             if (clock_getres(CLOCK_MONOTONIC, NULL) == 0) {
                 clock_id = CLOCK_MONOTONIC;
@@ -1225,8 +1929,19 @@ tlog_rec(struct tlog_errs **perrs, uid_t euid, gid_t egid,
         grc = TLOG_RC_FAILURE;
         TLOG_ERRS_RAISES("Log latency is not specified");
     }
-    num = json_object_get_int64(obj);
-    latency = (unsigned int)num;
+    tlog_timespec_from_fp(json_object_get_double(obj), &latency);
+
+    /* Read the idle flush time */
+    if (!json_object_object_get_ex(conf, "flush", &obj) ||
+        !json_object_object_get_ex(obj, "idle", &obj)) {
+        grc = TLOG_RC_FAILURE;
+        TLOG_ERRS_RAISES("Log idle flush time is not specified");
+    }
+    {
+        int64_t ms = json_object_get_int64(obj);
+        idle.tv_sec = (time_t)(ms / 1000);
+        idle.tv_nsec = (long)(ms % 1000 * 1000000);
+    }
 
     /* Read item mask */
     if (!json_object_object_get_ex(conf, "log", &obj)) {
@@ -1254,10 +1969,15 @@ tlog_rec(struct tlog_errs **perrs, uid_t euid, gid_t egid,
         fprintf(stderr, "%s", json_object_get_string(obj));
     }
 
-    /* Setup the tap */
+    /* Setup the tap, passing the streams not logged through */
     grc = tlog_tap_setup(perrs, &tap, euid, egid,
                          opts & TLOG_EXEC_OPT_MASK, path, argv,
-                         in_fd, out_fd, err_fd, clock_id);
+                         in_fd, out_fd, err_fd,
+                         ((item_mask & (1 << TLOG_REC_ITEM_INPUT))
+                            ? 0 : TLOG_TAP_PASS_IN) |
+                         ((item_mask & (1 << TLOG_REC_ITEM_OUTPUT))
+                            ? 0 : TLOG_TAP_PASS_OUT),
+                         clock_id);
     if (grc != TLOG_RC_OK) {
         TLOG_ERRS_RAISES("Failed setting up the I/O tap");
     }
@@ -1270,7 +1990,8 @@ tlog_rec(struct tlog_errs **perrs, uid_t euid, gid_t egid,
 
     /* Transfer and log the data until interrupted or either end is closed */
     grc = tlog_rec_transfer(perrs, tap.source, log_sink, tap.sink,
-                            latency, item_mask, in_fd, &signal);
+                            &tap.in_pass, &tap.out_pass,
+                            &latency, &idle, item_mask, in_fd, &signal);
     if (grc != TLOG_RC_OK) {
         TLOG_ERRS_RAISES("Failed transferring TTY data");
     }
@@ -20,10 +20,37 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <config.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <tlog/timespec.h>
 #include <tlog/rc.h>
+#include <tlog/misc.h>
+#include <tlog/json_sink.h>
 #include <tlog/rl_json_writer.h>
 
+/**
+ * Size of the buffer for the end of a message written by a JSON sink, with
+ * the "elided" and "dropped_msgs" fields added
+ */
+#define TLOG_RL_JSON_WRITER_END_SIZE    96
+
+/** Message in the backlog */
+struct tlog_rl_json_writer_msg {
+    /** Next message in the backlog, NULL if none */
+    struct tlog_rl_json_writer_msg *next;
+    /** Message ID */
+    size_t                          id;
+    /** Message length, bytes */
+    size_t                          len;
+    /** Message text */
+    uint8_t                         buf[];
+};
+
 /** Rate-limiting writer data */
 struct tlog_rl_json_writer {
     /** Abstract writer instance */
@@ -49,8 +76,14 @@ struct tlog_rl_json_writer {
      * Type is chosen to be compatible with timestamps.
      */
     struct timespec             limit;
-    /** True if messages exceeding rate should be dropped, false if delayed */
-    bool                        drop;
+    /**
+     * Part of the bucket limit reserved for messages carrying input or
+     * window changes, bytes, for the "drop" and "degrade" actions.
+     * Type is chosen to be compatible with timestamps.
+     */
+    struct timespec             reserve;
+    /** Action to take on messages exceeding the rate */
+    enum tlog_rl_json_writer_action action;
     /** True if the writer synced time and bucket previously */
     bool                        synced;
     /** Last sync timestamp */
@@ -60,23 +93,177 @@ struct tlog_rl_json_writer {
      * Type is chosen to be compatible with timestamps.
      */
     struct timespec             bucket;
+    /** Budget shared with other processes, NULL if none */
+    struct tlog_rl_shared      *shared;
+    /**
+     * Number of messages dropped since the last message written, to be
+     * reported in the next message written by a JSON sink, for the "drop"
+     * and "degrade" actions
+     */
+    size_t                      dropped;
+
+    /*
+     * Backlog, for the "backlog" action
+     */
+    /** Maximum total length of backlog messages, bytes */
+    size_t                      backlog_size;
+    /** Total length of backlog messages, bytes */
+    size_t                      backlog_len;
+    /** Backlog eviction policy */
+    enum tlog_rl_json_writer_evict evict;
+    /** First (oldest) message in the backlog, NULL if empty */
+    struct tlog_rl_json_writer_msg *first;
+    /** Last (newest) message in the backlog, NULL if empty */
+    struct tlog_rl_json_writer_msg *last;
+    /**
+     * Mutex protecting the backlog, the bucket, and the "below" writer,
+     * except while the thread is writing a message taken out of the
+     * backlog
+     */
+    pthread_mutex_t             mutex;
+    /** True if mutex is initialized */
+    bool                        mutex_init;
+    /** Condition signalled when messages are added, or stop is requested */
+    pthread_cond_t              cond;
+    /** True if cond is initialized */
+    bool                        cond_init;
+    /** Condition signalled when the thread finishes writing a message */
+    pthread_cond_t              write_cond;
+    /** True if write_cond is initialized */
+    bool                        write_cond_init;
+    /**
+     * True if the thread is writing a message to the "below" writer,
+     * with the mutex unlocked
+     */
+    bool                        writing;
+    /** Backlog writing thread */
+    pthread_t                   thread;
+    /** True if the thread was started */
+    bool                        started;
+    /** True if the thread should write out the backlog and exit */
+    bool                        stop;
+    /** Result of the first failed backlog write */
+    tlog_grc                    grc;
 };
 
+static void
+tlog_rl_json_writer_cleanup(struct tlog_json_writer *writer)
+{
+    struct tlog_rl_json_writer *rl_json_writer =
+                                    (struct tlog_rl_json_writer*)writer;
+    struct tlog_rl_json_writer_msg *msg;
+
+    assert(rl_json_writer != NULL);
+
+    /* Let the thread write out the backlog and exit */
+    if (rl_json_writer->started) {
+        pthread_mutex_lock(&rl_json_writer->mutex);
+        rl_json_writer->stop = true;
+        pthread_cond_signal(&rl_json_writer->cond);
+        pthread_mutex_unlock(&rl_json_writer->mutex);
+        pthread_join(rl_json_writer->thread, NULL);
+        rl_json_writer->started = false;
+    }
+    while (rl_json_writer->first != NULL) {
+        msg = rl_json_writer->first;
+        rl_json_writer->first = msg->next;
+        free(msg);
+    }
+    rl_json_writer->last = NULL;
+    rl_json_writer->backlog_len = 0;
+    if (rl_json_writer->cond_init) {
+        pthread_cond_destroy(&rl_json_writer->cond);
+        rl_json_writer->cond_init = false;
+    }
+    if (rl_json_writer->write_cond_init) {
+        pthread_cond_destroy(&rl_json_writer->write_cond);
+        rl_json_writer->write_cond_init = false;
+    }
+    if (rl_json_writer->mutex_init) {
+        pthread_mutex_destroy(&rl_json_writer->mutex);
+        rl_json_writer->mutex_init = false;
+    }
+
+    tlog_rl_shared_destroy(rl_json_writer->shared);
+    rl_json_writer->shared = NULL;
+
+    if (rl_json_writer->below_owned) {
+        tlog_json_writer_destroy(rl_json_writer->below);
+    }
+    rl_json_writer->below = NULL;
+}
+
 static tlog_grc
 tlog_rl_json_writer_init(struct tlog_json_writer *writer, va_list ap)
 {
     struct tlog_rl_json_writer *rl_json_writer =
                                     (struct tlog_rl_json_writer*)writer;
-    rl_json_writer->below = va_arg(ap, struct tlog_json_writer *);
-    assert(tlog_json_writer_is_valid(rl_json_writer->below));
-    rl_json_writer->below_owned = va_arg(ap, int) != 0;
-    rl_json_writer->clock_id = va_arg(ap, clockid_t);
-    rl_json_writer->rate.tv_sec = (time_t)va_arg(ap, size_t);
-    rl_json_writer->burst.tv_sec = (time_t)va_arg(ap, size_t);
+    const struct tlog_rl_json_writer_params *params =
+                    va_arg(ap, const struct tlog_rl_json_writer_params *);
+    pthread_condattr_t condattr;
+    tlog_grc grc;
+    int rc;
+
+    assert(tlog_rl_json_writer_params_is_valid(params));
+
+    rl_json_writer->below = params->below;
+    rl_json_writer->below_owned = params->below_owned;
+    rl_json_writer->clock_id = params->clock_id;
+    rl_json_writer->rate.tv_sec = (time_t)params->rate;
+    rl_json_writer->burst.tv_sec = (time_t)params->burst;
     tlog_timespec_add(&rl_json_writer->rate, &rl_json_writer->burst,
                       &rl_json_writer->limit);
-    rl_json_writer->drop = va_arg(ap, int) != 0;
+    rl_json_writer->action = params->action;
+    if (rl_json_writer->action == TLOG_RL_JSON_WRITER_ACTION_DROP ||
+        rl_json_writer->action == TLOG_RL_JSON_WRITER_ACTION_DEGRADE) {
+        rl_json_writer->reserve.tv_sec =
+            (time_t)((params->rate + params->burst) * params->reserve / 100);
+    }
+    rl_json_writer->backlog_size = params->backlog;
+    rl_json_writer->evict = params->evict;
+    rl_json_writer->shared = params->shared;
+
+    if (rl_json_writer->action == TLOG_RL_JSON_WRITER_ACTION_BACKLOG) {
+        rc = pthread_mutex_init(&rl_json_writer->mutex, NULL);
+        if (rc != 0) {
+            grc = TLOG_GRC_FROM(errno, rc);
+            goto error;
+        }
+        rl_json_writer->mutex_init = true;
+
+        /* Wait for the bucket to drain on the rate-limiting clock */
+        rc = pthread_condattr_init(&condattr);
+        if (rc != 0) {
+            grc = TLOG_GRC_FROM(errno, rc);
+            goto error;
+        }
+        rc = pthread_condattr_setclock(&condattr, rl_json_writer->clock_id);
+        if (rc == 0) {
+            rc = pthread_cond_init(&rl_json_writer->cond, &condattr);
+        }
+        pthread_condattr_destroy(&condattr);
+        if (rc != 0) {
+            grc = TLOG_GRC_FROM(errno, rc);
+            goto error;
+        }
+        rl_json_writer->cond_init = true;
+
+        rc = pthread_cond_init(&rl_json_writer->write_cond, NULL);
+        if (rc != 0) {
+            grc = TLOG_GRC_FROM(errno, rc);
+            goto error;
+        }
+        rl_json_writer->write_cond_init = true;
+    }
+
     return TLOG_RC_OK;
+
+error:
+    /* Leave the "below" writer and the shared budget to the caller */
+    rl_json_writer->below_owned = false;
+    rl_json_writer->shared = NULL;
+    tlog_rl_json_writer_cleanup(writer);
+    return grc;
 }
 
 static bool
@@ -88,40 +275,47 @@ tlog_rl_json_writer_is_valid(const struct tlog_json_writer *writer)
            tlog_json_writer_is_valid(rl_json_writer->below) &&
            tlog_timespec_is_valid(&rl_json_writer->rate) &&
            tlog_timespec_is_valid(&rl_json_writer->burst) &&
+           tlog_timespec_cmp(&rl_json_writer->reserve,
+                             &rl_json_writer->limit) <= 0 &&
+           tlog_rl_json_writer_action_is_valid(rl_json_writer->action) &&
+           (rl_json_writer->shared == NULL ||
+            tlog_rl_shared_is_valid(rl_json_writer->shared)) &&
            (!rl_json_writer->synced ||
             tlog_timespec_is_valid(&rl_json_writer->last_sync)) &&
            tlog_timespec_cmp(&rl_json_writer->bucket,
-                             &rl_json_writer->limit) <= 0;
-}
-
-static void
-tlog_rl_json_writer_cleanup(struct tlog_json_writer *writer)
-{
-    struct tlog_rl_json_writer *rl_json_writer =
-                                    (struct tlog_rl_json_writer*)writer;
-    assert(rl_json_writer != NULL);
-    if (rl_json_writer->below_owned) {
-        tlog_json_writer_destroy(rl_json_writer->below);
-    }
-    rl_json_writer->below = NULL;
+                             &rl_json_writer->limit) <= 0 &&
+           (rl_json_writer->action != TLOG_RL_JSON_WRITER_ACTION_BACKLOG ||
+            (rl_json_writer->mutex_init && rl_json_writer->cond_init &&
+             rl_json_writer->write_cond_init &&
+             tlog_rl_json_writer_evict_is_valid(rl_json_writer->evict) &&
+             rl_json_writer->backlog_len <= rl_json_writer->backlog_size &&
+             (rl_json_writer->first == NULL) ==
+                (rl_json_writer->last == NULL)));
 }
 
+/**
+ * Sync (drain) the bucket of a rate-limiting writer to the current time,
+ * and calculate the overflow a message would cause.
+ *
+ * @param rl_json_writer    The writer to operate on.
+ * @param len               Length of the message to fit, bytes.
+ * @param pbucket_poured    Location for the bucket contents with the
+ *                          message poured in.
+ * @param poverflow         Location for the amount the bucket would
+ *                          overflow by, with the message poured in.
+ *                          Positive, if the message doesn't fit.
+ *
+ * @return Global return code.
+ */
 static tlog_grc
-tlog_rl_json_writer_write(struct tlog_json_writer *writer,
-                           size_t id, const uint8_t *buf, size_t len)
+tlog_rl_json_writer_sync(struct tlog_rl_json_writer *rl_json_writer,
+                         size_t len,
+                         struct timespec *pbucket_poured,
+                         struct timespec *poverflow)
 {
-    struct tlog_rl_json_writer *rl_json_writer =
-                                    (struct tlog_rl_json_writer*)writer;
-    tlog_grc grc;
-    int rc;
     struct timespec now;
     struct timespec poured = {.tv_sec = len, .tv_nsec = 0};
-    struct timespec bucket_poured;
-    struct timespec overflow;
 
-    /*
-     * Sync (drain) the bucket to the time
-     */
     if (clock_gettime(rl_json_writer->clock_id, &now) < 0) {
         return TLOG_GRC_ERRNO;
     }
@@ -141,16 +335,95 @@ tlog_rl_json_writer_write(struct tlog_json_writer *writer,
     }
     rl_json_writer->last_sync = now;
 
-    /*
-     * Try to fit the message into the bucket
-     */
-    tlog_timespec_add(&rl_json_writer->bucket, &poured, &bucket_poured);
-    tlog_timespec_sub(&bucket_poured, &rl_json_writer->limit, &overflow);
+    tlog_timespec_add(&rl_json_writer->bucket, &poured, pbucket_poured);
+    tlog_timespec_sub(pbucket_poured, &rl_json_writer->limit, poverflow);
+    return TLOG_RC_OK;
+}
+
+/**
+ * Take a message out of the shared budget of a rate-limiting writer,
+ * waiting until it fits, if requested.
+ *
+ * @param rl_json_writer    The writer to operate on.
+ * @param len               Length of the message to take, bytes.
+ * @param wait              True if the message should be waited for to
+ *                          fit, false if the message should be reported
+ *                          as not fitting right away.
+ * @param ptaken            Location for the flag which is set to true if
+ *                          the message was taken out of the budget, and to
+ *                          false, if it doesn't fit.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_rl_json_writer_take_shared(struct tlog_rl_json_writer *rl_json_writer,
+                                size_t len, bool wait, bool *ptaken)
+{
+    tlog_grc grc;
+    int rc;
+    struct timespec delay;
+
+    while (true) {
+        grc = tlog_rl_shared_take(rl_json_writer->shared, len,
+                                  ptaken, &delay);
+        if (grc != TLOG_RC_OK || *ptaken || !wait) {
+            return grc;
+        }
+        rc = clock_nanosleep(rl_json_writer->clock_id, 0, &delay, NULL);
+        if (rc != 0) {
+            return TLOG_GRC_FROM(errno, rc);
+        }
+    }
+}
+
+/**
+ * Sync the bucket of a rate-limiting writer to the current time and wait
+ * until a message fits into it, and into the shared budget, if any, or find
+ * that the message should be dropped.
+ *
+ * @param rl_json_writer    The writer to operate on.
+ * @param len               Length of the message to fit, bytes.
+ * @param reserved          True if the message can use the reserved part
+ *                          of the limit, false if it should leave it.
+ * @param pfits             Location for the flag which is set to true if
+ *                          the message should be written, and to false if
+ *                          it should be dropped or degraded.
+ * @param pbucket_poured    Location for the bucket contents to commit after
+ *                          the message is written.
+ * @param pnow              Location for the timestamp to commit after the
+ *                          message is written.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_rl_json_writer_fit(struct tlog_rl_json_writer *rl_json_writer,
+                        size_t len, bool reserved, bool *pfits,
+                        struct timespec *pbucket_poured,
+                        struct timespec *pnow)
+{
+    tlog_grc grc;
+    int rc;
+    struct timespec bucket_poured;
+    struct timespec overflow;
+
+    grc = tlog_rl_json_writer_sync(rl_json_writer, len,
+                                   &bucket_poured, &overflow);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+    *pnow = rl_json_writer->last_sync;
+
+    /* Leave the reserve, unless the message can use it */
+    if (!reserved) {
+        tlog_timespec_add(&overflow, &rl_json_writer->reserve, &overflow);
+    }
+
     /* If the bucket would overflow */
     if (tlog_timespec_is_positive(&overflow)) {
-        /* If dropping */
-        if (rl_json_writer->drop) {
-            /* Report success without writing */
+        /* If dropping or degrading */
+        if (rl_json_writer->action == TLOG_RL_JSON_WRITER_ACTION_DROP ||
+            rl_json_writer->action == TLOG_RL_JSON_WRITER_ACTION_DEGRADE) {
+            *pfits = false;
             return TLOG_RC_OK;
         } else {
             struct timespec delay;
@@ -164,14 +437,432 @@ tlog_rl_json_writer_write(struct tlog_json_writer *writer,
                 return TLOG_GRC_FROM(errno, rc);
             }
             bucket_poured = rl_json_writer->limit;
-            now = wakeup;
+            *pnow = wakeup;
+        }
+    }
+
+    /* Fit into the shared budget as well, the same way */
+    if (rl_json_writer->shared != NULL) {
+        grc = tlog_rl_json_writer_take_shared(
+                    rl_json_writer, len,
+                    rl_json_writer->action == TLOG_RL_JSON_WRITER_ACTION_DELAY,
+                    pfits);
+        if (grc != TLOG_RC_OK || !*pfits) {
+            return grc;
+        }
+    }
+
+    *pfits = true;
+    *pbucket_poured = bucket_poured;
+    return TLOG_RC_OK;
+}
+
+/**
+ * Write a message to the "below" writer of a rate-limiting writer.
+ *
+ * @param rl_json_writer    The writer to write to the "below" writer of.
+ * @param id                ID of the message.
+ * @param iov               The vector of message pieces.
+ * @param iovcnt            Number of pieces in the vector.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_rl_json_writer_write_below(struct tlog_rl_json_writer *rl_json_writer,
+                                size_t id,
+                                const struct iovec *iov, int iovcnt)
+{
+    if (iovcnt == 1) {
+        return tlog_json_writer_write(rl_json_writer->below, id,
+                                      iov->iov_base, iov->iov_len);
+    }
+    return tlog_json_writer_writev(rl_json_writer->below, id, iov, iovcnt);
+}
+
+/**
+ * Backlog writing thread function: write backlog messages to the "below"
+ * writer as the rate allows, until asked to stop. Write out the remaining
+ * backlog without limiting, when stopping, so destroying the writer
+ * doesn't wait for the limits, but the messages are not lost. Write each
+ * message with the mutex unlocked, so the writers and flushers only wait
+ * for the backlog to be updated, and not for the "below" writer.
+ *
+ * @param arg   The rate-limiting writer to write the backlog of.
+ *
+ * @return NULL.
+ */
+static void *
+tlog_rl_json_writer_thread(void *arg)
+{
+    struct tlog_rl_json_writer *rl_json_writer =
+                                    (struct tlog_rl_json_writer *)arg;
+    struct tlog_rl_json_writer_msg *msg;
+    struct timespec bucket_poured;
+    struct timespec overflow;
+    struct timespec delay;
+    struct timespec wakeup;
+    struct iovec iov;
+    bool taken;
+    tlog_grc grc;
+
+    pthread_mutex_lock(&rl_json_writer->mutex);
+    while (true) {
+        /* Wait for work */
+        while (rl_json_writer->first == NULL && !rl_json_writer->stop) {
+            pthread_cond_wait(&rl_json_writer->cond, &rl_json_writer->mutex);
+        }
+        msg = rl_json_writer->first;
+        if (msg == NULL) {
+            break;
+        }
+
+        grc = tlog_rl_json_writer_sync(rl_json_writer, msg->len,
+                                       &bucket_poured, &overflow);
+        if (grc == TLOG_RC_OK && !rl_json_writer->stop) {
+            taken = true;
+            if (tlog_timespec_is_positive(&overflow)) {
+                tlog_timespec_fp_div(&overflow, &rl_json_writer->rate,
+                                     &delay);
+                taken = false;
+            } else if (rl_json_writer->shared != NULL) {
+                grc = tlog_rl_shared_take(rl_json_writer->shared, msg->len,
+                                          &taken, &delay);
+            }
+            if (!taken) {
+                /* Wait until the message fits, or something changes */
+                tlog_timespec_add(&rl_json_writer->last_sync, &delay,
+                                  &wakeup);
+                pthread_cond_timedwait(&rl_json_writer->cond,
+                                       &rl_json_writer->mutex, &wakeup);
+                continue;
+            }
+        } else if (grc == TLOG_RC_OK && rl_json_writer->shared != NULL) {
+            /* Account for the message written out without limits */
+            grc = tlog_rl_shared_force(rl_json_writer->shared, msg->len);
+        }
+
+        /* Take the message out of the backlog */
+        rl_json_writer->first = msg->next;
+        if (rl_json_writer->first == NULL) {
+            rl_json_writer->last = NULL;
+        }
+        rl_json_writer->backlog_len -= msg->len;
+
+        /*
+         * Write it, unless failed before, with the mutex unlocked, keeping
+         * the others off the "below" writer and the bucket meanwhile
+         */
+        if (grc == TLOG_RC_OK && rl_json_writer->grc == TLOG_RC_OK) {
+            rl_json_writer->writing = true;
+            pthread_mutex_unlock(&rl_json_writer->mutex);
+            iov.iov_base = msg->buf;
+            iov.iov_len = msg->len;
+            grc = tlog_rl_json_writer_write_below(rl_json_writer, msg->id,
+                                                  &iov, 1);
+            pthread_mutex_lock(&rl_json_writer->mutex);
+            rl_json_writer->writing = false;
+            pthread_cond_broadcast(&rl_json_writer->write_cond);
+            if (tlog_timespec_cmp(&bucket_poured,
+                                  &rl_json_writer->limit) > 0) {
+                bucket_poured = rl_json_writer->limit;
+            }
+            rl_json_writer->bucket = bucket_poured;
+        }
+        if (grc != TLOG_RC_OK && rl_json_writer->grc == TLOG_RC_OK) {
+            rl_json_writer->grc = grc;
+        }
+        free(msg);
+    }
+    pthread_mutex_unlock(&rl_json_writer->mutex);
+
+    return NULL;
+}
+
+/**
+ * Put a message into the backlog of a rate-limiting writer, evicting
+ * messages according to the policy, and start the backlog writing thread,
+ * if not started yet. Must be called with the mutex locked. Fails with
+ * TLOG_RC_RL_JSON_WRITER_MSG_TOO_LARGE, if the message is larger than the
+ * whole backlog, instead of dropping it silently.
+ *
+ * @param rl_json_writer    The writer to put the message into backlog of.
+ * @param id                ID of the message.
+ * @param iov               The vector of message pieces.
+ * @param iovcnt            Number of pieces in the vector.
+ * @param len               Total length of the message.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_rl_json_writer_backlog(struct tlog_rl_json_writer *rl_json_writer,
+                            size_t id,
+                            const struct iovec *iov, int iovcnt,
+                            size_t len)
+{
+    struct tlog_rl_json_writer_msg *msg;
+    uint8_t *p;
+    int i;
+    int rc;
+
+    /* Refuse messages which would never fit */
+    if (len > rl_json_writer->backlog_size) {
+        return TLOG_RC_RL_JSON_WRITER_MSG_TOO_LARGE;
+    }
+
+    /* Make space, or discard the new message */
+    if (rl_json_writer->backlog_len + len > rl_json_writer->backlog_size) {
+        if (rl_json_writer->evict == TLOG_RL_JSON_WRITER_EVICT_NEWEST) {
+            return TLOG_RC_OK;
+        }
+        while (rl_json_writer->backlog_len + len >
+                rl_json_writer->backlog_size) {
+            msg = rl_json_writer->first;
+            rl_json_writer->first = msg->next;
+            if (rl_json_writer->first == NULL) {
+                rl_json_writer->last = NULL;
+            }
+            rl_json_writer->backlog_len -= msg->len;
+            free(msg);
+        }
+    }
+
+    msg = malloc(sizeof(*msg) + len);
+    if (msg == NULL) {
+        return TLOG_GRC_ERRNO;
+    }
+    msg->next = NULL;
+    msg->id = id;
+    msg->len = len;
+    p = msg->buf;
+    for (i = 0; i < iovcnt; i++) {
+        memcpy(p, iov[i].iov_base, iov[i].iov_len);
+        p += iov[i].iov_len;
+    }
+
+    if (rl_json_writer->last == NULL) {
+        rl_json_writer->first = msg;
+    } else {
+        rl_json_writer->last->next = msg;
+    }
+    rl_json_writer->last = msg;
+    rl_json_writer->backlog_len += len;
+
+    /* Start the thread, blocking all signals in it */
+    if (!rl_json_writer->started) {
+        sigset_t all_set;
+        sigset_t orig_set;
+        sigfillset(&all_set);
+        rc = pthread_sigmask(SIG_SETMASK, &all_set, &orig_set);
+        if (rc != 0) {
+            return TLOG_GRC_FROM(errno, rc);
+        }
+        rc = pthread_create(&rl_json_writer->thread, NULL,
+                            tlog_rl_json_writer_thread, rl_json_writer);
+        pthread_sigmask(SIG_SETMASK, &orig_set, NULL);
+        if (rc != 0) {
+            return TLOG_GRC_FROM(errno, rc);
         }
+        rl_json_writer->started = true;
+    }
+
+    pthread_cond_signal(&rl_json_writer->cond);
+    return TLOG_RC_OK;
+}
+
+/**
+ * Write a message through a rate-limiting writer with the "backlog"
+ * action: write it right away, if it fits and the backlog is empty,
+ * or put it into the backlog otherwise.
+ *
+ * @param rl_json_writer    The writer to write the message to.
+ * @param id                ID of the message.
+ * @param iov               The vector of message pieces.
+ * @param iovcnt            Number of pieces in the vector.
+ * @param len               Total length of the message.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_rl_json_writer_write_or_backlog(
+                            struct tlog_rl_json_writer *rl_json_writer,
+                            size_t id,
+                            const struct iovec *iov, int iovcnt,
+                            size_t len)
+{
+    tlog_grc grc;
+    struct timespec bucket_poured;
+    struct timespec overflow;
+    struct timespec delay;
+    bool taken;
+
+    pthread_mutex_lock(&rl_json_writer->mutex);
+
+    /* Report backlog write failures */
+    grc = rl_json_writer->grc;
+    if (grc != TLOG_RC_OK) {
+        goto cleanup;
+    }
+
+    /*
+     * Keep the order, if there is a backlog already, or its last message
+     * is being written
+     */
+    if (rl_json_writer->first == NULL && !rl_json_writer->writing) {
+        grc = tlog_rl_json_writer_sync(rl_json_writer, len,
+                                       &bucket_poured, &overflow);
+        if (grc != TLOG_RC_OK) {
+            goto cleanup;
+        }
+        taken = !tlog_timespec_is_positive(&overflow);
+        if (taken && rl_json_writer->shared != NULL) {
+            grc = tlog_rl_shared_take(rl_json_writer->shared, len,
+                                      &taken, &delay);
+            if (grc != TLOG_RC_OK) {
+                goto cleanup;
+            }
+        }
+        if (taken) {
+            grc = tlog_rl_json_writer_write_below(rl_json_writer, id,
+                                                  iov, iovcnt);
+            if (grc == TLOG_RC_OK) {
+                rl_json_writer->bucket = bucket_poured;
+            }
+            goto cleanup;
+        }
+    }
+
+    grc = tlog_rl_json_writer_backlog(rl_json_writer, id,
+                                      iov, iovcnt, len);
+
+cleanup:
+    pthread_mutex_unlock(&rl_json_writer->mutex);
+    return grc;
+}
+
+/**
+ * Put the end of a message written by a JSON sink into a buffer, adding
+ * the number of elided output bytes in the "elided" field, if any, and the
+ * number of messages dropped since the last one written in the
+ * "dropped_msgs" field, if any.
+ *
+ * @param rl_json_writer    The writer writing the message.
+ * @param end               The original end part of the message.
+ * @param elided            The number of output bytes elided from the
+ *                          message.
+ * @param buf               The buffer to put the end into, at least
+ *                          TLOG_RL_JSON_WRITER_END_SIZE bytes.
+ * @param pend              Location for the end part to write.
+ */
+static void
+tlog_rl_json_writer_end(const struct tlog_rl_json_writer *rl_json_writer,
+                        const struct iovec *end, size_t elided,
+                        char *buf, struct iovec *pend)
+{
+    /* The closing brace and the newline ending the message */
+    static const size_t close_len = 2;
+    const char *p = (const char *)end->iov_base;
+    size_t len = end->iov_len;
+    int rc;
+
+    assert(len >= close_len);
+    assert(memcmp(p + len - close_len, "}\n", close_len) == 0);
+
+    if (elided == 0 && rl_json_writer->dropped == 0) {
+        *pend = *end;
+        return;
+    }
+
+    /* Insert the fields before the closing brace */
+    rc = snprintf(buf, TLOG_RL_JSON_WRITER_END_SIZE, "%.*s",
+                  (int)(len - close_len), p);
+    if (elided != 0) {
+        rc += snprintf(buf + rc, TLOG_RL_JSON_WRITER_END_SIZE - rc,
+                       ",\"elided\":%zu", elided);
+    }
+    if (rl_json_writer->dropped != 0) {
+        rc += snprintf(buf + rc, TLOG_RL_JSON_WRITER_END_SIZE - rc,
+                       ",\"dropped_msgs\":%zu", rl_json_writer->dropped);
+    }
+    rc += snprintf(buf + rc, TLOG_RL_JSON_WRITER_END_SIZE - rc, "}\n");
+    assert(rc < TLOG_RL_JSON_WRITER_END_SIZE);
+    pend->iov_base = buf;
+    pend->iov_len = (size_t)rc;
+}
+
+/**
+ * Check if a message written by a JSON sink carries input or window
+ * changes, and so can use the reserved part of the limit, once its output
+ * is elided.
+ *
+ * @param iov   The message parts, TLOG_JSON_SINK_MSG_PART_NUM elements.
+ *
+ * @return True if the message carries input or window changes.
+ */
+static bool
+tlog_rl_json_writer_msg_is_reserved(const struct iovec *iov)
+{
+    const struct iovec *timing = &iov[TLOG_JSON_SINK_MSG_PART_TIMING];
+    return iov[TLOG_JSON_SINK_MSG_PART_IN_TXT].iov_len != 0 ||
+           iov[TLOG_JSON_SINK_MSG_PART_IN_BIN].iov_len != 0 ||
+           memchr(timing->iov_base, '=', timing->iov_len) != NULL;
+}
+
+/**
+ * Calculate the total length of a message written in pieces.
+ *
+ * @param iov       The vector of message pieces.
+ * @param iovcnt    Number of pieces in the vector.
+ *
+ * @return The message length, bytes.
+ */
+static size_t
+tlog_rl_json_writer_iov_len(const struct iovec *iov, int iovcnt)
+{
+    size_t len = 0;
+    int i;
+
+    for (i = 0; i < iovcnt; i++) {
+        len += iov[i].iov_len;
+    }
+    return len;
+}
+
+static tlog_grc
+tlog_rl_json_writer_writev(struct tlog_json_writer *writer,
+                           size_t id, const struct iovec *iov, int iovcnt)
+{
+    struct tlog_rl_json_writer *rl_json_writer =
+                                    (struct tlog_rl_json_writer*)writer;
+    tlog_grc grc;
+    bool fits;
+    struct timespec bucket_poured;
+    struct timespec now;
+    size_t len = tlog_rl_json_writer_iov_len(iov, iovcnt);
+
+    if (rl_json_writer->action == TLOG_RL_JSON_WRITER_ACTION_BACKLOG) {
+        return tlog_rl_json_writer_write_or_backlog(rl_json_writer, id,
+                                                    iov, iovcnt, len);
+    }
+
+    grc = tlog_rl_json_writer_fit(rl_json_writer, len, false, &fits,
+                                  &bucket_poured, &now);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+    /*
+     * If not fitting, drop the message, to be counted in the next one
+     * written by a JSON sink. Messages not coming from a JSON sink can't
+     * be degraded.
+     */
+    if (!fits) {
+        rl_json_writer->dropped++;
+        return TLOG_RC_OK;
     }
 
     /*
      * Write the message and pour it into bucket
      */
-    grc = tlog_json_writer_write(rl_json_writer->below, id, buf, len);
+    grc = tlog_rl_json_writer_write_below(rl_json_writer, id, iov, iovcnt);
     if (grc != TLOG_RC_OK) {
         return grc;
     }
@@ -181,10 +872,127 @@ tlog_rl_json_writer_write(struct tlog_json_writer *writer,
     return TLOG_RC_OK;
 }
 
+static tlog_grc
+tlog_rl_json_writer_write_msg(struct tlog_json_writer *writer,
+                              size_t id, const struct iovec *iov)
+{
+    struct tlog_rl_json_writer *rl_json_writer =
+                                    (struct tlog_rl_json_writer*)writer;
+    struct iovec msg_iov[TLOG_JSON_SINK_MSG_PART_NUM];
+    char end_buf[TLOG_RL_JSON_WRITER_END_SIZE];
+    tlog_grc grc;
+    bool reserved;
+    bool fits;
+    struct timespec bucket_poured;
+    struct timespec now;
+
+    /* Only the messages which can be dropped need to be changed */
+    if (rl_json_writer->action != TLOG_RL_JSON_WRITER_ACTION_DROP &&
+        rl_json_writer->action != TLOG_RL_JSON_WRITER_ACTION_DEGRADE) {
+        return tlog_rl_json_writer_writev(writer, id, iov,
+                                          TLOG_JSON_SINK_MSG_PART_NUM);
+    }
+
+    /* Report the messages dropped before */
+    memcpy(msg_iov, iov, sizeof(msg_iov));
+    tlog_rl_json_writer_end(rl_json_writer,
+                            &iov[TLOG_JSON_SINK_MSG_PART_END], 0,
+                            end_buf, &msg_iov[TLOG_JSON_SINK_MSG_PART_END]);
+    grc = tlog_rl_json_writer_fit(
+                    rl_json_writer,
+                    tlog_rl_json_writer_iov_len(msg_iov,
+                                                TLOG_ARRAY_SIZE(msg_iov)),
+                    false, &fits, &bucket_poured, &now);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+
+    /*
+     * If not fitting, and degrading, or carrying input or window changes,
+     * try again with the output data elided, letting the input and window
+     * changes use the reserve
+     */
+    reserved = tlog_rl_json_writer_msg_is_reserved(iov);
+    if (!fits &&
+        (rl_json_writer->action == TLOG_RL_JSON_WRITER_ACTION_DEGRADE ||
+         reserved)) {
+        msg_iov[TLOG_JSON_SINK_MSG_PART_OUT_TXT].iov_len = 0;
+        msg_iov[TLOG_JSON_SINK_MSG_PART_OUT_BIN].iov_len = 0;
+        tlog_rl_json_writer_end(rl_json_writer,
+                                &iov[TLOG_JSON_SINK_MSG_PART_END],
+                                tlog_json_sink_msg_output_size(iov),
+                                end_buf,
+                                &msg_iov[TLOG_JSON_SINK_MSG_PART_END]);
+        grc = tlog_rl_json_writer_fit(
+                        rl_json_writer,
+                        tlog_rl_json_writer_iov_len(msg_iov,
+                                                    TLOG_ARRAY_SIZE(msg_iov)),
+                        reserved, &fits, &bucket_poured, &now);
+        if (grc != TLOG_RC_OK) {
+            return grc;
+        }
+    }
+
+    /* Drop the message, if still not fitting, to be counted in the next */
+    if (!fits) {
+        rl_json_writer->dropped++;
+        return TLOG_RC_OK;
+    }
+
+    grc = tlog_json_writer_write_msg(rl_json_writer->below, id, msg_iov);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+    rl_json_writer->bucket = bucket_poured;
+    rl_json_writer->last_sync = now;
+    rl_json_writer->dropped = 0;
+
+    return TLOG_RC_OK;
+}
+
+static tlog_grc
+tlog_rl_json_writer_write(struct tlog_json_writer *writer,
+                           size_t id, const uint8_t *buf, size_t len)
+{
+    struct iovec iov = {.iov_base = (void *)buf, .iov_len = len};
+    return tlog_rl_json_writer_writev(writer, id, &iov, 1);
+}
+
+static tlog_grc
+tlog_rl_json_writer_flush(struct tlog_json_writer *writer)
+{
+    struct tlog_rl_json_writer *rl_json_writer =
+                                    (struct tlog_rl_json_writer*)writer;
+    tlog_grc grc;
+
+    if (rl_json_writer->action != TLOG_RL_JSON_WRITER_ACTION_BACKLOG) {
+        return tlog_json_writer_flush(rl_json_writer->below);
+    }
+
+    /*
+     * Flush what was written so far, leaving the backlog be, once the
+     * thread is done with the "below" writer
+     */
+    pthread_mutex_lock(&rl_json_writer->mutex);
+    while (rl_json_writer->writing) {
+        pthread_cond_wait(&rl_json_writer->write_cond,
+                          &rl_json_writer->mutex);
+    }
+    grc = rl_json_writer->grc;
+    if (grc == TLOG_RC_OK) {
+        grc = tlog_json_writer_flush(rl_json_writer->below);
+    }
+    pthread_mutex_unlock(&rl_json_writer->mutex);
+    return grc;
+}
+
 const struct tlog_json_writer_type tlog_rl_json_writer_type = {
     .size       = sizeof(struct tlog_rl_json_writer),
     .init       = tlog_rl_json_writer_init,
     .is_valid   = tlog_rl_json_writer_is_valid,
     .cleanup    = tlog_rl_json_writer_cleanup,
     .write      = tlog_rl_json_writer_write,
+    .writev     = tlog_rl_json_writer_writev,
+    .write_msg  = tlog_rl_json_writer_write_msg,
+    .flush      = tlog_rl_json_writer_flush,
 };
@@ -0,0 +1,418 @@
+/*
+ * Shared rate-limiting budget.
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <tlog/rc.h>
+#include <tlog/rl_shared.h>
+
+/** Number of process slots in a shared memory segment */
+#define TLOG_RL_SHARED_SLOT_NUM 1024
+
+/** Minimum interval between counting the processes, nanoseconds */
+#define TLOG_RL_SHARED_COUNT_INTERVAL   1000000000
+
+/*
+ * Shared memory segment contents. Zero-filled, as created, is the valid
+ * initial state: an empty bucket without processes attached.
+ */
+struct tlog_rl_shared_seg {
+    /**
+     * Theoretical arrival time: the monotonic clock time the bucket
+     * becomes empty at, nanoseconds. Accessed atomically.
+     */
+    uint64_t    tat;
+    /**
+     * PIDs of the processes having the budget open, zero for free slots.
+     * Slots of the processes which died without closing the budget are
+     * freed by the others. Accessed atomically.
+     */
+    int32_t     pid_list[TLOG_RL_SHARED_SLOT_NUM];
+};
+
+/**
+ * Get the current time for a shared rate-limiting budget.
+ *
+ * @param pnow  Location for the current monotonic clock time, nanoseconds.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_rl_shared_now(uint64_t *pnow)
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0) {
+        return TLOG_GRC_ERRNO;
+    }
+    *pnow = (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+    return TLOG_RC_OK;
+}
+
+/**
+ * Convert a nanosecond interval to a timespec.
+ *
+ * @param ns    The interval to convert, nanoseconds.
+ * @param pts   Location for the converted interval.
+ */
+static void
+tlog_rl_shared_ns_to_timespec(uint64_t ns, struct timespec *pts)
+{
+    pts->tv_sec = (time_t)(ns / 1000000000);
+    pts->tv_nsec = (long)(ns % 1000000000);
+}
+
+/**
+ * Open the shared memory segment of a shared rate-limiting budget,
+ * creating it, if it doesn't exist. Only trust an existing segment, if
+ * it's owned by the effective user, and is accessible only to them, so
+ * other users can't tamper with the budget.
+ *
+ * @param name  Name of the shared memory segment, as for shm_open(3).
+ * @param pfd   Location for the opened segment FD.
+ *
+ * @return Global return code, TLOG_RC_RL_SHARED_SEG_UNTRUSTED, if the
+ *         existing segment is not trusted.
+ */
+static tlog_grc
+tlog_rl_shared_open(const char *name, int *pfd)
+{
+    tlog_grc grc;
+    struct stat st;
+    int fd;
+
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC,
+                  S_IRUSR | S_IWUSR);
+    if (fd >= 0) {
+        /* Override the umask */
+        if (fchmod(fd, S_IRUSR | S_IWUSR) < 0) {
+            grc = TLOG_GRC_ERRNO;
+            goto error;
+        }
+    } else if (errno == EEXIST) {
+        fd = shm_open(name, O_RDWR | O_NOFOLLOW | O_CLOEXEC, 0);
+        if (fd < 0) {
+            return TLOG_GRC_ERRNO;
+        }
+    } else {
+        return TLOG_GRC_ERRNO;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        grc = TLOG_GRC_ERRNO;
+        goto error;
+    }
+    if (!S_ISREG(st.st_mode) || st.st_uid != geteuid() ||
+        (st.st_mode & (S_IRWXU | S_IRWXG | S_IRWXO)) !=
+            (S_IRUSR | S_IWUSR)) {
+        grc = TLOG_RC_RL_SHARED_SEG_UNTRUSTED;
+        goto error;
+    }
+
+    /* Extend a new segment, zero-filling it, keeping an existing one */
+    if ((size_t)st.st_size < sizeof(struct tlog_rl_shared_seg) &&
+        ftruncate(fd, sizeof(struct tlog_rl_shared_seg)) < 0) {
+        grc = TLOG_GRC_ERRNO;
+        goto error;
+    }
+
+    *pfd = fd;
+    return TLOG_RC_OK;
+
+error:
+    close(fd);
+    return grc;
+}
+
+/**
+ * Check if a process having a shared rate-limiting budget open is alive.
+ *
+ * @param pid   The PID of the process to check.
+ *
+ * @return True if the process is alive, or can't be checked, false if it
+ *         doesn't exist.
+ */
+static bool
+tlog_rl_shared_pid_is_alive(pid_t pid)
+{
+    return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+/**
+ * Count the processes having a shared rate-limiting budget open,
+ * freeing the slots of the dead ones.
+ *
+ * @param shared    The budget to count the processes of.
+ *
+ * @return Number of the processes, at least one.
+ */
+static uint64_t
+tlog_rl_shared_count(struct tlog_rl_shared *shared)
+{
+    uint64_t users = 0;
+    int32_t pid;
+    size_t i;
+
+    for (i = 0; i < TLOG_RL_SHARED_SLOT_NUM; i++) {
+        pid = __atomic_load_n(&shared->seg->pid_list[i], __ATOMIC_ACQUIRE);
+        if (pid == 0) {
+            continue;
+        }
+        if (pid != shared->pid && !tlog_rl_shared_pid_is_alive(pid)) {
+            __atomic_compare_exchange_n(&shared->seg->pid_list[i], &pid, 0,
+                                        false, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_ACQUIRE);
+            continue;
+        }
+        users++;
+    }
+
+    /* Count ourselves, if we didn't get a slot */
+    if (shared->slot >= TLOG_RL_SHARED_SLOT_NUM) {
+        users++;
+    }
+    return users;
+}
+
+/**
+ * Get the number of processes having a shared rate-limiting budget open,
+ * as counted last, recounting them, if counted too long ago.
+ *
+ * @param shared    The budget to get the number of processes of.
+ * @param now       The current monotonic clock time, nanoseconds.
+ *
+ * @return Number of the processes, at least one.
+ */
+static uint64_t
+tlog_rl_shared_users(struct tlog_rl_shared *shared, uint64_t now)
+{
+    if (shared->users == 0 ||
+        now - shared->users_time >= TLOG_RL_SHARED_COUNT_INTERVAL) {
+        shared->users = tlog_rl_shared_count(shared);
+        shared->users_time = now;
+    }
+    return shared->users;
+}
+
+tlog_grc
+tlog_rl_shared_create(struct tlog_rl_shared **pshared,
+                      const char *name,
+                      size_t rate, size_t burst,
+                      enum tlog_rl_shared_fairness fairness)
+{
+    tlog_grc grc;
+    struct tlog_rl_shared *shared = NULL;
+    void *addr;
+    int fd = -1;
+    int32_t pid;
+    size_t i;
+
+    assert(pshared != NULL);
+    assert(rate > 0);
+    assert(tlog_rl_shared_fairness_is_valid(fairness));
+
+    shared = calloc(1, sizeof(*shared));
+    if (shared == NULL) {
+        grc = TLOG_GRC_ERRNO;
+        goto error;
+    }
+    shared->byte_ns = 1000000000.0 / rate;
+    shared->limit_ns = (uint64_t)((double)(rate + burst) * shared->byte_ns);
+    shared->fairness = fairness;
+    shared->pid = getpid();
+    shared->slot = TLOG_RL_SHARED_SLOT_NUM;
+
+    /* Map the named segment, or a private one */
+    if (name != NULL) {
+        grc = tlog_rl_shared_open(name, &fd);
+        if (grc != TLOG_RC_OK) {
+            goto error;
+        }
+        addr = mmap(NULL, sizeof(*shared->seg), PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+    } else {
+        addr = mmap(NULL, sizeof(*shared->seg), PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    }
+    if (addr == MAP_FAILED) {
+        grc = TLOG_GRC_ERRNO;
+        goto error;
+    }
+    shared->seg = addr;
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    /* Take a free slot, or the slot of a dead process, if any */
+    for (i = 0; i < TLOG_RL_SHARED_SLOT_NUM; i++) {
+        pid = __atomic_load_n(&shared->seg->pid_list[i], __ATOMIC_ACQUIRE);
+        if ((pid == 0 || !tlog_rl_shared_pid_is_alive(pid)) &&
+            __atomic_compare_exchange_n(&shared->seg->pid_list[i], &pid,
+                                        shared->pid, false,
+                                        __ATOMIC_ACQ_REL,
+                                        __ATOMIC_ACQUIRE)) {
+            shared->slot = i;
+            break;
+        }
+    }
+
+    assert(tlog_rl_shared_is_valid(shared));
+    *pshared = shared;
+    return TLOG_RC_OK;
+
+error:
+    if (fd >= 0) {
+        close(fd);
+    }
+    free(shared);
+    *pshared = NULL;
+    return grc;
+}
+
+bool
+tlog_rl_shared_is_valid(const struct tlog_rl_shared *shared)
+{
+    return shared != NULL &&
+           shared->seg != NULL &&
+           shared->byte_ns > 0 &&
+           tlog_rl_shared_fairness_is_valid(shared->fairness);
+}
+
+tlog_grc
+tlog_rl_shared_take(struct tlog_rl_shared *shared, size_t len,
+                    bool *ptaken, struct timespec *pdelay)
+{
+    tlog_grc grc;
+    uint64_t now;
+    uint64_t cost;
+    uint64_t users;
+    uint64_t own_tat = 0;
+    uint64_t tat;
+    uint64_t new_tat;
+
+    assert(tlog_rl_shared_is_valid(shared));
+    assert(ptaken != NULL);
+    assert(pdelay != NULL);
+
+    grc = tlog_rl_shared_now(&now);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+    cost = (uint64_t)((double)len * shared->byte_ns);
+
+    /* Check this process' share first, at the current number of them */
+    if (shared->fairness == TLOG_RL_SHARED_FAIRNESS_EQUAL) {
+        users = tlog_rl_shared_users(shared, now);
+        own_tat = shared->own_tat > now ? shared->own_tat : now;
+        if (own_tat > now && own_tat - now + cost * users >
+                                shared->limit_ns) {
+            tlog_rl_shared_ns_to_timespec(
+                own_tat - now + cost * users - shared->limit_ns, pdelay);
+            *ptaken = false;
+            return TLOG_RC_OK;
+        }
+        own_tat += cost * users;
+    }
+
+    /* Pour the bytes into the shared bucket, if they fit */
+    tat = __atomic_load_n(&shared->seg->tat, __ATOMIC_ACQUIRE);
+    do {
+        new_tat = tat > now ? tat : now;
+        if (new_tat > now && new_tat - now + cost > shared->limit_ns) {
+            tlog_rl_shared_ns_to_timespec(
+                new_tat - now + cost - shared->limit_ns, pdelay);
+            *ptaken = false;
+            return TLOG_RC_OK;
+        }
+        new_tat += cost;
+    } while (!__atomic_compare_exchange_n(&shared->seg->tat, &tat, new_tat,
+                                          true, __ATOMIC_ACQ_REL,
+                                          __ATOMIC_ACQUIRE));
+
+    if (shared->fairness == TLOG_RL_SHARED_FAIRNESS_EQUAL) {
+        shared->own_tat = own_tat;
+    }
+    *ptaken = true;
+    return TLOG_RC_OK;
+}
+
+tlog_grc
+tlog_rl_shared_force(struct tlog_rl_shared *shared, size_t len)
+{
+    tlog_grc grc;
+    uint64_t now;
+    uint64_t cost;
+    uint64_t users;
+    uint64_t tat;
+    uint64_t new_tat;
+
+    assert(tlog_rl_shared_is_valid(shared));
+
+    grc = tlog_rl_shared_now(&now);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+    cost = (uint64_t)((double)len * shared->byte_ns);
+
+    if (shared->fairness == TLOG_RL_SHARED_FAIRNESS_EQUAL) {
+        users = tlog_rl_shared_users(shared, now);
+        new_tat = (shared->own_tat > now ? shared->own_tat : now) +
+                  cost * users;
+        shared->own_tat = new_tat - now > shared->limit_ns
+                                ? now + shared->limit_ns
+                                : new_tat;
+    }
+
+    /* Fill the shared bucket up to the limit, or keep it overfilled */
+    tat = __atomic_load_n(&shared->seg->tat, __ATOMIC_ACQUIRE);
+    do {
+        new_tat = (tat > now ? tat : now) + cost;
+        if (new_tat - now > shared->limit_ns) {
+            new_tat = tat > now + shared->limit_ns
+                            ? tat : now + shared->limit_ns;
+        }
+    } while (!__atomic_compare_exchange_n(&shared->seg->tat, &tat, new_tat,
+                                          true, __ATOMIC_ACQ_REL,
+                                          __ATOMIC_ACQUIRE));
+    return TLOG_RC_OK;
+}
+
+void
+tlog_rl_shared_destroy(struct tlog_rl_shared *shared)
+{
+    if (shared == NULL) {
+        return;
+    }
+    assert(tlog_rl_shared_is_valid(shared));
+    if (shared->slot < TLOG_RL_SHARED_SLOT_NUM) {
+        __atomic_store_n(&shared->seg->pid_list[shared->slot], 0,
+                         __ATOMIC_RELEASE);
+    }
+    munmap(shared->seg, sizeof(*shared->seg));
+    free(shared);
+}
@@ -23,6 +23,8 @@
 #include <tlog/sink.h>
 #include <tlog/rc.h>
 #include <assert.h>
+#include <errno.h>
+#include <string.h>
 
 tlog_grc
 tlog_sink_create(struct tlog_sink **psink,
@@ -31,16 +33,21 @@ tlog_sink_create(struct tlog_sink **psink,
 {
     va_list ap;
     tlog_grc grc;
+    void *ptr;
     struct tlog_sink *sink;
+    int rc;
 
     assert(psink != NULL);
     assert(tlog_sink_type_is_valid(type));
     assert(type->size >= sizeof(*sink));
 
-    sink = calloc(type->size, 1);
-    if (sink == NULL) {
-        grc = TLOG_GRC_ERRNO;
+    rc = posix_memalign(&ptr, TLOG_SINK_ALIGN, type->size);
+    if (rc != 0) {
+        sink = NULL;
+        grc = TLOG_GRC_FROM(errno, rc);
     } else {
+        sink = ptr;
+        memset(sink, 0, type->size);
         sink->type = type;
 
         va_start(ap, type);
@@ -109,6 +116,113 @@ tlog_sink_write(struct tlog_sink *sink,
     return grc;
 }
 
+/**
+ * Write a batch of packets to a sink one packet at a time, for sinks
+ * without batch writing support. Stop, if a write makes no progress.
+ *
+ * @param sink      Pointer to the sink to write the packets to.
+ * @param pkt_list  The list of packets to write.
+ * @param pkt_num   Number of packets in the list.
+ * @param pidx      Location of the index of the packet the write should
+ *                  start at / location for the index of the packet the
+ *                  write ended at.
+ * @param ppos      Location of position in the packet the write should
+ *                  start at / location for position in the packet the
+ *                  write ended at.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_sink_write_batch_shim(struct tlog_sink *sink,
+                           const struct tlog_pkt *pkt_list, size_t pkt_num,
+                           size_t *pidx, struct tlog_pkt_pos *ppos)
+{
+    tlog_grc grc;
+    const struct tlog_pkt *pkt;
+    struct tlog_pkt_pos start;
+    struct tlog_pkt_pos end;
+
+    while (*pidx < pkt_num) {
+        pkt = &pkt_list[*pidx];
+        end = TLOG_PKT_POS_VOID;
+        tlog_pkt_pos_move_past(&end, pkt);
+        start = *ppos;
+        grc = sink->type->write(sink, pkt, ppos, &end);
+        if (grc != TLOG_RC_OK) {
+            return grc;
+        }
+        if (tlog_pkt_pos_is_past(ppos, pkt)) {
+            (*pidx)++;
+            *ppos = TLOG_PKT_POS_VOID;
+        } else if (tlog_pkt_pos_cmp(ppos, &start) == 0) {
+            break;
+        }
+    }
+
+    return TLOG_RC_OK;
+}
+
+tlog_grc
+tlog_sink_write_batch(struct tlog_sink *sink,
+                      const struct tlog_pkt *pkt_list, size_t pkt_num,
+                      size_t *pidx, struct tlog_pkt_pos *ppos)
+{
+    tlog_grc grc;
+    tlog_sink_type_write_batch_fn write_batch;
+#ifndef NDEBUG
+    size_t i;
+#endif
+    assert(tlog_sink_is_valid(sink));
+    assert(pkt_list != NULL || pkt_num == 0);
+    assert((pidx == NULL) == (ppos == NULL));
+#ifndef NDEBUG
+    for (i = 0; i < pkt_num; i++) {
+        assert(tlog_pkt_is_valid(&pkt_list[i]));
+        assert(!tlog_pkt_is_void(&pkt_list[i]));
+    }
+#endif
+
+    write_batch = sink->type->write_batch != NULL
+                        ? sink->type->write_batch
+                        : tlog_sink_write_batch_shim;
+
+    if (pidx == NULL) {
+        size_t idx = 0;
+        struct tlog_pkt_pos pos = TLOG_PKT_POS_VOID;
+        do {
+            grc = write_batch(sink, pkt_list, pkt_num, &idx, &pos);
+        } while ((grc == TLOG_RC_OK ||
+                  grc == TLOG_GRC_FROM(errno, EINTR)) &&
+                 idx < pkt_num);
+    } else {
+        assert(*pidx <= pkt_num);
+        assert(*pidx == pkt_num ||
+               (tlog_pkt_pos_is_valid(ppos) &&
+                tlog_pkt_pos_is_compatible(ppos, &pkt_list[*pidx]) &&
+                tlog_pkt_pos_is_in(ppos, &pkt_list[*pidx])));
+        grc = write_batch(sink, pkt_list, pkt_num, pidx, ppos);
+        assert(*pidx <= pkt_num);
+    }
+
+    assert(tlog_sink_is_valid(sink));
+    return grc;
+}
+
+tlog_grc
+tlog_sink_drop(struct tlog_sink *sink, const struct tlog_pkt *pkt)
+{
+    tlog_grc grc;
+    assert(tlog_sink_is_valid(sink));
+    assert(pkt != NULL);
+    assert(pkt->type == TLOG_PKT_TYPE_IO);
+
+    grc = (sink->type->drop != NULL) ? sink->type->drop(sink, pkt)
+                                     : TLOG_RC_OK;
+
+    assert(tlog_sink_is_valid(sink));
+    return grc;
+}
+
 tlog_grc
 tlog_sink_cut(struct tlog_sink *sink)
 {
@@ -123,12 +237,13 @@ tlog_sink_cut(struct tlog_sink *sink)
 }
 
 tlog_grc
-tlog_sink_flush(struct tlog_sink *sink)
+tlog_sink_flush(struct tlog_sink *sink, enum tlog_sink_flush_reason reason)
 {
     tlog_grc grc;
     assert(tlog_sink_is_valid(sink));
+    assert(tlog_sink_flush_reason_is_valid(reason));
 
-    grc = (sink->type->flush != NULL) ? sink->type->flush(sink)
+    grc = (sink->type->flush != NULL) ? sink->type->flush(sink, reason)
                                        : TLOG_RC_OK;
 
     assert(tlog_sink_is_valid(sink));
@@ -127,6 +127,61 @@ tlog_source_read(struct tlog_source *source, struct tlog_pkt *pkt)
     return grc;
 }
 
+tlog_grc
+tlog_source_read_batch(struct tlog_source *source,
+                       struct tlog_pkt *pkt_list, size_t pkt_size,
+                       size_t *ppkt_num)
+{
+    tlog_grc grc;
+#ifndef NDEBUG
+    size_t i;
+    struct timespec diff;
+#endif
+    assert(tlog_source_is_valid(source));
+    assert(pkt_list != NULL);
+    assert(pkt_size > 0);
+    assert(ppkt_num != NULL);
+#ifndef NDEBUG
+    for (i = 0; i < pkt_size; i++) {
+        assert(tlog_pkt_is_valid(&pkt_list[i]));
+        assert(tlog_pkt_is_void(&pkt_list[i]));
+    }
+#endif
+
+    /* Fall back to reading one packet, if batches are not supported */
+    if (source->type->read_batch == NULL) {
+        grc = source->type->read(source, pkt_list);
+        if (grc == TLOG_RC_OK) {
+            *ppkt_num = tlog_pkt_is_void(pkt_list) ? 0 : 1;
+        }
+    } else {
+        grc = source->type->read_batch(source, pkt_list, pkt_size, ppkt_num);
+        assert(grc != TLOG_RC_OK || *ppkt_num <= pkt_size);
+    }
+
+    assert(tlog_source_is_valid(source));
+#ifndef NDEBUG
+    if (grc == TLOG_RC_OK) {
+        for (i = 0; i < *ppkt_num; i++) {
+            assert(!tlog_pkt_is_void(&pkt_list[i]));
+            if (tlog_pkt_is_eof(&pkt_list[i])) {
+                continue;
+            }
+            tlog_timespec_sub(&pkt_list[i].timestamp,
+                              &source->last_timestamp, &diff);
+            assert(tlog_timespec_cmp(&diff, &tlog_timespec_zero) >= 0);
+            assert(tlog_timespec_cmp(&diff, &tlog_delay_max_timespec) <= 0);
+            source->last_timestamp = pkt_list[i].timestamp;
+        }
+    } else {
+        for (i = 0; i < pkt_size; i++) {
+            assert(tlog_pkt_is_void(&pkt_list[i]));
+        }
+    }
+#endif
+    return grc;
+}
+
 void
 tlog_source_destroy(struct tlog_source *source)
 {
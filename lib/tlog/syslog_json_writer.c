@@ -20,39 +20,536 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
-#include <syslog.h>
+#include <config.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <tlog/rc.h>
+#include <tlog/misc.h>
 #include <tlog/syslog_json_writer.h>
 
+/** Identifier to put into message headers */
+#define TLOG_SYSLOG_JSON_WRITER_IDENT   "tlog"
+
+/** Location of a message in the batch buffer */
+struct tlog_syslog_json_writer_msg {
+    size_t  off;    /**< Offset of the message */
+    size_t  len;    /**< Length of the message */
+};
+
 /** Syslog writer data */
 struct tlog_syslog_json_writer {
     struct tlog_json_writer writer;     /**< Abstract writer instance */
-    int                     priority;   /**< Logging priority */
+    enum tlog_syslog_json_writer_format format; /**< Message format */
+    char *path;                         /**< Socket path */
+    int fd;                             /**< Socket FD, -1 if closed */
+    int type;                           /**< Socket type */
+    char prefix_buf[16];                /**< Header part before the
+                                             timestamp */
+    size_t prefix_len;                  /**< Length of prefix_buf */
+    char *suffix_buf;                   /**< Header part after the
+                                             timestamp */
+    size_t suffix_len;                  /**< Length of suffix_buf */
+    time_t time_sec;                    /**< Second the timestamp was
+                                             rendered for last */
+    char time_buf[32];                  /**< Timestamp, up to seconds */
+    size_t time_len;                    /**< Length of time_buf */
+    char zone_buf[8];                   /**< Timezone offset, for the
+                                             RFC5424 format */
+    char *batch_buf;                    /**< Batch buffer */
+    size_t batch_size;                  /**< Batch buffer size */
+    size_t batch_len;                   /**< Batched data length */
+    struct tlog_syslog_json_writer_msg *msg_list;
+                                        /**< Batched message list */
+    struct mmsghdr *mmsg_list;          /**< Message headers to send
+                                             the batch with */
+    struct iovec *iov_list;             /**< I/O vectors to send
+                                             the batch with */
+    size_t msg_size;                    /**< Message list size */
+    size_t msg_num;                     /**< Number of batched messages */
 };
 
+/**
+ * Connect a syslog writer to its socket, closing the previous connection,
+ * if any.
+ *
+ * @param syslog_json_writer    The writer to connect.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_syslog_json_writer_connect(
+                    struct tlog_syslog_json_writer *syslog_json_writer)
+{
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    int type = SOCK_DGRAM;
+    int fd;
+
+    if (syslog_json_writer->fd >= 0) {
+        close(syslog_json_writer->fd);
+        syslog_json_writer->fd = -1;
+    }
+
+    if (strlen(syslog_json_writer->path) >= sizeof(addr.sun_path)) {
+        return TLOG_GRC_FROM(errno, ENAMETOOLONG);
+    }
+    strcpy(addr.sun_path, syslog_json_writer->path);
+
+    /* Try a datagram socket first, and a stream socket next, as syslog(3) */
+    while (true) {
+        fd = socket(AF_UNIX, type | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return TLOG_GRC_ERRNO;
+        }
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            break;
+        }
+        close(fd);
+        if (errno != EPROTOTYPE || type == SOCK_STREAM) {
+            return TLOG_GRC_ERRNO;
+        }
+        type = SOCK_STREAM;
+    }
+
+    syslog_json_writer->fd = fd;
+    syslog_json_writer->type = type;
+    return TLOG_RC_OK;
+}
+
+static void
+tlog_syslog_json_writer_cleanup_batch(
+                    struct tlog_syslog_json_writer *syslog_json_writer)
+{
+    free(syslog_json_writer->iov_list);
+    syslog_json_writer->iov_list = NULL;
+    free(syslog_json_writer->mmsg_list);
+    syslog_json_writer->mmsg_list = NULL;
+    free(syslog_json_writer->msg_list);
+    syslog_json_writer->msg_list = NULL;
+    free(syslog_json_writer->batch_buf);
+    syslog_json_writer->batch_buf = NULL;
+}
+
+/**
+ * Send the batched messages of a syslog writer to its socket,
+ * reconnecting once, if the connection was lost.
+ *
+ * @param syslog_json_writer    The writer to send the messages of.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_syslog_json_writer_send(
+                    struct tlog_syslog_json_writer *syslog_json_writer)
+{
+    tlog_grc grc;
+    bool reconnected = false;
+    size_t i;
+    size_t sent = 0;
+    ssize_t rc;
+
+    /* Reconnect, if failed to before */
+    if (syslog_json_writer->fd < 0) {
+        grc = tlog_syslog_json_writer_connect(syslog_json_writer);
+        if (grc != TLOG_RC_OK) {
+            goto cleanup;
+        }
+        reconnected = true;
+    }
+
+    while (true) {
+        if (syslog_json_writer->type == SOCK_STREAM) {
+            /* Messages are delimited with zeroes, send them at once */
+            while (sent < syslog_json_writer->batch_len) {
+                rc = send(syslog_json_writer->fd,
+                          syslog_json_writer->batch_buf + sent,
+                          syslog_json_writer->batch_len - sent,
+                          MSG_NOSIGNAL);
+                if (rc < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    break;
+                }
+                sent += rc;
+            }
+            if (sent >= syslog_json_writer->batch_len) {
+                break;
+            }
+        } else {
+            /* Send each message as a separate datagram */
+            for (i = 0; i < syslog_json_writer->msg_num; i++) {
+                syslog_json_writer->iov_list[i].iov_base =
+                    syslog_json_writer->batch_buf +
+                    syslog_json_writer->msg_list[i].off;
+                syslog_json_writer->iov_list[i].iov_len =
+                    syslog_json_writer->msg_list[i].len;
+            }
+            while (sent < syslog_json_writer->msg_num) {
+                rc = sendmmsg(syslog_json_writer->fd,
+                              syslog_json_writer->mmsg_list + sent,
+                              syslog_json_writer->msg_num - sent,
+                              MSG_NOSIGNAL);
+                if (rc < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    break;
+                }
+                sent += rc;
+            }
+            if (sent >= syslog_json_writer->msg_num) {
+                break;
+            }
+        }
+
+        /* If the syslog daemon was restarted, reconnect once */
+        if (reconnected ||
+            (errno != ECONNREFUSED && errno != ECONNRESET &&
+             errno != ENOTCONN && errno != EPIPE)) {
+            grc = TLOG_GRC_ERRNO;
+            goto cleanup;
+        }
+        grc = tlog_syslog_json_writer_connect(syslog_json_writer);
+        if (grc != TLOG_RC_OK) {
+            goto cleanup;
+        }
+        reconnected = true;
+        /* Resend whatever didn't reach the daemon */
+        if (syslog_json_writer->type == SOCK_STREAM) {
+            sent = 0;
+        }
+    }
+
+    grc = TLOG_RC_OK;
+cleanup:
+    /* Drop the batch even on failure, to not resend it forever */
+    syslog_json_writer->batch_len = 0;
+    syslog_json_writer->msg_num = 0;
+    return grc;
+}
+
+static void
+tlog_syslog_json_writer_cleanup(struct tlog_json_writer *writer)
+{
+    struct tlog_syslog_json_writer *syslog_json_writer =
+                                    (struct tlog_syslog_json_writer*)writer;
+
+    if (syslog_json_writer->msg_num > 0) {
+        tlog_syslog_json_writer_send(syslog_json_writer);
+    }
+    if (syslog_json_writer->fd >= 0) {
+        close(syslog_json_writer->fd);
+        syslog_json_writer->fd = -1;
+    }
+    tlog_syslog_json_writer_cleanup_batch(syslog_json_writer);
+    free(syslog_json_writer->suffix_buf);
+    syslog_json_writer->suffix_buf = NULL;
+    free(syslog_json_writer->path);
+    syslog_json_writer->path = NULL;
+}
+
 static tlog_grc
 tlog_syslog_json_writer_init(struct tlog_json_writer *writer, va_list ap)
 {
     struct tlog_syslog_json_writer *syslog_json_writer =
                                     (struct tlog_syslog_json_writer*)writer;
-    syslog_json_writer->priority = va_arg(ap, int);
+    const struct tlog_syslog_json_writer_params *params =
+                    va_arg(ap, const struct tlog_syslog_json_writer_params *);
+    char hostname[HOST_NAME_MAX + 1];
+    size_t i;
+    tlog_grc grc;
+    int len;
+
+    assert(tlog_syslog_json_writer_params_is_valid(params));
+
+    syslog_json_writer->fd = -1;
+    syslog_json_writer->format = params->format;
+    syslog_json_writer->time_sec = -1;
+
+    syslog_json_writer->path = strdup(params->path == NULL
+                                        ? TLOG_SYSLOG_JSON_WRITER_PATH_DEFAULT
+                                        : params->path);
+    if (syslog_json_writer->path == NULL) {
+        grc = TLOG_GRC_ERRNO;
+        goto error;
+    }
+
+    /* Render the constant parts of the header */
+    if (params->format == TLOG_SYSLOG_JSON_WRITER_FORMAT_RFC5424) {
+        if (gethostname(hostname, sizeof(hostname)) < 0) {
+            grc = TLOG_GRC_ERRNO;
+            goto error;
+        }
+        hostname[sizeof(hostname) - 1] = '\0';
+        if (hostname[0] == '\0') {
+            strcpy(hostname, "-");
+        }
+        snprintf(syslog_json_writer->prefix_buf,
+                 sizeof(syslog_json_writer->prefix_buf),
+                 "<%d>1 ", params->facility | params->priority);
+        len = asprintf(&syslog_json_writer->suffix_buf,
+                       " %s " TLOG_SYSLOG_JSON_WRITER_IDENT " - - - ",
+                       hostname);
+    } else {
+        snprintf(syslog_json_writer->prefix_buf,
+                 sizeof(syslog_json_writer->prefix_buf),
+                 "<%d>", params->facility | params->priority);
+        len = asprintf(&syslog_json_writer->suffix_buf,
+                       " " TLOG_SYSLOG_JSON_WRITER_IDENT ": ");
+    }
+    if (len < 0) {
+        syslog_json_writer->suffix_buf = NULL;
+        grc = TLOG_GRC_ERRNO;
+        goto error;
+    }
+    syslog_json_writer->prefix_len = strlen(syslog_json_writer->prefix_buf);
+    syslog_json_writer->suffix_len = (size_t)len;
+
+    /* Allocate the batch */
+    syslog_json_writer->msg_size = params->batch > 1 ? params->batch : 1;
+    syslog_json_writer->msg_list =
+            calloc(syslog_json_writer->msg_size,
+                   sizeof(*syslog_json_writer->msg_list));
+    syslog_json_writer->mmsg_list =
+            calloc(syslog_json_writer->msg_size,
+                   sizeof(*syslog_json_writer->mmsg_list));
+    syslog_json_writer->iov_list =
+            calloc(syslog_json_writer->msg_size,
+                   sizeof(*syslog_json_writer->iov_list));
+    if (syslog_json_writer->msg_list == NULL ||
+        syslog_json_writer->mmsg_list == NULL ||
+        syslog_json_writer->iov_list == NULL) {
+        grc = TLOG_GRC_ERRNO;
+        goto error;
+    }
+    for (i = 0; i < syslog_json_writer->msg_size; i++) {
+        syslog_json_writer->mmsg_list[i].msg_hdr.msg_iov =
+                                    &syslog_json_writer->iov_list[i];
+        syslog_json_writer->mmsg_list[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    grc = tlog_syslog_json_writer_connect(syslog_json_writer);
+    if (grc != TLOG_RC_OK) {
+        goto error;
+    }
+
     return TLOG_RC_OK;
+
+error:
+    tlog_syslog_json_writer_cleanup(writer);
+    return grc;
+}
+
+static bool
+tlog_syslog_json_writer_is_valid(const struct tlog_json_writer *writer)
+{
+    struct tlog_syslog_json_writer *syslog_json_writer =
+                                    (struct tlog_syslog_json_writer*)writer;
+    return tlog_syslog_json_writer_format_is_valid(
+                                    syslog_json_writer->format) &&
+           syslog_json_writer->path != NULL &&
+           syslog_json_writer->suffix_buf != NULL &&
+           syslog_json_writer->msg_list != NULL &&
+           syslog_json_writer->mmsg_list != NULL &&
+           syslog_json_writer->iov_list != NULL &&
+           syslog_json_writer->msg_num < syslog_json_writer->msg_size &&
+           syslog_json_writer->batch_len <= syslog_json_writer->batch_size;
 }
 
+/**
+ * Render the timestamp of a syslog writer for the current second, if not
+ * rendered yet.
+ *
+ * @param syslog_json_writer    The writer to render the timestamp for.
+ * @param ts                    The current time.
+ *
+ * @return Global return code.
+ */
 static tlog_grc
-tlog_syslog_json_writer_write(struct tlog_json_writer *writer,
-                              size_t id, const uint8_t *buf, size_t len)
+tlog_syslog_json_writer_render_time(
+                    struct tlog_syslog_json_writer *syslog_json_writer,
+                    const struct timespec *ts)
+{
+    /* Month names, independent of the locale, as in syslog(3) */
+    static const char *month_list[] = {
+        "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+    };
+    struct tm tm;
+    int off;
+
+    if (ts->tv_sec == syslog_json_writer->time_sec) {
+        return TLOG_RC_OK;
+    }
+    if (localtime_r(&ts->tv_sec, &tm) == NULL) {
+        return TLOG_GRC_ERRNO;
+    }
+
+    if (syslog_json_writer->format == TLOG_SYSLOG_JSON_WRITER_FORMAT_RFC5424) {
+        syslog_json_writer->time_len =
+            snprintf(syslog_json_writer->time_buf,
+                     sizeof(syslog_json_writer->time_buf),
+                     "%04d-%02d-%02dT%02d:%02d:%02d",
+                     tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                     tm.tm_hour, tm.tm_min, tm.tm_sec);
+        off = (int)(tm.tm_gmtoff / 60);
+        snprintf(syslog_json_writer->zone_buf,
+                 sizeof(syslog_json_writer->zone_buf),
+                 "%c%02u:%02u",
+                 off < 0 ? '-' : '+',
+                 (unsigned int)abs(off) / 60 % 100,
+                 (unsigned int)abs(off) % 60);
+    } else {
+        syslog_json_writer->time_len =
+            snprintf(syslog_json_writer->time_buf,
+                     sizeof(syslog_json_writer->time_buf),
+                     "%s %2d %02d:%02d:%02d",
+                     month_list[tm.tm_mon], tm.tm_mday,
+                     tm.tm_hour, tm.tm_min, tm.tm_sec);
+    }
+
+    syslog_json_writer->time_sec = ts->tv_sec;
+    return TLOG_RC_OK;
+}
+
+/**
+ * Append a piece of data to the batch buffer of a syslog writer.
+ * The buffer must have enough space.
+ *
+ * @param syslog_json_writer    The writer to append to.
+ * @param ptr                   The data to append.
+ * @param len                   The length of the data to append.
+ */
+static void
+tlog_syslog_json_writer_append(
+                    struct tlog_syslog_json_writer *syslog_json_writer,
+                    const void *ptr, size_t len)
+{
+    assert(syslog_json_writer->batch_len + len <=
+           syslog_json_writer->batch_size);
+    memcpy(syslog_json_writer->batch_buf + syslog_json_writer->batch_len,
+           ptr, len);
+    syslog_json_writer->batch_len += len;
+}
+
+static tlog_grc
+tlog_syslog_json_writer_writev(struct tlog_json_writer *writer,
+                               size_t id,
+                               const struct iovec *iov,
+                               int iovcnt)
 {
     struct tlog_syslog_json_writer *syslog_json_writer =
                                     (struct tlog_syslog_json_writer*)writer;
+    struct tlog_syslog_json_writer_msg *msg;
+    struct timespec ts;
+    char frac_buf[16];
+    size_t frac_len = 0;
+    size_t len;
+    size_t size;
+    char *buf;
+    tlog_grc grc;
+    int i;
+
     (void)id;
-    syslog(syslog_json_writer->priority, "%.*s",
-           (int)len, (const char *)buf);
+
+    if (clock_gettime(CLOCK_REALTIME, &ts) < 0) {
+        return TLOG_GRC_ERRNO;
+    }
+    grc = tlog_syslog_json_writer_render_time(syslog_json_writer, &ts);
+    if (grc != TLOG_RC_OK) {
+        return grc;
+    }
+    if (syslog_json_writer->format == TLOG_SYSLOG_JSON_WRITER_FORMAT_RFC5424) {
+        frac_len = snprintf(frac_buf, sizeof(frac_buf), ".%06ld%s",
+                            ts.tv_nsec / 1000,
+                            syslog_json_writer->zone_buf);
+    }
+
+    /* Make sure the message fits the buffer */
+    len = syslog_json_writer->prefix_len + syslog_json_writer->time_len +
+          frac_len + syslog_json_writer->suffix_len + 1;
+    for (i = 0; i < iovcnt; i++) {
+        len += iov[i].iov_len;
+    }
+    if (syslog_json_writer->batch_len + len > syslog_json_writer->batch_size) {
+        size = syslog_json_writer->batch_size;
+        if (size == 0) {
+            size = 4096;
+        }
+        while (size < syslog_json_writer->batch_len + len) {
+            size *= 2;
+        }
+        buf = realloc(syslog_json_writer->batch_buf, size);
+        if (buf == NULL) {
+            return TLOG_GRC_ERRNO;
+        }
+        syslog_json_writer->batch_buf = buf;
+        syslog_json_writer->batch_size = size;
+    }
+
+    /* Assemble the message in the buffer */
+    msg = &syslog_json_writer->msg_list[syslog_json_writer->msg_num];
+    msg->off = syslog_json_writer->batch_len;
+    tlog_syslog_json_writer_append(syslog_json_writer,
+                                   syslog_json_writer->prefix_buf,
+                                   syslog_json_writer->prefix_len);
+    tlog_syslog_json_writer_append(syslog_json_writer,
+                                   syslog_json_writer->time_buf,
+                                   syslog_json_writer->time_len);
+    tlog_syslog_json_writer_append(syslog_json_writer, frac_buf, frac_len);
+    tlog_syslog_json_writer_append(syslog_json_writer,
+                                   syslog_json_writer->suffix_buf,
+                                   syslog_json_writer->suffix_len);
+    for (i = 0; i < iovcnt; i++) {
+        tlog_syslog_json_writer_append(syslog_json_writer,
+                                       iov[i].iov_base, iov[i].iov_len);
+    }
+    /* Stream sockets need a delimiter */
+    if (syslog_json_writer->type == SOCK_STREAM) {
+        tlog_syslog_json_writer_append(syslog_json_writer, "", 1);
+    }
+    msg->len = syslog_json_writer->batch_len - msg->off;
+    syslog_json_writer->msg_num++;
+
+    /* Send the batch, if full */
+    if (syslog_json_writer->msg_num >= syslog_json_writer->msg_size) {
+        return tlog_syslog_json_writer_send(syslog_json_writer);
+    }
     return TLOG_RC_OK;
 }
 
+static tlog_grc
+tlog_syslog_json_writer_write(struct tlog_json_writer *writer,
+                              size_t id, const uint8_t *buf, size_t len)
+{
+    struct iovec iov = {.iov_base = (void *)buf, .iov_len = len};
+    return tlog_syslog_json_writer_writev(writer, id, &iov, 1);
+}
+
+static tlog_grc
+tlog_syslog_json_writer_flush(struct tlog_json_writer *writer)
+{
+    struct tlog_syslog_json_writer *syslog_json_writer =
+                                    (struct tlog_syslog_json_writer*)writer;
+    if (syslog_json_writer->msg_num == 0) {
+        return TLOG_RC_OK;
+    }
+    return tlog_syslog_json_writer_send(syslog_json_writer);
+}
+
 const struct tlog_json_writer_type tlog_syslog_json_writer_type = {
-    .size   = sizeof(struct tlog_syslog_json_writer),
-    .init   = tlog_syslog_json_writer_init,
-    .write  = tlog_syslog_json_writer_write,
+    .size       = sizeof(struct tlog_syslog_json_writer),
+    .init       = tlog_syslog_json_writer_init,
+    .cleanup    = tlog_syslog_json_writer_cleanup,
+    .is_valid   = tlog_syslog_json_writer_is_valid,
+    .write      = tlog_syslog_json_writer_write,
+    .writev     = tlog_syslog_json_writer_writev,
+    .flush      = tlog_syslog_json_writer_flush,
 };
@@ -146,7 +146,7 @@ tlog_tap_setup(struct tlog_errs **perrs,
                uid_t euid, gid_t egid,
                unsigned int opts, const char *path, char **argv,
                int in_fd, int out_fd, int err_fd,
-               clockid_t clock_id)
+               unsigned int pass, clockid_t clock_id)
 {
     tlog_grc grc;
     struct tlog_tap tap = TLOG_TAP_VOID;
@@ -277,8 +277,32 @@ tlog_tap_setup(struct tlog_errs **perrs,
                           "the privileges are escalated");
     }
 
-    /* Create the TTY source */
-    grc = tlog_tty_source_create(&tap.source, in_fd, tap.out_fd,
+    /*
+     * Pass the input through, if asked, and it can be waited for, without
+     * waiting for the child to accept it, as the child could be waiting
+     * for its output to be read
+     */
+    if ((pass & TLOG_TAP_PASS_IN) && in_fd >= 0 && tap.in_fd >= 0) {
+        grc = tlog_pass_init(&tap.in_pass, in_fd, tap.in_fd, false);
+        if (grc != TLOG_RC_OK && grc != TLOG_GRC_FROM(errno, EPERM)) {
+            TLOG_ERRS_RAISECS(grc, "Failed creating input pass-through");
+        }
+    }
+
+    /* Pass the output through, if asked, waiting for it to be accepted */
+    if ((pass & TLOG_TAP_PASS_OUT) && out_fd >= 0 && tap.out_fd >= 0) {
+        grc = tlog_pass_init(&tap.out_pass, tap.out_fd, out_fd, true);
+        if (grc != TLOG_RC_OK) {
+            TLOG_ERRS_RAISECS(grc, "Failed creating output pass-through");
+        }
+    }
+
+    /* Create the TTY source, reading the streams not passed through */
+    grc = tlog_tty_source_create(&tap.source,
+                                 tlog_pass_is_void(&tap.in_pass)
+                                    ? in_fd : -1,
+                                 tlog_pass_is_void(&tap.out_pass)
+                                    ? tap.out_fd : -1,
                                  tap.tty_fd, 4096, clock_id);
     if (grc != TLOG_RC_OK) {
         TLOG_ERRS_RAISECS(grc, "Failed creating TTY source");
@@ -334,6 +358,8 @@ tlog_tap_teardown(struct tlog_errs **perrs,
 
     assert(tap != NULL);
 
+    tlog_pass_cleanup(&tap->in_pass);
+    tlog_pass_cleanup(&tap->out_pass);
     tlog_sink_destroy(tap->sink);
     tap->sink = NULL;
     tlog_source_destroy(tap->source);
@@ -29,10 +29,14 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <tlog/rc.h>
 #include <tlog/misc.h>
 #include <tlog/tty_sink.h>
 
+/** Maximum number of I/O packets written with one writev(2) call */
+#define TLOG_TTY_SINK_IOV_SIZE  16
+
 /** TTY sink instance */
 struct tlog_tty_sink {
     struct tlog_sink        sink;       /**< Abstract sink instance */
@@ -86,6 +90,37 @@ tlog_tty_sink_init(struct tlog_sink *sink, va_list ap)
     return TLOG_RC_OK;
 }
 
+/**
+ * Set the window size of a TTY sink from a window packet, if changed.
+ *
+ * @param tty_sink  The TTY sink to set the window size of.
+ * @param pkt       The window packet to set the size from.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_tty_sink_write_window(struct tlog_tty_sink *tty_sink,
+                           const struct tlog_pkt *pkt)
+{
+    struct winsize win = {.ws_col = pkt->data.window.width,
+                          .ws_row = pkt->data.window.height};
+
+    assert(pkt->type == TLOG_PKT_TYPE_WINDOW);
+    assert(tty_sink->win_fd >= 0);
+
+    if (tty_sink->got_win &&
+        win.ws_col == tty_sink->last_win.ws_col &&
+        win.ws_row == tty_sink->last_win.ws_row) {
+        return TLOG_RC_OK;
+    }
+    if (ioctl(tty_sink->win_fd, TIOCSWINSZ, &win) < 0) {
+        return TLOG_GRC_ERRNO;
+    }
+    tty_sink->last_win = win;
+    tty_sink->got_win = true;
+    return TLOG_RC_OK;
+}
+
 static tlog_grc
 tlog_tty_sink_write(struct tlog_sink *sink,
                     const struct tlog_pkt *pkt,
@@ -94,6 +129,7 @@ tlog_tty_sink_write(struct tlog_sink *sink,
 {
     struct tlog_tty_sink *tty_sink =
                                 (struct tlog_tty_sink *)sink;
+    tlog_grc grc;
 
     if (tlog_pkt_pos_cmp(ppos, end) >= 0) {
         return TLOG_RC_OK;
@@ -101,18 +137,10 @@ tlog_tty_sink_write(struct tlog_sink *sink,
 
     if (pkt->type == TLOG_PKT_TYPE_WINDOW) {
         if (tty_sink->win_fd >= 0) {
-            struct winsize win = {.ws_col = pkt->data.window.width,
-                                  .ws_row = pkt->data.window.height};
-            if (tty_sink->got_win &&
-                win.ws_col == tty_sink->last_win.ws_col &&
-                win.ws_row == tty_sink->last_win.ws_row) {
-                return TLOG_RC_OK;
-            }
-            if (ioctl(tty_sink->win_fd, TIOCSWINSZ, &win) < 0) {
-                return TLOG_GRC_ERRNO;
+            grc = tlog_tty_sink_write_window(tty_sink, pkt);
+            if (grc != TLOG_RC_OK) {
+                return grc;
             }
-            tty_sink->last_win = win;
-            tty_sink->got_win = true;
             tlog_pkt_pos_move_past(ppos, pkt);
         }
     } else if (pkt->type == TLOG_PKT_TYPE_IO) {
@@ -132,11 +160,103 @@ tlog_tty_sink_write(struct tlog_sink *sink,
     return TLOG_RC_OK;
 }
 
+/**
+ * Write a batch of packets to a TTY sink, setting window sizes as they
+ * come, and gathering data of consecutive I/O packets of the same
+ * direction into a single writev(2) call. Packets for closed FDs are
+ * skipped.
+ */
+static tlog_grc
+tlog_tty_sink_write_batch(struct tlog_sink *sink,
+                          const struct tlog_pkt *pkt_list, size_t pkt_num,
+                          size_t *pidx, struct tlog_pkt_pos *ppos)
+{
+    struct tlog_tty_sink *tty_sink =
+                                (struct tlog_tty_sink *)sink;
+    struct iovec iov[TLOG_TTY_SINK_IOV_SIZE];
+    const struct tlog_pkt *pkt;
+    tlog_grc grc;
+    size_t iov_num;
+    size_t len;
+    size_t i;
+    ssize_t rc;
+    bool output;
+    int fd;
+
+    while (*pidx < pkt_num) {
+        pkt = &pkt_list[*pidx];
+
+        if (pkt->type == TLOG_PKT_TYPE_WINDOW) {
+            if (tty_sink->win_fd >= 0) {
+                grc = tlog_tty_sink_write_window(tty_sink, pkt);
+                if (grc != TLOG_RC_OK) {
+                    return grc;
+                }
+            }
+            (*pidx)++;
+            *ppos = TLOG_PKT_POS_VOID;
+            continue;
+        }
+
+        assert(pkt->type == TLOG_PKT_TYPE_IO);
+        output = pkt->data.io.output;
+        fd = output ? tty_sink->out_fd : tty_sink->in_fd;
+
+        /* Gather the rest of this and the following packets' data */
+        iov_num = 0;
+        for (i = *pidx;
+             i < pkt_num && iov_num < TLOG_ARRAY_SIZE(iov) &&
+             pkt_list[i].type == TLOG_PKT_TYPE_IO &&
+             pkt_list[i].data.io.output == output;
+             i++) {
+            len = pkt_list[i].data.io.len;
+            if (i == *pidx) {
+                iov[iov_num].iov_base = pkt_list[i].data.io.buf + ppos->val;
+                iov[iov_num].iov_len = len - ppos->val;
+            } else {
+                iov[iov_num].iov_base = pkt_list[i].data.io.buf;
+                iov[iov_num].iov_len = len;
+            }
+            if (iov[iov_num].iov_len > 0) {
+                iov_num++;
+            }
+        }
+
+        /* Skip the packets, if their FD is closed or they're empty */
+        if (fd < 0 || iov_num == 0) {
+            *pidx = i;
+            *ppos = TLOG_PKT_POS_VOID;
+            continue;
+        }
+
+        rc = writev(fd, iov, iov_num);
+        if (rc < 0) {
+            return TLOG_GRC_ERRNO;
+        }
+
+        /* Move past the data written */
+        while (rc > 0) {
+            pkt = &pkt_list[*pidx];
+            len = pkt->data.io.len - ppos->val;
+            if ((size_t)rc < len) {
+                tlog_pkt_pos_move(ppos, pkt, rc);
+                break;
+            }
+            rc -= len;
+            (*pidx)++;
+            *ppos = TLOG_PKT_POS_VOID;
+        }
+    }
+
+    return TLOG_RC_OK;
+}
+
 const struct tlog_sink_type tlog_tty_sink_type = {
     .size       = sizeof(struct tlog_tty_sink),
     .init       = tlog_tty_sink_init,
     .cleanup    = tlog_tty_sink_cleanup,
     .is_valid   = tlog_tty_sink_is_valid,
     .write      = tlog_tty_sink_write,
+    .write_batch = tlog_tty_sink_write_batch,
     .io_close   = tlog_tty_sink_io_close,
 };
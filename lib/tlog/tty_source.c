@@ -25,47 +25,73 @@
 #include <string.h>
 #include <errno.h>
 #include <signal.h>
-#include <poll.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
+#include <sys/signalfd.h>
 #include <tlog/rc.h>
 #include <tlog/timespec.h>
 #include <tlog/misc.h>
 #include <tlog/tty_source.h>
 
-/** Number of WINCH signals caught */
-static volatile sig_atomic_t tlog_tty_source_sig = 0;
-
-/** SIGWINCH handler */
-static void
-tlog_tty_source_winch_sighandler(int signum)
-{
-    (void)signum;
-    tlog_tty_source_sig++;
-}
-
-/** FD index */
+/** FD index, also used as epoll event data */
 enum tlog_tty_source_fd_idx {
     TLOG_TTY_SOURCE_FD_IDX_IN,
     TLOG_TTY_SOURCE_FD_IDX_OUT,
     TLOG_TTY_SOURCE_FD_IDX_NUM
 };
 
+/** Epoll event data of the SIGWINCH signalfd */
+#define TLOG_TTY_SOURCE_EV_WINCH    TLOG_TTY_SOURCE_FD_IDX_NUM
+
+/** Epoll event data of the eventfd standing in for unpollable FDs */
+#define TLOG_TTY_SOURCE_EV_READY    (TLOG_TTY_SOURCE_FD_IDX_NUM + 1)
+
+/** Period of refreshing the offset of the real time from the clock */
+static const struct timespec tlog_tty_source_real_sync_period = {1, 0};
+
 /** TTY source instance */
 struct tlog_tty_source {
     struct tlog_source      source;     /**< Abstract source instance */
     clockid_t               clock_id;   /**< Clock to use for timestamps */
-    struct sigaction        orig_sa;    /**< Original SIGWINCH sigaction */
-    size_t                  io_size;    /**< Size of I/O buffer */
-    uint8_t                *io_buf;     /**< Pointer to I/O buffer */
-    struct pollfd           fd_list[TLOG_TTY_SOURCE_FD_IDX_NUM];
-    size_t                  fd_idx;     /**< Index of FD read last */
+    size_t                  io_size;    /**< Size of I/O buffer per FD */
+    uint8_t                *io_buf;     /**< Pointer to I/O buffers of all
+                                             FDs, one after another */
+    int                     fd_list[TLOG_TTY_SOURCE_FD_IDX_NUM];
+                                        /**< I/O FDs, negative if closed */
+    bool                    unpolled_list[TLOG_TTY_SOURCE_FD_IDX_NUM];
+                                        /**< True for FDs epoll cannot
+                                             watch, e.g. regular files,
+                                             which are always ready */
+    size_t                  unpolled_num;   /**< Number of open
+                                                 unpolled FDs */
+    int                     epoll_fd;   /**< Epoll FD watching the I/O
+                                             FDs and the signalfd */
+    int                     ready_fd;   /**< Eventfd kept readable while
+                                             there are unpolled FDs open,
+                                             negative if not created */
     int                     win_fd;     /**< Window size source FD */
+    int                     sig_fd;     /**< SIGWINCH signalfd, negative
+                                             if not created */
+    bool                    winch_blocked;  /**< True if SIGWINCH was
+                                                 blocked by the source */
     bool                    started;    /**< True if read */
     struct timespec         start_ts;   /**< First read timestamp */
-    sig_atomic_t            last_sig;   /**< Last SIGWINCH number */
+    struct timespec         real_offset;    /**< Real time minus clock
+                                                 time, as of real_sync_ts */
+    struct timespec         real_sync_ts;   /**< Clock time the real time
+                                                 offset was taken at */
     struct winsize          last_win;   /**< Last window size */
+    struct tlog_pkt         pkt_list[TLOG_TTY_SOURCE_BATCH_SIZE];
+                                        /**< Packets read on the last
+                                             wakeup, referencing the
+                                             I/O buffers */
+    size_t                  pkt_idx;    /**< Index of the first packet
+                                             not returned yet */
+    size_t                  pkt_num;    /**< Number of packets read */
 };
 
 static bool
@@ -76,8 +102,8 @@ tlog_tty_source_is_valid(const struct tlog_source *source)
     return tty_source != NULL &&
            tty_source->io_size >= TLOG_TTY_SOURCE_IO_SIZE_MIN &&
            tty_source->io_buf != NULL &&
-           tty_source->fd_list[TLOG_TTY_SOURCE_FD_IDX_IN].events == POLLIN &&
-           tty_source->fd_list[TLOG_TTY_SOURCE_FD_IDX_OUT].events == POLLIN;
+           tty_source->epoll_fd >= 0 &&
+           (tty_source->win_fd < 0 || tty_source->sig_fd >= 0);
 }
 
 static void
@@ -86,16 +112,99 @@ tlog_tty_source_cleanup(struct tlog_source *source)
     struct tlog_tty_source *tty_source =
                                 (struct tlog_tty_source *)source;
     assert(tty_source != NULL);
-    if (tty_source->win_fd >= 0) {
-        /* Restore WINCH sigaction */
-        sigaction(SIGWINCH, &tty_source->orig_sa, NULL);
-        /* Leave the duty of window size retrieval */
-        tty_source->win_fd = -1;
+    if (tty_source->sig_fd >= 0) {
+        close(tty_source->sig_fd);
+        tty_source->sig_fd = -1;
+    }
+    if (tty_source->winch_blocked) {
+        sigset_t set;
+        /* Unblock SIGWINCH, delivering the pending one, if any */
+        sigemptyset(&set);
+        sigaddset(&set, SIGWINCH);
+        pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+        tty_source->winch_blocked = false;
+    }
+    /* Leave the duty of window size retrieval */
+    tty_source->win_fd = -1;
+    if (tty_source->ready_fd >= 0) {
+        close(tty_source->ready_fd);
+        tty_source->ready_fd = -1;
+    }
+    if (tty_source->epoll_fd >= 0) {
+        close(tty_source->epoll_fd);
+        tty_source->epoll_fd = -1;
     }
     free(tty_source->io_buf);
     tty_source->io_buf = NULL;
 }
 
+/**
+ * Start watching an I/O FD of a TTY source for readiness. If epoll cannot
+ * watch the FD, e.g. because it's a regular file, consider it always ready,
+ * and keep an eventfd in the epoll set readable instead.
+ *
+ * @param tty_source    The TTY source to watch the FD of.
+ * @param idx           The index of the FD to watch.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+tlog_tty_source_watch(struct tlog_tty_source *tty_source,
+                      enum tlog_tty_source_fd_idx idx)
+{
+    struct epoll_event ev = {.events = EPOLLIN, .data.u32 = idx};
+
+    if (epoll_ctl(tty_source->epoll_fd, EPOLL_CTL_ADD,
+                  tty_source->fd_list[idx], &ev) == 0) {
+        return TLOG_RC_OK;
+    }
+    if (errno != EPERM) {
+        return TLOG_GRC_ERRNO;
+    }
+
+    /* Create the eventfd, readable until closed, if not yet */
+    if (tty_source->ready_fd < 0) {
+        tty_source->ready_fd = eventfd(1, EFD_CLOEXEC);
+        if (tty_source->ready_fd < 0) {
+            return TLOG_GRC_ERRNO;
+        }
+    }
+    if (tty_source->unpolled_num == 0) {
+        ev.data.u32 = TLOG_TTY_SOURCE_EV_READY;
+        if (epoll_ctl(tty_source->epoll_fd, EPOLL_CTL_ADD,
+                      tty_source->ready_fd, &ev) < 0) {
+            return TLOG_GRC_ERRNO;
+        }
+    }
+    tty_source->unpolled_list[idx] = true;
+    tty_source->unpolled_num++;
+    return TLOG_RC_OK;
+}
+
+/**
+ * Stop watching a closed I/O FD of a TTY source and forget it.
+ *
+ * @param tty_source    The TTY source to unwatch the FD of.
+ * @param idx           The index of the FD to unwatch.
+ */
+static void
+tlog_tty_source_unwatch(struct tlog_tty_source *tty_source,
+                        enum tlog_tty_source_fd_idx idx)
+{
+    if (tty_source->unpolled_list[idx]) {
+        tty_source->unpolled_list[idx] = false;
+        tty_source->unpolled_num--;
+        if (tty_source->unpolled_num == 0) {
+            epoll_ctl(tty_source->epoll_fd, EPOLL_CTL_DEL,
+                      tty_source->ready_fd, NULL);
+        }
+    } else {
+        epoll_ctl(tty_source->epoll_fd, EPOLL_CTL_DEL,
+                  tty_source->fd_list[idx], NULL);
+    }
+    tty_source->fd_list[idx] = -1;
+}
+
 static tlog_grc
 tlog_tty_source_init(struct tlog_source *source, va_list ap)
 {
@@ -107,41 +216,70 @@ tlog_tty_source_init(struct tlog_source *source, va_list ap)
     int win_fd = va_arg(ap, int);
     int io_size = va_arg(ap, size_t);
     clockid_t clock_id = va_arg(ap, clockid_t);
+    size_t i;
 
     assert(io_size >= TLOG_TTY_SOURCE_IO_SIZE_MIN);
 
-    tty_source->fd_list[TLOG_TTY_SOURCE_FD_IDX_IN].fd = in_fd;
-    tty_source->fd_list[TLOG_TTY_SOURCE_FD_IDX_IN].events = POLLIN;
-    tty_source->fd_list[TLOG_TTY_SOURCE_FD_IDX_OUT].fd = out_fd;
-    tty_source->fd_list[TLOG_TTY_SOURCE_FD_IDX_OUT].events = POLLIN;
-
-    /* Non-existing FD was read last */
-    tty_source->fd_idx = SIZE_MAX;
+    tty_source->fd_list[TLOG_TTY_SOURCE_FD_IDX_IN] = in_fd;
+    tty_source->fd_list[TLOG_TTY_SOURCE_FD_IDX_OUT] = out_fd;
+    tty_source->epoll_fd = -1;
+    tty_source->ready_fd = -1;
+    tty_source->sig_fd = -1;
 
     /* Don't commit to getting window sizes yet */
     tty_source->win_fd = -1;
 
     tty_source->clock_id = clock_id;
     tty_source->io_size = io_size;
-    tty_source->io_buf = malloc(io_size);
+    tty_source->io_buf = malloc(io_size * TLOG_TTY_SOURCE_FD_IDX_NUM);
     if (tty_source->io_buf == NULL) {
         grc = TLOG_GRC_ERRNO;
         goto error;
     }
 
+    /* Watch the I/O FDs */
+    tty_source->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (tty_source->epoll_fd < 0) {
+        grc = TLOG_GRC_ERRNO;
+        goto error;
+    }
+    for (i = 0; i < TLOG_ARRAY_SIZE(tty_source->fd_list); i++) {
+        if (tty_source->fd_list[i] >= 0) {
+            grc = tlog_tty_source_watch(tty_source, i);
+            if (grc != TLOG_RC_OK) {
+                goto error;
+            }
+        }
+    }
+
     /* If asked to transfer window size changes */
     if (win_fd >= 0) {
-        struct sigaction sa;
-        /* Setup WINCH signal handler */
-        sa.sa_handler = tlog_tty_source_winch_sighandler;
-        sigemptyset(&sa.sa_mask);
-        /* NOTE: no SA_RESTART on purpose */
-        sa.sa_flags = 0;
-        if (sigaction(SIGWINCH, &sa, &tty_source->orig_sa) < 0) {
+        sigset_t set;
+        sigset_t orig_set;
+        struct epoll_event ev = {.events = EPOLLIN,
+                                 .data.u32 = TLOG_TTY_SOURCE_EV_WINCH};
+        int rc;
+
+        /* Receive SIGWINCH via a signalfd, instead of a handler */
+        sigemptyset(&set);
+        sigaddset(&set, SIGWINCH);
+        rc = pthread_sigmask(SIG_BLOCK, &set, &orig_set);
+        if (rc != 0) {
+            grc = TLOG_GRC_FROM(errno, rc);
+            goto error;
+        }
+        tty_source->winch_blocked = !sigismember(&orig_set, SIGWINCH);
+        tty_source->sig_fd = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (tty_source->sig_fd < 0) {
+            grc = TLOG_GRC_ERRNO;
+            goto error;
+        }
+        if (epoll_ctl(tty_source->epoll_fd, EPOLL_CTL_ADD,
+                      tty_source->sig_fd, &ev) < 0) {
             grc = TLOG_GRC_ERRNO;
             goto error;
         }
-        /* Accept the duty and mark sigaction saved */
+        /* Accept the duty */
         tty_source->win_fd = win_fd;
     }
 
@@ -151,6 +289,16 @@ error:
     return grc;
 }
 
+int
+tlog_tty_source_get_fd(const struct tlog_source *source)
+{
+    struct tlog_tty_source *tty_source =
+                                (struct tlog_tty_source *)source;
+    assert(tlog_source_is_valid(source));
+    assert(source->type == &tlog_tty_source_type);
+    return tty_source->epoll_fd;
+}
+
 static size_t
 tlog_tty_source_loc_get(const struct tlog_source *source)
 {
@@ -180,16 +328,16 @@ tlog_tty_source_loc_fmt(const struct tlog_source *source, size_t loc)
 /**
  * Return true if any TTY source FDs are active, otherwise false
  *
- * @param fds       FD list pointer.
+ * @param tty_source    The TTY source to check the FDs of.
  *
  * @return True if any TTY source FDs are active, false if all FDs are inactive.
  *
  */
 static bool
-tlog_tty_source_fds_active(struct pollfd *fds)
+tlog_tty_source_fds_active(const struct tlog_tty_source *tty_source)
 {
     for (int i = 0; i < TLOG_TTY_SOURCE_FD_IDX_NUM; i++) {
-        if (fds[i].fd >= 0) {
+        if (tty_source->fd_list[i] >= 0) {
             return true;
         }
     }
@@ -198,148 +346,248 @@ tlog_tty_source_fds_active(struct pollfd *fds)
 }
 
 /**
- * Call poll(2) if at least one FD in the poll FD list is "active"
- * (i.e. non-negative), and poll(2) will be able to return an event.
+ * Retrieve the window size of a TTY source, and remember it, if this is
+ * the first read, or if the size has changed.
  *
- * @param fds       FD list pointer.
- * @param nfds      Number of FDs in the list.
- * @param timeout   Number of milliseconds to block for, negative means
- *                  infinity.
+ * @param tty_source    The TTY source to retrieve the window size of.
+ * @param pchanged      Location for the flag set to true if the size was
+ *                      remembered, and to false otherwise.
  *
- * @return Number of FDs that got events, or -1 on error.
+ * @return Global return code.
  */
-static int
-tlog_tty_source_poll_if_active(struct pollfd *fds, nfds_t nfds, int timeout)
+static tlog_grc
+tlog_tty_source_read_window(struct tlog_tty_source *tty_source,
+                            bool *pchanged)
 {
-    nfds_t i;
-    for (i = 0; i < nfds; i++) {
-        if (fds[i].fd >= 0) {
-            return poll(fds, nfds, timeout);
-        }
+    struct winsize win;
+
+    /* Retrieve window size */
+    if (ioctl(tty_source->win_fd, TIOCGWINSZ, &win) < 0) {
+        return TLOG_GRC_ERRNO;
+    }
+
+    /* If this is the first read, or window size has changed */
+    *pchanged = !tty_source->started ||
+                win.ws_row != tty_source->last_win.ws_row ||
+                win.ws_col != tty_source->last_win.ws_col;
+    if (*pchanged) {
+        /* Remember last window */
+        tty_source->last_win = win;
     }
-    return 0;
+
+    return TLOG_RC_OK;
 }
 
+/**
+ * Wait for a TTY source to become ready, and read the window size change,
+ * if any, and whatever is available on every ready I/O FD into the packet
+ * list, replacing the packets there. All the packets of one wakeup share
+ * the timestamp taken after reading, and the real time derived from it.
+ * Nothing is read, if all the I/O FDs are closed, and window size changes
+ * are not tracked.
+ *
+ * If reading an FD fails after something was already read, the failure is
+ * left to be reported by the next call, reading the same FD again.
+ *
+ * @param tty_source    The TTY source to fill the packet list of.
+ *
+ * @return Global return code.
+ */
 static tlog_grc
-tlog_tty_source_read(struct tlog_source *source, struct tlog_pkt *pkt)
+tlog_tty_source_fill(struct tlog_tty_source *tty_source)
 {
-    struct tlog_tty_source *tty_source =
-                                (struct tlog_tty_source *)source;
+    struct epoll_event ev_list[TLOG_TTY_SOURCE_EV_READY + 1];
+    bool ready_list[TLOG_TTY_SOURCE_FD_IDX_NUM];
+    ssize_t rc_list[TLOG_TTY_SOURCE_FD_IDX_NUM];
+    bool winch = false;
+    bool win_changed = false;
+    bool io_read = false;
     struct timespec ts;
     struct timespec real_ts;
-
-    assert(tlog_pkt_is_void(pkt));
-
-    /* If asked to transfer window size changes */
-    if (tty_source->win_fd >= 0) {
-        sig_atomic_t sig = tlog_tty_source_sig;
-
-        /* If this is the first read, or received SIGWINCH */
-        if (!tty_source->started || sig != tty_source->last_sig) {
-            struct winsize win;
-
-            /* Retrieve window size */
-            if (ioctl(tty_source->win_fd, TIOCGWINSZ, &win) < 0) {
+    struct timespec sync_ts;
+    tlog_grc grc = TLOG_RC_OK;
+    size_t i;
+    int ev_num;
+
+    tty_source->pkt_idx = 0;
+    tty_source->pkt_num = 0;
+    memset(ready_list, 0, sizeof(ready_list));
+
+    /* If this is the first read, and asked for window size changes */
+    if (!tty_source->started && tty_source->win_fd >= 0) {
+        grc = tlog_tty_source_read_window(tty_source, &win_changed);
+        if (grc != TLOG_RC_OK) {
+            return grc;
+        }
+    /* Else, unless all FDs are closed, and there is no more data */
+    } else if (tlog_tty_source_fds_active(tty_source) ||
+               tty_source->win_fd >= 0) {
+        /* Wait until something is read, in case of spurious wakeups */
+        do {
+            /* Wait for I/O or SIGWINCH */
+            ev_num = epoll_wait(tty_source->epoll_fd, ev_list,
+                                TLOG_ARRAY_SIZE(ev_list), -1);
+            if (ev_num < 0) {
                 return TLOG_GRC_ERRNO;
             }
+            memcpy(ready_list, tty_source->unpolled_list,
+                   sizeof(ready_list));
+            winch = false;
+            for (i = 0; i < (size_t)ev_num; i++) {
+                uint32_t idx = ev_list[i].data.u32;
+                if (idx < TLOG_TTY_SOURCE_FD_IDX_NUM) {
+                    ready_list[idx] = true;
+                } else if (idx == TLOG_TTY_SOURCE_EV_WINCH) {
+                    winch = true;
+                }
+            }
 
-            /* If this is the first read, or window size has changed */
-            if (!tty_source->started ||
-                win.ws_row != tty_source->last_win.ws_row ||
-                win.ws_col != tty_source->last_win.ws_col) {
-                /* Retrieve timestamp */
-                if (clock_gettime(tty_source->clock_id, &ts) < 0) {
+            /* If received SIGWINCH */
+            if (winch) {
+                struct signalfd_siginfo info;
+
+                /* Mark all pending SIGWINCH processed */
+                while (read(tty_source->sig_fd, &info, sizeof(info)) > 0);
+                if (errno != EAGAIN) {
                     return TLOG_GRC_ERRNO;
                 }
 
-                if (clock_gettime(CLOCK_REALTIME, &real_ts) < 0) {
-                    return TLOG_GRC_ERRNO;
+                grc = tlog_tty_source_read_window(tty_source, &win_changed);
+                if (grc != TLOG_RC_OK) {
+                    return grc;
                 }
-                tlog_pkt_init_window(pkt, &ts, &real_ts,
-                                     win.ws_col, win.ws_row);
-                /* Remember last window */
-                tty_source->last_win = win;
             }
 
-            /* Mark SIGWINCH processed */
-            tty_source->last_sig = sig;
-
-            /* If got something to return */
-            if (!tlog_pkt_is_void(pkt)) {
-                goto success;
+            /* Drain every ready FD, input first */
+            for (i = 0; i < TLOG_ARRAY_SIZE(tty_source->fd_list); i++) {
+                if (!ready_list[i] || tty_source->fd_list[i] < 0) {
+                    ready_list[i] = false;
+                    continue;
+                }
+                rc_list[i] = read(tty_source->fd_list[i],
+                                  tty_source->io_buf +
+                                    tty_source->io_size * i,
+                                  tty_source->io_size);
+                if (rc_list[i] < 0) {
+                    /* If the FD is shared with a non-blocking pass-through */
+                    if (errno == EAGAIN) {
+                        ready_list[i] = false;
+                        continue;
+                    }
+                    grc = TLOG_GRC_ERRNO;
+                    /* Skip this and the rest of the FDs */
+                    memset(ready_list + i, 0,
+                           sizeof(ready_list) - sizeof(*ready_list) * i);
+                    break;
+                }
+                io_read = true;
             }
-        }
-    } else {
-        /* If all FDs are closed and win_fd is invalid, return Void packet
-         * to indicate no more data from source */
-        if (!tlog_tty_source_fds_active(tty_source->fd_list)) {
-            goto success;
-        }
+        } while (!win_changed && !io_read && grc == TLOG_RC_OK);
     }
 
-    /* Wait for I/O until interrupted by SIGWINCH or other signal */
-    if (tlog_tty_source_poll_if_active(tty_source->fd_list,
-                                       TLOG_ARRAY_SIZE(tty_source->fd_list),
-                                       -1) < 0) {
-            return TLOG_GRC_ERRNO;
+    /* Report failure, if nothing else */
+    if (!win_changed && !io_read) {
+        return grc;
+    }
+
+    /* Retrieve the timestamp once for the whole wakeup */
+    if (clock_gettime(tty_source->clock_id, &ts) < 0) {
+        return TLOG_GRC_ERRNO;
     }
 
     /*
-     * Read I/O.
+     * Derive the real time from the timestamp, refreshing its offset
+     * periodically to follow the real time adjustments
      */
-    while (true) {
-        /* Make sure we start from another FD each call */
-        tty_source->fd_idx++;
-        if (tty_source->fd_idx >= TLOG_ARRAY_SIZE(tty_source->fd_list)) {
-            tty_source->fd_idx = 0;
+    tlog_timespec_sub(&ts, &tty_source->real_sync_ts, &sync_ts);
+    if (!tty_source->started ||
+        tlog_timespec_cmp(&sync_ts,
+                          &tlog_tty_source_real_sync_period) >= 0) {
+        if (clock_gettime(CLOCK_REALTIME, &real_ts) < 0) {
+            return TLOG_GRC_ERRNO;
         }
-        if (tty_source->fd_list[tty_source->fd_idx].revents &
-                (POLLIN | POLLHUP | POLLERR)) {
-            ssize_t rc;
-            bool output;
+        tlog_timespec_sub(&real_ts, &ts, &tty_source->real_offset);
+        tty_source->real_sync_ts = ts;
+    } else {
+        tlog_timespec_add(&ts, &tty_source->real_offset, &real_ts);
+    }
 
-            output = tty_source->fd_idx == TLOG_TTY_SOURCE_FD_IDX_OUT;
+    /* Fill the packets */
+    if (win_changed) {
+        tlog_pkt_init_window(&tty_source->pkt_list[tty_source->pkt_num++],
+                             &ts, &real_ts,
+                             tty_source->last_win.ws_col,
+                             tty_source->last_win.ws_row);
+    }
+    for (i = 0; i < TLOG_ARRAY_SIZE(tty_source->fd_list); i++) {
+        struct tlog_pkt *pkt;
+        bool output;
+        if (!ready_list[i]) {
+            continue;
+        }
+        pkt = &tty_source->pkt_list[tty_source->pkt_num++];
+        output = i == TLOG_TTY_SOURCE_FD_IDX_OUT;
+        if (rc_list[i] > 0) {
+            tlog_pkt_init_io(pkt, &ts, &real_ts, output,
+                             tty_source->io_buf + tty_source->io_size * i,
+                             false, rc_list[i]);
+        } else {
+            tlog_tty_source_unwatch(tty_source, i);
+            tlog_pkt_init_eof(pkt, &ts, &real_ts, output);
+        }
+    }
 
-            rc = read(tty_source->fd_list[tty_source->fd_idx].fd,
-                      tty_source->io_buf, tty_source->io_size);
+    if (!tty_source->started) {
+        tty_source->start_ts = ts;
+        tty_source->started = true;
+    }
 
-            if (clock_gettime(tty_source->clock_id, &ts) < 0) {
-                return TLOG_GRC_ERRNO;
-            }
-            if (clock_gettime(CLOCK_REALTIME, &real_ts) < 0) {
-                return TLOG_GRC_ERRNO;
-            }
+    return TLOG_RC_OK;
+}
 
-            if (rc < 0) {
-                return TLOG_GRC_ERRNO;
-            } else if (rc > 0) {
-                tlog_pkt_init_io(pkt, &ts, &real_ts, output,
-                                 tty_source->io_buf, false, rc);
-            } else if (rc == 0) {
-                tty_source->fd_list[tty_source->fd_idx].fd = -1;
-                tlog_pkt_init_eof(pkt, &ts, &real_ts, output);
-            }
-            goto success;
+static tlog_grc
+tlog_tty_source_read_batch(struct tlog_source *source,
+                           struct tlog_pkt *pkt_list, size_t pkt_size,
+                           size_t *ppkt_num)
+{
+    struct tlog_tty_source *tty_source =
+                                (struct tlog_tty_source *)source;
+    tlog_grc grc;
+    size_t i;
+
+    /* Read more packets, if all the previous ones were returned */
+    if (tty_source->pkt_idx >= tty_source->pkt_num) {
+        grc = tlog_tty_source_fill(tty_source);
+        if (grc != TLOG_RC_OK) {
+            return grc;
         }
     }
 
-success:
-    if (!tlog_pkt_is_void(pkt)) {
-        if (!tty_source->started) {
-            tty_source->start_ts = pkt->timestamp;
-            tty_source->started = true;
-        }
+    for (i = 0;
+         i < pkt_size && tty_source->pkt_idx < tty_source->pkt_num;
+         i++, tty_source->pkt_idx++) {
+        pkt_list[i] = tty_source->pkt_list[tty_source->pkt_idx];
     }
+    *ppkt_num = i;
 
     return TLOG_RC_OK;
 }
 
+static tlog_grc
+tlog_tty_source_read(struct tlog_source *source, struct tlog_pkt *pkt)
+{
+    size_t pkt_num;
+    assert(tlog_pkt_is_void(pkt));
+    return tlog_tty_source_read_batch(source, pkt, 1, &pkt_num);
+}
+
 const struct tlog_source_type tlog_tty_source_type = {
     .size       = sizeof(struct tlog_tty_source),
     .init       = tlog_tty_source_init,
     .cleanup    = tlog_tty_source_cleanup,
     .is_valid   = tlog_tty_source_is_valid,
     .read       = tlog_tty_source_read,
+    .read_batch = tlog_tty_source_read_batch,
     .loc_get    = tlog_tty_source_loc_get,
     .loc_fmt    = tlog_tty_source_loc_fmt,
 };
@@ -23,6 +23,7 @@
 #include <tltest/json_sink.h>
 #include <tlog/mem_json_writer.h>
 #include <tlog/json_sink.h>
+#include <tlog/queue_sink.h>
 #include <tlog/misc.h>
 #include <tlog/rc.h>
 #include <tltest/misc.h>
@@ -35,6 +36,8 @@ tltest_json_sink_op_type_to_str(enum tltest_json_sink_op_type type)
         return "none";
     case TLTEST_JSON_SINK_OP_TYPE_WRITE:
         return "write";
+    case TLTEST_JSON_SINK_OP_TYPE_DROP:
+        return "drop";
     case TLTEST_JSON_SINK_OP_TYPE_FLUSH:
         return "flush";
     case TLTEST_JSON_SINK_OP_TYPE_CUT:
@@ -75,6 +78,10 @@ tltest_json_sink_run(
             .terminal = input->terminal,
             .session_id = input->session_id,
             .chunk_size = input->chunk_size,
+            .chunk_num = input->chunk_num,
+            .input_budget = input->input_budget,
+            .output_budget = input->output_budget,
+            .report_flush = input->report_flush,
         };
         grc = tlog_json_sink_create(&sink, &params);
         if (grc != TLOG_RC_OK) {
@@ -84,6 +91,16 @@ tltest_json_sink_run(
         };
     }
 
+    if (input->queue_size > 0) {
+        grc = tlog_queue_sink_create(&sink, sink, true, input->queue_size,
+                                     input->queue_overflow);
+        if (grc != TLOG_RC_OK) {
+            fprintf(stderr, "Failed initializing the queue: %s\n",
+                    tlog_grc_strerror(grc));
+            exit(1);
+        };
+    }
+
 #define FAIL(_fmt, _args...) \
     do {                                                    \
         fprintf(stderr, "%s: " _fmt "\n", name, ##_args);   \
@@ -112,8 +129,11 @@ tltest_json_sink_run(
         case TLTEST_JSON_SINK_OP_TYPE_WRITE:
             CHECK_OP(tlog_sink_write(sink, &op->data.write, NULL, NULL));
             break;
+        case TLTEST_JSON_SINK_OP_TYPE_DROP:
+            CHECK_OP(tlog_sink_drop(sink, &op->data.drop));
+            break;
         case TLTEST_JSON_SINK_OP_TYPE_FLUSH:
-            CHECK_OP(tlog_sink_flush(sink));
+            CHECK_OP(tlog_sink_flush(sink, op->data.flush));
             break;
         case TLTEST_JSON_SINK_OP_TYPE_CUT:
             CHECK_OP(tlog_sink_cut(sink));
@@ -124,6 +144,10 @@ tltest_json_sink_run(
         }
     }
 
+    if (input->queue_size > 0) {
+        CHECK_OP(tlog_queue_sink_drain(sink));
+    }
+
 #undef CHECK_OP
 #undef FAIL_OP
 #undef FAIL
@@ -138,27 +162,58 @@ bool
 tltest_json_sink(const char *file, int line, const char *name,
                  const struct tltest_json_sink test)
 {
+    /*
+     * Queue and chunk ring variants to run the test with,
+     * the output must not differ
+     */
+    static const struct {
+        const char                     *suffix;
+        size_t                          size;
+        enum tlog_queue_sink_overflow   overflow;
+        size_t                          chunk_num;
+    } queue_list[] = {
+        {"", 0, TLOG_QUEUE_SINK_OVERFLOW_BLOCK, 1},
+        {" (queue_block)", 1, TLOG_QUEUE_SINK_OVERFLOW_BLOCK, 1},
+        {" (queue_spill)", 1, TLOG_QUEUE_SINK_OVERFLOW_SPILL, 1},
+        {" (chunk_pair)", 0, TLOG_QUEUE_SINK_OVERFLOW_BLOCK, 2},
+        {" (chunk_ring)", 0, TLOG_QUEUE_SINK_OVERFLOW_BLOCK, 3},
+        {" (queue_block, chunk_ring)", 1,
+         TLOG_QUEUE_SINK_OVERFLOW_BLOCK, 3},
+    };
     bool passed = true;
     const char *exp_output_buf = test.output;
     size_t exp_output_len = strlen(exp_output_buf);
-    char *res_output_buf = NULL;
-    size_t res_output_len = 0;
-
-    passed = tltest_json_sink_run(name,
-                                  &test.input,
-                                  &res_output_buf,
-                                  &res_output_len);
-
-    if (res_output_len != exp_output_len ||
-        memcmp(res_output_buf, exp_output_buf, res_output_len) != 0) {
-        fprintf(stderr, "%s: output mismatch:\n", name);
-        tltest_diff(stderr,
-                    (const uint8_t *)res_output_buf, res_output_len,
-                    (const uint8_t *)exp_output_buf, exp_output_len);
-        passed = false;
-    }
+    char *res_output_buf;
+    size_t res_output_len;
+    struct tltest_json_sink_input input = test.input;
+    char variant_name[256];
+    size_t i;
+
+    for (i = 0; i < TLOG_ARRAY_SIZE(queue_list); i++) {
+        snprintf(variant_name, sizeof(variant_name), "%s%s",
+                 name, queue_list[i].suffix);
+        input.queue_size = queue_list[i].size;
+        input.queue_overflow = queue_list[i].overflow;
+        input.chunk_num = queue_list[i].chunk_num;
+        res_output_buf = NULL;
+        res_output_len = 0;
+
+        passed = tltest_json_sink_run(variant_name,
+                                      &input,
+                                      &res_output_buf,
+                                      &res_output_len) && passed;
+
+        if (res_output_len != exp_output_len ||
+            memcmp(res_output_buf, exp_output_buf, res_output_len) != 0) {
+            fprintf(stderr, "%s: output mismatch:\n", variant_name);
+            tltest_diff(stderr,
+                        (const uint8_t *)res_output_buf, res_output_len,
+                        (const uint8_t *)exp_output_buf, exp_output_len);
+            passed = false;
+        }
 
-    free(res_output_buf);
+        free(res_output_buf);
+    }
 
     fprintf(stderr, "%s %s:%d %s\n",(passed ? "PASS" : "FAIL"), file, line, name);
     return passed;
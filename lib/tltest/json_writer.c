@@ -0,0 +1,204 @@
+/*
+ * Tlog_json_writer test functions.
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <tltest/json_writer.h>
+#include <tltest/misc.h>
+#include <tlog/json_sink.h>
+#include <tlog/misc.h>
+#include <tlog/rc.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+const char*
+tltest_json_writer_op_type_to_str(enum tltest_json_writer_op_type type)
+{
+    switch (type) {
+    case TLTEST_JSON_WRITER_OP_TYPE_NONE:
+        return "none";
+    case TLTEST_JSON_WRITER_OP_TYPE_WRITE:
+        return "write";
+    case TLTEST_JSON_WRITER_OP_TYPE_WRITE_MSG:
+        return "write_msg";
+    case TLTEST_JSON_WRITER_OP_TYPE_SLEEP:
+        return "sleep";
+    case TLTEST_JSON_WRITER_OP_TYPE_FLUSH:
+        return "flush";
+    case TLTEST_JSON_WRITER_OP_TYPE_CHECK:
+        return "check";
+    case TLTEST_JSON_WRITER_OP_TYPE_CUSTOM:
+        return "custom";
+    default:
+        return "<unknown>";
+    }
+}
+
+/**
+ * Write a message with text input and output, split into parts the way a
+ * JSON sink does it.
+ *
+ * @param writer    The writer to write the message to.
+ * @param id        The message ID.
+ * @param timing    The "timing" value.
+ * @param in_txt    The "in_txt" value.
+ * @param out_txt   The "out_txt" value.
+ * @param out_bin   The "out_bin" value, without brackets.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+write_msg(struct tlog_json_writer *writer, size_t id,
+          const char *timing, const char *in_txt,
+          const char *out_txt, const char *out_bin)
+{
+    const char *part_list[TLOG_JSON_SINK_MSG_PART_NUM] = {
+        [TLOG_JSON_SINK_MSG_PART_PREFIX]        = "{",
+        [TLOG_JSON_SINK_MSG_PART_FIELDS]        = "\"timing\":\"",
+        [TLOG_JSON_SINK_MSG_PART_TIMING]        = timing,
+        [TLOG_JSON_SINK_MSG_PART_IN_TXT_SEP]    = "\",\"in_txt\":\"",
+        [TLOG_JSON_SINK_MSG_PART_IN_TXT]        = in_txt,
+        [TLOG_JSON_SINK_MSG_PART_IN_BIN_SEP]    = "\",\"in_bin\":[",
+        [TLOG_JSON_SINK_MSG_PART_IN_BIN]        = "",
+        [TLOG_JSON_SINK_MSG_PART_OUT_TXT_SEP]   = "],\"out_txt\":\"",
+        [TLOG_JSON_SINK_MSG_PART_OUT_TXT]       = out_txt,
+        [TLOG_JSON_SINK_MSG_PART_OUT_BIN_SEP]   = "\",\"out_bin\":[",
+        [TLOG_JSON_SINK_MSG_PART_OUT_BIN]       = out_bin,
+        [TLOG_JSON_SINK_MSG_PART_END]           = "]}\n",
+    };
+    struct iovec iov[TLOG_JSON_SINK_MSG_PART_NUM];
+    int i;
+
+    for (i = 0; i < TLOG_JSON_SINK_MSG_PART_NUM; i++) {
+        iov[i].iov_base = (void *)part_list[i];
+        iov[i].iov_len = strlen(part_list[i]);
+    }
+    return tlog_json_writer_write_msg(writer, id, iov);
+}
+
+bool
+tltest_json_writer(const char *file, int line, const char *name,
+                   const struct tltest_json_writer_hooks *hooks,
+                   const struct tltest_json_writer test)
+{
+    bool passed = true;
+    tlog_grc grc;
+    struct tlog_json_writer *writer;
+    void *data = NULL;
+    const struct tltest_json_writer_op *op;
+    size_t id = 1;
+    struct timespec ts;
+    char res_buf[TLTEST_JSON_WRITER_BUF_SIZE];
+    size_t res_len;
+
+    assert(hooks != NULL);
+    assert(hooks->setup != NULL);
+    assert(hooks->read != NULL);
+    assert(hooks->teardown != NULL);
+
+    writer = hooks->setup(test.params, &data);
+
+#define FAIL(_fmt, _args...) \
+    do {                                              \
+        fprintf(stderr, "FAIL %s:%d %s " _fmt "\n",   \
+                file, line, name, ##_args);           \
+        passed = false;                               \
+    } while (0)
+
+#define FAIL_OP(_fmt, _args...) \
+    FAIL("op #%zd (%s): " _fmt,                                 \
+         op - test.op_list + 1,                                 \
+         tltest_json_writer_op_type_to_str(op->type), ##_args)
+
+#define CHECK(_exp_str, _fail_args...) \
+    do {                                                        \
+        res_len = hooks->read(data, res_buf, sizeof(res_buf));  \
+        if (res_len != strlen(_exp_str) ||                      \
+            memcmp(res_buf, _exp_str, res_len) != 0) {          \
+            _fail_args;                                         \
+            tltest_diff(stderr,                                 \
+                        (const uint8_t *)res_buf, res_len,      \
+                        (const uint8_t *)(_exp_str),            \
+                        strlen(_exp_str));                      \
+        }                                                       \
+    } while (0)
+
+    for (op = test.op_list;
+         op->type != TLTEST_JSON_WRITER_OP_TYPE_NONE;
+         op++) {
+        switch (op->type) {
+        case TLTEST_JSON_WRITER_OP_TYPE_WRITE:
+            grc = tlog_json_writer_write(writer, id++,
+                                         (const uint8_t *)op->str,
+                                         strlen(op->str));
+            if (grc != op->exp_grc) {
+                FAIL_OP("grc: %s", tlog_grc_strerror(grc));
+            }
+            break;
+        case TLTEST_JSON_WRITER_OP_TYPE_WRITE_MSG:
+            grc = write_msg(writer, id++, op->timing, op->in_txt,
+                            op->str, op->bin);
+            if (grc != op->exp_grc) {
+                FAIL_OP("grc: %s", tlog_grc_strerror(grc));
+            }
+            break;
+        case TLTEST_JSON_WRITER_OP_TYPE_SLEEP:
+            ts.tv_sec = op->ms / 1000;
+            ts.tv_nsec = op->ms % 1000 * 1000000;
+            nanosleep(&ts, NULL);
+            break;
+        case TLTEST_JSON_WRITER_OP_TYPE_FLUSH:
+            grc = tlog_json_writer_flush(writer);
+            if (grc != TLOG_RC_OK) {
+                FAIL_OP("grc: %s", tlog_grc_strerror(grc));
+            }
+            break;
+        case TLTEST_JSON_WRITER_OP_TYPE_CHECK:
+            CHECK(op->str, FAIL_OP("contents mismatch:"));
+            break;
+        case TLTEST_JSON_WRITER_OP_TYPE_CUSTOM:
+            assert(hooks->custom != NULL);
+            grc = hooks->custom(data, op->str);
+            if (grc != TLOG_RC_OK) {
+                FAIL_OP("grc: %s", tlog_grc_strerror(grc));
+            }
+            break;
+        default:
+            fprintf(stderr, "Unknown operation type: %d\n", op->type);
+            exit(1);
+        }
+    }
+
+    tlog_json_writer_destroy(writer);
+    CHECK(test.exp_final, FAIL("final contents mismatch:"));
+
+#undef CHECK
+#undef FAIL_OP
+#undef FAIL
+
+    hooks->teardown(data);
+
+    fprintf(stderr, "%s %s:%d %s\n", (passed ? "PASS" : "FAIL"),
+            file, line, name);
+    return passed;
+}
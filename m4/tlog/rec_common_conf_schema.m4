@@ -25,13 +25,14 @@ m4_dnl along with tlog; if not, write to the Free Software
 m4_dnl Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 m4_dnl
 _M4_PARAM(`', `latency', `file-',
-          `M4_TYPE_INT(10, 1)', true,
+          `M4_TYPE_DOUBLE(10, 0.001)', true,
           `', `=SECONDS', `Cache captured data SECONDS seconds before logging',
           `SECONDS is the ', `The ',
           `M4_LINES(`number of seconds to cache captured data for before logging.',
                     `The encoded data which does not reach payload size',
                     `stays in memory and is not logged until this number of',
-                    `seconds elapses.')')m4_dnl
+                    `seconds elapses. Fractions of a second can be specified,',
+                    `down to a millisecond.')')m4_dnl
 m4_dnl
 _M4_PARAM(`', `payload', `file-',
           `M4_TYPE_INT(2048, 32)', true,
@@ -41,6 +42,50 @@ _M4_PARAM(`', `payload', `file-',
                     `As soon as payload exceeds this number of bytes,',
                     `it is formatted into a message and logged.')')m4_dnl
 m4_dnl
+_M4_PARAM(`', `buffers', `file-',
+          `M4_TYPE_INT(2, 1)', true,
+          `', `=NUMBER', `Fill NUMBER payload buffers in rotation',
+          `NUMBER is the ', `The ',
+          `M4_LINES(`number of payload buffers to fill in rotation.',
+                    `With more than one, full payloads are logged on a',
+                    `separate thread, while the next buffer fills, and a',
+                    `failure to log them is reported on the next flush.',
+                    `With one, each full payload is logged right away,',
+                    `without the extra thread.')')m4_dnl
+m4_dnl
+_M4_PARAM(`', `clock', `file-',
+          `M4_TYPE_CHOICE(`auto', `auto', `fine', `coarse')', true,
+          `', `=STRING', `Timestamp terminal I/O with STRING clock (auto/fine/coarse)',
+          `STRING is the ', `The ',
+          `M4_LINES(`clock to timestamp terminal I/O with.',
+                    `If set to "fine", the precise monotonic clock is used.',
+                    `If set to "coarse", the faster coarse monotonic clock is',
+                    `used, even if its resolution is worse than a millisecond,',
+                    `the granularity of recorded timing. If set to "auto",',
+                    `the coarse clock is used only if its resolution is at',
+                    `least a millisecond.')')m4_dnl
+m4_dnl
+m4_dnl
+m4_dnl
+M4_CONTAINER(`', `/flush', `Log flushing')m4_dnl
+m4_dnl
+_M4_PARAM(`/flush', `idle', `file-',
+          `M4_TYPE_INT(0, 0)', true,
+          `', `=MILLISECONDS', `Log cached data after MILLISECONDS of idle I/O',
+          `MILLISECONDS is the ', `The ',
+          `M4_LINES(`number of milliseconds terminal I/O has to stay idle for',
+                    `the cached data to be logged before latency expires.',
+                    `Latency stays the upper bound on caching time. Zero means',
+                    `cached data is only logged when latency expires.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/flush', `report', `file-',
+          `M4_TYPE_BOOL(false)', true,
+          `', `[=BOOL]', `Enable/disable reporting reasons for logging messages',
+          `If specified as ', `If ',
+          `M4_LINES(`true, each message reports the reason it was logged for',
+                    `in the "flush" field: payload size reached ("full"),',
+                    `end of recording ("request"), idle I/O ("idle"), or',
+                    `latency expiry ("latency").')')m4_dnl
 m4_dnl
 m4_dnl
 M4_CONTAINER(`', `/log', `Logged data set')m4_dnl
@@ -81,13 +126,149 @@ _M4_PARAM(`/limit', `burst', `file-',
                     `the rate limit momentarily, i.e. "burstiness".')')m4_dnl
 m4_dnl
 _M4_PARAM(`/limit', `action', `file-',
-          `M4_TYPE_CHOICE(`pass', `pass', `delay', `drop')', true,
-          `', `=STRING', `Perform STRING action above limits (pass/delay/drop)',
+          `M4_TYPE_CHOICE(`pass', `pass', `delay', `drop', `backlog', `degrade')', true,
+          `', `=STRING', `Perform STRING action above limits (pass/delay/drop/backlog/degrade)',
           `STRING is the ', `The ',
           `M4_LINES(`logging limit action.',
                     `If set to "pass" no logging limits will be applied.',
                     `If set to "delay", logging will be throttled.',
-                    `If set to "drop", messages exceeding limits will be dropped.')')m4_dnl
+                    `If set to "drop", messages exceeding limits will be dropped,',
+                    `and counted in the next message logged, except those',
+                    `carrying input or window changes, which will be logged with',
+                    `their output elided, within the reserve.',
+                    `If set to "backlog", messages exceeding limits will be kept',
+                    `in a backlog and logged in background, as limits allow.',
+                    `If set to "degrade", messages exceeding limits will be logged',
+                    `with their output elided, keeping the input and the timing,',
+                    `or dropped, if even that exceeds limits.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/limit', `reserve', `file-',
+          `M4_TYPE_INT(10, 0)', true,
+          `', `=PERCENT', `Reserve PERCENT of limits for input and window changes',
+          `PERCENT is the ', `The ',
+          `M4_LINES(`percentage of the rate and burst limits reserved for the',
+                    `messages carrying input or window changes, with their output',
+                    `elided, for the "drop" and "degrade" limit actions. Other',
+                    `messages are limited to the rest, so the input and the window',
+                    `changes are logged through a flood of output. Must not be',
+                    `more than 100.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/limit', `backlog', `file-',
+          `M4_TYPE_INT(1048576, 0)', true,
+          `', `=BYTES', `Keep up to BYTES bytes of messages above limits',
+          `BYTES is the ', `The ',
+          `M4_LINES(`maximum amount of messages, bytes, kept in the backlog',
+                    `with the "backlog" limit action. Must be larger than any',
+                    `message, or recording fails. The backlog is logged',
+                    `without limits when recording ends.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/limit', `evict', `file-',
+          `M4_TYPE_CHOICE(`oldest', `oldest', `newest')', true,
+          `', `=STRING', `Evict STRING messages from a full backlog (oldest/newest)',
+          `STRING is the ', `The ',
+          `M4_LINES(`backlog eviction policy for the "backlog" limit action.',
+                    `If set to "oldest", the oldest messages are dropped to make',
+                    `space for new ones. If set to "newest", messages not fitting',
+                    `the backlog are dropped.')')m4_dnl
+m4_dnl
+M4_CONTAINER(`/limit', `/shared', `Shared logging limit')m4_dnl
+m4_dnl
+_M4_PARAM(`/limit/shared', `scope', `file-',
+          `M4_TYPE_CHOICE(`none', `none', `host', `user')', true,
+          `', `=STRING', `Share logging limits within STRING (none/host/user)',
+          `STRING is the ', `The ',
+          `M4_LINES(`scope of the logging limit shared between recording processes.',
+                    `If set to "none", no shared limit will be applied.',
+                    `If set to "host", all recording processes on the host will',
+                    `draw from the same limit, in addition to their own.',
+                    `If set to "user", all recording processes of the same user',
+                    `will draw from the same limit, in addition to their own.',
+                    `The limit is shared only between processes running as the',
+                    `same effective user, and is not used if someone else could',
+                    `have changed it.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/limit/shared', `rate', `file-',
+          `M4_TYPE_INT(1048576, 1)', true,
+          `', `=NUMBER', `Set shared logging rate limit to NUMBER of message bytes/sec',
+          `NUMBER is the ', `The ',
+          `M4_LINES(`maximum rate messages could be logged at, bytes/sec,',
+                    `by all the recording processes sharing the limit.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/limit/shared', `burst', `file-',
+          `M4_TYPE_INT(1048576, 0)', true,
+          `', `=NUMBER', `Set shared logging burst limit to NUMBER of message bytes',
+          `NUMBER is the ', `The ',
+          `M4_LINES(`number of bytes by which messages logged by all the recording',
+                    `processes sharing the limit are allowed to exceed the shared',
+                    `rate limit momentarily.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/limit/shared', `fairness', `file-',
+          `M4_TYPE_CHOICE(`none', `none', `equal')', true,
+          `', `=STRING', `Share logging limits with STRING policy (none/equal)',
+          `STRING is the ', `The ',
+          `M4_LINES(`policy of sharing the limit between recording processes.',
+                    `If set to "none", any process can use all of the shared limit.',
+                    `If set to "equal", each process is limited to an equal share',
+                    `of the shared rate, given the number of processes sharing it.')')m4_dnl
+m4_dnl
+M4_CONTAINER(`/limit', `/input', `Input logging limit')m4_dnl
+m4_dnl
+_M4_PARAM(`/limit/input', `rate', `file-',
+          `M4_TYPE_INT(0, 0)', true,
+          `', `=NUMBER', `Set input logging rate limit to NUMBER of bytes/sec',
+          `NUMBER is the ', `The ',
+          `M4_LINES(`maximum rate terminal input could be logged at, bytes/sec.',
+                    `Input exceeding it is not logged, and only the number of',
+                    `bytes skipped is. Zero means no limit.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/limit/input', `burst', `file-',
+          `M4_TYPE_INT(0, 0)', true,
+          `', `=NUMBER', `Set input logging burst limit to NUMBER of bytes',
+          `NUMBER is the ', `The ',
+          `M4_LINES(`number of bytes by which logged terminal input is allowed',
+                    `to exceed the input rate limit momentarily.')')m4_dnl
+m4_dnl
+M4_CONTAINER(`/limit', `/output', `Output logging limit')m4_dnl
+m4_dnl
+_M4_PARAM(`/limit/output', `rate', `file-',
+          `M4_TYPE_INT(0, 0)', true,
+          `', `=NUMBER', `Set output logging rate limit to NUMBER of bytes/sec',
+          `NUMBER is the ', `The ',
+          `M4_LINES(`maximum rate terminal output could be logged at, bytes/sec.',
+                    `Output exceeding it is not logged, and only the number of',
+                    `bytes skipped is. Zero means no limit. Keep it below the',
+                    `message rate limit, to leave room for the input.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/limit/output', `burst', `file-',
+          `M4_TYPE_INT(0, 0)', true,
+          `', `=NUMBER', `Set output logging burst limit to NUMBER of bytes',
+          `NUMBER is the ', `The ',
+          `M4_LINES(`number of bytes by which logged terminal output is allowed',
+                    `to exceed the output rate limit momentarily.')')m4_dnl
+m4_dnl
+m4_dnl
+m4_dnl
+M4_CONTAINER(`', `/queue', `Logging queue')m4_dnl
+m4_dnl
+_M4_PARAM(`/queue', `size', `file-',
+          `M4_TYPE_INT(0, 0)', true,
+          `', `=BYTES', `Queue up to BYTES bytes of terminal data for logging',
+          `BYTES is the ', `The ',
+          `M4_LINES(`maximum amount of terminal data, bytes, queued for encoding',
+                    `and logging on a separate thread, after it is delivered.',
+                    `If zero, the data is logged before it is delivered,',
+                    `on the same thread.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/queue', `overflow', `file-',
+          `M4_TYPE_CHOICE(`block', `block', `drop', `spill')', true,
+          `', `=STRING', `Perform STRING action on queue overflow (block/drop/spill)',
+          `STRING is the ', `The ',
+          `M4_LINES(`logging queue overflow action.',
+                    `If set to "block", terminal I/O will wait for the queue.',
+                    `If set to "drop", data not fitting the queue will be dropped.',
+                    `with the number of bytes dropped logged instead.',
+                    `If set to "spill", data not fitting the queue will be',
+                    `stored in a temporary file until the queue drains.')')m4_dnl
 m4_dnl
 m4_dnl
 m4_dnl
@@ -99,6 +280,51 @@ _M4_PARAM(`/file', `path', `file-',
           `FILE is the ', `The ',
           `M4_LINES(`"file" writer log file path.')')m4_dnl
 m4_dnl
+_M4_PARAM(`/file', `batch', `file-',
+          `M4_TYPE_INT(0, 0)', true,
+          `', `=BYTES', `Write log file in batches of up to BYTES bytes',
+          `BYTES is the ', `The ',
+          `M4_LINES(`maximum size of a batch of messages the "file" writer',
+                    `collects before writing them with a single call.',
+                    `Batches are also written when the log is flushed.',
+                    `If zero, each message is written as soon as it is formatted.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/file', `sync', `file-',
+          `M4_TYPE_CHOICE(`never', `never', `interval', `bytes', `flush')', true,
+          `', `=STRING', `Sync log file with STRING policy (never/interval/bytes/flush)',
+          `STRING is the ', `The ',
+          `M4_LINES(`policy of making the "file" writer data durable on storage.',
+                    `If set to "never", the data is synced by the system as usual.',
+                    `If set to "interval", the data is synced after writing,',
+                    `or flushing the log, if "interval" milliseconds passed',
+                    `since the last sync.',
+                    `If set to "bytes", the data is synced after writing',
+                    `"threshold" bytes since the last sync.',
+                    `If set to "flush", the data is synced each time the log is',
+                    `flushed, i.e. when latency expires and at the end.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/file', `interval', `file-',
+          `M4_TYPE_INT(1000, 1)', true,
+          `', `=MS', `Sync log file every MS milliseconds with "interval" policy',
+          `MS is the ', `The ',
+          `M4_LINES(`minimum number of milliseconds between syncs of the log file',
+                    `with the "interval" sync policy.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/file', `threshold', `file-',
+          `M4_TYPE_INT(1048576, 1)', true,
+          `', `=BYTES', `Sync log file every BYTES bytes with "bytes" policy',
+          `BYTES is the ', `The ',
+          `M4_LINES(`number of bytes written to the log file after which it is',
+                    `synced with the "bytes" sync policy.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/file', `prealloc', `file-',
+          `M4_TYPE_INT(0, 0)', true,
+          `', `=BYTES', `Preallocate log file space BYTES bytes at a time',
+          `BYTES is the ', `The ',
+          `M4_LINES(`amount of log file space, bytes, reserved ahead of writes',
+                    `at a time, to reduce fragmentation. If zero, no space is',
+                    `reserved.')')m4_dnl
+m4_dnl
 m4_dnl
 m4_dnl
 M4_CONTAINER(`', `/syslog', `Syslog writer')m4_dnl
@@ -145,6 +371,31 @@ _M4_PARAM(`/syslog', `priority', `file-',
           `STRING is the ', `The ',
           `M4_LINES(`syslog priority "syslog" writer should use for messages.')')m4_dnl
 m4_dnl
+_M4_PARAM(`/syslog', `format', `file-',
+          `M4_TYPE_CHOICE(`rfc3164', `rfc3164', `rfc5424')', true,
+          `', `=STRING', `Format syslog messages as STRING (rfc3164/rfc5424)',
+          `STRING is the ', `The ',
+          `M4_LINES(`format of the messages the "syslog" writer sends.',
+                    `If set to "rfc3164", the BSD syslog format is used, as',
+                    `produced by syslog(3). If set to "rfc5424", the syslog',
+                    `protocol format is used, with microsecond timestamps.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/syslog', `path', `file-',
+          `M4_TYPE_STRING(`/dev/log')', true,
+          `', `=FILE', `Send syslog messages to FILE socket',
+          `FILE is the ', `The ',
+          `M4_LINES(`path to the local socket the "syslog" writer sends',
+                    `messages to.')')m4_dnl
+m4_dnl
+_M4_PARAM(`/syslog', `batch', `file-',
+          `M4_TYPE_INT(0, 0)', true,
+          `', `=NUMBER', `Send syslog messages in batches of up to NUMBER',
+          `NUMBER is the ', `The ',
+          `M4_LINES(`maximum number of messages the "syslog" writer collects',
+                    `before sending them with a single call. Batches are also',
+                    `sent when the log is flushed, i.e. when latency expires.',
+                    `If zero, each message is sent as soon as it is formatted.')')m4_dnl
+m4_dnl
 m4_dnl
 m4_dnl
 m4_ifelse(M4_JOURNAL_ENABLED(), `1', `m4_dnl
@@ -175,5 +426,16 @@ _M4_PARAM(`/journal', `augment', `file-',
                     `to Journal fields: user -> TLOG_USER, session -> TLOG_SESSION,',
                     `rec -> TLOG_REC, and id -> TLOG_ID.')')m4_dnl
 m4_dnl
+_M4_PARAM(`/journal', `stream', `file-',
+          `M4_TYPE_BOOL(false)',
+          true,
+          `', `[=BOOL]', `Enable/disable writing to a journal stream',
+          `If specified as ', `If ',
+          `M4_LINES(`true, the "journal" writer writes messages as lines to a',
+                    `persistent journal stream connection, instead of sending',
+                    `each as a separate entry. This costs less per message, but',
+                    `streams cannot carry extra fields, so this only takes effect',
+                    `if "augment" is false.')')m4_dnl
+m4_dnl
 ')m4_dnl m4_ifelse M4_JOURNAL_ENABLED
 m4_dnl
@@ -0,0 +1,248 @@
+/*
+ * Tlog file writer test.
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <tlog/rc.h>
+#include <tlog/file_json_writer.h>
+#include <tltest/json_writer.h>
+
+/**
+ * Create a file writer writing to an unlinked temporary file.
+ *
+ * @param params    The file writer parameters, except the FD.
+ * @param pdata     Location for the temporary file FD.
+ *
+ * @return The created writer.
+ */
+static struct tlog_json_writer *
+setup(const void *params, void **pdata)
+{
+    tlog_grc grc;
+    struct tlog_json_writer *writer = NULL;
+    char filename[] = "tlog-test-file-json-writer.XXXXXX";
+    struct tlog_file_json_writer_params file_params =
+                    *(const struct tlog_file_json_writer_params *)params;
+    int *pfd;
+
+    pfd = malloc(sizeof(*pfd));
+    if (pfd == NULL) {
+        fprintf(stderr, "Failed allocating test state: %s\n",
+                strerror(errno));
+        exit(1);
+    }
+    *pfd = mkstemp(filename);
+    if (*pfd < 0) {
+        fprintf(stderr, "Failed opening a temporary file: %s\n",
+                strerror(errno));
+        exit(1);
+    }
+    if (unlink(filename) < 0) {
+        fprintf(stderr, "Failed unlinking the temporary file: %s\n",
+                strerror(errno));
+        exit(1);
+    }
+    if (fcntl(*pfd, F_SETFL, O_APPEND) < 0) {
+        fprintf(stderr, "Failed setting temporary file flags: %s\n",
+                strerror(errno));
+        exit(1);
+    }
+    file_params.fd = *pfd;
+    file_params.fd_owned = false;
+    grc = tlog_file_json_writer_create(&writer, &file_params);
+    if (grc != TLOG_RC_OK) {
+        fprintf(stderr, "Failed creating file writer: %s\n",
+                tlog_grc_strerror(grc));
+        exit(1);
+    }
+
+    *pdata = pfd;
+    return writer;
+}
+
+/**
+ * Read the complete contents of the temporary file.
+ *
+ * @param data  The temporary file FD.
+ * @param buf   The buffer to read into.
+ * @param size  The size of the buffer.
+ *
+ * @return Length of the contents.
+ */
+static size_t
+read_file(void *data, char *buf, size_t size)
+{
+    int fd = *(int *)data;
+    struct stat st;
+    ssize_t rc;
+
+    if (fstat(fd, &st) < 0) {
+        fprintf(stderr, "Failed getting temporary file status: %s\n",
+                strerror(errno));
+        exit(1);
+    }
+    if ((size_t)st.st_size > size) {
+        fprintf(stderr, "Temporary file is too big: %lld\n",
+                (long long int)st.st_size);
+        exit(1);
+    }
+    rc = pread(fd, buf, st.st_size, 0);
+    if (rc != st.st_size) {
+        fprintf(stderr, "Failed reading the temporary file: %s\n",
+                strerror(errno));
+        exit(1);
+    }
+    return (size_t)rc;
+}
+
+/**
+ * Close the temporary file.
+ *
+ * @param data  The temporary file FD.
+ */
+static void
+teardown(void *data)
+{
+    close(*(int *)data);
+    free(data);
+}
+
+static const struct tltest_json_writer_hooks hooks = {
+    .setup = setup,
+    .read = read_file,
+    .teardown = teardown,
+};
+
+int
+main(void)
+{
+    bool passed = true;
+
+#define OP_WRITE(_str) TLTEST_JSON_WRITER_OP_WRITE(_str)
+#define OP_FLUSH TLTEST_JSON_WRITER_OP_FLUSH
+#define OP_CHECK(_str) TLTEST_JSON_WRITER_OP_CHECK(_str)
+
+#define PARAMS(_batch, _sync, _interval, _threshold, _prealloc) \
+    (&(struct tlog_file_json_writer_params){                        \
+        .batch = _batch,                                            \
+        .sync = TLOG_FILE_JSON_WRITER_SYNC_##_sync,                 \
+        .interval = _interval,                                      \
+        .threshold = _threshold,                                    \
+        .prealloc = _prealloc,                                      \
+    })
+
+#define TEST(_name_token, _params, _exp_final, _op_list_init_args...) \
+    passed = tltest_json_writer(                                \
+                __FILE__, __LINE__, #_name_token, &hooks,       \
+                (struct tltest_json_writer){                    \
+                    .params = _params,                          \
+                    .op_list = {_op_list_init_args,             \
+                                TLTEST_JSON_WRITER_OP_NONE},    \
+                    .exp_final = _exp_final                     \
+                }                                               \
+             ) && passed
+
+    TEST(empty, PARAMS(0, NEVER, 0, 0, 0), "",
+         OP_CHECK(""));
+
+    TEST(unbatched, PARAMS(0, NEVER, 0, 0, 0), "abc\ndef\n",
+         OP_WRITE("abc\n"),
+         OP_CHECK("abc\n"),
+         OP_WRITE("def\n"),
+         OP_CHECK("abc\ndef\n"));
+
+    TEST(batch_held, PARAMS(8, NEVER, 0, 0, 0), "abc\ndef\n",
+         OP_WRITE("abc\n"),
+         OP_CHECK(""),
+         OP_WRITE("def\n"),
+         OP_CHECK(""));
+
+    TEST(batch_flushed, PARAMS(8, NEVER, 0, 0, 0), "abc\ndef\n",
+         OP_WRITE("abc\n"),
+         OP_FLUSH,
+         OP_CHECK("abc\n"),
+         OP_WRITE("def\n"),
+         OP_CHECK("abc\n"),
+         OP_FLUSH,
+         OP_CHECK("abc\ndef\n"),
+         OP_FLUSH,
+         OP_CHECK("abc\ndef\n"));
+
+    TEST(batch_overflow, PARAMS(8, NEVER, 0, 0, 0), "abc\ndef\ng\n",
+         OP_WRITE("abc\n"),
+         OP_WRITE("def\n"),
+         OP_WRITE("g\n"),
+         OP_CHECK("abc\ndef\n"));
+
+    TEST(batch_oversized, PARAMS(4, NEVER, 0, 0, 0), "ab\ncdefgh\ni\n",
+         OP_WRITE("ab\n"),
+         OP_CHECK(""),
+         OP_WRITE("cdefgh\n"),
+         OP_CHECK("ab\ncdefgh\n"),
+         OP_WRITE("i\n"),
+         OP_CHECK("ab\ncdefgh\n"));
+
+    TEST(sync_interval, PARAMS(4, INTERVAL, 1, 0, 0), "ab\ncd\nef\n",
+         OP_WRITE("ab\n"),
+         OP_WRITE("cd\n"),
+         OP_CHECK("ab\n"),
+         OP_WRITE("ef\n"),
+         OP_FLUSH,
+         OP_CHECK("ab\ncd\nef\n"));
+
+    TEST(sync_bytes, PARAMS(0, BYTES, 0, 4, 0), "ab\ncd\nef\n",
+         OP_WRITE("ab\n"),
+         OP_WRITE("cd\n"),
+         OP_WRITE("ef\n"),
+         OP_CHECK("ab\ncd\nef\n"));
+
+    TEST(sync_flush, PARAMS(16, FLUSH, 0, 0, 0), "ab\ncd\nef\n",
+         OP_WRITE("ab\n"),
+         OP_WRITE("cd\n"),
+         OP_FLUSH,
+         OP_CHECK("ab\ncd\n"),
+         OP_WRITE("ef\n"),
+         OP_CHECK("ab\ncd\n"));
+
+    /* Preallocated space must not be visible in the file size */
+    TEST(prealloc, PARAMS(4, NEVER, 0, 0, 4096), "ab\ncdefgh\ni\n",
+         OP_WRITE("ab\n"),
+         OP_WRITE("cdefgh\n"),
+         OP_CHECK("ab\ncdefgh\n"),
+         OP_WRITE("i\n"),
+         OP_FLUSH,
+         OP_CHECK("ab\ncdefgh\ni\n"));
+
+    /* Writes running past the preallocated space must get more */
+    TEST(prealloc_exceeded, PARAMS(0, NEVER, 0, 0, 4), "abc\ndef\nghijkl\n",
+         OP_WRITE("abc\n"),
+         OP_WRITE("def\n"),
+         OP_WRITE("ghijkl\n"),
+         OP_CHECK("abc\ndef\nghijkl\n"));
+
+    return !passed;
+}
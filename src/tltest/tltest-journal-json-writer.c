@@ -0,0 +1,252 @@
+/*
+ * Tlog journal writer test.
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <syslog.h>
+#include <systemd/sd-journal.h>
+#include <tlog/rc.h>
+#include <tlog/journal_json_writer.h>
+
+/** Journal socket, the test is skipped if it's missing */
+#define JOURNAL_SOCKET  "/run/systemd/journal/socket"
+
+/** Automake's exit status of a skipped test */
+#define EXIT_SKIP   77
+
+/** Maximum number of seconds to wait for an entry to appear */
+#define WAIT_SEC    5
+
+/** Name of the user "being recorded" */
+#define USERNAME    "tltest"
+
+/** Audit session ID "being recorded" */
+#define SESSION_ID  1234
+
+/** Field identifying the probe entry */
+#define PROBE_FIELD "TLTEST_PROBE"
+
+/**
+ * Check that a journal entry field has the expected value.
+ *
+ * @param journal   The journal positioned at the entry to check.
+ * @param name      The field name.
+ * @param exp_value The expected field value.
+ *
+ * @return True if the field has the value, false otherwise.
+ */
+static bool
+check_field(sd_journal *journal, const char *name, const char *exp_value)
+{
+    const void *data;
+    size_t len;
+    size_t name_len = strlen(name);
+    int sd_rc;
+
+    sd_rc = sd_journal_get_data(journal, name, &data, &len);
+    if (sd_rc < 0) {
+        fprintf(stderr, "Failed getting field %s: %s\n",
+                name, strerror(-sd_rc));
+        return false;
+    }
+    if (len != name_len + 1 + strlen(exp_value) ||
+        memcmp((const char *)data + name_len + 1, exp_value,
+               len - name_len - 1) != 0) {
+        fprintf(stderr, "Field mismatch: %.*s, expecting %s=%s\n",
+                (int)len, (const char *)data, name, exp_value);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Open the journal positioned at the entry matching a field, waiting for
+ * it to be stored.
+ *
+ * @param pjournal  Location for the opened journal, NULL if the entry
+ *                  wasn't found.
+ * @param match     The "FIELD=value" match of the entry.
+ *
+ * @return True if the entry was found, false otherwise.
+ */
+static bool
+find_entry(sd_journal **pjournal, const char *match)
+{
+    sd_journal *journal = NULL;
+    int sd_rc;
+    int i;
+
+    sd_rc = sd_journal_open(&journal, SD_JOURNAL_LOCAL_ONLY);
+    if (sd_rc < 0) {
+        fprintf(stderr, "Failed opening the journal: %s\n",
+                strerror(-sd_rc));
+        goto error;
+    }
+    sd_rc = sd_journal_add_match(journal, match, 0);
+    if (sd_rc < 0) {
+        fprintf(stderr, "Failed adding a journal match: %s\n",
+                strerror(-sd_rc));
+        goto error;
+    }
+
+    /* Wait for the entry to be stored */
+    for (i = 0; (sd_rc = sd_journal_next(journal)) == 0 && i < WAIT_SEC;
+         i++) {
+        sd_journal_wait(journal, 1000000);
+    }
+    if (sd_rc <= 0) {
+        fprintf(stderr, "Entry with %s not found\n", match);
+        goto error;
+    }
+
+    *pjournal = journal;
+    return true;
+
+error:
+    if (journal != NULL) {
+        sd_journal_close(journal);
+    }
+    *pjournal = NULL;
+    return false;
+}
+
+/**
+ * Check the entries we write can be read back.
+ *
+ * @return True if they can, false otherwise.
+ */
+static bool
+probe(void)
+{
+    sd_journal *journal;
+    char match[64];
+    int sd_rc;
+
+    snprintf(match, sizeof(match), PROBE_FIELD "=%d", (int)getpid());
+    sd_rc = sd_journal_send("MESSAGE=tltest probe", "%s", match, NULL);
+    if (sd_rc < 0) {
+        fprintf(stderr, "Failed sending a probe entry: %s\n",
+                strerror(-sd_rc));
+        return false;
+    }
+    if (!find_entry(&journal, match)) {
+        return false;
+    }
+    sd_journal_close(journal);
+    return true;
+}
+
+static bool
+test(const char *file, int line, const char *n, bool augment, bool stream)
+{
+    bool passed = false;
+    tlog_grc grc;
+    struct tlog_json_writer *writer = NULL;
+    sd_journal *journal = NULL;
+    char rec[64];
+    char message[sizeof(rec) + 32];
+    char match[sizeof(message) + 16];
+    char session_id[16];
+
+    /* Make the message unique, to find it without the extra fields */
+    snprintf(rec, sizeof(rec), "tltest-%d-%s", (int)getpid(), n);
+    snprintf(message, sizeof(message),
+             "{\"ver\":\"2.3\",\"rec\":\"%s\"}", rec);
+    snprintf(session_id, sizeof(session_id), "%u", SESSION_ID);
+
+    grc = tlog_journal_json_writer_create(&writer, LOG_INFO,
+                                          augment, stream,
+                                          rec, USERNAME, SESSION_ID);
+    if (grc != TLOG_RC_OK) {
+        fprintf(stderr, "Failed creating journal writer: %s\n",
+                tlog_grc_strerror(grc));
+        goto cleanup;
+    }
+    grc = tlog_json_writer_write(writer, 1, (const uint8_t *)message,
+                                 strlen(message));
+    if (grc != TLOG_RC_OK) {
+        fprintf(stderr, "Failed writing a message: %s\n",
+                tlog_grc_strerror(grc));
+        goto cleanup;
+    }
+    tlog_json_writer_destroy(writer);
+    writer = NULL;
+
+    if (augment) {
+        snprintf(match, sizeof(match), "TLOG_REC=%s", rec);
+    } else {
+        snprintf(match, sizeof(match), "MESSAGE=%s", message);
+    }
+    if (!find_entry(&journal, match)) {
+        goto cleanup;
+    }
+
+    /* Streams can't carry the extra fields, so they're only used without */
+    passed = check_field(journal, "MESSAGE", message) &&
+             check_field(journal, "_TRANSPORT",
+                         (stream && !augment) ? "stdout" : "journal");
+    if (augment) {
+        passed = check_field(journal, "TLOG_USER", USERNAME) &&
+                 check_field(journal, "TLOG_SESSION", session_id) &&
+                 check_field(journal, "TLOG_ID", "1") &&
+                 passed;
+    }
+
+cleanup:
+    if (journal != NULL) {
+        sd_journal_close(journal);
+    }
+    tlog_json_writer_destroy(writer);
+    fprintf(stderr, "%s %s:%d %s\n", (passed ? "PASS" : "FAIL"),
+            file, line, n);
+    return passed;
+}
+
+int
+main(void)
+{
+    bool passed = true;
+
+    if (access(JOURNAL_SOCKET, W_OK) < 0) {
+        fprintf(stderr, "Skipping, journal is not available: %s\n",
+                strerror(errno));
+        return EXIT_SKIP;
+    }
+    if (!probe()) {
+        fprintf(stderr, "Skipping, journal entries can't be read back\n");
+        return EXIT_SKIP;
+    }
+
+#define TEST(_name_token, _augment, _stream) \
+    passed = test(__FILE__, __LINE__, #_name_token,     \
+                  _augment, _stream) && passed
+
+    TEST(entries, false, false);
+    TEST(entries_augmented, true, false);
+    TEST(stream, false, true);
+    /* Extra fields must be kept even if a stream is requested */
+    TEST(stream_augmented, true, true);
+
+    return !passed;
+}
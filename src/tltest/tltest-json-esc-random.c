@@ -0,0 +1,317 @@
+/*
+ * Tlog JSON escaping kernel random input test.
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <tltest/misc.h>
+#include <tlog/json_esc.h>
+#include <tlog/json_misc.h>
+#include <tlog/json_chunk.h>
+#include <tlog/misc.h>
+#include <tlog/rc.h>
+
+/** Number of random inputs to test */
+#define ITER_NUM    2000
+
+/** Maximum number of characters in a random input */
+#define CHR_MAX     300
+
+/** Maximum length of a random input */
+#define IN_SIZE     (CHR_MAX * 4)
+
+/** Maximum length of an escaped random input, with terminating zero */
+#define OUT_SIZE    (CHR_MAX * 6 + 1)
+
+/**
+ * Generate a random valid UTF-8 buffer, biased towards characters
+ * needing escaping and sequences longer than one byte.
+ *
+ * @param buf   The buffer to output to, IN_SIZE bytes long.
+ * @param pchr  Location for the number of generated characters.
+ *
+ * @return Length of the generated buffer.
+ */
+static size_t
+gen(uint8_t *buf, size_t *pchr)
+{
+    static const char *mb_list[] = {
+        "\xc3\xa9",
+        "\xd0\x90",
+        "\xe2\x82\xac",
+        "\xe5\x96\x9c",
+        "\xf0\x9d\x84\x9e",
+    };
+    size_t chr = (size_t)rand() % (CHR_MAX + 1);
+    size_t i;
+    size_t len = 0;
+    const char *mb;
+
+    for (i = 0; i < chr; i++) {
+        switch (rand() % 8) {
+        case 0:
+            buf[len++] = (uint8_t)(rand() % 0x20);
+            break;
+        case 1:
+            buf[len++] = "\"\\\x7f"[rand() % 3];
+            break;
+        case 2:
+            mb = mb_list[rand() % TLOG_ARRAY_SIZE(mb_list)];
+            memcpy(buf + len, mb, strlen(mb));
+            len += strlen(mb);
+            break;
+        default:
+            buf[len++] = (uint8_t)(0x20 + rand() % 0x5f);
+            break;
+        }
+    }
+    assert(len <= IN_SIZE);
+
+    *pchr = chr;
+    return len;
+}
+
+/**
+ * Escape a valid UTF-8 buffer one byte at a time, for reference.
+ *
+ * @param out_buf   The buffer to output to, OUT_SIZE bytes long.
+ * @param in_buf    The buffer to escape.
+ * @param in_len    The length of the buffer to escape.
+ *
+ * @return Length of the output.
+ */
+static size_t
+ref_esc(uint8_t *out_buf, const uint8_t *in_buf, size_t in_len)
+{
+    size_t out_len = 0;
+    size_t i;
+    uint8_t c;
+
+    for (i = 0; i < in_len; i++) {
+        c = in_buf[i];
+        switch (c) {
+        case '"':
+        case '\\':
+            out_buf[out_len++] = '\\';
+            out_buf[out_len++] = c;
+            break;
+#define ESC_CASE(_c, _e) \
+        case _c:                            \
+            out_buf[out_len++] = '\\';      \
+            out_buf[out_len++] = _e;        \
+            break;
+        ESC_CASE('\b', 'b');
+        ESC_CASE('\f', 'f');
+        ESC_CASE('\n', 'n');
+        ESC_CASE('\r', 'r');
+        ESC_CASE('\t', 't');
+#undef ESC_CASE
+        default:
+            if (c < 0x20 || c == 0x7f) {
+                out_len += snprintf((char *)out_buf + out_len, 7,
+                                    "\\u%04x", c);
+            } else {
+                out_buf[out_len++] = c;
+            }
+            break;
+        }
+    }
+    assert(out_len < OUT_SIZE);
+    return out_len;
+}
+
+/**
+ * Find the reference escaped output length for a buffer cut to fit the
+ * specified output space, the way tlog_json_esc_buf does it.
+ *
+ * @param in_buf    The buffer to escape.
+ * @param in_len    The length of the buffer to escape.
+ * @param out_len   The output space, including terminating zero.
+ *
+ * @return The length of the output which fits, not including
+ *         terminating zero.
+ */
+static size_t
+ref_esc_fit(const uint8_t *in_buf, size_t in_len, size_t out_len)
+{
+    uint8_t buf[TLOG_JSON_ESC_BYTE_LEN_MAX * 4];
+    size_t fit_len = 0;
+    size_t chr_len;
+    size_t esc_len;
+    size_t i;
+
+    for (i = 0; i < in_len; i += chr_len) {
+        chr_len = 1;
+        while (i + chr_len < in_len &&
+               (in_buf[i + chr_len] & 0xc0) == 0x80) {
+            chr_len++;
+        }
+        esc_len = ref_esc(buf, in_buf + i, chr_len);
+        if (fit_len + esc_len >= out_len) {
+            break;
+        }
+        fit_len += esc_len;
+    }
+    return fit_len;
+}
+
+static bool
+test_span(size_t iter, const uint8_t *in_buf, size_t in_len)
+{
+    size_t off;
+    size_t exp_len;
+    size_t res_len;
+    bool ascii;
+
+    for (off = 0; off < in_len; off++) {
+        for (ascii = false; ; ascii = true) {
+            exp_len = 0;
+            while (off + exp_len < in_len &&
+                   !tlog_json_esc_byte_is_needed(in_buf[off + exp_len]) &&
+                   !(ascii && in_buf[off + exp_len] >= 0x80)) {
+                exp_len++;
+            }
+            res_len = tlog_json_esc_span(in_buf + off, in_len - off, ascii);
+            if (res_len != exp_len) {
+                fprintf(stderr,
+                        "FAIL span #%zu off %zu ascii %d: %zu != %zu\n",
+                        iter, off, ascii, res_len, exp_len);
+                return false;
+            }
+            if (ascii) {
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+static bool
+test_esc_buf(size_t iter, const uint8_t *in_buf, size_t in_len)
+{
+    uint8_t exp_buf[OUT_SIZE];
+    size_t exp_len;
+    char res_buf[OUT_SIZE + 1];
+    size_t res_len;
+    size_t out_len;
+    size_t fit_len;
+
+    exp_len = ref_esc(exp_buf, in_buf, in_len);
+
+    /* Check with enough space, and with the output cut randomly */
+    for (out_len = exp_len + 1; ;
+         out_len = (size_t)rand() % (exp_len + 1)) {
+        memset(res_buf, 0x20, sizeof(res_buf));
+        res_len = tlog_json_esc_buf(out_len > 0 ? res_buf : NULL, out_len,
+                                    (const char *)in_buf, in_len);
+        if (res_len != exp_len + 1) {
+            fprintf(stderr, "FAIL esc_buf #%zu out_len %zu: "
+                    "res_len %zu != %zu\n",
+                    iter, out_len, res_len, exp_len + 1);
+            return false;
+        }
+        fit_len = ref_esc_fit(in_buf, in_len, out_len);
+        if (memcmp(res_buf, exp_buf, fit_len) != 0 ||
+            (out_len > 0 && res_buf[fit_len] != 0) ||
+            res_buf[out_len > 0 ? fit_len + 1 : 0] != 0x20) {
+            fprintf(stderr, "FAIL esc_buf #%zu out_len %zu: "
+                    "out_buf mismatch:\n", iter, out_len);
+            tltest_diff(stderr, (uint8_t *)res_buf, fit_len + 1,
+                        exp_buf, fit_len);
+            return false;
+        }
+        if (out_len <= exp_len) {
+            break;
+        }
+    }
+    return true;
+}
+
+static bool
+test_stream(size_t iter, const uint8_t *in_buf, size_t in_len, size_t chr)
+{
+    bool passed = true;
+    tlog_grc grc;
+    struct tlog_json_chunk chunk;
+    struct tlog_pkt pkt = TLOG_PKT_IO(0, 0, 0, 0, true, in_buf, in_len);
+    struct tlog_pkt_pos pos = TLOG_PKT_POS_VOID;
+    struct tlog_pkt_pos end = TLOG_PKT_POS_VOID;
+    uint8_t exp_buf[OUT_SIZE];
+    size_t exp_len;
+
+    grc = tlog_json_chunk_init(&chunk, OUT_SIZE * 2, NULL);
+    if (grc != TLOG_RC_OK) {
+        fprintf(stderr, "Failed initializing the chunk: %s\n",
+                tlog_grc_strerror(grc));
+        exit(1);
+    }
+
+    exp_len = ref_esc(exp_buf, in_buf, in_len);
+    if (in_len > 0) {
+        tlog_pkt_pos_move_past(&end, &pkt);
+        if (!tlog_json_chunk_write(&chunk, &pkt, &pos, &end)) {
+            fprintf(stderr, "FAIL stream #%zu: write didn't fit\n", iter);
+            passed = false;
+            goto cleanup;
+        }
+    }
+    if (chunk.output.state.txt_run != chr) {
+        fprintf(stderr, "FAIL stream #%zu: txt_run %zu != %zu\n",
+                iter, chunk.output.state.txt_run, chr);
+        passed = false;
+    }
+    if (chunk.output.state.txt_len != exp_len ||
+        memcmp(chunk.output.txt_buf, exp_buf, exp_len) != 0) {
+        fprintf(stderr, "FAIL stream #%zu: txt_buf mismatch:\n", iter);
+        tltest_diff(stderr, chunk.output.txt_buf, chunk.output.state.txt_len,
+                    exp_buf, exp_len);
+        passed = false;
+    }
+
+cleanup:
+    tlog_json_chunk_cleanup(&chunk);
+    return passed;
+}
+
+int
+main(void)
+{
+    bool passed = true;
+    uint8_t in_buf[IN_SIZE];
+    size_t in_len;
+    size_t chr;
+    size_t iter;
+
+    srand(1);
+    for (iter = 0; iter < ITER_NUM && passed; iter++) {
+        in_len = gen(in_buf, &chr);
+        passed = test_span(iter, in_buf, in_len) &&
+                 test_esc_buf(iter, in_buf, in_len) &&
+                 test_stream(iter, in_buf, in_len, chr);
+    }
+
+    fprintf(stderr, "%s %zu random inputs\n",
+            (passed ? "PASS" : "FAIL"), iter);
+    return !passed;
+}
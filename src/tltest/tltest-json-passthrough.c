@@ -140,7 +140,8 @@ tltest_json_passthrough_buf(const char *name,
     GUARD("write the buffer to the sink",
           tlog_sink_write(sink, &pkt, NULL, NULL));
     GUARD("cut the sink", tlog_sink_cut(sink));
-    GUARD("flush the sink", tlog_sink_flush(sink));
+    GUARD("flush the sink",
+          tlog_sink_flush(sink, TLOG_SINK_FLUSH_REASON_REQUEST));
 
     GUARD("create a memory reader",
           tlog_mem_json_reader_create(&reader, log_buf, log_len));
@@ -0,0 +1,155 @@
+/*
+ * Tlog JSON sink idle memory test.
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <tlog/rc.h>
+#include <tlog/fd_json_writer.h>
+#include <tlog/json_sink.h>
+#include <tlog/misc.h>
+
+/** Number of sinks (sessions) to create per test */
+#define SINK_NUM    4
+
+/** Recorder's default payload size */
+#define DEFAULT_CHUNK_SIZE  2048
+
+/** Recorder's default number of payload buffers */
+#define DEFAULT_CHUNK_NUM   2
+
+/**
+ * Have sinks busy with a few chunks of I/O each, flush them, and expect
+ * their buffer memory given back. Look at the buffers only, as the rest
+ * of the process memory varies with the allocator and the system.
+ *
+ * @param name          The test name.
+ * @param chunk_size    The chunk (payload) size of each sink.
+ * @param chunk_num     The number of chunks of each sink.
+ * @param reason        The reason to flush the sinks for.
+ *
+ * @return True if the test passed, false otherwise.
+ */
+static bool
+test(const char *name, size_t chunk_size, size_t chunk_num,
+     enum tlog_sink_flush_reason reason)
+{
+    bool passed = false;
+    int fd = -1;
+    struct tlog_json_writer *writer = NULL;
+    struct tlog_sink *sink_list[SINK_NUM] = {NULL, };
+    uint8_t data_buf[1024];
+    struct tlog_pkt pkt;
+    size_t busy_size;
+    size_t idle_size;
+    size_t i;
+    size_t j;
+
+#define GUARD(_op_name, _op_expr) \
+    do {                                                        \
+        tlog_grc grc;                                           \
+        grc = (_op_expr);                                       \
+        if (grc != TLOG_RC_OK) {                                \
+            fprintf(stderr, "Failed to %s: %s\n",               \
+                    _op_name, tlog_grc_strerror(grc));          \
+            passed = false;                                     \
+            goto cleanup;                                       \
+        }                                                       \
+    } while (0)
+
+    /* Mix valid and invalid UTF-8 to fill both text and binary buffers */
+    for (i = 0; i < sizeof(data_buf); i++) {
+        data_buf[i] = (i % 16 == 15) ? 0xff : 'a' + i % 26;
+    }
+
+    fd = open("/dev/null", O_WRONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed opening /dev/null: %s\n", strerror(errno));
+        goto cleanup;
+    }
+    GUARD("create a writer", tlog_fd_json_writer_create(&writer, fd, false));
+
+    passed = true;
+    for (i = 0; i < SINK_NUM; i++) {
+        struct tlog_json_sink_params params = {
+            .writer = writer,
+            .writer_owned = false,
+            .hostname = "localhost",
+            .recording = "rec-1",
+            .username = "user",
+            .terminal = "xterm",
+            .session_id = 1,
+            .chunk_size = chunk_size,
+            .chunk_num = chunk_num,
+        };
+        GUARD("create a sink", tlog_json_sink_create(&sink_list[i], &params));
+        for (j = 0; j < chunk_size * chunk_num * 2 / sizeof(data_buf); j++) {
+            pkt = TLOG_PKT_IO(j, 0, 0, 0, j & 1, data_buf, sizeof(data_buf));
+            GUARD("write a packet", tlog_sink_write(sink_list[i], &pkt,
+                                                    NULL, NULL));
+        }
+        GUARD("get busy buffer size",
+              tlog_json_sink_resident_size(sink_list[i], &busy_size));
+        GUARD("flush a sink", tlog_sink_flush(sink_list[i], reason));
+        GUARD("get idle buffer size",
+              tlog_json_sink_resident_size(sink_list[i], &idle_size));
+        fprintf(stderr, "%s: sink #%zu resident buffer memory, "
+                "%zu-byte payload: %zu bytes busy, %zu bytes idle\n",
+                name, i + 1, chunk_size, busy_size, idle_size);
+        passed = passed && busy_size > 0 && idle_size == 0;
+    }
+
+#undef GUARD
+
+cleanup:
+    for (i = 0; i < SINK_NUM; i++) {
+        tlog_sink_destroy(sink_list[i]);
+    }
+    tlog_json_writer_destroy(writer);
+    if (fd >= 0) {
+        close(fd);
+    }
+    fprintf(stderr, "%s %s\n", (passed ? "PASS" : "FAIL"), name);
+    return passed;
+}
+
+int
+main(void)
+{
+    bool passed = true;
+
+    /* Without idle flushing, as by default, idle sessions flush by latency */
+    passed = test("default_latency", DEFAULT_CHUNK_SIZE, DEFAULT_CHUNK_NUM,
+                  TLOG_SINK_FLUSH_REASON_LATENCY) && passed;
+    passed = test("large_latency", 64 * 1024, DEFAULT_CHUNK_NUM,
+                  TLOG_SINK_FLUSH_REASON_LATENCY) && passed;
+    passed = test("large_idle", 64 * 1024, DEFAULT_CHUNK_NUM,
+                  TLOG_SINK_FLUSH_REASON_IDLE) && passed;
+    passed = test("large_unbuffered", 64 * 1024, 1,
+                  TLOG_SINK_FLUSH_REASON_IDLE) && passed;
+
+    return !passed;
+}
@@ -33,7 +33,9 @@ main(void)
 #define TLOG_DELAY_MAX_AS_EPOCH_STR "2147483647.999"
 
 #define OP_WRITE(_pkt)  TLTEST_JSON_SINK_OP_WRITE(_pkt)
+#define OP_DROP(_pkt)   TLTEST_JSON_SINK_OP_DROP(_pkt)
 #define OP_FLUSH        TLTEST_JSON_SINK_OP_FLUSH
+#define OP_FLUSH_REASON TLTEST_JSON_SINK_OP_FLUSH_REASON
 #define OP_CUT          TLTEST_JSON_SINK_OP_CUT
 
 #define OP_WRITE_WINDOW(_pkt_window_args...) \
@@ -42,6 +44,9 @@ main(void)
 #define OP_WRITE_IO(_pkt_io_args...) \
     OP_WRITE(TLOG_PKT_IO(_pkt_io_args))
 
+#define OP_DROP_IO(_pkt_io_args...) \
+    OP_DROP(TLOG_PKT_IO(_pkt_io_args))
+
 #define MSG(_id_tkn, _pos, _time, _timing, \
             _in_txt, _in_bin, _out_txt, _out_bin)                   \
     "{\"ver\":\"2.3\",\"host\":\"localhost\",\"rec\":\"rec-1\","    \
@@ -53,6 +58,25 @@ main(void)
       "\"out_txt\":\"" _out_txt "\",\"out_bin\":[" _out_bin "]"     \
     "}\n"
 
+#define MSG_THROTTLED(_id_tkn, _pos, _time, _throttled, _timing, \
+                      _in_txt, _in_bin, _out_txt, _out_bin)         \
+    "{\"ver\":\"2.3\",\"host\":\"localhost\",\"rec\":\"rec-1\","    \
+      "\"user\":\"user\",\"term\":\"xterm\",\"session\":1,"         \
+      "\"id\":" #_id_tkn ",\"pos\":" _pos ","                       \
+      "\"time\":" _time "," _throttled ","                          \
+      "\"timing\":\"" _timing "\","                                 \
+      "\"in_txt\":\"" _in_txt "\",\"in_bin\":[" _in_bin "],"        \
+      "\"out_txt\":\"" _out_txt "\",\"out_bin\":[" _out_bin "]"     \
+    "}\n"
+
+#define MSG_FLUSH(_id_tkn, _pos, _time, _flush, _timing, \
+                  _in_txt, _in_bin, _out_txt, _out_bin)             \
+    MSG_THROTTLED(_id_tkn, _pos, _time, "\"flush\":\"" _flush "\"",   \
+                  _timing, _in_txt, _in_bin, _out_txt, _out_bin)
+
+#define BUDGET(_rate, _burst) \
+    ((struct tlog_json_sink_budget){.rate = _rate, .burst = _burst})
+
 #define INPUT(_struct_init_args...) \
     .input = {                      \
         .chunk_size = 64,           \
@@ -835,5 +859,150 @@ main(void)
                     "", ""))
     );
 
+    TEST(output_throttled,
+         INPUT(.output_budget = BUDGET(10, 0),
+               .op_list = {
+            OP_WRITE_IO(0, 0, 0, 0, false, "abc", 3),
+            OP_WRITE_IO(0, 0, 0, 0, true, "0123456789ABCDE", 15),
+            OP_WRITE_WINDOW(0, 500000000, 0, 500000000, 100, 100),
+            OP_WRITE_IO(1, 0, 1, 0, true, "xyz", 3),
+            OP_FLUSH
+         }),
+         OUTPUT(MSG_THROTTLED(1, "0", "0.000", "\"out_throttled\":5",
+                              "<3>10+500=100x100+500>3",
+                              "abc", "", "0123456789xyz", ""))
+    );
+
+    TEST(output_throttled_next_msg,
+         INPUT(.output_budget = BUDGET(2, 1),
+               .op_list = {
+            OP_WRITE_IO(0, 0, 0, 0, true, "abcdef", 6),
+            OP_FLUSH,
+            OP_WRITE_IO(1, 0, 1, 0, true, "gh", 2),
+            OP_FLUSH
+         }),
+         OUTPUT(MSG_THROTTLED(1, "0", "0.000", "\"out_throttled\":3",
+                              ">3", "", "", "abc", "")
+                MSG(2, "1000", "1.000", ">2", "", "", "gh", ""))
+    );
+
+    TEST(input_throttled,
+         INPUT(.input_budget = BUDGET(1, 1),
+               .output_budget = BUDGET(1, 0),
+               .op_list = {
+            OP_WRITE_IO(0, 0, 0, 0, false, "abcd", 4),
+            OP_WRITE_IO(0, 0, 0, 0, true, "efgh", 4),
+            OP_FLUSH
+         }),
+         OUTPUT(MSG_THROTTLED(1, "0", "0.000",
+                              "\"in_throttled\":2,\"out_throttled\":3",
+                              "<2>1", "ab", "", "e", ""))
+    );
+
+    TEST(throttled_char_boundary,
+         INPUT(.output_budget = BUDGET(4, 0),
+               .op_list = {
+            OP_WRITE_IO(0, 0, 0, 0, true, "ab\xf0\x9d\x84\x9e", 6),
+            OP_FLUSH
+         }),
+         OUTPUT(MSG_THROTTLED(1, "0", "0.000", "\"out_throttled\":4",
+                              ">2", "", "", "ab", ""))
+    );
+
+    TEST(throttled_all,
+         INPUT(.output_budget = BUDGET(1, 0),
+               .op_list = {
+            OP_WRITE_IO(0, 0, 0, 0, true, "a", 1),
+            OP_WRITE_IO(0, 0, 0, 0, true, "bc", 2),
+            OP_WRITE_WINDOW(0, 0, 0, 0, 80, 24),
+            OP_FLUSH
+         }),
+         OUTPUT(MSG_THROTTLED(1, "0", "0.000", "\"out_throttled\":2",
+                              ">1=80x24", "", "", "a", ""))
+    );
+
+    /* Bytes throttled after the last message are reported on flush */
+    TEST(throttled_flushed,
+         INPUT(.output_budget = BUDGET(1, 0),
+               .op_list = {
+            OP_WRITE_IO(0, 0, 0, 0, true, "a", 1),
+            OP_FLUSH,
+            OP_WRITE_IO(0, 500000000, 0, 500000000, true, "bc", 2),
+            OP_FLUSH,
+            OP_FLUSH
+         }),
+         OUTPUT(MSG(1, "0", "0.000", ">1", "", "", "a", "")
+                MSG_THROTTLED(2, "500", "0.500", "\"out_throttled\":2",
+                              "", "", "", "", ""))
+    );
+
+    TEST(dropped,
+         INPUT(.op_list = {
+            OP_WRITE_IO(0, 0, 0, 0, true, "abc", 3),
+            OP_DROP_IO(0, 0, 0, 0, true, "def", 3),
+            OP_DROP_IO(0, 0, 0, 0, false, "gh", 2),
+            OP_DROP_IO(0, 0, 0, 0, true, "ijkl", 4),
+            OP_WRITE_IO(1, 0, 1, 0, true, "mno", 3),
+            OP_FLUSH
+         }),
+         OUTPUT(MSG_THROTTLED(1, "0", "0.000",
+                              "\"in_dropped\":2,\"out_dropped\":7",
+                              ">3+1000>3", "", "", "abcmno", ""))
+    );
+
+    /* Bytes dropped before anything was written start the recording */
+    TEST(dropped_first,
+         INPUT(.op_list = {
+            OP_DROP_IO(0, 0, 0, 0, true, "abc", 3),
+            OP_FLUSH,
+            OP_WRITE_IO(0, 500000000, 0, 500000000, true, "def", 3),
+            OP_FLUSH
+         }),
+         OUTPUT(MSG_THROTTLED(1, "0", "0.000", "\"out_dropped\":3",
+                              "", "", "", "", "")
+                MSG(2, "500", "0.500", ">3", "", "", "def", ""))
+    );
+
+    TEST(flush_unreported,
+         INPUT(.op_list = {
+            OP_WRITE_IO(0, 0, 0, 0, true, "abc", 3),
+            OP_FLUSH_REASON(TLOG_SINK_FLUSH_REASON_IDLE)
+         }),
+         OUTPUT(MSG(1, "0", "0.000", ">3", "", "", "abc", ""))
+    );
+
+    TEST(flush_reasons,
+         INPUT(.report_flush = true,
+               .op_list = {
+            OP_WRITE_IO(0, 0, 0, 0, true, "abc", 3),
+            OP_FLUSH_REASON(TLOG_SINK_FLUSH_REASON_IDLE),
+            OP_WRITE_IO(1, 0, 1, 0, true, "def", 3),
+            OP_FLUSH_REASON(TLOG_SINK_FLUSH_REASON_LATENCY),
+            OP_WRITE_IO(2, 0, 2, 0, true, "ghi", 3),
+            OP_FLUSH
+         }),
+         OUTPUT(MSG_FLUSH(1, "0", "0.000", "idle", ">3", "", "", "abc", "")
+                MSG_FLUSH(2, "1000", "1.000", "latency",
+                          ">3", "", "", "def", "")
+                MSG_FLUSH(3, "2000", "2.000", "request",
+                          ">3", "", "", "ghi", ""))
+    );
+
+    TEST(flush_reason_full,
+         INPUT(.report_flush = true,
+               .op_list = {
+            OP_WRITE_IO(0, 0, 0, 0, true,
+                        "0123456789abcdef0123456789abcdef"
+                        "0123456789abcdef0123456789abcdef",
+                        64),
+            OP_FLUSH
+         }),
+         OUTPUT(MSG_FLUSH(1, "0", "0.000", "full", ">61", "", "",
+                          "0123456789abcdef0123456789abcdef"
+                          "0123456789abcdef0123456789abc", "")
+                MSG_FLUSH(2, "0", "0.000", "request", ">3", "", "",
+                          "def", ""))
+    );
+
     return !passed;
 }
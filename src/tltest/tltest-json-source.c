@@ -1027,6 +1027,111 @@ main(void)
              )
         );
 
+        tltest_json_source_fmt_msg(1, "1000", "<4",
+                          "\\\"\\\\\\t\\ud834\\udd1e", "", "", "",
+                          curr_version, msg);
+        TEST(io_in_txt_escapes,
+             INPUT(msg),
+             OUTPUT(
+                .io_size = 4,
+                .op_list = {
+                    OP_READ_OK(PKT_IO_STR(1, 0, 0, 0, false, "\"\\\t")),
+                    OP_READ_OK(PKT_IO_STR(1, 0, 0, 0, false,
+                                          "\xf0\x9d\x84\x9e")),
+                    OP_READ_OK(PKT_VOID)
+                }
+             )
+        );
+
+        /* Invalid bytes only fail the read once reached */
+        tltest_json_source_fmt_msg(1, "1000", "[0/1", "", " 7 , 3.14 ",
+                          "", "", curr_version, msg);
+        TEST(io_in_bin_invalid_unread,
+             INPUT(msg),
+             OUTPUT(
+                .io_size = 4,
+                .op_list = {
+                    OP_READ_OK(PKT_IO(1, 0, 0, 0, false, "\x07", 1)),
+                    OP_READ_OK(PKT_VOID)
+                }
+             )
+        );
+
+        /* Unknown fields are skipped, whatever their values */
+        tltest_json_source_fmt_msg(1, "1000", "=100x200",
+                          "", "", "", "", curr_version, msg);
+        strcpy(msg + strlen(msg) - 2,
+               ",\"extra\":{\"a\":[1,-2.5e3,{\"b\":null}],\"c\":true}}\n");
+        TEST(unknown_fields,
+             INPUT(msg),
+             OUTPUT(
+                .io_size = 4,
+                .op_list = {
+                    OP_READ_OK(PKT_WINDOW(1, 0, 0, 0, 100, 200)),
+                    OP_READ_OK(PKT_VOID)
+                }
+             )
+        );
+
+        /* Interleaved messages are filtered, escaped values compared */
+        TEST(filtered_interleaved,
+             INPUT(MSG_SPEC(host, user, xterm, 2, 1, "1000",
+                            "=100x200", "", "", "", "")
+                   MSG_SPEC(host, user, xterm, 1, 1, "1000",
+                            "=110x120", "", "", "", "")
+                   MSG_SPEC(other, user, xterm, 1, 2, "2000",
+                            "=200x300", "", "", "", "")
+                   MSG_SPEC(host, someone, xterm, 1, 2, "2000",
+                            "=300x400", "", "", "", "")
+                   "{\"ver\":1,\"host\":\"ho\\u0073t\","
+                   "\"user\":\"user\",\"term\":\"xterm\","
+                   "\"session\":1,\"id\":2,\"pos\":2000,"
+                   "\"timing\":\"=210x220\",\"in_txt\":\"\","
+                   "\"in_bin\":[],\"out_txt\":\"\",\"out_bin\":[]}\n"),
+             .output = {
+                .hostname = "host",
+                .username = "user",
+                .session_id = 1,
+                .io_size = 4,
+                .op_list = {
+                    OP_READ_OK(PKT_WINDOW(1, 0, 0, 0, 110, 120)),
+                    OP_READ_OK(PKT_WINDOW(2, 0, 0, 0, 210, 220)),
+                    OP_READ_OK(PKT_VOID)
+                }
+             }
+        );
+
+        /* Elided I/O is skipped, keeping the delays and windows */
+        tltest_json_source_fmt_msg(1, "1000", "=100x200+500>3]2/1+500=300x400",
+                          "", "", "", "", curr_version, msg);
+        strcpy(msg + strlen(msg) - 2, ",\"elided\":64}\n");
+        TEST(io_elided,
+             INPUT(msg),
+             OUTPUT(
+                .io_size = 4,
+                .op_list = {
+                    OP_READ_OK(PKT_WINDOW(1, 0, 0, 0, 100, 200)),
+                    OP_READ_OK(PKT_WINDOW(2, 0, 0, 0, 300, 400)),
+                    OP_READ_OK(PKT_VOID)
+                }
+             )
+        );
+
+        /* Elided output is skipped, keeping the input */
+        tltest_json_source_fmt_msg(1, "1000", "<2+500>3",
+                          "ab", "", "", "", curr_version, msg);
+        strcpy(msg + strlen(msg) - 2, ",\"elided\":3}\n");
+        TEST(io_elided_input,
+             INPUT(msg),
+             OUTPUT(
+                .io_size = 4,
+                .op_list = {
+                    OP_READ_OK(PKT_IO_STR(1, 0, 0, 0, false, "ab")),
+                    OP_READ_OK(PKT_VOID)
+                }
+             )
+        );
+
         tltest_json_source_fmt_msg(1, "1000", "<1[1/1+234>1]1/1",
                           "1.", "50", "3.", "52", curr_version, msg);
         TEST(io_everything,
@@ -1290,6 +1395,79 @@ main(void)
              )
         );
 
+        tltest_json_source_fmt_msg(1, "1000", " =0065535x1\\t+1000\\n=1x65535 ",
+                                   "", "", "", "", curr_version, msg);
+        TEST(timing_valid,
+             INPUT(msg),
+             OUTPUT(
+                .io_size = 4,
+                .op_list = {
+                    OP_READ_OK(PKT_WINDOW(1, 0, 0, 0, 65535, 1)),
+                    OP_READ_OK(PKT_WINDOW(2, 0, 0, 0, 1, 65535)),
+                    OP_READ_OK(PKT_VOID)
+                }
+             )
+        );
+
+        tltest_json_source_fmt_msg(1, "1000", "=100x200=300x",
+                                   "", "", "", "", curr_version, msg);
+        TEST(timing_truncated,
+             INPUT(msg),
+             OUTPUT(
+                .io_size = 4,
+                .op_list = {
+                    OP_READ_OK(PKT_WINDOW(1, 0, 0, 0, 100, 200)),
+                    OP_READ(TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_TIMING,
+                            PKT_VOID),
+                    OP_READ_OK(PKT_VOID)
+                }
+             )
+        );
+
+        /* Would be a 1ms delay if the number wrapped around */
+        tltest_json_source_fmt_msg(1, "1000", "+18446744073709551617=1x1",
+                                   "", "", "", "", curr_version, msg);
+        TEST(timing_overflow,
+             INPUT(msg),
+             OUTPUT(
+                .io_size = 4,
+                .op_list = {
+                    OP_READ(TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_TIMING,
+                            PKT_VOID),
+                    OP_READ_OK(PKT_VOID)
+                }
+             )
+        );
+
+        tltest_json_source_fmt_msg(1, "1000", "=100x200= 100x200",
+                                   "", "", "", "", curr_version, msg);
+        TEST(timing_space_after_type,
+             INPUT(msg),
+             OUTPUT(
+                .io_size = 4,
+                .op_list = {
+                    OP_READ_OK(PKT_WINDOW(1, 0, 0, 0, 100, 200)),
+                    OP_READ(TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_TIMING,
+                            PKT_VOID),
+                    OP_READ_OK(PKT_VOID)
+                }
+             )
+        );
+
+        tltest_json_source_fmt_msg(1, "1000", "=100 x200",
+                                   "", "", "", "", curr_version, msg);
+        TEST(timing_space_before_sep,
+             INPUT(msg),
+             OUTPUT(
+                .io_size = 4,
+                .op_list = {
+                    OP_READ(TLOG_RC_JSON_MSG_FIELD_INVALID_VALUE_TIMING,
+                            PKT_VOID),
+                    OP_READ_OK(PKT_VOID)
+                }
+             )
+        );
+
     } while (curr_version);
 
     return !passed;
@@ -79,14 +79,14 @@ main(void)
     /* Two byte input, output short of one byte */
     TEST(two_out_one,   .ibuf_in    = {0xfe, 0xff},
                         .ilen_in    = 2,
-                        .obuf_out   = "254,",
+                        .obuf_out   = "",
                         .orem_in    = 8,
                         .orem_out   = 8);
 
     /* Two byte input, output short of two bytes */
     TEST(two_out_two,   .ibuf_in    = {0xfe, 0xff},
                         .ilen_in    = 2,
-                        .obuf_out   = "254,",
+                        .obuf_out   = "",
                         .orem_in    = 7,
                         .orem_out   = 7);
 
@@ -96,7 +96,7 @@ main(void)
      */
     TEST(two_out_three, .ibuf_in    = {0xfe, 0xff},
                         .ilen_in    = 2,
-                        .obuf_out   = "254,",
+                        .obuf_out   = "",
                         .orem_in    = 6,
                         .orem_out   = 6);
 
@@ -106,7 +106,7 @@ main(void)
      */
     TEST(two_out_four,  .ibuf_in    = {0xfe, 0xff},
                         .ilen_in    = 2,
-                        .obuf_out   = "254",
+                        .obuf_out   = "",
                         .orem_in    = 5,
                         .orem_out   = 5);
 
@@ -106,6 +106,8 @@ struct test_meta {
     uint8_t                         buf[SIZE];
     uint8_t                        *ptr;
     size_t                          rem;
+    uint8_t                         txt_buf[SIZE];
+    uint8_t                         bin_buf[SIZE];
     struct tlog_json_stream         stream;
     struct tlog_trx_iface           trx_iface;
     TLOG_TRX_BASIC_MEMBERS(test_meta);
@@ -165,7 +167,6 @@ test_meta_dispatcher_advance(tlog_trx_state trx,
 static void
 test_meta_init(struct test_meta *meta, size_t rem)
 {
-    tlog_grc grc;
     assert(meta != NULL);
     assert(rem <= sizeof(meta->buf));
 
@@ -178,13 +179,8 @@ test_meta_init(struct test_meta *meta, size_t rem)
                               meta, &meta->trx_iface);
     meta->ptr = meta->buf;
     meta->rem = rem;
-    grc = tlog_json_stream_init(&meta->stream, &meta->dispatcher,
-                                SIZE, '<', '[');
-    if (grc != TLOG_RC_OK) {
-        fprintf(stderr, "Failed initializing the stream: %s\n",
-                tlog_grc_strerror(grc));
-        exit(1);
-    }
+    tlog_json_stream_init(&meta->stream, &meta->dispatcher, SIZE,
+                          meta->txt_buf, meta->bin_buf, '<', '[');
 }
 
 static void
@@ -317,9 +313,9 @@ test(const char *file, int line, const char *n, const struct test t)
             passed = false;                                             \
         }                                                               \
     } while (0)
-    BUF_CMP(txt, meta.stream.txt_buf, meta.stream.txt_len,
+    BUF_CMP(txt, meta.stream.txt_buf, meta.stream.state.txt_len,
             t.txt_buf, t.txt_len);
-    BUF_CMP(bin, meta.stream.bin_buf, meta.stream.bin_len,
+    BUF_CMP(bin, meta.stream.bin_buf, meta.stream.state.bin_len,
             t.bin_buf, t.bin_len);
     BUF_CMP(meta,
             meta.buf, (size_t)(meta.ptr - meta.buf),
@@ -510,5 +506,82 @@ main(void)
                                 .meta_buf = "<1<1",
                                 .meta_len = 4);
 
+    TEST(plain_run,             .op_list = {
+                                    OP_WRITE(.buf = "0123456789abcdef"
+                                                    "ghij",
+                                             .len_in = 20,
+                                             .rem_off = 23),
+                                    OP_FLUSH(.meta_off = 3)
+                                },
+                                .rem_in = SIZE,
+                                .rem_out = SIZE - 23,
+                                .txt_buf = "0123456789abcdefghij",
+                                .txt_len = 20,
+                                .meta_buf = "<20",
+                                .meta_len = 3);
+
+    TEST(plain_run_partial,     .op_list = {
+                                    OP_WRITE(.buf = "0123456789abcdef"
+                                                    "ghijklmnopqrstuv",
+                                             .len_in = 32,
+                                             .len_out = 3,
+                                             .rem_off = SIZE),
+                                    OP_FLUSH(.meta_off = 3)
+                                },
+                                .rem_in = SIZE,
+                                .rem_out = 0,
+                                .txt_buf = "0123456789abcdefghijklmnopqrs",
+                                .txt_len = 29,
+                                .meta_buf = "<29",
+                                .meta_len = 3);
+
+    TEST(plain_run_no_digit,    .op_list = {
+                                    OP_WRITE(.buf = "0123456789ab",
+                                             .len_in = 12,
+                                             .len_out = 3,
+                                             .rem_off = 11),
+                                    OP_FLUSH(.meta_off = 2)
+                                },
+                                .rem_in = 12,
+                                .rem_out = 1,
+                                .txt_buf = "012345678",
+                                .txt_len = 9,
+                                .meta_buf = "<9",
+                                .meta_len = 2);
+
+    TEST(control_in_run,        .op_list = {
+                                    OP_WRITE(.buf = "aaaaaaaa\x1f"
+                                                    "bbbbbbbbbbbbbbbb"
+                                                    "bbbbbbb",
+                                             .len_in = 32,
+                                             .len_out = 8,
+                                             .rem_off = SIZE),
+                                    OP_FLUSH(.meta_off = 3)
+                                },
+                                .rem_in = SIZE,
+                                .rem_out = 0,
+                                .txt_buf = "aaaaaaaa\\u001f"
+                                           "bbbbbbbbbbbbbbb",
+                                .txt_len = 29,
+                                .meta_buf = "<24",
+                                .meta_len = 3);
+
+    TEST(mixed_runs,            .op_list = {
+                                    OP_WRITE(.buf = {'A', 0xc3, 0xa9, '"',
+                                                     'B', 0xff, 'C'},
+                                             .len_in = 7,
+                                             .rem_off = 21,
+                                             .meta_off = 6),
+                                    OP_FLUSH(.meta_off = 2)
+                                },
+                                .rem_in = SIZE,
+                                .rem_out = SIZE - 21,
+                                .txt_buf = "Aé\\\"B�C",
+                                .txt_len = 10,
+                                .bin_buf = "255",
+                                .bin_len = 3,
+                                .meta_buf = "<4[1/1<1",
+                                .meta_len = 8);
+
     return !passed;
 }
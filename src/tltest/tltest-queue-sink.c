@@ -0,0 +1,208 @@
+/*
+ * Tlog queueing sink overflow test.
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tlog/rc.h>
+#include <tlog/mem_json_writer.h>
+#include <tlog/json_sink.h>
+#include <tlog/queue_sink.h>
+#include <tltest/misc.h>
+
+/**
+ * Gate sink: passes operations to the "below" sink, holding writes until
+ * opened, to keep the queue full for as long as necessary.
+ */
+struct gate_sink {
+    struct tlog_sink    sink;   /**< Abstract sink */
+    struct tlog_sink   *below;  /**< "Below" sink, not owned */
+    pthread_mutex_t     mutex;  /**< Mutex protecting "open" */
+    pthread_cond_t      cond;   /**< Signalled when opened */
+    bool                open;   /**< True if writes can pass */
+};
+
+static tlog_grc
+gate_sink_init(struct tlog_sink *sink, va_list ap)
+{
+    struct gate_sink *gate_sink = (struct gate_sink *)sink;
+    gate_sink->below = va_arg(ap, struct tlog_sink *);
+    pthread_mutex_init(&gate_sink->mutex, NULL);
+    pthread_cond_init(&gate_sink->cond, NULL);
+    return TLOG_RC_OK;
+}
+
+static tlog_grc
+gate_sink_write(struct tlog_sink *sink,
+                const struct tlog_pkt *pkt,
+                struct tlog_pkt_pos *ppos,
+                const struct tlog_pkt_pos *end)
+{
+    struct gate_sink *gate_sink = (struct gate_sink *)sink;
+    pthread_mutex_lock(&gate_sink->mutex);
+    while (!gate_sink->open) {
+        pthread_cond_wait(&gate_sink->cond, &gate_sink->mutex);
+    }
+    pthread_mutex_unlock(&gate_sink->mutex);
+    return tlog_sink_write(gate_sink->below, pkt, ppos, end);
+}
+
+static tlog_grc
+gate_sink_drop(struct tlog_sink *sink, const struct tlog_pkt *pkt)
+{
+    struct gate_sink *gate_sink = (struct gate_sink *)sink;
+    return tlog_sink_drop(gate_sink->below, pkt);
+}
+
+static tlog_grc
+gate_sink_flush(struct tlog_sink *sink, enum tlog_sink_flush_reason reason)
+{
+    struct gate_sink *gate_sink = (struct gate_sink *)sink;
+    return tlog_sink_flush(gate_sink->below, reason);
+}
+
+static void
+gate_sink_open(struct tlog_sink *sink)
+{
+    struct gate_sink *gate_sink = (struct gate_sink *)sink;
+    pthread_mutex_lock(&gate_sink->mutex);
+    gate_sink->open = true;
+    pthread_cond_broadcast(&gate_sink->cond);
+    pthread_mutex_unlock(&gate_sink->mutex);
+}
+
+static void
+gate_sink_cleanup(struct tlog_sink *sink)
+{
+    struct gate_sink *gate_sink = (struct gate_sink *)sink;
+    pthread_cond_destroy(&gate_sink->cond);
+    pthread_mutex_destroy(&gate_sink->mutex);
+}
+
+static const struct tlog_sink_type gate_sink_type = {
+    .size       = sizeof(struct gate_sink),
+    .init       = gate_sink_init,
+    .write      = gate_sink_write,
+    .drop       = gate_sink_drop,
+    .flush      = gate_sink_flush,
+    .cleanup    = gate_sink_cleanup,
+};
+
+int
+main(void)
+{
+    static const char exp_output_buf[] =
+        "{\"ver\":\"2.3\",\"host\":\"localhost\",\"rec\":\"rec-1\","
+          "\"user\":\"user\",\"term\":\"xterm\",\"session\":1,"
+          "\"id\":1,\"pos\":0,\"time\":0.000,"
+          "\"in_dropped\":2,\"out_dropped\":7,"
+          "\"timing\":\">3\","
+          "\"in_txt\":\"\",\"in_bin\":[],"
+          "\"out_txt\":\"abc\",\"out_bin\":[]"
+        "}\n";
+    const size_t exp_output_len = sizeof(exp_output_buf) - 1;
+    bool passed = false;
+    char *res_output_buf = NULL;
+    size_t res_output_len = 0;
+    struct tlog_json_writer *writer = NULL;
+    struct tlog_sink *json_sink = NULL;
+    struct tlog_sink *gate_sink = NULL;
+    struct tlog_sink *sink = NULL;
+    struct tlog_pkt pkt;
+
+#define GUARD(_op_name, _op_expr) \
+    do {                                                        \
+        tlog_grc grc;                                           \
+        grc = (_op_expr);                                       \
+        if (grc != TLOG_RC_OK) {                                \
+            fprintf(stderr, "Failed to %s: %s\n",               \
+                    _op_name, tlog_grc_strerror(grc));          \
+            goto cleanup;                                       \
+        }                                                       \
+    } while (0)
+
+    GUARD("create a writer",
+          tlog_mem_json_writer_create(&writer,
+                                      &res_output_buf, &res_output_len));
+    {
+        struct tlog_json_sink_params params = {
+            .writer = writer,
+            .writer_owned = false,
+            .hostname = "localhost",
+            .recording = "rec-1",
+            .username = "user",
+            .terminal = "xterm",
+            .session_id = 1,
+            .chunk_size = 64,
+            .chunk_num = 1,
+        };
+        GUARD("create a JSON sink",
+              tlog_json_sink_create(&json_sink, &params));
+    }
+    GUARD("create a gate sink",
+          tlog_sink_create(&gate_sink, &gate_sink_type, json_sink));
+    GUARD("create a queueing sink",
+          tlog_queue_sink_create(&sink, gate_sink, false, 1,
+                                 TLOG_QUEUE_SINK_OVERFLOW_DROP));
+
+    /* The first packet always fits, and keeps the queue busy */
+    pkt = TLOG_PKT_IO(0, 0, 0, 0, true, "abc", 3);
+    GUARD("write a packet", tlog_sink_write(sink, &pkt, NULL, NULL));
+    /* The rest are dropped, and only counted */
+    pkt = TLOG_PKT_IO(0, 0, 0, 0, true, "def", 3);
+    GUARD("write a packet", tlog_sink_write(sink, &pkt, NULL, NULL));
+    pkt = TLOG_PKT_IO(0, 0, 0, 0, false, "gh", 2);
+    GUARD("write a packet", tlog_sink_write(sink, &pkt, NULL, NULL));
+    pkt = TLOG_PKT_IO(0, 0, 0, 0, true, "ijkl", 4);
+    GUARD("write a packet", tlog_sink_write(sink, &pkt, NULL, NULL));
+
+    gate_sink_open(gate_sink);
+    GUARD("flush the sink",
+          tlog_sink_flush(sink, TLOG_SINK_FLUSH_REASON_REQUEST));
+    GUARD("drain the queue", tlog_queue_sink_drain(sink));
+
+#undef GUARD
+
+    passed = res_output_len == exp_output_len &&
+             memcmp(res_output_buf, exp_output_buf, res_output_len) == 0;
+    if (!passed) {
+        fprintf(stderr, "output mismatch:\n");
+        tltest_diff(stderr,
+                    (const uint8_t *)res_output_buf, res_output_len,
+                    (const uint8_t *)exp_output_buf, exp_output_len);
+    }
+
+cleanup:
+    /* Let the queue finish on failure */
+    if (gate_sink != NULL) {
+        gate_sink_open(gate_sink);
+    }
+    tlog_sink_destroy(sink);
+    tlog_sink_destroy(gate_sink);
+    tlog_sink_destroy(json_sink);
+    tlog_json_writer_destroy(writer);
+    free(res_output_buf);
+    fprintf(stderr, "%s overflow_drop\n", (passed ? "PASS" : "FAIL"));
+    return !passed;
+}
@@ -0,0 +1,520 @@
+/*
+ * Tlog rate-limiting writer test.
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <tlog/rc.h>
+#include <tlog/rl_json_writer.h>
+#include <tlog/mem_json_writer.h>
+#include <tltest/json_writer.h>
+
+/** Shared budget parameters */
+struct shared {
+    /** True if the shared budget is used */
+    bool                                enabled;
+    /** Average message data rate, bytes per second */
+    size_t                              rate;
+    /** Maximum message burst size, bytes */
+    size_t                              burst;
+    /** Budget sharing policy */
+    enum tlog_rl_shared_fairness        fairness;
+};
+
+/** Test parameters */
+struct params {
+    /** Writer parameters, except the writer below and the clock */
+    struct tlog_rl_json_writer_params   writer;
+    /** Shared budget parameters */
+    struct shared                       shared;
+};
+
+/** Test state */
+struct state {
+    /** Data written by the writer below */
+    char                               *res_buf;
+    /** Length of the data written by the writer below */
+    size_t                              res_len;
+    /** True if the shared budget is used */
+    bool                                shared;
+    /** Name of the shared budget segment */
+    char                                shared_name[32];
+    /** The shared budget, as opened by "another process" */
+    struct tlog_rl_shared              *other;
+};
+
+/**
+ * Create a rate-limiting writer on top of a memory writer, and open the
+ * shared budget, if requested, both for the writer and for "another
+ * process".
+ *
+ * @param params    The test parameters.
+ * @param pdata     Location for the test state.
+ *
+ * @return The created writer.
+ */
+static struct tlog_json_writer *
+setup(const void *params, void **pdata)
+{
+    const struct params *test_params = (const struct params *)params;
+    tlog_grc grc;
+    struct tlog_json_writer *below = NULL;
+    struct tlog_json_writer *writer = NULL;
+    struct tlog_rl_json_writer_params rl_params = test_params->writer;
+    struct state *state;
+
+    state = calloc(1, sizeof(*state));
+    if (state == NULL) {
+        fprintf(stderr, "Failed allocating test state: %s\n",
+                strerror(errno));
+        exit(1);
+    }
+
+    if (test_params->shared.enabled) {
+        state->shared = true;
+        snprintf(state->shared_name, sizeof(state->shared_name),
+                 "/tlog-test-rl-%d", (int)getpid());
+        shm_unlink(state->shared_name);
+        grc = tlog_rl_shared_create(&rl_params.shared, state->shared_name,
+                                    test_params->shared.rate,
+                                    test_params->shared.burst,
+                                    test_params->shared.fairness);
+        if (grc == TLOG_RC_OK) {
+            grc = tlog_rl_shared_create(&state->other, state->shared_name,
+                                        test_params->shared.rate,
+                                        test_params->shared.burst,
+                                        test_params->shared.fairness);
+        }
+        if (grc != TLOG_RC_OK) {
+            fprintf(stderr, "Failed opening shared budget: %s\n",
+                    tlog_grc_strerror(grc));
+            exit(1);
+        }
+    }
+
+    grc = tlog_mem_json_writer_create(&below,
+                                      &state->res_buf, &state->res_len);
+    if (grc != TLOG_RC_OK) {
+        fprintf(stderr, "Failed creating memory writer: %s\n",
+                tlog_grc_strerror(grc));
+        exit(1);
+    }
+    rl_params.below = below;
+    rl_params.below_owned = true;
+    rl_params.clock_id = CLOCK_MONOTONIC;
+    grc = tlog_rl_json_writer_create(&writer, &rl_params);
+    if (grc != TLOG_RC_OK) {
+        fprintf(stderr, "Failed creating rate-limiting writer: %s\n",
+                tlog_grc_strerror(grc));
+        exit(1);
+    }
+
+    *pdata = state;
+    return writer;
+}
+
+/**
+ * Retrieve the data written by the writer below.
+ *
+ * @param data  The test state.
+ * @param buf   The buffer to copy the data to.
+ * @param size  The size of the buffer.
+ *
+ * @return Length of the data.
+ */
+static size_t
+read_mem(void *data, char *buf, size_t size)
+{
+    const struct state *state = (const struct state *)data;
+
+    if (state->res_len > size) {
+        fprintf(stderr, "Written data is too long: %zu\n", state->res_len);
+        exit(1);
+    }
+    if (state->res_len > 0) {
+        memcpy(buf, state->res_buf, state->res_len);
+    }
+    return state->res_len;
+}
+
+/**
+ * Take the string length out of the shared budget, as another process.
+ *
+ * @param data  The test state.
+ * @param str   The string to take the length of.
+ *
+ * @return Global return code.
+ */
+static tlog_grc
+take_shared(void *data, const char *str)
+{
+    const struct state *state = (const struct state *)data;
+
+    assert(state->shared);
+    return tlog_rl_shared_force(state->other, strlen(str));
+}
+
+/**
+ * Close the shared budget and free the written data.
+ *
+ * @param data  The test state.
+ */
+static void
+teardown(void *data)
+{
+    struct state *state = (struct state *)data;
+
+    if (state->shared) {
+        tlog_rl_shared_destroy(state->other);
+        shm_unlink(state->shared_name);
+    }
+    free(state->res_buf);
+    free(state);
+}
+
+static const struct tltest_json_writer_hooks hooks = {
+    .setup = setup,
+    .read = read_mem,
+    .custom = take_shared,
+    .teardown = teardown,
+};
+
+/**
+ * Check a shared budget segment created by someone else, accessible to
+ * anyone, is not trusted.
+ *
+ * @return True if the test passed, false otherwise.
+ */
+static bool
+test_shared_untrusted(void)
+{
+    bool passed;
+    tlog_grc grc;
+    char name[32];
+    struct tlog_rl_shared *shared = NULL;
+    int fd;
+
+    snprintf(name, sizeof(name), "/tlog-test-rl-%d", (int)getpid());
+    shm_unlink(name);
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 || fchmod(fd, 0666) < 0) {
+        fprintf(stderr, "Failed creating a shared memory segment: %s\n",
+                strerror(errno));
+        exit(1);
+    }
+    close(fd);
+
+    grc = tlog_rl_shared_create(&shared, name, 8, 0,
+                                TLOG_RL_SHARED_FAIRNESS_EQUAL);
+    passed = grc == TLOG_RC_RL_SHARED_SEG_UNTRUSTED && shared == NULL;
+    fprintf(stderr, "%s shared_untrusted: %s\n",
+            (passed ? "PASS" : "FAIL"), tlog_grc_strerror(grc));
+
+    tlog_rl_shared_destroy(shared);
+    shm_unlink(name);
+    return passed;
+}
+
+/**
+ * Check a process which died with a shared budget open doesn't keep
+ * counting towards the "equal" shares.
+ *
+ * @return True if the test passed, false otherwise.
+ */
+static bool
+test_shared_dead(void)
+{
+    bool passed;
+    tlog_grc grc;
+    char name[32];
+    struct tlog_rl_shared *shared = NULL;
+    struct tlog_rl_shared *other = NULL;
+    struct timespec delay;
+    bool taken;
+    pid_t pid;
+
+    snprintf(name, sizeof(name), "/tlog-test-rl-%d", (int)getpid());
+    shm_unlink(name);
+    grc = tlog_rl_shared_create(&shared, name, 8, 0,
+                                TLOG_RL_SHARED_FAIRNESS_EQUAL);
+    if (grc != TLOG_RC_OK) {
+        fprintf(stderr, "Failed opening shared budget: %s\n",
+                tlog_grc_strerror(grc));
+        exit(1);
+    }
+
+    /* Have a child open the budget and exit without closing it */
+    pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Failed forking: %s\n", strerror(errno));
+        exit(1);
+    } else if (pid == 0) {
+        grc = tlog_rl_shared_create(&other, name, 8, 0,
+                                    TLOG_RL_SHARED_FAIRNESS_EQUAL);
+        _exit(grc == TLOG_RC_OK ? 0 : 1);
+    }
+    if (waitpid(pid, NULL, 0) < 0) {
+        fprintf(stderr, "Failed waiting for the child: %s\n",
+                strerror(errno));
+        exit(1);
+    }
+
+    /* Expect the whole budget to be ours */
+    grc = tlog_rl_shared_take(shared, 8, &taken, &delay);
+    passed = grc == TLOG_RC_OK && taken && shared->users == 1;
+    fprintf(stderr, "%s shared_dead: %zu users\n",
+            (passed ? "PASS" : "FAIL"), (size_t)shared->users);
+
+    tlog_rl_shared_destroy(shared);
+    shm_unlink(name);
+    return passed;
+}
+
+int
+main(void)
+{
+    bool passed = true;
+
+#define OP_WRITE(_str) TLTEST_JSON_WRITER_OP_WRITE(_str)
+#define OP_WRITE_FAIL(_str, _grc) TLTEST_JSON_WRITER_OP_WRITE_FAIL(_str, _grc)
+#define OP_WRITE_MSG(_timing, _out_txt, _out_bin) \
+    TLTEST_JSON_WRITER_OP_WRITE_MSG(_timing, _out_txt, _out_bin)
+#define OP_WRITE_MSG_IO(_timing, _in_txt, _out_txt, _out_bin) \
+    TLTEST_JSON_WRITER_OP_WRITE_MSG_IO(_timing, _in_txt, _out_txt, _out_bin)
+#define OP_SLEEP(_ms) TLTEST_JSON_WRITER_OP_SLEEP(_ms)
+#define OP_FLUSH TLTEST_JSON_WRITER_OP_FLUSH
+#define OP_CHECK(_str) TLTEST_JSON_WRITER_OP_CHECK(_str)
+
+/* Take the string's length out of the shared budget, as another process */
+#define OP_SHARED(_str) TLTEST_JSON_WRITER_OP_CUSTOM(_str)
+
+#define PARAMS(_rate, _burst, _action, _backlog, _evict) \
+    ((struct tlog_rl_json_writer_params){                           \
+        .rate = _rate,                                              \
+        .burst = _burst,                                            \
+        .action = TLOG_RL_JSON_WRITER_ACTION_##_action,             \
+        .backlog = _backlog,                                        \
+        .evict = TLOG_RL_JSON_WRITER_EVICT_##_evict,                \
+    })
+
+#define PARAMS_RESERVE(_rate, _burst, _action, _reserve) \
+    ((struct tlog_rl_json_writer_params){                           \
+        .rate = _rate,                                              \
+        .burst = _burst,                                            \
+        .action = TLOG_RL_JSON_WRITER_ACTION_##_action,             \
+        .reserve = _reserve,                                        \
+    })
+
+#define SHARED(_rate, _burst, _fairness) \
+    ((struct shared){                                               \
+        .enabled = true,                                            \
+        .rate = _rate,                                              \
+        .burst = _burst,                                            \
+        .fairness = TLOG_RL_SHARED_FAIRNESS_##_fairness,            \
+    })
+
+#define TEST_SHARED(_name_token, _params, _shared, _exp_final, \
+                    _op_list_init_args...)                          \
+    passed = tltest_json_writer(                                \
+                __FILE__, __LINE__, #_name_token, &hooks,       \
+                (struct tltest_json_writer){                    \
+                    .params = &(struct params){                 \
+                        .writer = _params,                      \
+                        .shared = _shared,                      \
+                    },                                          \
+                    .op_list = {_op_list_init_args,             \
+                                TLTEST_JSON_WRITER_OP_NONE},    \
+                    .exp_final = _exp_final                     \
+                }                                               \
+             ) && passed
+
+#define TEST(_name_token, _params, _exp_final, _op_list_init_args...) \
+    TEST_SHARED(_name_token, _params, (struct shared){.enabled = false}, \
+                _exp_final, _op_list_init_args)
+
+    TEST(delay_fits, PARAMS(1, 8, DELAY, 0, OLDEST), "abc\ndef\n",
+         OP_WRITE("abc\n"),
+         OP_WRITE("def\n"),
+         OP_CHECK("abc\ndef\n"));
+
+    TEST(drop, PARAMS(4, 0, DROP, 0, OLDEST), "abc\nghi\n",
+         OP_WRITE("abc\n"),
+         OP_WRITE("def\n"),
+         OP_CHECK("abc\n"),
+         OP_SLEEP(1200),
+         OP_WRITE("ghi\n"));
+
+    /* The backlog is written out when the writer is destroyed */
+    TEST(backlog_held, PARAMS(1, 3, BACKLOG, 16, OLDEST),
+         "abc\ndef\nghi\n",
+         OP_WRITE("abc\n"),
+         OP_WRITE("def\n"),
+         OP_WRITE("ghi\n"),
+         OP_FLUSH,
+         OP_CHECK("abc\n"));
+
+    TEST(backlog_evict_oldest, PARAMS(1, 3, BACKLOG, 8, OLDEST),
+         "abc\nghi\njkl\n",
+         OP_WRITE("abc\n"),
+         OP_WRITE("def\n"),
+         OP_WRITE("ghi\n"),
+         OP_WRITE("jkl\n"),
+         OP_FLUSH,
+         OP_CHECK("abc\n"));
+
+    TEST(backlog_evict_newest, PARAMS(1, 3, BACKLOG, 8, NEWEST),
+         "abc\ndef\nghi\n",
+         OP_WRITE("abc\n"),
+         OP_WRITE("def\n"),
+         OP_WRITE("ghi\n"),
+         OP_WRITE("jkl\n"),
+         OP_FLUSH,
+         OP_CHECK("abc\n"));
+
+    /* Messages larger than the whole backlog are refused */
+    TEST(backlog_oversized, PARAMS(1, 3, BACKLOG, 4, OLDEST),
+         "abc\n",
+         OP_WRITE("abc\n"),
+         OP_WRITE_FAIL("defgh\n", TLOG_RC_RL_JSON_WRITER_MSG_TOO_LARGE));
+
+    /* Messages keep their order while the backlog is being written */
+    TEST(backlog_order, PARAMS(8, 0, BACKLOG, 16, OLDEST),
+         "abc\ndef\nghi\njkl\n",
+         OP_WRITE("abc\n"),
+         OP_WRITE("def\n"),
+         OP_WRITE("ghi\n"),
+         OP_SLEEP(900),
+         OP_WRITE("jkl\n"),
+         OP_FLUSH,
+         OP_CHECK("abc\ndef\nghi\n"));
+
+    /* The backlog is written in background, as the rate allows */
+    TEST(backlog_drained, PARAMS(7, 0, BACKLOG, 16, OLDEST),
+         "abc\ndef\nghi\n",
+         OP_WRITE("abc\n"),
+         OP_WRITE("def\n"),
+         OP_WRITE("ghi\n"),
+         OP_FLUSH,
+         OP_CHECK("abc\n"),
+         OP_SLEEP(1500),
+         OP_FLUSH,
+         OP_CHECK("abc\ndef\nghi\n"));
+
+#define MSG(_timing, _out_txt, _out_bin) \
+    "{\"timing\":\"" _timing "\",\"in_txt\":\"\",\"in_bin\":[],"    \
+    "\"out_txt\":\"" _out_txt "\",\"out_bin\":[" _out_bin "]}\n"
+
+#define MSG_DEGRADED(_timing, _elided) \
+    "{\"timing\":\"" _timing "\",\"in_txt\":\"\",\"in_bin\":[],"    \
+    "\"out_txt\":\"\",\"out_bin\":[],\"elided\":" #_elided "}\n"
+
+#define MSG_DROPPED(_timing, _out_txt, _out_bin, _dropped) \
+    "{\"timing\":\"" _timing "\",\"in_txt\":\"\",\"in_bin\":[],"    \
+    "\"out_txt\":\"" _out_txt "\",\"out_bin\":[" _out_bin "],"      \
+    "\"dropped_msgs\":" #_dropped "}\n"
+
+    /*
+     * Dropped messages are counted in the next message written by a JSON
+     * sink, whether they came from one or not
+     */
+    TEST(drop_counted, PARAMS(100, 0, DROP, 0, OLDEST),
+         MSG(">8", "abcdefgh", "") MSG_DROPPED(">3", "xyz", "", 2),
+         OP_WRITE_MSG(">8", "abcdefgh", ""),
+         OP_WRITE_MSG(">3", "xyz", ""),
+         OP_WRITE("abcdefghijklmnopqrstuvwxyz\n"),
+         OP_SLEEP(1200),
+         OP_WRITE_MSG(">3", "xyz", ""));
+
+    /*
+     * Only the I/O bytes are counted as elided, degraded messages are
+     * charged as usual, and dropped, if they still don't fit, same as
+     * messages not coming from a JSON sink
+     */
+    TEST(degrade, PARAMS(155, 0, DEGRADE, 0, OLDEST),
+         MSG(">8", "abcdefgh", "") MSG_DEGRADED(">4]1/2", 6)
+         MSG_DROPPED(">3", "xyz", "", 2),
+         OP_WRITE_MSG(">8", "abcdefgh", ""),
+         OP_WRITE_MSG(">4]1/2", "a\\n\\u001b\\\"\xef\xbf\xbd", "255,254"),
+         OP_WRITE_MSG(">8", "abcdefgh", ""),
+         OP_WRITE("abc\n"),
+         OP_SLEEP(1200),
+         OP_WRITE_MSG(">3", "xyz", ""));
+
+    /*
+     * Output flooding past the rest of the limit is dropped, but the input
+     * and the window changes get through in the reserve, with the output
+     * elided
+     */
+    TEST(drop_reserve, PARAMS_RESERVE(400, 0, DROP, 50),
+         MSG(">8", "abcdefgh", "") MSG(">8", "abcdefgh", "")
+         "{\"timing\":\"<2>8\",\"in_txt\":\"ab\",\"in_bin\":[],"
+         "\"out_txt\":\"\",\"out_bin\":[],"
+         "\"elided\":8,\"dropped_msgs\":1}\n"
+         MSG_DEGRADED("=80x25>3", 3),
+         OP_WRITE_MSG(">8", "abcdefgh", ""),
+         OP_WRITE_MSG(">8", "abcdefgh", ""),
+         OP_WRITE_MSG(">8", "abcdefgh", ""),
+         OP_WRITE_MSG_IO("<2>8", "ab", "abcdefgh", ""),
+         OP_WRITE_MSG("=80x25>3", "xyz", ""),
+         OP_WRITE_MSG(">3", "xyz", ""));
+
+#undef MSG_DROPPED
+#undef MSG_DEGRADED
+#undef MSG
+
+    /* Messages not fitting the shared budget are limited as well */
+    TEST_SHARED(shared_drop, PARAMS(1000, 0, DROP, 0, OLDEST),
+                SHARED(8, 0, NONE), "abc\n",
+                OP_WRITE("abc\n"),
+                OP_SHARED("abc\n"),
+                OP_WRITE("def\n"));
+
+    TEST_SHARED(shared_fairness_none, PARAMS(1000, 0, DROP, 0, OLDEST),
+                SHARED(8, 0, NONE), "abc\ndef\n",
+                OP_WRITE("abc\n"),
+                OP_WRITE("def\n"));
+
+    /* With two processes sharing, each gets half of the budget */
+    TEST_SHARED(shared_fairness_equal, PARAMS(1000, 0, DROP, 0, OLDEST),
+                SHARED(8, 0, EQUAL), "abc\n",
+                OP_WRITE("abc\n"),
+                OP_WRITE("def\n"));
+
+    TEST_SHARED(shared_delay, PARAMS(1000, 0, DELAY, 0, OLDEST),
+                SHARED(8, 0, NONE), "abc\ndef\n",
+                OP_SHARED("abcdefgh"),
+                OP_WRITE("abc\n"),
+                OP_WRITE("def\n"));
+
+    passed = test_shared_untrusted() && passed;
+    passed = test_shared_dead() && passed;
+
+    return !passed;
+}
@@ -0,0 +1,264 @@
+/*
+ * Tlog syslog writer test.
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This file is part of tlog.
+ *
+ * Tlog is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Tlog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with tlog; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <syslog.h>
+#include <tlog/rc.h>
+#include <tlog/syslog_json_writer.h>
+#include <tltest/json_writer.h>
+
+/** Maximum length of a received message */
+#define MSG_SIZE    1024
+
+/** Syslog stand-in state */
+struct state {
+    /** Temporary directory holding the socket */
+    char                                    dirname[40];
+    /** Socket path */
+    char                                    path[48];
+    /** Socket FD */
+    int                                     fd;
+    /** Format of the messages */
+    enum tlog_syslog_json_writer_format     format;
+};
+
+/**
+ * Create a syslog writer sending to a temporary socket.
+ *
+ * @param params    The syslog writer parameters, except the path.
+ * @param pdata     Location for the syslog stand-in state.
+ *
+ * @return The created writer.
+ */
+static struct tlog_json_writer *
+setup(const void *params, void **pdata)
+{
+    tlog_grc grc;
+    struct tlog_json_writer *writer = NULL;
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    struct tlog_syslog_json_writer_params syslog_params =
+                    *(const struct tlog_syslog_json_writer_params *)params;
+    struct state *state;
+
+    state = calloc(1, sizeof(*state));
+    if (state == NULL) {
+        fprintf(stderr, "Failed allocating test state: %s\n",
+                strerror(errno));
+        exit(1);
+    }
+
+    /* Create a stand-in for the syslog socket */
+    strcpy(state->dirname, "tlog-test-syslog-json-writer.XXXXXX");
+    if (mkdtemp(state->dirname) == NULL) {
+        fprintf(stderr, "Failed creating a temporary directory: %s\n",
+                strerror(errno));
+        exit(1);
+    }
+    snprintf(state->path, sizeof(state->path), "%s/log", state->dirname);
+    strcpy(addr.sun_path, state->path);
+    state->fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (state->fd < 0 ||
+        bind(state->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "Failed creating a socket: %s\n", strerror(errno));
+        exit(1);
+    }
+    state->format = syslog_params.format;
+
+    syslog_params.path = state->path;
+    grc = tlog_syslog_json_writer_create(&writer, &syslog_params);
+    if (grc != TLOG_RC_OK) {
+        fprintf(stderr, "Failed creating syslog writer: %s\n",
+                tlog_grc_strerror(grc));
+        exit(1);
+    }
+
+    *pdata = state;
+    return writer;
+}
+
+/**
+ * Receive all the pending datagrams from the socket, replacing the
+ * timestamp in each with "T" and terminating each with "|".
+ *
+ * @param data  The syslog stand-in state.
+ * @param buf   The buffer to output to.
+ * @param size  The size of the buffer.
+ *
+ * @return Length of the output.
+ */
+static size_t
+recv_all(void *data, char *buf, size_t size)
+{
+    const struct state *state = (const struct state *)data;
+    char msg_buf[MSG_SIZE];
+    ssize_t rc;
+    size_t len = 0;
+    char *ts;
+    char *ts_end;
+
+    while (true) {
+        rc = recv(state->fd, msg_buf, sizeof(msg_buf) - 1, MSG_DONTWAIT);
+        if (rc < 0) {
+            if (errno == EAGAIN) {
+                break;
+            }
+            fprintf(stderr, "Failed receiving a message: %s\n",
+                    strerror(errno));
+            exit(1);
+        }
+        msg_buf[rc] = '\0';
+
+        /* Find the timestamp */
+        ts = strchr(msg_buf, '>');
+        if (ts == NULL) {
+            fprintf(stderr, "Invalid message received: %s\n", msg_buf);
+            exit(1);
+        }
+        ts++;
+        if (state->format == TLOG_SYSLOG_JSON_WRITER_FORMAT_RFC5424) {
+            ts += 2;
+            ts_end = strchr(ts, ' ');
+        } else {
+            ts_end = ts + 15;
+        }
+        if (ts_end == NULL || ts_end > msg_buf + rc) {
+            fprintf(stderr, "Invalid message received: %s\n", msg_buf);
+            exit(1);
+        }
+
+        len += snprintf(buf + len, size - len, "%.*sT%s|",
+                        (int)(ts - msg_buf), msg_buf, ts_end);
+        if (len >= size) {
+            fprintf(stderr, "Received messages are too long\n");
+            exit(1);
+        }
+    }
+    return len;
+}
+
+/**
+ * Remove the syslog stand-in.
+ *
+ * @param data  The syslog stand-in state.
+ */
+static void
+teardown(void *data)
+{
+    struct state *state = (struct state *)data;
+
+    close(state->fd);
+    unlink(state->path);
+    rmdir(state->dirname);
+    free(state);
+}
+
+static const struct tltest_json_writer_hooks hooks = {
+    .setup = setup,
+    .read = recv_all,
+    .teardown = teardown,
+};
+
+int
+main(void)
+{
+    bool passed = true;
+    char hostname[HOST_NAME_MAX + 1];
+    char exp_buf[MSG_SIZE];
+
+#define OP_WRITE(_str) TLTEST_JSON_WRITER_OP_WRITE(_str)
+#define OP_FLUSH TLTEST_JSON_WRITER_OP_FLUSH
+#define OP_CHECK(_str) TLTEST_JSON_WRITER_OP_CHECK(_str)
+
+#define PARAMS(_format, _batch) \
+    (&(struct tlog_syslog_json_writer_params){                      \
+        .facility = LOG_AUTHPRIV,                                   \
+        .priority = LOG_INFO,                                       \
+        .format = TLOG_SYSLOG_JSON_WRITER_FORMAT_##_format,         \
+        .batch = _batch,                                            \
+    })
+
+#define TEST(_name_token, _params, _exp_final, _op_list_init_args...) \
+    passed = tltest_json_writer(                                \
+                __FILE__, __LINE__, #_name_token, &hooks,       \
+                (struct tltest_json_writer){                    \
+                    .params = _params,                          \
+                    .op_list = {_op_list_init_args,             \
+                                TLTEST_JSON_WRITER_OP_NONE},    \
+                    .exp_final = _exp_final                     \
+                }                                               \
+             ) && passed
+
+    TEST(empty, PARAMS(RFC3164, 0), "",
+         OP_CHECK(""));
+
+    TEST(unbatched, PARAMS(RFC3164, 0), "",
+         OP_WRITE("abc\n"),
+         OP_CHECK("<86>T tlog: abc\n|"),
+         OP_WRITE("def\n"),
+         OP_CHECK("<86>T tlog: def\n|"));
+
+    TEST(batch_held, PARAMS(RFC3164, 3), "<86>T tlog: abc|<86>T tlog: def|",
+         OP_WRITE("abc"),
+         OP_CHECK(""),
+         OP_WRITE("def"),
+         OP_CHECK(""));
+
+    TEST(batch_flushed, PARAMS(RFC3164, 3), "<86>T tlog: ghi|",
+         OP_WRITE("abc"),
+         OP_WRITE("def"),
+         OP_FLUSH,
+         OP_CHECK("<86>T tlog: abc|<86>T tlog: def|"),
+         OP_FLUSH,
+         OP_CHECK(""),
+         OP_WRITE("ghi"));
+
+    TEST(batch_full, PARAMS(RFC3164, 2), "<86>T tlog: ghi|",
+         OP_WRITE("abc"),
+         OP_CHECK(""),
+         OP_WRITE("def"),
+         OP_CHECK("<86>T tlog: abc|<86>T tlog: def|"),
+         OP_WRITE("ghi"),
+         OP_CHECK(""));
+
+    /* The RFC5424 header contains the hostname */
+    if (gethostname(hostname, sizeof(hostname)) < 0) {
+        fprintf(stderr, "Failed getting the hostname: %s\n",
+                strerror(errno));
+        exit(1);
+    }
+    hostname[sizeof(hostname) - 1] = '\0';
+    snprintf(exp_buf, sizeof(exp_buf),
+             "<86>1 T %s tlog - - - abc|", hostname);
+
+    TEST(rfc5424, PARAMS(RFC5424, 0), "",
+         OP_WRITE("abc"),
+         OP_CHECK(exp_buf));
+
+    return !passed;
+}